@@ -0,0 +1,267 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2023  Neuro Software Developers, Inc.
+//
+// Contact Information:
+//
+// Email:
+// info@neurosoftware.com
+//
+// Website:
+// www.neurosoftware.com
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Headless acquisition: the scope's acquisition, conditioning and recording core (AcquisitionSession) without a
+// window, for unattended soak captures on rack machines. It acquires from a device with the settings given on the
+// command line, streams every block to a capture file if asked, keeps the filters and measurements going like the
+// display would, and prints a line of statistics every period until the duration is up or Ctrl+C.
+//
+//   Acquire --device Dev1 --inputs 8 --range 10 --rate 100000 --terminal Differential --seconds 3600 --record soak.osc
+//
+// Builds without the DAQmx driver (SCOPE_NO_NIDAQMX, e.g. on Linux), then only the Sim- devices and playback work.
+
+#include <string>
+#include <vector>
+#include <chrono>
+#include <thread>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "AcquisitionSession.h"
+#include "Measurements.h"
+#include "Telemetry.h"
+
+using namespace std;
+
+#define BLOCK_MILLISECONDS 10		// target duration of one read, as in the window
+#define RING_SECONDS 4
+#define RECORD_QUEUE_SECONDS 4
+#define POLL_MILLISECONDS 10		// how often the ring is drained
+#define FRAMES_PER_DRAIN 4096
+#define MEASURE_SECONDS 1
+#define BROADCAST_MEGABYTES 64
+
+static volatile sig_atomic_t interrupted = 0;
+
+static void onInterrupt(int) {
+	interrupted = 1;
+}
+
+static void usage() {
+	fprintf(stderr,
+		"usage: Acquire --device NAME [--inputs N] [--range V] | --channels LIST | --play FILE [--speed X]\n"
+		"               [--rate HZ] [--terminal Default|RSE|NRSE|Differential|PseudoDiff] [--seconds S]\n"
+		"               [--record FILE [--uncompressed]] [--filters LIST] [--decimate N] [--stats S] [--log FILE] [--measure]\n"
+		"               [--broadcast NAME] [--serve PORT] [--loopback]\n"
+		"       Acquire --list\n"
+		"--seconds 0 (the default) runs until Ctrl+C; --log writes the statistics as CSV (.csv) or JSON lines;\n"
+		"--record compresses losslessly unless --uncompressed; --serve streams the blocks to remote viewers\n"
+		"(StreamViewer), --loopback only to this machine.\n");
+}
+
+int main(int argc, char **argv) {
+	SessionSettings settings;
+	settings.blockMilliseconds = BLOCK_MILLISECONDS;
+	settings.ringSeconds = RING_SECONDS;
+	double seconds = 0;
+	double statsSeconds = 1;
+	double speed = 1;
+	string recordPath, logPath, broadcastName;
+	bool measure = false;
+	int servePort = -1;
+	bool loopbackOnly = false;
+	bool compress = true;
+
+	for (int i = 1; i < argc; i++) {
+		string arg = argv[i];
+		bool hasValue = i + 1 < argc;
+		if (arg == "--list") {
+			vector<string> devices = AcquisitionSession::deviceNames();
+			for (size_t d = 0; d < devices.size(); d++) printf("%s\n", devices[d].c_str());
+			return 0;
+		}
+		else if (arg == "--measure") measure = true;
+		else if (arg == "--loopback") loopbackOnly = true;
+		else if (arg == "--uncompressed") compress = false;
+		else if (!hasValue) {
+			usage();
+			return 2;
+		}
+		else if (arg == "--device") settings.device = argv[++i];
+		else if (arg == "--inputs") settings.inputs = atoi(argv[++i]);
+		else if (arg == "--range") settings.inputRange = atof(argv[++i]);
+		else if (arg == "--channels") settings.channelList = argv[++i];
+		else if (arg == "--play") settings.playbackFile = argv[++i];
+		else if (arg == "--speed") speed = atof(argv[++i]);
+		else if (arg == "--rate") settings.sampleRate = atof(argv[++i]);
+		else if (arg == "--terminal") {
+			if (!AcquisitionSession::parseTerminalConfig(argv[++i], &settings.terminalConfig)) {
+				fprintf(stderr, "unknown terminal configuration %s\n", argv[i]);
+				return 2;
+			}
+		}
+		else if (arg == "--seconds") seconds = atof(argv[++i]);
+		else if (arg == "--record") recordPath = argv[++i];
+		else if (arg == "--filters") settings.filterList = argv[++i];
+		else if (arg == "--decimate") settings.decimation = atoi(argv[++i]);
+		else if (arg == "--stats") statsSeconds = atof(argv[++i]);
+		else if (arg == "--log") logPath = argv[++i];
+		else if (arg == "--broadcast") broadcastName = argv[++i];
+		else if (arg == "--serve") servePort = atoi(argv[++i]);
+		else {
+			usage();
+			return 2;
+		}
+	}
+	if (settings.device.empty() && settings.channelList.empty() && settings.playbackFile.empty()) {
+		usage();
+		return 2;
+	}
+
+	AcquisitionSession session;
+	session.playback().setSpeed(speed);
+	if (!broadcastName.empty() && !session.startBroadcast(broadcastName, BROADCAST_MEGABYTES)) {
+		fprintf(stderr, "%s\n", session.errorString().c_str());
+		return 1;
+	}
+	if (servePort >= 0 && !session.startStreaming(servePort, loopbackOnly)) {
+		fprintf(stderr, "%s\n", session.errorString().c_str());
+		return 1;
+	}
+	if (!session.start(settings)) {
+		fprintf(stderr, "%s\n", session.errorString().c_str());
+		return 1;
+	}
+	AcquisitionSource *source = session.source();
+	int channels = source->numChannels();
+	printf("acquiring %d channels at %g Hz from %s (%s)%s\n", channels, source->sampleRate(), session.config().device().c_str(),
+		AcquisitionSession::terminalConfigName(session.config().terminalConfig), session.filters().active() ? ", filtered" : "");
+
+	if (!recordPath.empty()) {
+		session.recorder().setCompression(compress);
+		if (!session.startRecording(recordPath, RECORD_QUEUE_SECONDS)) {
+			fprintf(stderr, "%s\n", session.errorString().c_str());
+			return 1;
+		}
+		printf("recording to %s%s\n", recordPath.c_str(), compress ? ", compressed" : "");
+	}
+	if (session.broadcasting()) {
+		printf("broadcasting as %s, %llu frames of ring\n", broadcastName.c_str(), (unsigned long long)session.broadcaster().capacityFrames());
+	}
+	if (session.streaming()) {
+		printf("serving on port %d%s\n", session.streamServer().port(), loopbackOnly ? ", loopback only" : "");
+	}
+
+	vector<ChannelScaling> scaling(channels);
+	for (int channel = 0; channel < channels; channel++) {
+		scaling[channel] = source->scaling(channel);
+	}
+	Measurements measurements;
+	measurements.configure(channels, session.outputRate(), scaling.data(), MEASURE_SECONDS);
+
+	Telemetry telemetry;
+	telemetry.start(statsSeconds);
+	if (!logPath.empty() && !telemetry.openLog(logPath)) {
+		fprintf(stderr, "%s\n", telemetry.errorString().c_str());
+		return 1;
+	}
+
+	signal(SIGINT, onInterrupt);
+	signal(SIGTERM, onInterrupt);
+
+	AcquisitionEngine &engine = session.engine();
+	FilterBank &filters = session.filters();
+	Recorder &recorder = session.recorder();
+	vector<int16_t> frames((size_t)FRAMES_PER_DRAIN * channels);
+	int exitCode = 0;
+	chrono::steady_clock::time_point began = chrono::steady_clock::now();
+
+	// the display's frame loop without the drawing: drain, condition, measure, and a statistics line per period
+	while (!interrupted) {
+		this_thread::sleep_for(chrono::milliseconds(POLL_MILLISECONDS));
+
+		telemetry.beginFrame(engine.capacity() > 0 ? (double)engine.backlog() / engine.capacity() : 0);
+		Telemetry::Clock::time_point mark = Telemetry::Clock::now();
+		size_t numFrames, drained = 0;
+		while ((numFrames = engine.drain(frames.data(), FRAMES_PER_DRAIN)) > 0) {
+			drained += numFrames;
+			if (filters.active()) {
+				numFrames = filters.process(frames.data(), numFrames, frames.data());
+			}
+			measurements.add(frames.data(), numFrames);
+		}
+		telemetry.lap(STAGE_DRAIN, mark);
+		int64_t sampledAt;
+		if (drained > 0 && engine.newestSampleTime(&sampledAt)) {
+			int64_t now = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+			telemetry.sampleLatency((now - sampledAt) / 1e9);
+		}
+		telemetry.endFrame(drained > 0);
+
+		if (telemetry.update(engine)) {
+			const TelemetryReport &r = telemetry.report();
+			char line[512];
+			int length = snprintf(line, sizeof(line), "[%8.1f s] %.0f frames/s  block %d  backlog %lld  ring %.0f%%  dropped %llu  overruns %llu  errors %llu  latency p50 %.1f p99 %.1f ms",
+				r.time, r.seconds > 0 ? r.framesAcquired / r.seconds : 0, r.engine.largestBlock, (long long)r.engine.backendBacklog,
+				r.peakRingFill * 100, (unsigned long long)r.framesDropped, (unsigned long long)r.overruns, (unsigned long long)r.errors,
+				r.latency.percentile(0.5), r.latency.percentile(0.99));
+			if (recorder.recording() && length < (int)sizeof(line)) {
+				RecorderStats stats = recorder.stats();
+				snprintf(line + length, sizeof(line) - length, "  REC %.1f MB  %.1f MB/s  ratio %.2f  queue %d%%  dropped %llu", stats.bytesWritten / 1e6,
+					stats.recentMBps, stats.compressionRatio, (int)(stats.peakQueueFill * 100), (unsigned long long)stats.droppedFrames);
+			}
+			length = (int)strlen(line);
+			if (session.streaming() && length < (int)sizeof(line)) {
+				StreamServerStats stats = session.streamServer().stats();
+				snprintf(line + length, sizeof(line) - length, "  NET %d clients  %.1f MB/s  dropped %llu", stats.clients, stats.recentMBps,
+					(unsigned long long)(stats.droppedFrames + stats.queueDropped));
+			}
+			printf("%s\n", line);
+			if (measure) {
+				for (int channel = 0; channel < channels; channel++) {
+					Measurement m;
+					if (measurements.result(channel, m)) {
+						printf("    ch %d  min %.4f  max %.4f  mean %.4f  rms %.4f  freq %.2f Hz\n", channel, m.minimum, m.maximum, m.mean, m.rms, m.frequency);
+					}
+				}
+			}
+			fflush(stdout);
+
+			// a backend that failed for a whole period isn't coming back (a DAQmx task stops at its first error)
+			if (r.framesAcquired == 0 && r.errors + r.overruns > 0) {
+				fprintf(stderr, "acquisition stopped: %s\n", source->errorString(r.engine.status).c_str());
+				exitCode = 1;
+				break;
+			}
+			if (!logPath.empty() && !telemetry.logging()) {
+				fprintf(stderr, "%s\n", telemetry.errorString().c_str());
+				exitCode = 1;
+				break;
+			}
+		}
+
+		if (seconds > 0 && chrono::duration<double>(chrono::steady_clock::now() - began).count() >= seconds) break;
+		if (session.playingBack() && session.playback().finished() && engine.backlog() == 0) break;
+	}
+
+	bool recorded = recorder.recording();
+	session.stop();
+	RecorderStats stats = recorder.stats();  // after stop() flushed the last blocks to the file
+	telemetry.closeLog();
+	if (!session.errorString().empty()) {
+		fprintf(stderr, "%s\n", session.errorString().c_str());
+		exitCode = 1;
+	}
+	EngineCounters totals = engine.counters();
+	printf("acquired %llu frames, dropped %llu, %llu overruns, %llu errors\n", (unsigned long long)totals.framesAcquired,
+		(unsigned long long)totals.framesDropped, (unsigned long long)totals.overruns, (unsigned long long)totals.errors);
+	if (recorded) {
+		printf("recorded %.1f MB to %s, %llu frames dropped\n", stats.bytesWritten / 1e6, recordPath.c_str(), (unsigned long long)stats.droppedFrames);
+		if (stats.compressMBps > 0) {
+			printf("compressed %.1f MB of samples to %.1f%% at %.0f MB/s\n", stats.sampleBytes / 1e6, stats.compressionRatio * 100, stats.compressMBps);
+		}
+	}
+	return exitCode;
+}
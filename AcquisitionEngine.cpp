@@ -0,0 +1,189 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2023  Neuro Software Developers, Inc.
+//
+// Contact Information:
+//
+// Email:
+// info@neurosoftware.com
+//
+// Website:
+// www.neurosoftware.com
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "AcquisitionEngine.h"
+#include <vector>
+#include <chrono>
+
+using namespace std;
+
+AcquisitionEngine::AcquisitionEngine() : source(NULL), keepRunning(false), lastStatus(0), dropped(0), acquired(0), iterations(0), samplesPerBlock(1),
+	reads(0), overruns(0), errors(0), largestBlock(0), backendBacklog(-1), peakBackendBacklog(-1), readNanoseconds(0), sinkNanoseconds(0),
+	drained(0), newestStamp(0) {
+	pendingStamp[0] = pendingStamp[1] = -1;
+	for (int i = 0; i < ENGINE_MAX_SINKS; i++) {
+		sinks[i] = NULL;
+	}
+}
+
+AcquisitionEngine::~AcquisitionEngine() {
+	stop();
+}
+
+void AcquisitionEngine::start(AcquisitionSource *acquisitionSource, int blockMilliseconds, double ringSeconds) {
+	stop();
+
+	source = acquisitionSource;
+	double rate = source->sampleRate();
+
+	// read in blocks of roughly blockMilliseconds so the reader thread sleeps inside the backend between reads
+	samplesPerBlock = (int)(rate * blockMilliseconds / 1000.0);
+	if (samplesPerBlock < 1) samplesPerBlock = 1;
+
+	size_t ringFrames = (size_t)(rate * ringSeconds);
+	if (ringFrames < (size_t)samplesPerBlock * 4) ringFrames = (size_t)samplesPerBlock * 4;
+	ring.allocate(source->numChannels(), ringFrames);
+	stamps.allocate(2, ENGINE_STAMPS);
+
+	lastStatus = 0;
+	dropped = 0;
+	acquired = 0;
+	reads = 0;
+	overruns = 0;
+	errors = 0;
+	largestBlock = 0;
+	backendBacklog = -1;
+	peakBackendBacklog = -1;
+	readNanoseconds = 0;
+	sinkNanoseconds = 0;
+	drained = 0;
+	pendingStamp[0] = pendingStamp[1] = -1;
+	newestStamp = 0;
+	keepRunning = true;
+	readerThread = std::thread(&AcquisitionEngine::run, this);
+}
+
+void AcquisitionEngine::stop() {
+	// the reader thread must be out of source->read() before the caller stops the source
+	keepRunning = false;
+	if (readerThread.joinable()) {
+		readerThread.join();
+	}
+}
+
+bool AcquisitionEngine::attach(BlockSink *sink) {
+	for (int i = 0; i < ENGINE_MAX_SINKS; i++) {
+		BlockSink *empty = NULL;
+		if (sinks[i].compare_exchange_strong(empty, sink)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+void AcquisitionEngine::detach(BlockSink *sink) {
+	for (int i = 0; i < ENGINE_MAX_SINKS; i++) {
+		BlockSink *expected = sink;
+		sinks[i].compare_exchange_strong(expected, (BlockSink *)NULL);
+	}
+	// once the reader loop has gone round twice it can no longer be inside sink->consume()
+	uint64_t seen = iterations;
+	while (running() && keepRunning && iterations < seen + 2) {
+		this_thread::sleep_for(chrono::milliseconds(1));
+	}
+}
+
+size_t AcquisitionEngine::drain(int16_t *frames, size_t maxFrames) {
+	size_t count = ring.pop(frames, maxFrames);
+	drained += count;
+	return count;
+}
+
+EngineCounters AcquisitionEngine::counters() {
+	EngineCounters c;
+	c.reads = reads;
+	c.framesAcquired = acquired;
+	c.framesDropped = dropped;
+	c.overruns = overruns;
+	c.errors = errors;
+	c.status = lastStatus;
+	c.largestBlock = largestBlock.exchange(0);
+	c.backendBacklog = backendBacklog;
+	c.peakBackendBacklog = peakBackendBacklog.exchange(backendBacklog);
+	c.readNanoseconds = readNanoseconds;
+	c.sinkNanoseconds = sinkNanoseconds;
+	return c;
+}
+
+bool AcquisitionEngine::newestSampleTime(int64_t *nanoseconds) {
+	// the stamps of the blocks drained since last time; the one a drain stopped inside of waits for the next call
+	for (;;) {
+		if (pendingStamp[0] < 0 && stamps.pop(pendingStamp, 1) == 0) break;
+		if ((uint64_t)pendingStamp[0] > drained) break;
+		newestStamp = pendingStamp[1];
+		pendingStamp[0] = -1;
+	}
+	*nanoseconds = newestStamp;
+	return newestStamp != 0;
+}
+
+static int64_t nowNanoseconds() {
+	return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void AcquisitionEngine::run() {
+	vector<int16_t> frames((size_t)samplesPerBlock * source->numChannels());
+	double rate = source->sampleRate();
+	uint64_t pushedFrames = 0;
+
+	// let the backend wait for a whole block, but wake up often enough to notice stop()
+	double timeOut = 2.0 * samplesPerBlock / source->sampleRate();
+	if (timeOut < 0.1) timeOut = 0.1;
+
+	while (keepRunning) {
+		iterations++;
+		int framesRead = 0;
+		int64_t began = nowNanoseconds();
+		int status = source->read(frames.data(), samplesPerBlock, timeOut, &framesRead);
+		int64_t readAt = nowNanoseconds();
+		readNanoseconds += readAt - began;
+
+		if (status < 0 && framesRead <= 0) {
+			lastStatus = status;
+			if (source->overrun(status)) overruns++;
+			else errors++;
+			this_thread::sleep_for(chrono::milliseconds(10));  // don't spin on a persistent error
+			continue;
+		}
+		lastStatus = status;
+		if (framesRead <= 0) continue;
+
+		acquired += framesRead;
+		reads++;
+		if (framesRead > largestBlock) largestBlock = framesRead;
+		int64_t behind = source->available();
+		backendBacklog = behind;
+		if (behind > peakBackendBacklog) peakBackendBacklog = behind;
+
+		// every block goes to the sinks before the display gets it, so they see it even if the ring is full
+		for (int i = 0; i < ENGINE_MAX_SINKS; i++) {
+			BlockSink *sink = sinks[i];
+			if (sink != NULL) {
+				sink->consume(frames.data(), framesRead);
+			}
+		}
+		sinkNanoseconds += nowNanoseconds() - readAt;
+
+		size_t pushed = ring.push(frames.data(), framesRead);
+		if (pushed < (size_t)framesRead) {
+			dropped += framesRead - pushed;
+		}
+		if (pushed > 0) {
+			// the block's newest sample is older than the read by the frames that came in after it
+			pushedFrames += pushed;
+			int64_t stamp[2] = { (int64_t)pushedFrames, readAt - (behind > 0 ? (int64_t)(behind / rate * 1e9) : 0) };
+			stamps.push(stamp, 1);  // a full stamp ring only costs latency samples
+		}
+	}
+}
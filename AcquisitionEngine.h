@@ -0,0 +1,109 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2023  Neuro Software Developers, Inc.
+//
+// Contact Information:
+//
+// Email:
+// info@neurosoftware.com
+//
+// Website:
+// www.neurosoftware.com
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <atomic>
+#include <thread>
+#include <stdint.h>
+#include "AcquisitionSource.h"
+#include "SampleRing.h"
+
+#define ENGINE_MAX_SINKS 8
+#define ENGINE_STAMPS 1024		// read blocks whose time is kept until the display drains them
+
+// what the reader thread has been doing; totals since start() unless noted
+struct EngineCounters {
+	uint64_t reads;				// read() calls that returned frames
+	uint64_t framesAcquired;
+	uint64_t framesDropped;		// did not fit in the ring
+	uint64_t overruns;			// reads that failed because the backend overwrote samples before they were read
+	uint64_t errors;			// other failed reads
+	int status;					// of the last read
+	int largestBlock;			// frames, since the previous counters() call
+	int64_t backendBacklog;		// frames per channel left in the backend after the last read, -1 if unknown
+	int64_t peakBackendBacklog;	// since the previous counters() call
+	uint64_t readNanoseconds;	// in read(), mostly waiting for the samples
+	uint64_t sinkNanoseconds;	// handing the blocks to the sinks
+
+	EngineCounters() : reads(0), framesAcquired(0), framesDropped(0), overruns(0), errors(0), status(0), largestBlock(0),
+		backendBacklog(-1), peakBackendBacklog(-1), readNanoseconds(0), sinkNanoseconds(0) {}
+};
+
+// Something that wants every acquired block as it arrives (recorder, broadcast, ...). consume() runs on the
+// reader thread, so it must hand the data off and return without blocking.
+class BlockSink {
+public:
+	virtual ~BlockSink() {}
+	virtual void consume(const int16_t *frames, size_t numFrames) = 0;
+};
+
+// Owns the reader thread: block reads from an AcquisitionSource and pushes the frames into a
+// lock-free ring that the display (or any other single consumer) drains at its own pace.
+class AcquisitionEngine {
+public:
+	AcquisitionEngine();
+	~AcquisitionEngine();
+
+	// source must already be started; blockMilliseconds is the target duration of one read
+	void start(AcquisitionSource *source, int blockMilliseconds, double ringSeconds);
+	void stop();
+	bool running() const { return readerThread.joinable(); }
+
+	// consumer side, copies up to maxFrames interleaved frames of raw codes
+	size_t drain(int16_t *frames, size_t maxFrames);
+	size_t backlog() const { return ring.readable(); }
+	size_t capacity() const { return ring.capacityFrames(); }
+
+	// sinks can come and go while acquiring; detach() returns once the reader thread is done with the sink
+	bool attach(BlockSink *sink);
+	void detach(BlockSink *sink);
+
+	int numChannels() const { return ring.numChannels(); }
+	int framesPerBlock() const { return samplesPerBlock; }
+	int status() const { return lastStatus; }		// last backend status seen by the reader thread, 0 when healthy
+	uint64_t droppedFrames() const { return dropped; }	// frames that did not fit in the ring
+	uint64_t acquiredFrames() const { return acquired; }
+
+	// consumer side: the counters, resetting the peaks they report
+	EngineCounters counters();
+	// consumer side: when the newest frame drained so far was sampled, in steady_clock nanoseconds, estimated from
+	// when its block was read and how many frames the backend still held then; false if not known yet
+	bool newestSampleTime(int64_t *nanoseconds);
+
+private:
+	void run();
+
+	AcquisitionSource *source;
+	SampleRing<int16_t> ring;
+	std::thread readerThread;
+	std::atomic<bool> keepRunning;
+	std::atomic<int> lastStatus;
+	std::atomic<uint64_t> dropped;
+	std::atomic<uint64_t> acquired;
+	std::atomic<BlockSink *> sinks[ENGINE_MAX_SINKS];
+	std::atomic<uint64_t> iterations;	// reader loop passes, lets detach() wait out a consume() in flight
+	int samplesPerBlock;
+
+	// telemetry, written by the reader thread
+	std::atomic<uint64_t> reads, overruns, errors;
+	std::atomic<int> largestBlock;
+	std::atomic<int64_t> backendBacklog, peakBackendBacklog;
+	std::atomic<uint64_t> readNanoseconds, sinkNanoseconds;
+	// per block pushed: frames pushed into the ring in all, and when the newest of them was sampled
+	SampleRing<int64_t> stamps;
+	uint64_t drained;					// consumer side from here on
+	int64_t pendingStamp[2];			// popped, but its frames weren't drained yet
+	int64_t newestStamp;				// sample time of the newest frame drained, 0 if unknown
+};
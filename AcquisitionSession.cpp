@@ -0,0 +1,295 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2023  Neuro Software Developers, Inc.
+//
+// Contact Information:
+//
+// Email:
+// info@neurosoftware.com
+//
+// Website:
+// www.neurosoftware.com
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "AcquisitionSession.h"
+#include "ChannelList.h"
+#include <string.h>
+
+using namespace std;
+
+#define STREAM_QUEUE_SECONDS 2	// how long the stream server's network thread may stall before blocks are dropped
+
+static const struct {
+	int value;
+	const char *name;
+} terminalConfigs[] = {
+	{ TERMINAL_CONFIG_DEFAULT, "Default" },
+	{ TERMINAL_CONFIG_RSE, "RSE" },
+	{ TERMINAL_CONFIG_NRSE, "NRSE" },
+	{ TERMINAL_CONFIG_DIFFERENTIAL, "Differential" },
+	{ TERMINAL_CONFIG_PSEUDO_DIFFERENTIAL, "PseudoDiff" },
+};
+#define NUM_TERMINAL_CONFIGS (int)(sizeof(terminalConfigs) / sizeof(terminalConfigs[0]))
+
+const char *AcquisitionSession::terminalConfigName(int terminalConfig) {
+	for (int i = 0; i < NUM_TERMINAL_CONFIGS; i++) {
+		if (terminalConfigs[i].value == terminalConfig) return terminalConfigs[i].name;
+	}
+	return "Default";
+}
+
+bool AcquisitionSession::parseTerminalConfig(const string &name, int *terminalConfig) {
+	for (int i = 0; i < NUM_TERMINAL_CONFIGS; i++) {
+		if (name == terminalConfigs[i].name) {
+			*terminalConfig = terminalConfigs[i].value;
+			return true;
+		}
+	}
+	return false;
+}
+
+vector<string> AcquisitionSession::deviceNames() {
+	vector<string> names;
+#ifndef SCOPE_NO_NIDAQMX
+	names = NIDAQmxSource::deviceNames();
+#endif
+	vector<string> simulated = SimulatedSource::deviceNames();
+	names.insert(names.end(), simulated.begin(), simulated.end());
+	return names;
+}
+
+AcquisitionSession::AcquisitionSession() : active(NULL) {
+}
+
+AcquisitionSession::~AcquisitionSession() {
+	stop();
+	stopBroadcast();
+	stopStreaming();
+}
+
+bool AcquisitionSession::fail(const string &what) {
+	error = what;
+	return false;
+}
+
+bool AcquisitionSession::makeConfig(const SessionSettings &settings, AcquisitionConfig &config) {
+	config.sampleRate = settings.sampleRate;
+	config.terminalConfig = settings.terminalConfig;
+	if (!settings.playbackFile.empty()) {
+		// every channel in the file
+		if (!playbackSource.isOpen() || playbackPath != settings.playbackFile) {
+			playbackPath.clear();
+			if (!playbackSource.open(settings.playbackFile)) return fail(playbackSource.lastError());
+			playbackPath = settings.playbackFile;
+		}
+		config.devices.push_back(settings.playbackFile);
+		config.addInputs(0, (int)playbackSource.capture().numChannels, playbackSource.capture().minVoltage, playbackSource.capture().maxVoltage);
+	}
+	else if (!settings.channelList.empty()) {
+		string listError;
+		if (!parseChannelList(settings.channelList, -settings.inputRange, settings.inputRange, config, listError)) return fail(listError);
+	}
+	else {
+		if (settings.device.empty()) return fail("No device chosen.");
+		config.devices.push_back(settings.device);
+		config.addInputs(0, settings.inputs, -settings.inputRange, settings.inputRange);
+	}
+	if (config.numChannels() < settings.minimumChannels || config.numChannels() < 1) {
+		return fail(settings.minimumChannels > 1 ? "Choose at least " + to_string(settings.minimumChannels) + " channels." : "No channels to acquire.");
+	}
+	return true;
+}
+
+bool AcquisitionSession::start(const SessionSettings &settings) {
+	stop();
+	error.clear();
+
+	AcquisitionConfig config;
+	if (!makeConfig(settings, config)) return false;
+
+	AcquisitionSource *source;
+	if (!settings.playbackFile.empty()) {
+		source = &playbackSource;
+	}
+	else if (SimulatedSource::isSimulatedDevice(config.device())) {
+		source = &simulatedSource;
+	}
+	else {
+#ifndef SCOPE_NO_NIDAQMX
+		source = &daqSource;
+#else
+		return fail("This build has no DAQmx support, choose a simulated device (" + config.device() + ").");
+#endif
+	}
+	if (!source->start(config)) return fail(source->lastError());
+
+	vector<FilterSpec> filters;
+	string filterError;
+	vector<ChannelScaling> scaling;
+	for (int channel = 0; channel < source->numChannels(); channel++) {
+		scaling.push_back(source->scaling(channel));
+	}
+	if (!parseFilterList(settings.filterList, filters, filterError) ||
+		!conditioning.configure(source->numChannels(), source->sampleRate(), filters, settings.decimation, scaling.data())) {
+		source->stop();
+		return fail(filterError.empty() ? conditioning.errorString() : filterError);
+	}
+
+	active = source;
+	activeConfig = config;
+	activeSettings = settings;
+	if (broadcast.isOpen() && !configureBroadcast()) {
+		// the acquisition is more important than its broadcast
+		stopBroadcast();
+	}
+	if (server.running()) {
+		configureStreaming();
+	}
+	// hand the running source over to the reader thread
+	acquisition.start(active, settings.blockMilliseconds, settings.ringSeconds);
+	return true;
+}
+
+void AcquisitionSession::stop() {
+	if (active == NULL)
+		return;
+
+	stopRecording();
+	// the reader thread must be out of read() before the source goes away
+	acquisition.stop();
+	if (broadcast.isOpen()) {
+		acquisition.detach(&broadcast);
+		broadcast.idle();
+	}
+	if (server.running()) {
+		acquisition.detach(&server);
+		server.idle();
+	}
+	active->stop();
+	if (!active->lastError().empty()) {
+		error = active->lastError();
+	}
+	active = NULL;
+}
+
+bool AcquisitionSession::seekPlayback(uint64_t frame) {
+	if (active != &playbackSource)
+		return false;
+
+	acquisition.stop();
+	playbackSource.stop();
+	playbackSource.seek(frame);
+	conditioning.reset();  // the filters start over on the samples from the new position
+	if (!playbackSource.start(activeConfig)) {
+		active = NULL;
+		return fail(playbackSource.lastError());
+	}
+	acquisition.start(active, activeSettings.blockMilliseconds, activeSettings.ringSeconds);
+	return true;
+}
+
+bool AcquisitionSession::startRecording(const string &path, double queueSeconds) {
+	if (active == NULL) return fail("Start acquisition before recording.");
+	if (active == &playbackSource) return fail("Recording is not available while a capture is playing back.");
+	stopRecording();
+
+	// the per channel scaling is what matters, the header's device and range summarize the channel list
+	CaptureInfo info;
+	info.device = deviceSummary();
+	info.terminalConfig = activeConfig.terminalConfig;
+	info.terminalConfigName = terminalConfigName(activeConfig.terminalConfig);
+	info.numChannels = active->numChannels();
+	info.sampleRate = active->sampleRate();
+	info.minVoltage = 0;
+	info.maxVoltage = 0;
+	for (int channel = 0; channel < info.numChannels; channel++) {
+		if (activeConfig.channels[channel].minVoltage < info.minVoltage) info.minVoltage = activeConfig.channels[channel].minVoltage;
+		if (activeConfig.channels[channel].maxVoltage > info.maxVoltage) info.maxVoltage = activeConfig.channels[channel].maxVoltage;
+		info.scaling.push_back(active->scaling(channel));
+	}
+
+	if (!capture.start(path, info, queueSeconds)) return fail(capture.errorString());
+	acquisition.attach(&capture);
+	return true;
+}
+
+void AcquisitionSession::stopRecording() {
+	if (!capture.recording())
+		return;
+
+	acquisition.detach(&capture);  // after this the reader thread no longer calls into the recorder
+	capture.stop();
+	if (!capture.errorString().empty()) {
+		error = capture.errorString();
+	}
+}
+
+string AcquisitionSession::deviceSummary() const {
+	string devices;
+	for (size_t i = 0; i < activeConfig.devices.size(); i++) {
+		devices += (i > 0 ? "," : "") + activeConfig.devices[i];
+	}
+	return devices;
+}
+
+bool AcquisitionSession::configureBroadcast() {
+	vector<ChannelScaling> scaling;
+	for (int channel = 0; channel < active->numChannels(); channel++) {
+		scaling.push_back(active->scaling(channel));
+	}
+	if (!broadcast.configure(deviceSummary(), active->numChannels(), active->sampleRate(), scaling.data())) return fail(broadcast.errorString());
+	acquisition.attach(&broadcast);
+	return true;
+}
+
+bool AcquisitionSession::startBroadcast(const string &name, size_t megabytes) {
+	stopBroadcast();
+	if (!broadcast.open(name, megabytes)) return fail(broadcast.errorString());
+	if (active != NULL && !configureBroadcast()) {
+		broadcast.close();
+		return false;
+	}
+	return true;
+}
+
+void AcquisitionSession::stopBroadcast() {
+	if (!broadcast.isOpen())
+		return;
+
+	acquisition.detach(&broadcast);  // after this the reader thread no longer calls into the broadcaster
+	broadcast.close();
+}
+
+void AcquisitionSession::configureStreaming() {
+	StreamLayout layout;
+	layout.device = deviceSummary();
+	layout.sampleRate = active->sampleRate();
+	for (int channel = 0; channel < active->numChannels(); channel++) {
+		StreamChannel description;
+		ChannelScaling scaling = active->scaling(channel);
+		memcpy(description.coefficients, scaling.coefficients, sizeof(description.coefficients));
+		description.minVoltage = activeConfig.channels[channel].minVoltage;
+		description.maxVoltage = activeConfig.channels[channel].maxVoltage;
+		layout.channels.push_back(description);
+	}
+	server.configure(layout, STREAM_QUEUE_SECONDS);
+	acquisition.attach(&server);
+}
+
+bool AcquisitionSession::startStreaming(int port, bool loopbackOnly) {
+	stopStreaming();
+	if (!server.start(port, loopbackOnly)) return fail(server.errorString());
+	if (active != NULL) {
+		configureStreaming();
+	}
+	return true;
+}
+
+void AcquisitionSession::stopStreaming() {
+	if (!server.running())
+		return;
+
+	acquisition.detach(&server);  // after this the reader thread no longer calls into the server
+	server.stop();
+}
@@ -0,0 +1,136 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2023  Neuro Software Developers, Inc.
+//
+// Contact Information:
+//
+// Email:
+// info@neurosoftware.com
+//
+// Website:
+// www.neurosoftware.com
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <string>
+#include "AcquisitionEngine.h"
+#include "Broadcaster.h"
+#include "FilterBank.h"
+#include "PlaybackSource.h"
+#include "Recorder.h"
+#include "SimulatedSource.h"
+#include "StreamServer.h"
+#ifndef SCOPE_NO_NIDAQMX
+#include "NIDAQmxSource.h"
+#endif
+
+// DAQmx_Val_... terminal configurations, spelled out so the core also builds without NIDAQmx.h
+#define TERMINAL_CONFIG_DEFAULT (-1)
+#define TERMINAL_CONFIG_RSE 10083
+#define TERMINAL_CONFIG_NRSE 10078
+#define TERMINAL_CONFIG_DIFFERENTIAL 10106
+#define TERMINAL_CONFIG_PSEUDO_DIFFERENTIAL 12529
+
+// what to acquire and how to condition it
+struct SessionSettings {
+	std::string device;			// a DAQmx device ("Dev1") or one of SimulatedSource::deviceNames()
+	std::string channelList;	// when set it names the inputs and their devices itself, see ChannelList.h
+	int inputs;					// otherwise ai0..ai(inputs - 1) of device
+	double inputRange;			// +- volts, for inputs the channel list gives no range
+	double sampleRate;			// per channel
+	int terminalConfig;			// TERMINAL_CONFIG_...
+	std::string playbackFile;	// replays this capture instead of acquiring, at its own rate and channels
+	std::string filterList;		// see parseFilterList()
+	int decimation;
+	int minimumChannels;		// fewer is an error
+	int blockMilliseconds;		// target duration of one read
+	double ringSeconds;			// how long the consumer may stall before samples are dropped
+
+	SessionSettings() : inputs(8), inputRange(10), sampleRate(1000), terminalConfig(TERMINAL_CONFIG_DEFAULT), decimation(1),
+		minimumChannels(1), blockMilliseconds(10), ringSeconds(4) {}
+};
+
+// The acquisition core without a user interface: picks the backend for a device (DAQmx, simulated, or playback
+// of a capture), starts it and the reader thread, and owns the filters between the ring and whatever consumes
+// it, the recorder that streams the raw blocks to disk, the broadcaster that shares them with other processes and the
+// stream server that sends them to remote viewers. The window and the headless Acquire tool both run on
+// it; the consumer drains engine() and runs filters() itself, on its own thread and at its own pace.
+class AcquisitionSession {
+public:
+	AcquisitionSession();
+	~AcquisitionSession();
+
+	// stops whatever runs, then starts over with settings; false (see errorString()) leaves it stopped
+	bool start(const SessionSettings &settings);
+	// stops recording, the reader thread and the backend; errorString() has the backend's last error, if any
+	void stop();
+	bool running() const { return active != NULL; }
+
+	// restarts playback at frame, the filters starting over
+	bool seekPlayback(uint64_t frame);
+
+	bool startRecording(const std::string &path, double queueSeconds);
+	void stopRecording();  // errorString() has the recorder's error, if it failed
+	bool recording() const { return capture.recording(); }
+
+	// publishes the raw blocks to local readers (see Broadcaster.h); unlike recording it carries on across start()
+	bool startBroadcast(const std::string &name, size_t megabytes);
+	void stopBroadcast();
+	bool broadcasting() const { return broadcast.isOpen(); }
+
+	// serves the raw blocks to remote viewers over TCP (see StreamServer.h), also across start()
+	bool startStreaming(int port, bool loopbackOnly);
+	void stopStreaming();
+	bool streaming() const { return server.running(); }
+
+	AcquisitionSource *source() const { return active; }
+	bool playingBack() const { return active == &playbackSource; }
+	const AcquisitionConfig &config() const { return activeConfig; }
+	const SessionSettings &settings() const { return activeSettings; }
+	double outputRate() const { return active != NULL ? conditioning.outputRate() : 0; }	// after decimation
+
+	AcquisitionEngine &engine() { return acquisition; }
+	FilterBank &filters() { return conditioning; }
+	Recorder &recorder() { return capture; }
+	Broadcaster &broadcaster() { return broadcast; }
+	StreamServer &streamServer() { return server; }
+	PlaybackSource &playback() { return playbackSource; }
+	SimulatedSource &simulator() { return simulatedSource; }
+
+	const std::string &errorString() const { return error; }
+
+	// DAQ Settings names ("Default", "RSE", "NRSE", "Differential", "PseudoDiff") of the terminal configurations
+	static const char *terminalConfigName(int terminalConfig);
+	static bool parseTerminalConfig(const std::string &name, int *terminalConfig);
+	// every device a session can acquire from: the DAQmx driver's, then the simulated ones
+	static std::vector<std::string> deviceNames();
+
+private:
+	AcquisitionSession(const AcquisitionSession &);
+	AcquisitionSession &operator=(const AcquisitionSession &);
+
+	bool makeConfig(const SessionSettings &settings, AcquisitionConfig &config);
+	bool fail(const std::string &what);
+	std::string deviceSummary() const;
+	bool configureBroadcast();
+	void configureStreaming();
+
+#ifndef SCOPE_NO_NIDAQMX
+	NIDAQmxSource daqSource;
+#endif
+	SimulatedSource simulatedSource;
+	PlaybackSource playbackSource;
+	std::string playbackPath;		// what playbackSource has open
+	AcquisitionSource *active;
+	AcquisitionConfig activeConfig;
+	SessionSettings activeSettings;
+
+	AcquisitionEngine acquisition;
+	FilterBank conditioning;
+	Recorder capture;
+	Broadcaster broadcast;
+	StreamServer server;
+	std::string error;
+};
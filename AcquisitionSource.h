@@ -0,0 +1,89 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2023  Neuro Software Developers, Inc.
+//
+// Contact Information:
+//
+// Email:
+// info@neurosoftware.com
+//
+// Website:
+// www.neurosoftware.com
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include "Scaling.h"
+
+// one analog input of the scan
+struct ChannelConfig {
+	int device;					// index into AcquisitionConfig::devices
+	int input;					// aiN on that device
+	double minVoltage;
+	double maxVoltage;
+
+	ChannelConfig(int deviceIndex = 0, int inputNumber = 0, double minimum = -10.0, double maximum = 10.0)
+		: device(deviceIndex), input(inputNumber), minVoltage(minimum), maxVoltage(maximum) {}
+};
+
+// what to acquire, independent of the backend that produces it
+struct AcquisitionConfig {
+	// e.g. "Dev1", one of the simulated device names, or a capture file for playback. Channels on several
+	// devices are acquired in one scan, clocked by the first device's sample clock.
+	std::vector<std::string> devices;
+	std::vector<ChannelConfig> channels;	// in the order they appear in a frame
+	double sampleRate;			// samples per second per channel
+	int terminalConfig;			// DAQmx_Val_Cfg_Default, DAQmx_Val_RSE, ... (ignored by backends without terminals)
+
+	AcquisitionConfig() : sampleRate(50), terminalConfig(-1) {}
+
+	int numChannels() const { return (int)channels.size(); }
+	const std::string &device() const { static const std::string none; return devices.empty() ? none : devices[0]; }
+
+	// appends ai0..ai(count-1) of device, all with the same range
+	void addInputs(int device, int count, double minVoltage, double maxVoltage) {
+		for (int input = 0; input < count; input++) {
+			channels.push_back(ChannelConfig(device, input, minVoltage, maxVoltage));
+		}
+	}
+};
+
+// A backend that delivers continuous, hardware timed (or simulated) sample frames.
+// read() is only ever called from the acquisition thread; start() and stop() from the thread that owns the source.
+class AcquisitionSource {
+public:
+	virtual ~AcquisitionSource() {}
+
+	// configures and starts the acquisition, returns false and sets errorString() on failure
+	virtual bool start(const AcquisitionConfig &config) = 0;
+
+	// waits up to timeOut seconds for framesPerChannel frames and copies whatever arrived, interleaved by scan
+	// (one sample per channel per frame) into frames as raw ADC codes. Returns 0 on success (including a timeout
+	// with fewer or no frames), a negative backend status on error.
+	virtual int read(int16_t *frames, int framesPerChannel, double timeOut, int *framesRead) = 0;
+
+	virtual void stop() = 0;
+
+	virtual int numChannels() const = 0;
+	virtual double sampleRate() const = 0;
+
+	// how to turn a channel's raw codes into volts, valid after a successful start()
+	virtual ChannelScaling scaling(int channel) const = 0;
+
+	// frames per channel the backend holds beyond what the last read() returned, -1 if it can't tell; called on
+	// the acquisition thread right after read()
+	virtual int64_t available() { return -1; }
+	// whether a read() status means the backend overwrote samples before they were read
+	virtual bool overrun(int status) const { (void)status; return false; }
+
+	// human readable description of a status returned by start() or read()
+	virtual std::string errorString(int status) const = 0;
+	const std::string &lastError() const { return error; }
+
+protected:
+	std::string error;
+};
@@ -0,0 +1,27 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2023  Neuro Software Developers, Inc.
+//
+// Contact Information:
+//
+// Email:
+// info@neurosoftware.com
+//
+// Website:
+// www.neurosoftware.com
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+#pragma once
+
+#include <stdint.h>
+
+// Debug builds replace the global operator new to count every heap allocation made by any thread, so the frame
+// stats can show that acquisition and drawing allocate nothing once they are up and running. Release builds
+// leave the allocator alone and allocationCount() stays 0.
+#if defined(_DEBUG) && !defined(SCOPE_COUNT_ALLOCATIONS)
+#define SCOPE_COUNT_ALLOCATIONS 1
+#endif
+
+uint64_t allocationCount();
@@ -0,0 +1,1038 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2023  Neuro Software Developers, Inc.
+//
+// Contact Information:
+//
+// Email:
+// info@neurosoftware.com
+//
+// Website:
+// www.neurosoftware.com
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Headless benchmark of the acquisition-to-pixel pipeline: the stages the display runs on every block or frame,
+// fed with synthetic samples, without hardware or a window. Every case sweeps some of channel count, sample rate,
+// history depth and window size, and reports throughput and per iteration latency percentiles as JSON lines (or
+// CSV with --csv) on stdout, so runs can be kept and compared; --compare checks one run against another.
+//
+//   Benchmark [--quick] [--seconds S] [--csv] [--stages ring,scale,...] [--dir PATH]
+//   Benchmark --compare BASELINE.jsonl CANDIDATE.jsonl [--tolerance 0.1]
+//   Benchmark --check
+//
+// --check draws fixed scenes with the rasterizer's vectorized primitives and compares them pixel for pixel with
+// reference images drawn one pixel at a time, so a faster drawing path can't quietly change what is drawn. It also
+// packs and unpacks signals of several shapes and sizes and checks they come back bit for bit, as captures and the
+// stream rely on.
+//
+// An iteration is what one pass of the program does: a 10 ms block read from the ring, scaled, appended to the
+// history, filtered, recorded, broadcast or streamed, or one 60 Hz frame's worth of samples drawn into the trace layer.
+
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "SampleRing.h"
+#include "Scaling.h"
+#include "Decimator.h"
+#include "HistoryBuffer.h"
+#include "FilterBank.h"
+#include "Raster.h"
+#include "TraceView.h"
+#include "WorkerPool.h"
+#include "Recorder.h"
+#include "BinaryFile.h"
+#include "Broadcaster.h"
+#include "BroadcastReader.h"
+#include "StreamServer.h"
+#include "StreamClient.h"
+#include "SampleCodec.h"
+#include "SimdSupport.h"
+
+using namespace std;
+
+typedef chrono::steady_clock Clock;
+
+#define BLOCK_MILLISECONDS 10		// as the display's reader thread reads
+#define FRAME_RATE 60
+#define MIN_ITERATIONS 10
+#define MAX_ITERATIONS 200000
+#define SOURCE_BYTES (16 << 20)		// synthetic samples cycled through, more than the caches of most machines
+#define MEMORY_LIMIT (512ull << 20)	// cases whose history would need more are left out
+#define DEFAULT_TOLERANCE 0.1
+#define BROADCAST_NAME "OscilloscopeBenchmark"
+#define BROADCAST_MEGABYTES 64
+#define STREAM_QUEUE_SECONDS 1
+#define UNPACK_BLOCKS 4
+#define STREAM_TIMEOUT_SECONDS 5
+
+const int channelCounts[] = { 1, 8, 32 };
+const double sampleRates[] = { 100000, 1000000 };
+const double historyDepths[] = { 1, 10 };	// seconds
+const int windowSizes[][2] = { { 1024, 768 }, { 1920, 1080 }, { 3840, 2160 } };
+const int readerCounts[] = { 1, 4 };		// broadcast readers against the one writer
+const int streamChannelCounts[] = { 8, 32, 64 };
+#define COUNT(a) (int)(sizeof(a) / sizeof(a[0]))
+
+struct Options {
+	double seconds;				// per case
+	bool quick;					// the smallest and largest of each sweep only
+	bool csv;
+	string stages;				// comma separated, empty for all
+	string directory;			// where the record stage writes
+	Options() : seconds(0.5), quick(false), csv(false) {}
+};
+
+struct Case {
+	const char *stage;
+	int channels;
+	double rate;
+	double historySeconds;		// 0 where it doesn't apply
+	int width, height;
+	int threads;
+	Case(const char *name, int numChannels, double sampleRate) : stage(name), channels(numChannels), rate(sampleRate),
+		historySeconds(0), width(0), height(0), threads(1) {}
+};
+
+// one timed iteration processes samples samples, the sum of its channels' samples
+class Workload {
+public:
+	virtual ~Workload() {}
+	virtual uint64_t iterate() = 0;
+	virtual void finish() {}					// after the last iteration, inside the timed run
+	virtual uint64_t dropped() const { return 0; }
+};
+
+// interleaved frames of a sine per channel with some noise, quantized like an ADC; blocks are handed out in turn
+class SyntheticSamples {
+public:
+	SyntheticSamples(int numChannels, double sampleRate, size_t framesPerBlock) : channels(numChannels), blockFrames(framesPerBlock), next(0) {
+		size_t totalFrames = SOURCE_BYTES / (sizeof(int16_t) * numChannels);
+		numBlocks = totalFrames / framesPerBlock;
+		if (numBlocks < 2) numBlocks = 2;
+		codes.resize(numBlocks * framesPerBlock * numChannels);
+		// a phasor per channel turned a step each frame, channel k at 50 * (k + 1) Hz
+		ChannelScaling scaling = ChannelScaling::linear(-10, 10);
+		vector<double> re(numChannels), im(numChannels), stepRe(numChannels), stepIm(numChannels);
+		for (int channel = 0; channel < numChannels; channel++) {
+			double step = 2 * 3.14159265358979 * 50.0 * (channel + 1) / sampleRate;
+			re[channel] = cos((double)channel);
+			im[channel] = sin((double)channel);
+			stepRe[channel] = cos(step);
+			stepIm[channel] = sin(step);
+		}
+		uint32_t seed = 12345;
+		int16_t *code = codes.data();
+		for (size_t frame = 0; frame < numBlocks * framesPerBlock; frame++) {
+			for (int channel = 0; channel < numChannels; channel++) {
+				seed = seed * 1664525u + 1013904223u;
+				double noise = ((seed >> 8) / 16777216.0 - 0.5) * 0.1;
+				*code++ = scaling.toCode(5 * im[channel] + noise);
+				double turned = re[channel] * stepRe[channel] - im[channel] * stepIm[channel];
+				im[channel] = re[channel] * stepIm[channel] + im[channel] * stepRe[channel];
+				re[channel] = turned;
+			}
+		}
+	}
+
+	const int16_t *block() {
+		const int16_t *frames = &codes[next * blockFrames * channels];
+		next = (next + 1) % numBlocks;
+		return frames;
+	}
+	size_t framesPerBlock() const { return blockFrames; }
+
+private:
+	int channels;
+	size_t blockFrames;
+	size_t numBlocks;
+	size_t next;
+	vector<int16_t> codes;
+};
+
+static size_t blockFrames(double rate, double milliseconds) {
+	size_t frames = (size_t)(rate * milliseconds / 1000);
+	return frames > 0 ? frames : 1;
+}
+
+// the reader thread's push and the display's drain in pops of 4096 frames, as daqRead() does
+class RingWorkload : public Workload {
+public:
+	RingWorkload(const Case &c) : samples(c.channels, c.rate, blockFrames(c.rate, BLOCK_MILLISECONDS)), channels(c.channels) {
+		ring.allocate(c.channels, samples.framesPerBlock() * 8);
+		out.resize(4096 * (size_t)c.channels);
+	}
+	uint64_t iterate() {
+		size_t pushed = ring.push(samples.block(), samples.framesPerBlock());
+		while (ring.pop(out.data(), 4096) > 0) {}
+		return (uint64_t)pushed * channels;
+	}
+private:
+	SyntheticSamples samples;
+	SampleRing<int16_t> ring;
+	vector<int16_t> out;
+	int channels;
+};
+
+class ScaleWorkload : public Workload {
+public:
+	ScaleWorkload(const Case &c) : samples(c.channels, c.rate, blockFrames(c.rate, BLOCK_MILLISECONDS)),
+		scaling(ChannelScaling::linear(-10, 10)), count(samples.framesPerBlock() * c.channels) {
+		volts.resize(count);
+	}
+	uint64_t iterate() {
+		scaleToVolts(samples.block(), count, scaling, volts.data());
+		return count;
+	}
+private:
+	SyntheticSamples samples;
+	ChannelScaling scaling;
+	size_t count;
+	vector<float> volts;
+};
+
+class HistoryWorkload : public Workload {
+public:
+	HistoryWorkload(const Case &c) : samples(c.channels, c.rate, blockFrames(c.rate, BLOCK_MILLISECONDS)), channels(c.channels) {
+		history.allocate(c.channels, (uint64_t)(c.rate * c.historySeconds), MEMORY_LIMIT, "");
+	}
+	uint64_t iterate() {
+		history.append(samples.block(), samples.framesPerBlock());
+		return (uint64_t)samples.framesPerBlock() * channels;
+	}
+private:
+	SyntheticSamples samples;
+	HistoryBuffer<int16_t> history;
+	int channels;
+};
+
+// peak-detect decimation of every channel's whole history to one min/max per column, what a full redraw reads
+class DecimateWorkload : public Workload {
+public:
+	DecimateWorkload(const Case &c) : channels(c.channels), columns(c.width) {
+		SyntheticSamples samples(c.channels, c.rate, blockFrames(c.rate, BLOCK_MILLISECONDS));
+		history.allocate(c.channels, (uint64_t)(c.rate * c.historySeconds), MEMORY_LIMIT, "");
+		while (history.written() < history.capacity()) {
+			history.append(samples.block(), samples.framesPerBlock());
+		}
+		columnMin.resize(columns);
+		columnMax.resize(columns);
+	}
+	uint64_t iterate() {
+		uint64_t first = history.oldest(), count = history.size();
+		for (int channel = 0; channel < channels; channel++) {
+			decimator.begin(count, columns, columnMin.data(), columnMax.data());
+			for (uint64_t index = first, left = count; left > 0;) {
+				const int16_t *run;
+				size_t n = history.span(channel, index, left, &run);
+				decimator.add(run, n);
+				index += n;
+				left -= n;
+			}
+			decimator.end();
+		}
+		return count * channels;
+	}
+private:
+	int channels;
+	int columns;
+	HistoryBuffer<int16_t> history;
+	PeakDecimator<int16_t> decimator;
+	vector<int16_t> columnMin, columnMax;
+};
+
+class FilterWorkload : public Workload {
+public:
+	FilterWorkload(const Case &c, int decimation) : samples(c.channels, c.rate, blockFrames(c.rate, BLOCK_MILLISECONDS)), channels(c.channels) {
+		// mains notch everywhere and a 4th order low-pass well inside the band, the common conditioning
+		char text[100];
+		snprintf(text, sizeof(text), "notch 60; lp %g/4", c.rate / 20);
+		vector<FilterSpec> filters;
+		string error;
+		parseFilterList(text, filters, error);
+		vector<ChannelScaling> scaling(c.channels, ChannelScaling::linear(-10, 10));
+		filterBank.configure(c.channels, c.rate, filters, decimation, scaling.data());
+		out.resize(samples.framesPerBlock() * c.channels);
+	}
+	uint64_t iterate() {
+		filterBank.process(samples.block(), samples.framesPerBlock(), out.data());
+		return (uint64_t)samples.framesPerBlock() * channels;
+	}
+private:
+	SyntheticSamples samples;
+	FilterBank filterBank;
+	vector<int16_t> out;
+	int channels;
+};
+
+// the trace layer of a window: every channel stacked, the history scrolling in a frame's worth of samples at a time,
+// or (full) redrawn from scratch every frame as after a resize or a layout change
+class RasterWorkload : public Workload {
+public:
+	RasterWorkload(const Case &c, bool full) : samples(c.channels, c.rate, blockFrames(c.rate, 1000.0 / FRAME_RATE)), channels(c.channels),
+		redraw(full) {
+		history.allocate(c.channels, (uint64_t)(c.rate * c.historySeconds), MEMORY_LIMIT, "");
+		while (history.written() < history.capacity()) {
+			history.append(samples.block(), samples.framesPerBlock());
+		}
+		layer.allocate(c.width, c.height);
+		pool.start(c.threads);
+		vector<int> order(c.channels);
+		vector<Pixel> colors(c.channels);
+		vector<ChannelScaling> scaling(c.channels, ChannelScaling::linear(-10, 10));
+		vector<float> low(c.channels, -10.f), high(c.channels, 10.f);
+		for (int channel = 0; channel < c.channels; channel++) {
+			order[channel] = channel;
+			colors[channel] = pixelRGB(0, 255, channel * 8 & 255);
+		}
+		view.setPool(&pool);
+		view.setArea(RasterRect(40, 0, c.width, c.height), -10, 10);
+		view.setChannels(order.data(), colors.data(), scaling.data(), c.channels, low.data(), high.data());
+		view.setLayout(TRACES_STACKED);
+		view.update(layer, history);
+	}
+	uint64_t iterate() {
+		history.append(samples.block(), samples.framesPerBlock());
+		if (redraw) view.invalidate();
+		view.update(layer, history);
+		return (redraw ? history.size() : samples.framesPerBlock()) * channels;
+	}
+private:
+	SyntheticSamples samples;
+	HistoryBuffer<int16_t> history;
+	Raster layer;
+	WorkerPool pool;
+	TraceView view;
+	int channels;
+	bool redraw;
+};
+
+// Recorder::consume() on the calling thread as the reader thread would, the blocks coming as fast as the writer
+// thread takes them: an iteration waits while the queue is more than half full, so the throughput is that of
+// packing (compressing, with compress) and writing the chunks, final flush included; frames still dropped mean
+// the wait was too coarse. The compression ratio goes to stderr.
+class RecordWorkload : public Workload {
+public:
+	RecordWorkload(const Case &c, const string &directory, bool compress) : samples(c.channels, c.rate, blockFrames(c.rate, BLOCK_MILLISECONDS)),
+		channels(c.channels), failed(false) {
+		path = (directory.empty() ? string(".") : directory) + "/benchmark.osc";
+		CaptureInfo info;
+		info.device = "Benchmark";
+		info.terminalConfigName = "Default";
+		info.numChannels = c.channels;
+		info.sampleRate = c.rate;
+		info.scaling.assign(c.channels, ChannelScaling::linear(-10, 10));
+		recorder.setCompression(compress);
+		if (!recorder.start(path, info, 1.0)) {
+			fprintf(stderr, "record: %s\n", recorder.errorString().c_str());
+			failed = true;
+		}
+	}
+	~RecordWorkload() {
+		recorder.stop();
+		remove(path.c_str());
+	}
+	uint64_t iterate() {
+		if (failed) return 0;
+		while (recorder.stats().queueFill > 0.5) {
+			this_thread::yield();
+		}
+		recorder.consume(samples.block(), samples.framesPerBlock());
+		return (uint64_t)samples.framesPerBlock() * channels;
+	}
+	void finish() {
+		recorder.stop();
+		if (!recorder.errorString().empty()) fprintf(stderr, "record: %s\n", recorder.errorString().c_str());
+		RecorderStats stats = recorder.stats();
+		if (recorder.compression()) {
+			fprintf(stderr, "record_packed: %d channels, ratio %.3f, packing %.0f MB/s\n", channels, stats.compressionRatio, stats.compressMBps);
+		}
+	}
+	uint64_t dropped() const { return recorder.stats().droppedFrames * channels; }
+private:
+	SyntheticSamples samples;
+	Recorder recorder;
+	string path;
+	int channels;
+	bool failed;
+};
+
+// unpackFrames() of one recorder chunk's worth (1 MB of samples) a time, what playback decodes per chunk on one core
+class UnpackWorkload : public Workload {
+public:
+	UnpackWorkload(const Case &c) : samples(c.channels, c.rate, (1 << 20) / (c.channels * sizeof(int16_t))), channels(c.channels), next(0),
+		failed(false) {
+		size_t numFrames = samples.framesPerBlock();
+		vector<uint8_t> buffer(packedFramesBound(numFrames, channels));
+		for (int i = 0; i < UNPACK_BLOCKS; i++) {
+			originals[i] = samples.block();
+			size_t bytes = packFrames(originals[i], numFrames, channels, buffer.data());
+			packed[i].assign(buffer.begin(), buffer.begin() + bytes);
+		}
+		frames.resize(numFrames * channels);
+	}
+	uint64_t iterate() {
+		if (failed) return 0;
+		const vector<uint8_t> &block = packed[next];
+		const int16_t *original = originals[next];
+		next = (next + 1) % UNPACK_BLOCKS;
+		// a codec that got lossy must not pass for a faster one
+		size_t numFrames = samples.framesPerBlock();
+		if (!unpackFrames(block.data(), block.size(), numFrames, channels, frames.data()) ||
+			memcmp(frames.data(), original, numFrames * channels * sizeof(int16_t)) != 0) {
+			fprintf(stderr, "unpack: a block did not decode to the frames that were packed\n");
+			failed = true;
+			return 0;
+		}
+		return (uint64_t)numFrames * channels;
+	}
+private:
+	SyntheticSamples samples;
+	int channels;
+	vector<uint8_t> packed[UNPACK_BLOCKS];
+	const int16_t *originals[UNPACK_BLOCKS];	// in samples
+	vector<int16_t> frames;
+	int next;
+	bool failed;
+};
+
+// one writer publishing blocks into the shared memory broadcast flat out, against threads readers on threads of
+// their own that each look at every frame in place, as separate processes would; dropped counts the samples the
+// readers lost to the writer lapping them
+class BroadcastWorkload : public Workload {
+public:
+	BroadcastWorkload(const Case &c) : samples(c.channels, c.rate, blockFrames(c.rate, BLOCK_MILLISECONDS)), channels(c.channels),
+		failed(false), keepReading(true), checksum(0) {
+		vector<ChannelScaling> scaling(c.channels, ChannelScaling::linear(-10, 10));
+		if (!broadcaster.open(BROADCAST_NAME, BROADCAST_MEGABYTES) || !broadcaster.configure("Benchmark", c.channels, c.rate, scaling.data())) {
+			fprintf(stderr, "broadcast: %s\n", broadcaster.errorString().c_str());
+			failed = true;
+			return;
+		}
+		lost.assign(c.threads, 0);
+		for (int i = 0; i < c.threads; i++) {
+			readers.push_back(thread(&BroadcastWorkload::read, this, i));
+		}
+	}
+	~BroadcastWorkload() {
+		finish();
+		broadcaster.close();
+	}
+	uint64_t iterate() {
+		if (failed) return 0;
+		broadcaster.consume(samples.block(), samples.framesPerBlock());
+		return (uint64_t)samples.framesPerBlock() * channels;
+	}
+	void finish() {
+		keepReading = false;
+		for (size_t i = 0; i < readers.size(); i++) {
+			readers[i].join();
+		}
+		readers.clear();
+	}
+	uint64_t dropped() const {
+		uint64_t frames = 0;
+		for (size_t i = 0; i < lost.size(); i++) frames += lost[i];
+		return frames * channels;
+	}
+private:
+	void read(int index) {
+		BroadcastReader reader;
+		if (!reader.open(BROADCAST_NAME)) {
+			fprintf(stderr, "broadcast: %s\n", reader.errorString().c_str());
+			return;
+		}
+		int64_t sum = 0;
+		while (keepReading) {
+			BroadcastView view;
+			if (reader.peek(view, 65536) == 0) {
+				this_thread::yield();
+				continue;
+			}
+			for (int part = 0; part < 2; part++) {
+				const int16_t *codes = view.frames[part];
+				for (size_t i = 0; i < view.numFrames[part] * channels; i++) sum += codes[i];
+			}
+			reader.release(view);
+		}
+		lost[index] = reader.lostFrames();
+		checksum += sum;  // keeps the loop from being optimized away
+	}
+
+	SyntheticSamples samples;
+	Broadcaster broadcaster;
+	vector<thread> readers;
+	vector<uint64_t> lost;
+	int channels;
+	bool failed;
+	atomic<bool> keepReading;
+	atomic<int64_t> checksum;
+};
+
+// StreamServer::consume() on the calling thread against one StreamClient on a thread of its own, connected over
+// 127.0.0.1 and decoding every block, as a remote viewer would. Flat out an iteration waits while more than a
+// quarter of the server's queue (less than a client's outgoing buffer) hasn't reached the client, so the
+// throughput is that of the whole way: batching, packing, the kernel's loopback and unpacking. With waitForClient
+// every iteration waits until the client has its block, so the percentiles are the sample-to-viewer latency, the
+// server's batching interval included.
+class StreamWorkload : public Workload {
+public:
+	StreamWorkload(const Case &c, int encoding, bool waitForClient) : samples(c.channels, c.rate, blockFrames(c.rate, BLOCK_MILLISECONDS)),
+		channels(c.channels), window((uint64_t)(c.rate * STREAM_QUEUE_SECONDS / 4)), waitEach(waitForClient), failed(false), keepReading(true),
+		consumed(0), received(0) {
+		if (!server.start(0, true)) {
+			fprintf(stderr, "stream: %s\n", server.errorString().c_str());
+			failed = true;
+			return;
+		}
+		StreamLayout layout;
+		layout.device = "Benchmark";
+		layout.sampleRate = c.rate;
+		StreamChannel channel;
+		ChannelScaling scaling = ChannelScaling::linear(-10, 10);
+		memcpy(channel.coefficients, scaling.coefficients, sizeof(channel.coefficients));
+		channel.minVoltage = -10;
+		channel.maxVoltage = 10;
+		layout.channels.assign(c.channels, channel);
+		server.configure(layout, STREAM_QUEUE_SECONDS);
+		if (!client.connect("127.0.0.1", server.port(), STREAM_TIMEOUT_SECONDS) || !client.subscribe(STREAM_MODE_BLOCKS, encoding, 0, 0)) {
+			fprintf(stderr, "stream: %s\n", client.errorString().c_str());
+			failed = true;
+			return;
+		}
+		reader = thread(&StreamWorkload::read, this);
+		// blocks before the server has the subscription go nowhere, so warm up until one arrives
+		Clock::time_point began = Clock::now();
+		while (received == 0 && Clock::now() - began < chrono::seconds(STREAM_TIMEOUT_SECONDS)) {
+			send();
+			this_thread::sleep_for(chrono::milliseconds(BLOCK_MILLISECONDS));
+		}
+		this_thread::sleep_for(chrono::milliseconds(10 * BLOCK_MILLISECONDS));  // the rest of the warm up blocks arrive
+		consumed = received.load();
+	}
+	~StreamWorkload() {
+		finish();
+		server.stop();
+	}
+	uint64_t iterate() {
+		if (failed) return 0;
+		while ((int64_t)(consumed - received) > (int64_t)window && !failed) {
+			this_thread::yield();
+		}
+		send();
+		while (waitEach && (int64_t)(consumed - received) > 0 && !failed) {
+			this_thread::yield();
+		}
+		return (uint64_t)samples.framesPerBlock() * channels;
+	}
+	void finish() {
+		keepReading = false;
+		if (reader.joinable()) reader.join();
+	}
+	uint64_t dropped() const {
+		StreamServerStats stats = server.stats();
+		return (stats.droppedFrames + stats.queueDropped) * channels;
+	}
+private:
+	void send() {
+		server.consume(samples.block(), samples.framesPerBlock());
+		consumed += samples.framesPerBlock();
+	}
+	void read() {
+		while (keepReading) {
+			int type = client.receive(0.01);
+			if (type == STREAM_BLOCK) {
+				received += client.numFrames() + client.blockHeader().droppedFrames;
+			}
+			else if (type < 0) {
+				fprintf(stderr, "stream: %s\n", client.errorString().c_str());
+				failed = true;
+				return;
+			}
+		}
+	}
+
+	SyntheticSamples samples;
+	StreamServer server;
+	StreamClient client;
+	thread reader;
+	int channels;
+	uint64_t window;			// frames in flight at most
+	bool waitEach;
+	atomic<bool> failed;
+	atomic<bool> keepReading;
+	uint64_t consumed;
+	atomic<uint64_t> received;	// frames the client got or was told were skipped
+};
+
+struct Result {
+	uint64_t iterations;
+	uint64_t samples;
+	uint64_t dropped;
+	double seconds;
+	double p50, p90, p99, maximum;	// microseconds per iteration
+};
+
+static double percentile(const vector<double> &sorted, double fraction) {
+	size_t index = (size_t)(fraction * (sorted.size() - 1) + 0.5);
+	return sorted[index];
+}
+
+static Result measure(Workload &work, double seconds) {
+	vector<double> times;
+	times.reserve(MAX_ITERATIONS);
+	work.iterate();  // warm up caches, the pool's threads and the writer
+	Result result;
+	result.samples = 0;
+	Clock::time_point began = Clock::now(), last = began;
+	while (times.size() < MAX_ITERATIONS && (times.size() < MIN_ITERATIONS || chrono::duration<double>(last - began).count() < seconds)) {
+		result.samples += work.iterate();
+		Clock::time_point now = Clock::now();
+		times.push_back(chrono::duration<double, micro>(now - last).count());
+		last = now;
+	}
+	work.finish();
+	result.seconds = chrono::duration<double>(Clock::now() - began).count();
+	result.iterations = times.size();
+	result.dropped = work.dropped();
+	sort(times.begin(), times.end());
+	result.p50 = percentile(times, 0.5);
+	result.p90 = percentile(times, 0.9);
+	result.p99 = percentile(times, 0.99);
+	result.maximum = times.back();
+	return result;
+}
+
+static const char *simdName() {
+#ifdef SCOPE_SSE2
+	return "sse2";
+#else
+	return "scalar";
+#endif
+}
+
+static void report(const Options &options, const Case &c, const Result &r) {
+	static bool headerDone = false;
+	double rate = r.seconds > 0 ? r.samples / r.seconds : 0;
+	if (options.csv) {
+		if (!headerDone) {
+			printf("stage,simd,channels,rate,history_s,width,height,threads,iterations,samples,dropped,seconds,samples_per_s,p50_us,p90_us,p99_us,max_us\n");
+			headerDone = true;
+		}
+		printf("%s,%s,%d,%g,%g,%d,%d,%d,%llu,%llu,%llu,%.6f,%.6g,%.3f,%.3f,%.3f,%.3f\n", c.stage, simdName(), c.channels, c.rate, c.historySeconds,
+			c.width, c.height, c.threads, (unsigned long long)r.iterations, (unsigned long long)r.samples, (unsigned long long)r.dropped,
+			r.seconds, rate, r.p50, r.p90, r.p99, r.maximum);
+	}
+	else {
+		printf("{\"stage\":\"%s\",\"simd\":\"%s\",\"channels\":%d,\"rate\":%g,\"history_s\":%g,\"width\":%d,\"height\":%d,\"threads\":%d,"
+			"\"iterations\":%llu,\"samples\":%llu,\"dropped\":%llu,\"seconds\":%.6f,\"samples_per_s\":%.6g,"
+			"\"p50_us\":%.3f,\"p90_us\":%.3f,\"p99_us\":%.3f,\"max_us\":%.3f}\n", c.stage, simdName(), c.channels, c.rate, c.historySeconds,
+			c.width, c.height, c.threads, (unsigned long long)r.iterations, (unsigned long long)r.samples, (unsigned long long)r.dropped,
+			r.seconds, rate, r.p50, r.p90, r.p99, r.maximum);
+	}
+	fflush(stdout);
+}
+
+static bool wanted(const Options &options, const char *stage) {
+	if (options.stages.empty()) return true;
+	string list = "," + options.stages + ",";
+	return list.find("," + string(stage) + ",") != string::npos;
+}
+
+// the sweep values a case runs with: all of them, or the ends for --quick
+static bool inSweep(const Options &options, int index, int count) {
+	return !options.quick || index == 0 || index == count - 1;
+}
+
+static void run(const Options &options, Case c, Workload *work) {
+	Result result = measure(*work, options.seconds);
+	delete work;
+	report(options, c, result);
+}
+
+static void runAll(const Options &options) {
+	int cores = (int)thread::hardware_concurrency();
+	if (cores < 1) cores = 1;
+	for (int ci = 0; ci < COUNT(channelCounts); ci++) {
+		if (!inSweep(options, ci, COUNT(channelCounts))) continue;
+		for (int ri = 0; ri < COUNT(sampleRates); ri++) {
+			if (!inSweep(options, ri, COUNT(sampleRates))) continue;
+			Case c("", channelCounts[ci], sampleRates[ri]);
+
+			if (wanted(options, "ring")) { c.stage = "ring"; run(options, c, new RingWorkload(c)); }
+			if (wanted(options, "scale")) { c.stage = "scale"; run(options, c, new ScaleWorkload(c)); }
+			if (wanted(options, "filter")) { c.stage = "filter"; run(options, c, new FilterWorkload(c, 1)); }
+			if (wanted(options, "filter_decimate")) { c.stage = "filter_decimate"; run(options, c, new FilterWorkload(c, 4)); }
+			if (wanted(options, "record")) { c.stage = "record"; run(options, c, new RecordWorkload(c, options.directory, false)); }
+			if (wanted(options, "record_packed")) { c.stage = "record_packed"; run(options, c, new RecordWorkload(c, options.directory, true)); }
+			if (wanted(options, "unpack")) { c.stage = "unpack"; run(options, c, new UnpackWorkload(c)); }
+			for (int ni = 0; ni < COUNT(readerCounts); ni++) {
+				c.threads = readerCounts[ni];
+				if (wanted(options, "broadcast")) { c.stage = "broadcast"; run(options, c, new BroadcastWorkload(c)); }
+			}
+			c.threads = 1;
+
+			for (int hi = 0; hi < COUNT(historyDepths); hi++) {
+				if (!inSweep(options, hi, COUNT(historyDepths))) continue;
+				c.historySeconds = historyDepths[hi];
+				if ((double)c.channels * c.rate * c.historySeconds * sizeof(int16_t) > MEMORY_LIMIT) continue;
+
+				if (wanted(options, "history")) { c.stage = "history"; run(options, c, new HistoryWorkload(c)); }
+				for (int wi = 0; wi < COUNT(windowSizes); wi++) {
+					if (!inSweep(options, wi, COUNT(windowSizes))) continue;
+					c.width = windowSizes[wi][0];
+					c.height = windowSizes[wi][1];
+					if (wanted(options, "decimate")) { c.stage = "decimate"; run(options, c, new DecimateWorkload(c)); }
+					for (int threads = 1; threads <= cores; threads = threads < cores ? cores : cores + 1) {
+						c.threads = threads;
+						if (wanted(options, "raster")) { c.stage = "raster"; run(options, c, new RasterWorkload(c, false)); }
+						if (wanted(options, "raster_full")) { c.stage = "raster_full"; run(options, c, new RasterWorkload(c, true)); }
+					}
+					c.threads = 1;
+				}
+				c.width = c.height = 0;
+			}
+			c.historySeconds = 0;
+		}
+	}
+
+	// the stream server against a viewer on the loopback, at the channel counts of remote viewing
+	for (int ci = 0; ci < COUNT(streamChannelCounts); ci++) {
+		for (int ri = 0; ri < COUNT(sampleRates); ri++) {
+			if (!inSweep(options, ri, COUNT(sampleRates))) continue;
+			Case c("", streamChannelCounts[ci], sampleRates[ri]);
+			if (wanted(options, "stream")) { c.stage = "stream"; run(options, c, new StreamWorkload(c, STREAM_ENCODING_RAW, false)); }
+			if (wanted(options, "stream_packed")) { c.stage = "stream_packed"; run(options, c, new StreamWorkload(c, STREAM_ENCODING_PACKED, false)); }
+			if (wanted(options, "stream_latency")) { c.stage = "stream_latency"; run(options, c, new StreamWorkload(c, STREAM_ENCODING_PACKED, true)); }
+		}
+	}
+}
+
+// --compare: the value of key in a JSON line we wrote, or the empty string
+static string field(const string &line, const char *key) {
+	string quoted = string("\"") + key + "\":";
+	size_t at = line.find(quoted);
+	if (at == string::npos) return "";
+	at += quoted.size();
+	size_t end = line.find_first_of(",}", at);
+	string value = line.substr(at, end == string::npos ? string::npos : end - at);
+	if (value.size() >= 2 && value[0] == '"') value = value.substr(1, value.size() - 2);
+	return value;
+}
+
+static string caseKey(const string &line) {
+	return field(line, "stage") + " ch " + field(line, "channels") + " rate " + field(line, "rate") + " history " + field(line, "history_s") +
+		" window " + field(line, "width") + "x" + field(line, "height") + " threads " + field(line, "threads");
+}
+
+static bool readLines(const string &path, vector<string> &lines) {
+	BinaryFile file;
+	if (!file.openRead(path)) {
+		fprintf(stderr, "%s\n", file.errorString().c_str());
+		return false;
+	}
+	string text((size_t)file.size(), '\0');
+	if (!text.empty() && !file.readAt(0, &text[0], text.size())) {
+		fprintf(stderr, "%s\n", file.errorString().c_str());
+		return false;
+	}
+	size_t begin = 0;
+	while (begin < text.size()) {
+		size_t end = text.find('\n', begin);
+		if (end == string::npos) end = text.size();
+		if (text.compare(begin, 1, "{") == 0) lines.push_back(text.substr(begin, end - begin));
+		begin = end + 1;
+	}
+	return true;
+}
+
+// a case regresses when its throughput dropped or its p90 latency grew by more than tolerance (p99 and the maximum
+// are left out, on a desktop they mostly measure the scheduler); returns the number of regressions
+static int compare(const string &baselinePath, const string &candidatePath, double tolerance) {
+	vector<string> baseline, candidate;
+	if (!readLines(baselinePath, baseline) || !readLines(candidatePath, candidate)) return -1;
+	int regressions = 0, compared = 0;
+	for (size_t i = 0; i < candidate.size(); i++) {
+		string key = caseKey(candidate[i]);
+		for (size_t j = 0; j < baseline.size(); j++) {
+			if (caseKey(baseline[j]) != key) continue;
+			double oldRate = atof(field(baseline[j], "samples_per_s").c_str()), newRate = atof(field(candidate[i], "samples_per_s").c_str());
+			double oldP90 = atof(field(baseline[j], "p90_us").c_str()), newP90 = atof(field(candidate[i], "p90_us").c_str());
+			bool slower = newRate < oldRate * (1 - tolerance);
+			bool laggier = newP90 > oldP90 * (1 + tolerance);
+			printf("%s %s: %.4g -> %.4g samples/s (%+.1f%%), p90 %.1f -> %.1f us\n", slower || laggier ? "REGRESSED" : "ok       ", key.c_str(),
+				oldRate, newRate, oldRate > 0 ? (newRate / oldRate - 1) * 100 : 0, oldP90, newP90);
+			if (slower || laggier) regressions++;
+			compared++;
+			break;
+		}
+	}
+	printf("%d of %d cases regressed by more than %g%%\n", regressions, compared, tolerance * 100);
+	return regressions;
+}
+
+// --check: reference images, drawn one pixel at a time by the rules Raster.h documents
+class ReferenceImage {
+public:
+	ReferenceImage(int width, int height, Pixel background) : w(width), h(height), pixels((size_t)width * height, background) {
+		setClip(0, 0, width, height);
+	}
+	void setClip(int left, int top, int right, int bottom) { clipX0 = left; clipY0 = top; clipX1 = right; clipY1 = bottom; }
+	void plot(int x, int y, Pixel color) {
+		if (x >= clipX0 && x < clipX1 && y >= clipY0 && y < clipY1) pixels[(size_t)y * w + x] = color;
+	}
+	void column(int x, int y0, int y1, Pixel color) {
+		if (y1 < y0) swap(y0, y1);
+		for (int y = y0; y <= y1; y++) plot(x, y, color);
+	}
+	// plain Bresenham, for lines that lie inside the clip
+	void line(int x0, int y0, int x1, int y1, Pixel color) {
+		int dx = abs(x1 - x0), dy = -abs(y1 - y0), stepX = x0 < x1 ? 1 : -1, stepY = y0 < y1 ? 1 : -1, error = dx + dy;
+		for (;;) {
+			plot(x0, y0, color);
+			if (x0 == x1 && y0 == y1) break;
+			int e2 = 2 * error;
+			if (e2 >= dy) { error += dy; x0 += stepX; }
+			if (e2 <= dx) { error += dx; y0 += stepY; }
+		}
+	}
+	Pixel at(int x, int y) const { return pixels[(size_t)y * w + x]; }
+	void set(int x, int y, Pixel color) { pixels[(size_t)y * w + x] = color; }
+
+	int w, h;
+private:
+	vector<Pixel> pixels;
+	int clipX0, clipY0, clipX1, clipY1;
+};
+
+static uint32_t checkRandom(uint32_t &seed) {
+	seed = seed * 1664525u + 1013904223u;
+	return seed >> 8;
+}
+
+// the raster against the reference, every pixel; prints the first difference
+static bool sameImage(const char *name, const Raster &raster, const ReferenceImage &expected) {
+	int differ = 0, firstX = 0, firstY = 0;
+	for (int y = 0; y < expected.h; y++) {
+		for (int x = 0; x < expected.w; x++) {
+			if (raster.row(y)[x] == expected.at(x, y)) continue;
+			if (differ++ == 0) { firstX = x; firstY = y; }
+		}
+	}
+	if (differ == 0) printf("ok        %s\n", name);
+	else printf("DIFFERENT %s: %d pixels, the first at (%d, %d) is %08X instead of %08X\n", name, differ, firstX, firstY,
+		raster.row(firstY)[firstX], expected.at(firstX, firstY));
+	return differ == 0;
+}
+
+// the sizes are odd so that rows are padded and vector loops end in scalar tails
+#define CHECK_WIDTH 203
+#define CHECK_HEIGHT 97
+
+static bool checkRaster() {
+	Pixel background = pixelRGB(10, 20, 30), trace = pixelRGB(0, 255, 0);
+	uint32_t seed = 4321;
+	bool ok = true;
+	Raster raster;
+	if (!raster.allocate(CHECK_WIDTH, CHECK_HEIGHT)) {
+		printf("could not allocate the check raster\n");
+		return false;
+	}
+
+	// polyline: a random walk with steps of 0 to 3 columns, so both the span and the line paths are taken
+	{
+		ReferenceImage expected(CHECK_WIDTH, CHECK_HEIGHT, background);
+		vector<int> x, y;
+		for (int px = 2, py = CHECK_HEIGHT / 2; px < CHECK_WIDTH - 2; px += checkRandom(seed) % 4) {
+			py += (int)(checkRandom(seed) % 41) - 20;
+			py = py < 0 ? 0 : (py >= CHECK_HEIGHT ? CHECK_HEIGHT - 1 : py);
+			x.push_back(px);
+			y.push_back(py);
+		}
+		raster.resetClip();
+		raster.fill(background);
+		raster.polyline(x.data(), y.data(), x.size(), trace);
+		for (size_t i = 1; i < x.size(); i++) {
+			if (x[i] == x[i - 1] + 1 || x[i] == x[i - 1]) expected.column(x[i], y[i - 1], y[i], trace);
+			else expected.line(x[i - 1], y[i - 1], x[i], y[i], trace);
+		}
+		ok &= sameImage("polyline", raster, expected);
+	}
+
+	// columnSpans: a sparse and a dense envelope (the column and the row order), some spans upside down or off the
+	// raster, under a clip with unaligned edges
+	for (int dense = 0; dense < 2; dense++) {
+		ReferenceImage expected(CHECK_WIDTH, CHECK_HEIGHT, background);
+		size_t count = CHECK_WIDTH + 20;
+		vector<int> top(count), bottom(count);
+		for (size_t i = 0; i < count; i++) {
+			int middle = (int)(checkRandom(seed) % (CHECK_HEIGHT + 20)) - 10;
+			int reach = dense ? (int)(checkRandom(seed) % CHECK_HEIGHT) : (int)(checkRandom(seed) % 4);
+			top[i] = middle - reach;
+			bottom[i] = middle + reach;
+			if (checkRandom(seed) % 8 == 0) swap(top[i], bottom[i]);
+		}
+		raster.resetClip();
+		raster.fill(background);
+		raster.setClip(3, 5, CHECK_WIDTH - 6, CHECK_HEIGHT - 2);
+		expected.setClip(3, 5, CHECK_WIDTH - 6, CHECK_HEIGHT - 2);
+		raster.columnSpans(-10, top.data(), bottom.data(), count, trace);
+		for (size_t i = 0; i < count; i++) {
+			expected.column(-10 + (int)i, top[i], bottom[i], trace);
+		}
+		ok &= sameImage(dense ? "columnSpans dense" : "columnSpans sparse", raster, expected);
+	}
+
+	// dots, some of them off the raster
+	{
+		ReferenceImage expected(CHECK_WIDTH, CHECK_HEIGHT, background);
+		vector<int> x(2000), y(2000);
+		for (size_t i = 0; i < x.size(); i++) {
+			x[i] = (int)(checkRandom(seed) % (CHECK_WIDTH + 10)) - 5;
+			y[i] = (int)(checkRandom(seed) % (CHECK_HEIGHT + 10)) - 5;
+		}
+		raster.resetClip();
+		raster.fill(background);
+		raster.dots(x.data(), y.data(), x.size(), trace);
+		for (size_t i = 0; i < x.size(); i++) {
+			expected.plot(x[i], y[i], trace);
+		}
+		ok &= sameImage("dots", raster, expected);
+	}
+
+	// composite: a layer of transparent, opaque and partly transparent pixels over an unaligned rectangle; any
+	// nonzero alpha replaces the pixel under it
+	{
+		ReferenceImage expected(CHECK_WIDTH, CHECK_HEIGHT, background);
+		Raster layer;
+		layer.allocate(CHECK_WIDTH, CHECK_HEIGHT);
+		const Pixel alphas[] = { 0, 0, 0, 0xFF000000u, 0x80000000u, 0x01000000u };
+		for (int y = 0; y < CHECK_HEIGHT; y++) {
+			for (int x = 0; x < CHECK_WIDTH; x++) {
+				layer.row(y)[x] = alphas[checkRandom(seed) % 6] | (checkRandom(seed) & 0xFFFFFF);
+			}
+		}
+		raster.resetClip();
+		raster.fill(background);
+		raster.composite(layer, 1, 2, CHECK_WIDTH - 3, CHECK_HEIGHT - 1);
+		for (int y = 2; y < CHECK_HEIGHT - 1; y++) {
+			for (int x = 1; x < CHECK_WIDTH - 3; x++) {
+				if (layer.row(y)[x] & 0xFF000000u) expected.set(x, y, layer.row(y)[x]);
+			}
+		}
+		ok &= sameImage("composite", raster, expected);
+	}
+	return ok;
+}
+
+#define CODEC_SHAPES 4
+const char *codecShapes[CODEC_SHAPES] = { "sine", "noise", "square", "full scale" };
+const int codecChannelCounts[] = { 1, 3, 8, 33 };
+const size_t codecFrameCounts[] = { 1, 2, 127, 128, 129, 1000, 4097 };	// whole and partial SAMPLE_CODEC_GROUPs
+
+// frames of one shape, each channel at its own frequency or phase
+static void codecSignal(int shape, int channels, size_t numFrames, uint32_t &seed, vector<int16_t> &frames) {
+	frames.resize(numFrames * channels);
+	for (size_t frame = 0; frame < numFrames; frame++) {
+		for (int channel = 0; channel < channels; channel++) {
+			int16_t &code = frames[frame * channels + channel];
+			switch (shape) {
+			case 0:	// a sine with a little ADC noise
+				code = (int16_t)(20000 * sin(0.01 * (channel + 1) * frame + channel) + (int)(checkRandom(seed) % 9) - 4);
+				break;
+			case 1:	// every code equally likely
+				code = (int16_t)(checkRandom(seed) & 0xFFFF);
+				break;
+			case 2:
+				code = ((frame + channel * 7) / 50) % 2 ? 16000 : -16000;
+				break;
+			default:	// the largest step there is, every frame
+				code = (frame + channel) % 2 ? 32767 : -32768;
+				break;
+			}
+		}
+	}
+}
+
+// packFrames() then unpackFrames() must give back every frame bit for bit
+static bool checkCodec() {
+	uint32_t seed = 8765;
+	bool ok = true;
+	vector<int16_t> frames, unpacked;
+	vector<uint8_t> packed;
+	for (int shape = 0; shape < CODEC_SHAPES; shape++) {
+		int failures = 0;
+		for (int c = 0; c < COUNT(codecChannelCounts); c++) {
+			for (int f = 0; f < COUNT(codecFrameCounts); f++) {
+				int channels = codecChannelCounts[c];
+				size_t numFrames = codecFrameCounts[f];
+				codecSignal(shape, channels, numFrames, seed, frames);
+				packed.assign(packedFramesBound(numFrames, channels), 0);
+				unpacked.assign(frames.size(), 0);
+				size_t bytes = packFrames(frames.data(), numFrames, channels, packed.data());
+				bool same = bytes <= packed.size() && unpackFrames(packed.data(), bytes, numFrames, channels, unpacked.data()) &&
+					memcmp(frames.data(), unpacked.data(), frames.size() * sizeof(int16_t)) == 0;
+				if (!same && failures++ == 0) {
+					printf("DIFFERENT codec %s: %d channels x %zu frames did not come back as packed\n", codecShapes[shape], channels, numFrames);
+				}
+			}
+		}
+		if (failures == 0) printf("ok        codec %s\n", codecShapes[shape]);
+		ok &= failures == 0;
+	}
+	return ok;
+}
+
+static void usage() {
+	fprintf(stderr,
+		"usage: Benchmark [--quick] [--seconds S] [--csv] [--stages LIST] [--dir PATH]\n"
+		"       Benchmark --compare BASELINE CANDIDATE [--tolerance T]\n"
+		"       Benchmark --check\n"
+		"stages: ring, scale, filter, filter_decimate, record, record_packed, unpack, broadcast, history, decimate, raster,\n"
+		"        raster_full, stream, stream_packed, stream_latency\n");
+}
+
+int main(int argc, char **argv) {
+	Options options;
+	string baseline, candidate;
+	double tolerance = DEFAULT_TOLERANCE;
+	bool check = false;
+	for (int i = 1; i < argc; i++) {
+		string arg = argv[i];
+		bool hasValue = i + 1 < argc;
+		if (arg == "--quick") options.quick = true;
+		else if (arg == "--check") check = true;
+		else if (arg == "--csv") options.csv = true;
+		else if (arg == "--seconds" && hasValue) options.seconds = atof(argv[++i]);
+		else if (arg == "--stages" && hasValue) options.stages = argv[++i];
+		else if (arg == "--dir" && hasValue) options.directory = argv[++i];
+		else if (arg == "--tolerance" && hasValue) tolerance = atof(argv[++i]);
+		else if (arg == "--compare" && i + 2 < argc) {
+			baseline = argv[++i];
+			candidate = argv[++i];
+		}
+		else {
+			usage();
+			return 2;
+		}
+	}
+
+	if (check) {
+		bool ok = checkRaster();
+		ok &= checkCodec();
+		return ok ? 0 : 1;
+	}
+	if (!baseline.empty()) {
+		int regressions = compare(baseline, candidate, tolerance);
+		return regressions < 0 ? 2 : (regressions > 0 ? 1 : 0);
+	}
+	runAll(options);
+	return 0;
+}
@@ -0,0 +1,184 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2023  Neuro Software Developers, Inc.
+//
+// Contact Information:
+//
+// Email:
+// info@neurosoftware.com
+//
+// Website:
+// www.neurosoftware.com
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "BinaryFile.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#include <malloc.h>
+#else
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#endif
+
+using namespace std;
+
+BinaryFile::BinaryFile() {
+#ifdef _WIN32
+	handle = INVALID_HANDLE_VALUE;
+#else
+	descriptor = -1;
+#endif
+}
+
+BinaryFile::~BinaryFile() {
+	close();
+}
+
+bool BinaryFile::fail(const string &what) {
+#ifdef _WIN32
+	error = what + " " + path + " (error " + to_string((unsigned long long)GetLastError()) + ")";
+#else
+	error = what + " " + path + " (" + strerror(errno) + ")";
+#endif
+	return false;
+}
+
+bool BinaryFile::isOpen() const {
+#ifdef _WIN32
+	return handle != INVALID_HANDLE_VALUE;
+#else
+	return descriptor >= 0;
+#endif
+}
+
+bool BinaryFile::create(const string &filePath, bool unbuffered) {
+	close();
+	path = filePath;
+#ifdef _WIN32
+	DWORD flags = FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN;
+	if (unbuffered) flags |= FILE_FLAG_NO_BUFFERING;
+	handle = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, NULL, CREATE_ALWAYS, flags, NULL);
+#else
+	(void)unbuffered;  // the page cache is fine here, O_DIRECT support depends on the file system
+	descriptor = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+#endif
+	return isOpen() ? true : fail("Could not create");
+}
+
+bool BinaryFile::openRead(const string &filePath) {
+	close();
+	path = filePath;
+#ifdef _WIN32
+	handle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+#else
+	descriptor = open(path.c_str(), O_RDONLY);
+#endif
+	return isOpen() ? true : fail("Could not open");
+}
+
+void BinaryFile::close() {
+#ifdef _WIN32
+	if (handle != INVALID_HANDLE_VALUE) CloseHandle(handle);
+	handle = INVALID_HANDLE_VALUE;
+#else
+	if (descriptor >= 0) ::close(descriptor);
+	descriptor = -1;
+#endif
+}
+
+bool BinaryFile::writeAt(uint64_t offset, const void *data, size_t bytes) {
+	const char *p = (const char *)data;
+	while (bytes > 0) {
+#ifdef _WIN32
+		OVERLAPPED overlapped = {};
+		overlapped.Offset = (DWORD)offset;
+		overlapped.OffsetHigh = (DWORD)(offset >> 32);
+		DWORD n = 0;
+		DWORD request = bytes > 0x40000000 ? 0x40000000 : (DWORD)bytes;
+		if (!WriteFile(handle, p, request, &n, &overlapped) || n == 0) return fail("Could not write");
+#else
+		ssize_t n = pwrite(descriptor, p, bytes, (off_t)offset);
+		if (n <= 0) {
+			if (n < 0 && errno == EINTR) continue;
+			return fail("Could not write");
+		}
+#endif
+		p += n;
+		bytes -= n;
+		offset += n;
+	}
+	return true;
+}
+
+bool BinaryFile::readAt(uint64_t offset, void *data, size_t bytes) {
+	char *p = (char *)data;
+	while (bytes > 0) {
+#ifdef _WIN32
+		OVERLAPPED overlapped = {};
+		overlapped.Offset = (DWORD)offset;
+		overlapped.OffsetHigh = (DWORD)(offset >> 32);
+		DWORD n = 0;
+		DWORD request = bytes > 0x40000000 ? 0x40000000 : (DWORD)bytes;
+		if (!ReadFile(handle, p, request, &n, &overlapped) || n == 0) return fail("Could not read");
+#else
+		ssize_t n = pread(descriptor, p, bytes, (off_t)offset);
+		if (n <= 0) {
+			if (n < 0 && errno == EINTR) continue;
+			return fail("Could not read");
+		}
+#endif
+		p += n;
+		bytes -= n;
+		offset += n;
+	}
+	return true;
+}
+
+uint64_t BinaryFile::size() {
+#ifdef _WIN32
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(handle, &size)) return 0;
+	return (uint64_t)size.QuadPart;
+#else
+	struct stat info;
+	if (fstat(descriptor, &info) != 0) return 0;
+	return (uint64_t)info.st_size;
+#endif
+}
+
+bool BinaryFile::truncate(uint64_t bytes) {
+#ifdef _WIN32
+	LARGE_INTEGER position;
+	position.QuadPart = (LONGLONG)bytes;
+	if (!SetFilePointerEx(handle, position, NULL, FILE_BEGIN) || !SetEndOfFile(handle)) return fail("Could not resize");
+	return true;
+#else
+	return ftruncate(descriptor, (off_t)bytes) == 0 ? true : fail("Could not resize");
+#endif
+}
+
+void *BinaryFile::allocateAligned(size_t bytes) {
+#ifdef _WIN32
+	return _aligned_malloc(bytes, FILE_ALIGNMENT);
+#else
+	void *data = NULL;
+	if (posix_memalign(&data, FILE_ALIGNMENT, bytes) != 0) return NULL;
+	return data;
+#endif
+}
+
+void BinaryFile::freeAligned(void *data) {
+#ifdef _WIN32
+	_aligned_free(data);
+#else
+	free(data);
+#endif
+}
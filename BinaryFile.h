@@ -0,0 +1,59 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2023  Neuro Software Developers, Inc.
+//
+// Contact Information:
+//
+// Email:
+// info@neurosoftware.com
+//
+// Website:
+// www.neurosoftware.com
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <string>
+#include <stdint.h>
+#include <stddef.h>
+
+#define FILE_ALIGNMENT 4096		// sector/page multiple for unbuffered writes
+
+// Thin positional file I/O wrapper over CreateFile / open. With unbuffered set, writes bypass the OS cache
+// (FILE_FLAG_NO_BUFFERING on Windows), so every write must be FILE_ALIGNMENT aligned in offset, size and
+// memory; use allocateAligned() for the buffers.
+class BinaryFile {
+public:
+	BinaryFile();
+	~BinaryFile();
+
+	bool create(const std::string &path, bool unbuffered);
+	bool openRead(const std::string &path);
+	void close();
+	bool isOpen() const;
+
+	bool writeAt(uint64_t offset, const void *data, size_t bytes);
+	bool readAt(uint64_t offset, void *data, size_t bytes);
+	uint64_t size();
+	bool truncate(uint64_t bytes);
+
+	const std::string &errorString() const { return error; }
+
+	static void *allocateAligned(size_t bytes);
+	static void freeAligned(void *data);
+
+private:
+	BinaryFile(const BinaryFile &);
+	BinaryFile &operator=(const BinaryFile &);
+
+	bool fail(const std::string &what);
+
+	std::string path;
+	std::string error;
+#ifdef _WIN32
+	void *handle;
+#else
+	int descriptor;
+#endif
+};
@@ -0,0 +1,153 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2023  Neuro Software Developers, Inc.
+//
+// Contact Information:
+//
+// Email:
+// info@neurosoftware.com
+//
+// Website:
+// www.neurosoftware.com
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Example consumer of the scope's live sample broadcast: follows the samples the scope (or Acquire --broadcast)
+// is acquiring, in place in the shared memory, and prints each channel's minimum, maximum and RMS in volts once a
+// second, with how many frames it got and lost. Start as many as you like next to the scope.
+//
+//   BroadcastConsumer [--name OscilloscopeSamples] [--seconds S] [--channels N] [--delay MS]
+//
+// --delay takes that long over every block it looks at, to play a reader too slow to keep up and show the overruns.
+
+#include <string>
+#include <vector>
+#include <chrono>
+#include <thread>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "BroadcastReader.h"
+
+using namespace std;
+
+#define POLL_MILLISECONDS 5
+#define FRAMES_PER_PEEK 65536
+
+struct ChannelStats {
+	int minimum;
+	int maximum;
+	double sum;
+	double sumSquares;
+
+	ChannelStats() : minimum(32767), maximum(-32768), sum(0), sumSquares(0) {}
+};
+
+static void accumulate(const int16_t *frames, size_t numFrames, int channels, int shown, vector<ChannelStats> &stats) {
+	for (size_t frame = 0; frame < numFrames; frame++) {
+		const int16_t *codes = frames + frame * channels;
+		for (int channel = 0; channel < shown; channel++) {
+			int code = codes[channel];
+			ChannelStats &s = stats[channel];
+			if (code < s.minimum) s.minimum = code;
+			if (code > s.maximum) s.maximum = code;
+			s.sum += code;
+			s.sumSquares += (double)code * code;
+		}
+	}
+}
+
+int main(int argc, char **argv) {
+	string name = BROADCAST_DEFAULT_NAME;
+	double seconds = 0;
+	int maxChannels = 8;
+	int delay = 0;
+	for (int i = 1; i < argc; i++) {
+		string arg = argv[i];
+		if (i + 1 >= argc) {
+			fprintf(stderr, "usage: BroadcastConsumer [--name NAME] [--seconds S] [--channels N] [--delay MS]\n");
+			return 2;
+		}
+		if (arg == "--name") name = argv[++i];
+		else if (arg == "--seconds") seconds = atof(argv[++i]);
+		else if (arg == "--channels") maxChannels = atoi(argv[++i]);
+		else if (arg == "--delay") delay = atoi(argv[++i]);
+		else {
+			fprintf(stderr, "unknown option %s\n", arg.c_str());
+			return 2;
+		}
+	}
+
+	BroadcastReader reader;
+	chrono::steady_clock::time_point began = chrono::steady_clock::now();
+	chrono::steady_clock::time_point reported = began;
+	vector<ChannelStats> stats;
+	uint64_t reportedFrames = 0, reportedLost = 0;
+	bool waiting = false;
+
+	while (seconds <= 0 || chrono::duration<double>(chrono::steady_clock::now() - began).count() < seconds) {
+		// the scope may not be running yet, or may have closed its broadcast and opened a new one
+		if (!reader.isOpen() || reader.state() == BROADCAST_CLOSED) {
+			if (!reader.open(name)) {
+				if (!waiting) printf("waiting for %s: %s\n", name.c_str(), reader.errorString().c_str());
+				waiting = true;
+				this_thread::sleep_for(chrono::milliseconds(500));
+				continue;
+			}
+			waiting = false;
+		}
+		if (reader.layoutChanged()) {
+			printf("%s: %d channels at %g Hz\n", reader.device().c_str(), reader.numChannels(), reader.sampleRate());
+			stats.assign(reader.numChannels(), ChannelStats());
+			reportedFrames = reader.framesRead();
+			reportedLost = reader.lostFrames();
+		}
+
+		// look at the frames where the writer put them; only what survived the look counts
+		BroadcastView view;
+		while (chrono::steady_clock::now() - reported < chrono::seconds(1) && reader.peek(view, FRAMES_PER_PEEK) > 0) {
+			// peek() picked up a new layout: leave the view for after the layoutChanged() above resized the stats
+			int channels = reader.numChannels();
+			if ((size_t)channels != stats.size()) break;
+			int shown = channels < maxChannels ? channels : maxChannels;
+			vector<ChannelStats> pass(shown);
+			accumulate(view.frames[0], view.numFrames[0], channels, shown, pass);
+			accumulate(view.frames[1], view.numFrames[1], channels, shown, pass);
+			if (delay > 0) this_thread::sleep_for(chrono::milliseconds(delay));
+			if (!reader.release(view)) continue;
+			for (int channel = 0; channel < shown; channel++) {
+				if (pass[channel].minimum < stats[channel].minimum) stats[channel].minimum = pass[channel].minimum;
+				if (pass[channel].maximum > stats[channel].maximum) stats[channel].maximum = pass[channel].maximum;
+				stats[channel].sum += pass[channel].sum;
+				stats[channel].sumSquares += pass[channel].sumSquares;
+			}
+		}
+
+		chrono::steady_clock::time_point now = chrono::steady_clock::now();
+		double elapsed = chrono::duration<double>(now - reported).count();
+		if (elapsed >= 1) {
+			uint64_t frames = reader.framesRead() - reportedFrames;
+			uint64_t lost = reader.lostFrames() - reportedLost;
+			printf("%s  %.0f frames/s  lost %llu  overruns %llu\n", reader.state() == BROADCAST_LIVE ? "live" : "idle", frames / elapsed,
+				(unsigned long long)lost, (unsigned long long)reader.overruns());
+			int shown = reader.numChannels() < maxChannels ? reader.numChannels() : maxChannels;
+			for (int channel = 0; channel < shown && frames > 0; channel++) {
+				const ChannelScaling &scaling = reader.scaling(channel);
+				// the linear part of the scaling is plenty for an RMS
+				double offset = scaling.coefficients[0], gain = scaling.coefficients[1];
+				double meanSquare = offset * offset + 2 * offset * gain * stats[channel].sum / frames + gain * gain * stats[channel].sumSquares / frames;
+				double rms = sqrt(meanSquare > 0 ? meanSquare : 0);
+				printf("    ch %d  min %.4f V  max %.4f V  rms %.4f V\n", channel, scaling.toVolts((int16_t)stats[channel].minimum),
+					scaling.toVolts((int16_t)stats[channel].maximum), rms);
+			}
+			fflush(stdout);
+			stats.assign(reader.numChannels(), ChannelStats());
+			reportedFrames = reader.framesRead();
+			reportedLost = reader.lostFrames();
+			reported = now;
+		}
+
+		this_thread::sleep_for(chrono::milliseconds(POLL_MILLISECONDS));
+	}
+	return 0;
+}
@@ -0,0 +1,81 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2023  Neuro Software Developers, Inc.
+//
+// Contact Information:
+//
+// Email:
+// info@neurosoftware.com
+//
+// Website:
+// www.neurosoftware.com
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <atomic>
+#include <stdint.h>
+#include "Scaling.h"
+
+/*
+Live sample broadcast, a named shared memory region (see SharedMemory.h) that one writer, the scope, fills and any
+number of local readers map and consume in place (see BroadcastReader.h):
+
+	BroadcastHeader, then BROADCAST_MAX_CHANNELS x BroadcastChannel, padded to dataOffset
+	ring: capacityFrames interleaved frames of int16 ADC codes, frame n in slot n & (capacityFrames - 1)
+
+The writer never waits for readers. Before it overwrites a stretch of the ring it advances claimed, then copies the
+frames in and advances published. A reader consumes frames below published in place and afterwards checks claimed:
+if the writer claimed the slots it was reading in the meantime, those frames are torn and the reader counts an
+overrun instead of using them. The layout (channels, rate, scaling) is guarded the same way by layoutSequence,
+which is odd while the writer changes it. The counters are 32 bit and wrap; only their differences are used, so
+the ring must stay below 2^31 frames. 32 bit atomics are lock free everywhere, so readers can map read-only.
+*/
+
+#define BROADCAST_MAGIC 0x54534342u			// "BCST"
+#define BROADCAST_VERSION 1
+#define BROADCAST_DEFAULT_NAME "OscilloscopeSamples"
+#define BROADCAST_MAX_CHANNELS 1024			// as many as a channel list can name
+#define BROADCAST_ALIGNMENT 4096
+
+#define BROADCAST_IDLE 0					// the writer exists but isn't acquiring
+#define BROADCAST_LIVE 1
+#define BROADCAST_CLOSED 2					// the writer let go of the region, readers should reopen it
+
+struct BroadcastHeader {
+	uint32_t magic;					// BROADCAST_MAGIC, written last when the region is set up
+	uint32_t version;
+	uint64_t regionBytes;
+	uint64_t dataOffset;			// of the ring
+	uint64_t dataBytes;
+
+	// the layout, only read between two equal even values of layoutSequence
+	std::atomic<uint32_t> layoutSequence;
+	uint32_t state;					// BROADCAST_IDLE, _LIVE or _CLOSED
+	uint32_t numChannels;
+	uint32_t capacityFrames;		// power of two
+	double sampleRate;				// per channel
+	int64_t startTime;				// when this layout went live, seconds since 1970-01-01 UTC
+	uint32_t startFrame;			// the published count it went live at
+	uint32_t writerProcess;			// process id, for diagnostics
+	char device[64];
+
+	// the writer's and the readers' views of the counters on cache lines of their own
+	char pad0[64];
+	std::atomic<uint32_t> claimed;	// frames the writer has started to write
+	char pad1[64];
+	std::atomic<uint32_t> published;	// frames complete and readable
+	char pad2[64];
+};
+
+struct BroadcastChannel {
+	double coefficients[SCALING_COEFFICIENTS];	// codes -> volts, see ChannelScaling
+};
+
+static_assert(sizeof(std::atomic<uint32_t>) == 4, "broadcast counters must be plain 32 bit words");
+static_assert(sizeof(BroadcastChannel) == 32, "broadcast channel layout changed");
+
+inline uint64_t alignBroadcast(uint64_t bytes) {
+	return (bytes + BROADCAST_ALIGNMENT - 1) & ~(uint64_t)(BROADCAST_ALIGNMENT - 1);
+}
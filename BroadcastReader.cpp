@@ -0,0 +1,224 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2023  Neuro Software Developers, Inc.
+//
+// Contact Information:
+//
+// Email:
+// info@neurosoftware.com
+//
+// Website:
+// www.neurosoftware.com
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "BroadcastReader.h"
+#include <string.h>
+
+using namespace std;
+
+BroadcastReader::BroadcastReader() : header(NULL), channelTable(NULL), ring(NULL), sequence(0), synced(false), changed(false),
+	layoutState(BROADCAST_CLOSED), channels(0), capacity(0), rate(0), started(0), cursor(0), position(0), consumed(0), lost(0), overrunCount(0) {
+}
+
+BroadcastReader::~BroadcastReader() {
+	close();
+}
+
+bool BroadcastReader::open(const string &name) {
+	close();
+	error.clear();
+	if (!region.open(name, true)) {
+		error = region.errorString();
+		return false;
+	}
+	const BroadcastHeader *mapped = (const BroadcastHeader *)region.data();
+	if (region.size() < sizeof(BroadcastHeader) || mapped->magic != BROADCAST_MAGIC || mapped->version != BROADCAST_VERSION ||
+		mapped->dataOffset + mapped->dataBytes > region.size()) {
+		region.close();
+		error = name + " is not a sample broadcast, or its writer is still setting it up.";
+		return false;
+	}
+
+	header = mapped;
+	channelTable = (const BroadcastChannel *)(header + 1);
+	ring = (const int16_t *)((const char *)region.data() + header->dataOffset);
+	synced = false;
+	changed = false;
+	layoutState = BROADCAST_IDLE;
+	channels = 0;
+	capacity = 0;
+	consumed = 0;
+	lost = 0;
+	overrunCount = 0;
+	return true;
+}
+
+void BroadcastReader::close() {
+	region.close();
+	header = NULL;
+	channelTable = NULL;
+	ring = NULL;
+	synced = false;
+	layoutState = BROADCAST_CLOSED;
+	channels = 0;
+	capacity = 0;
+}
+
+// picks up a new layout: false while there is none to use (the writer is changing it or hasn't published one)
+bool BroadcastReader::sync() {
+	if (header == NULL)
+		return false;
+
+	uint32_t seen = header->layoutSequence.load(memory_order_acquire);
+	if (synced && seen == sequence) return true;
+	if (seen & 1) return false;
+
+	// seqlock read: copy, then make sure the writer didn't touch it meanwhile
+	int state = (int)header->state;
+	int numChannels = (int)header->numChannels;
+	uint32_t frames = header->capacityFrames;
+	double sampleRate = header->sampleRate;
+	int64_t startTime = header->startTime;
+	char device[sizeof(header->device)];
+	memcpy(device, header->device, sizeof(device));
+	device[sizeof(device) - 1] = 0;
+	vector<ChannelScaling> scaling(numChannels > 0 && numChannels <= BROADCAST_MAX_CHANNELS ? numChannels : 0);
+	for (size_t channel = 0; channel < scaling.size(); channel++) {
+		memcpy(scaling[channel].coefficients, channelTable[channel].coefficients, sizeof(scaling[channel].coefficients));
+	}
+	atomic_thread_fence(memory_order_acquire);
+	if (header->layoutSequence.load(memory_order_relaxed) != seen) return false;
+
+	bool usable = !scaling.empty() && frames > 0 && (frames & (frames - 1)) == 0 &&
+		(uint64_t)frames * numChannels * sizeof(int16_t) <= header->dataBytes;
+	if (!usable) {
+		// nothing published yet
+		sequence = seen;
+		synced = true;
+		layoutState = state;
+		channels = 0;
+		capacity = 0;
+		return false;
+	}
+
+	// going idle or live again with the same layout keeps the reader's place, anything else starts over
+	bool same = channels == numChannels && capacity == frames && rate == sampleRate && started == startTime && deviceName == device;
+	sequence = seen;
+	synced = true;
+	layoutState = state;
+	if (!same) {
+		channels = numChannels;
+		capacity = frames;
+		rate = sampleRate;
+		started = startTime;
+		deviceName = device;
+		channelScaling.swap(scaling);
+		cursor = header->published.load(memory_order_acquire);
+		position = 0;
+		changed = true;
+	}
+	return true;
+}
+
+int BroadcastReader::state() const {
+	const_cast<BroadcastReader *>(this)->sync();
+	return layoutState;
+}
+
+bool BroadcastReader::layoutChanged() {
+	sync();
+	bool result = changed;
+	changed = false;
+	return result;
+}
+
+// lapped: what the writer overwrote is gone, carry on half a ring behind it
+void BroadcastReader::skip(uint32_t published) {
+	uint32_t keep = capacity / 2;
+	uint32_t skipped = published - cursor - keep;
+	cursor += skipped;
+	position += skipped;
+	lost += skipped;
+	overrunCount++;
+}
+
+size_t BroadcastReader::available() {
+	if (!sync())
+		return 0;
+
+	uint32_t waiting = header->published.load(memory_order_acquire) - cursor;
+	return waiting < capacity ? waiting : capacity;
+}
+
+size_t BroadcastReader::peek(BroadcastView &view, size_t maxFrames) {
+	view.frames[0] = view.frames[1] = NULL;
+	view.numFrames[0] = view.numFrames[1] = 0;
+	view.firstFrame = position;
+	view.layoutSequence = sequence;
+	if (!sync())
+		return 0;
+	view.layoutSequence = sequence;
+
+	uint32_t published = header->published.load(memory_order_acquire);
+	if (published - cursor > capacity) {
+		skip(published);
+		view.firstFrame = position;
+	}
+	size_t numFrames = published - cursor;
+	if (numFrames > maxFrames) numFrames = maxFrames;
+	if (numFrames == 0) return 0;
+
+	size_t start = cursor & (capacity - 1);
+	size_t first = capacity - start;
+	if (first > numFrames) first = numFrames;
+	view.frames[0] = ring + start * channels;
+	view.numFrames[0] = first;
+	view.frames[1] = ring;
+	view.numFrames[1] = numFrames - first;
+	return numFrames;
+}
+
+bool BroadcastReader::release(const BroadcastView &view) {
+	size_t numFrames = view.totalFrames();
+	if (numFrames == 0 || header == NULL)
+		return true;
+
+	// the slots of the view's first frame are the ones the writer reaches first; a layout change since peek()
+	// may have resized the frames under it, so they are dropped too (the next sync() decides where to go on)
+	atomic_thread_fence(memory_order_acquire);
+	if (header->layoutSequence.load(memory_order_relaxed) != view.layoutSequence) {
+		if (view.firstFrame == position) {
+			cursor += (uint32_t)numFrames;
+			position += numFrames;
+			lost += numFrames;
+		}
+		return false;
+	}
+	if (view.firstFrame != position)
+		return true;
+
+	bool intact = header->claimed.load(memory_order_relaxed) - cursor <= capacity;
+	cursor += (uint32_t)numFrames;
+	position += numFrames;
+	if (intact) {
+		consumed += numFrames;
+	}
+	else {
+		lost += numFrames;
+		overrunCount++;
+	}
+	return intact;
+}
+
+size_t BroadcastReader::read(int16_t *frames, size_t maxFrames) {
+	BroadcastView view;
+	size_t numFrames = peek(view, maxFrames);
+	if (numFrames == 0)
+		return 0;
+
+	size_t frameBytes = channels * sizeof(int16_t);
+	memcpy(frames, view.frames[0], view.numFrames[0] * frameBytes);
+	memcpy(frames + view.numFrames[0] * channels, view.frames[1], view.numFrames[1] * frameBytes);
+	return release(view) ? numFrames : 0;
+}
@@ -0,0 +1,113 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2023  Neuro Software Developers, Inc.
+//
+// Contact Information:
+//
+// Email:
+// info@neurosoftware.com
+//
+// Website:
+// www.neurosoftware.com
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include <stddef.h>
+#include "BroadcastFormat.h"
+#include "SharedMemory.h"
+
+// Frames a reader is looking at in place, in the writer's ring: the run up to the end of the ring and the rest
+// from its start. Valid until release().
+struct BroadcastView {
+	const int16_t *frames[2];
+	size_t numFrames[2];
+	uint64_t firstFrame;		// frames since the reader picked up the current layout, counting the ones it lost
+	uint32_t layoutSequence;	// the writer's layoutSequence when the view was taken
+
+	size_t totalFrames() const { return numFrames[0] + numFrames[1]; }
+};
+
+// Reads the scope's live samples from its shared memory broadcast (see Broadcaster.h) without copies or locks:
+//
+//	BroadcastReader reader;
+//	reader.open(BROADCAST_DEFAULT_NAME);
+//	for (;;) {
+//		BroadcastView view;
+//		if (reader.peek(view, 4096) == 0) { sleep a little; continue; }
+//		... look at view.frames[0..1], reader.numChannels() int16 codes per frame ...
+//		if (!reader.release(view)) { the writer overwrote them meanwhile, drop what was computed from them }
+//	}
+//
+// A reader that falls more than the ring behind loses frames (overruns(), lostFrames()) and picks up again half
+// a ring behind the writer. When the writer changes the layout the reader starts over at its newest frame and
+// layoutChanged() says so once. Not thread safe, one reader per thread.
+class BroadcastReader {
+public:
+	BroadcastReader();
+	~BroadcastReader();
+
+	bool open(const std::string &name);
+	void close();
+	bool isOpen() const { return header != NULL; }
+
+	// the writer's state, BROADCAST_IDLE, _LIVE or _CLOSED (reopen to find its next region)
+	int state() const;
+	// true once after the layout below changed
+	bool layoutChanged();
+	int numChannels() const { return channels; }
+	double sampleRate() const { return rate; }
+	const ChannelScaling &scaling(int channel) const { return channelScaling[channel]; }
+	const std::string &device() const { return deviceName; }
+	int64_t startTime() const { return started; }		// when the layout went live, seconds since 1970-01-01 UTC
+
+	// frames waiting for this reader, at most the ring
+	size_t available();
+	// up to maxFrames of the next frames in place, without copying
+	size_t peek(BroadcastView &view, size_t maxFrames);
+	// done with a view: true if its frames were intact the whole time, false if the writer got to them first or
+	// changed the layout meanwhile
+	bool release(const BroadcastView &view);
+	// peek, copy out and release; 0 if nothing came or what came was overwritten
+	size_t read(int16_t *frames, size_t maxFrames);
+
+	uint64_t framesRead() const { return consumed; }
+	uint64_t lostFrames() const { return lost; }
+	uint64_t overruns() const { return overrunCount; }
+	const std::string &errorString() const { return error; }
+
+private:
+	BroadcastReader(const BroadcastReader &);
+	BroadcastReader &operator=(const BroadcastReader &);
+
+	bool sync();
+	void skip(uint32_t published);
+
+	SharedMemory region;
+	std::string error;
+	const BroadcastHeader *header;
+	const BroadcastChannel *channelTable;
+	const int16_t *ring;
+
+	// the layout as of sequence
+	uint32_t sequence;
+	bool synced;
+	bool changed;
+	int layoutState;
+	int channels;
+	uint32_t capacity;
+	double rate;
+	int64_t started;
+	std::string deviceName;
+	std::vector<ChannelScaling> channelScaling;
+
+	uint32_t cursor;			// the writer's count of the next frame to read
+	uint64_t position;			// the same as frames since sync()
+	uint64_t consumed;
+	uint64_t lost;
+	uint64_t overrunCount;
+};
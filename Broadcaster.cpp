@@ -0,0 +1,180 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2023  Neuro Software Developers, Inc.
+//
+// Contact Information:
+//
+// Email:
+// info@neurosoftware.com
+//
+// Website:
+// www.neurosoftware.com
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "Broadcaster.h"
+#include <time.h>
+#include <string.h>
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+#define MAX_CAPACITY_FRAMES (1u << 30)		// keeps the 32 bit counter differences unambiguous
+
+Broadcaster::Broadcaster() : header(NULL), channelTable(NULL), ring(NULL), channels(0), capacity(0), published(0) {
+}
+
+Broadcaster::~Broadcaster() {
+	close();
+}
+
+bool Broadcaster::open(const string &name, size_t megabytes) {
+	close();
+	error.clear();
+	uint64_t dataOffset = alignBroadcast(sizeof(BroadcastHeader) + BROADCAST_MAX_CHANNELS * sizeof(BroadcastChannel));
+	if (!region.create(name, (size_t)(dataOffset + megabytes * 1024 * 1024))) {
+		error = region.errorString();
+		return false;
+	}
+	if (region.size() <= dataOffset) {
+		region.close();
+		error = "The shared memory " + name + " is too small for a broadcast.";
+		return false;
+	}
+
+	header = (BroadcastHeader *)region.data();
+	channelTable = (BroadcastChannel *)(header + 1);
+	ring = (int16_t *)((char *)region.data() + dataOffset);
+	regionName = name;
+	channels = 0;
+	capacity = 0;
+	published = 0;
+
+	// a region left behind by an earlier writer keeps its counters, so readers still mapping it carry on
+	bool reuse = region.existed() && header->magic == BROADCAST_MAGIC && header->version == BROADCAST_VERSION &&
+		header->regionBytes == region.size() && header->dataOffset == dataOffset;
+	if (!reuse) {
+		// keep the sequence going, a reader of the old layout must not mistake the new one for it
+		uint32_t sequence = header->layoutSequence.load(memory_order_relaxed);
+		memset((void *)header, 0, sizeof(BroadcastHeader));
+		header->layoutSequence.store((sequence + 2) & ~1u, memory_order_relaxed);
+		header->version = BROADCAST_VERSION;
+		header->regionBytes = region.size();
+		header->dataOffset = dataOffset;
+		header->dataBytes = region.size() - dataOffset;
+		atomic_thread_fence(memory_order_release);
+		header->magic = BROADCAST_MAGIC;
+	}
+	beginLayout();
+	header->state = BROADCAST_IDLE;
+#ifdef _WIN32
+	header->writerProcess = GetCurrentProcessId();
+#else
+	header->writerProcess = (uint32_t)getpid();
+#endif
+	endLayout();
+	return true;
+}
+
+void Broadcaster::close() {
+	if (header == NULL)
+		return;
+
+	beginLayout();
+	header->state = BROADCAST_CLOSED;
+	endLayout();
+	region.close();
+	header = NULL;
+	channelTable = NULL;
+	ring = NULL;
+	channels = 0;
+	capacity = 0;
+}
+
+// the layout seqlock: odd while the fields change, readers retry or discard what they read meanwhile
+void Broadcaster::beginLayout() {
+	header->layoutSequence.store(header->layoutSequence.load(memory_order_relaxed) + 1, memory_order_relaxed);
+	atomic_thread_fence(memory_order_release);
+}
+
+void Broadcaster::endLayout() {
+	header->layoutSequence.store(header->layoutSequence.load(memory_order_relaxed) + 1, memory_order_release);
+}
+
+bool Broadcaster::configure(const string &device, int numChannels, double sampleRate, const ChannelScaling *scaling) {
+	if (header == NULL) {
+		error = "The broadcast is not open.";
+		return false;
+	}
+	if (numChannels < 1 || numChannels > BROADCAST_MAX_CHANNELS) {
+		error = "A broadcast carries 1 to " + to_string(BROADCAST_MAX_CHANNELS) + " channels.";
+		return false;
+	}
+
+	// the largest power of two of frames that fits, so the wrapping counters map straight onto slots
+	size_t fits = (size_t)(header->dataBytes / (numChannels * sizeof(int16_t)));
+	size_t frames = 1;
+	while (frames * 2 <= fits && frames * 2 <= MAX_CAPACITY_FRAMES) frames *= 2;
+
+	beginLayout();
+	header->state = BROADCAST_LIVE;
+	header->numChannels = numChannels;
+	header->capacityFrames = (uint32_t)frames;
+	header->sampleRate = sampleRate;
+	header->startTime = (int64_t)time(NULL);
+	header->startFrame = header->published.load(memory_order_relaxed);
+	memset(header->device, 0, sizeof(header->device));
+	strncpy(header->device, device.c_str(), sizeof(header->device) - 1);
+	for (int channel = 0; channel < numChannels; channel++) {
+		memcpy(channelTable[channel].coefficients, scaling[channel].coefficients, sizeof(channelTable[channel].coefficients));
+	}
+	endLayout();
+
+	channels = numChannels;
+	capacity = frames;
+	return true;
+}
+
+void Broadcaster::idle() {
+	if (header == NULL)
+		return;
+
+	beginLayout();
+	header->state = BROADCAST_IDLE;
+	endLayout();
+}
+
+void Broadcaster::consume(const int16_t *frames, size_t numFrames) {
+	if (capacity == 0)
+		return;
+
+	size_t mask = capacity - 1;
+	uint32_t count = header->published.load(memory_order_relaxed);  // we are the only writer
+	while (numFrames > 0) {
+		size_t piece = numFrames < capacity ? numFrames : capacity;
+
+		// claim the slots first: a reader that was looking at them sees the claim when it checks afterwards
+		header->claimed.store(count + (uint32_t)piece, memory_order_relaxed);
+		atomic_thread_fence(memory_order_release);
+
+		size_t start = count & mask;
+		size_t first = capacity - start;
+		if (first > piece) first = piece;
+		memcpy(ring + start * channels, frames, first * channels * sizeof(int16_t));
+		if (piece > first) {
+			memcpy(ring, frames + first * channels, (piece - first) * channels * sizeof(int16_t));
+		}
+
+		count += (uint32_t)piece;
+		header->published.store(count, memory_order_release);
+		frames += piece * channels;
+		numFrames -= piece;
+		published += piece;
+	}
+}
@@ -0,0 +1,65 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2023  Neuro Software Developers, Inc.
+//
+// Contact Information:
+//
+// Email:
+// info@neurosoftware.com
+//
+// Website:
+// www.neurosoftware.com
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <string>
+#include <atomic>
+#include <stdint.h>
+#include "AcquisitionEngine.h"
+#include "BroadcastFormat.h"
+#include "SharedMemory.h"
+
+// Publishes every acquired block into a named shared memory ring (see BroadcastFormat.h) for other processes on
+// this machine to consume with a BroadcastReader, so analysis tools can watch the acquisition without a DAQmx task
+// of their own. consume() runs on the acquisition thread and is one copy into the mapping; readers that fall
+// behind lose frames and notice, the writer never waits for them. One writer per name.
+class Broadcaster : public BlockSink {
+public:
+	Broadcaster();
+	~Broadcaster();
+
+	// creates (or takes over) the region, with megabytes of ring; it stays idle until configure()
+	bool open(const std::string &name, size_t megabytes);
+	void close();  // tells the readers the region is gone
+	bool isOpen() const { return header != NULL; }
+
+	// publishes the layout of the blocks consume() will get and goes live; the readers start over with it
+	bool configure(const std::string &device, int numChannels, double sampleRate, const ChannelScaling *scaling);
+	void idle();  // acquisition stopped, the readers keep the layout and wait
+
+	void consume(const int16_t *frames, size_t numFrames);
+
+	uint64_t framesPublished() const { return published; }
+	size_t capacityFrames() const { return capacity; }
+	const std::string &name() const { return regionName; }
+	const std::string &errorString() const { return error; }
+
+private:
+	Broadcaster(const Broadcaster &);
+	Broadcaster &operator=(const Broadcaster &);
+
+	void beginLayout();
+	void endLayout();
+
+	SharedMemory region;
+	std::string regionName;
+	std::string error;
+	BroadcastHeader *header;
+	BroadcastChannel *channelTable;
+	int16_t *ring;
+	int channels;
+	size_t capacity;				// frames
+	std::atomic<uint64_t> published;
+};
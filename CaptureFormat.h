@@ -0,0 +1,88 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2023  Neuro Software Developers, Inc.
+//
+// Contact Information:
+//
+// Email:
+// info@neurosoftware.com
+//
+// Website:
+// www.neurosoftware.com
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <stdint.h>
+#include "Scaling.h"
+
+/*
+Capture file layout (all integers little endian, every section starts on a CAPTURE_ALIGNMENT boundary):
+
+	CaptureHeader, then numChannels x CaptureChannel, padded to headerBytes
+	chunk 0: CaptureChunkHeader + payload, padded to chunkBytes
+	chunk 1: ...
+	index:   numChunks x CaptureIndexEntry, padded (at indexOffset)
+
+A chunk payload holds numFrames interleaved frames (one int16 ADC code per channel per frame) in the chunk's
+encoding. Every chunk decodes on its own, so chunks can be decoded in parallel and a seek reads only the chunk it
+lands in. The header is rewritten with the index location when recording stops; a capture that was not closed
+cleanly has indexOffset 0 and can still be read by walking the chunk headers from headerBytes.
+*/
+
+#define CAPTURE_MAGIC "OSCCAPT"
+#define CAPTURE_VERSION 1
+#define CAPTURE_ALIGNMENT 4096
+#define CAPTURE_CHUNK_MAGIC 0x4B4E4843u		// "CHNK"
+
+#define CAPTURE_ENCODING_RAW 0				// interleaved int16 frames as acquired
+#define CAPTURE_ENCODING_PACKED 1			// packFrames() of the frames, see SampleCodec.h
+
+struct CaptureHeader {
+	char magic[8];				// CAPTURE_MAGIC
+	uint32_t version;
+	uint32_t headerBytes;		// offset of the first chunk
+	char device[64];
+	char terminalConfigName[16];	// as chosen in DAQ Settings, e.g. "Differential"
+	int32_t terminalConfig;		// DAQmx_Val_... value
+	uint32_t numChannels;
+	double sampleRate;			// per channel
+	double minVoltage;
+	double maxVoltage;
+	int64_t startTime;			// seconds since 1970-01-01 UTC
+	uint64_t totalFrames;
+	uint64_t numChunks;
+	uint64_t indexOffset;		// 0 until recording stopped cleanly
+	uint32_t chunkFrames;		// frames per chunk, the last chunk may hold fewer
+	uint32_t reserved;
+};
+
+struct CaptureChannel {
+	double coefficients[SCALING_COEFFICIENTS];	// codes -> volts, see ChannelScaling
+};
+
+struct CaptureChunkHeader {
+	uint32_t magic;				// CAPTURE_CHUNK_MAGIC
+	uint32_t encoding;			// CAPTURE_ENCODING_...
+	uint64_t firstFrame;
+	uint32_t numFrames;
+	uint32_t payloadBytes;		// encoded bytes following this header
+	uint32_t chunkBytes;		// header + payload + padding, distance to the next chunk
+	uint32_t reserved;
+};
+
+struct CaptureIndexEntry {
+	uint64_t firstFrame;
+	uint64_t offset;			// of the chunk header
+	uint32_t numFrames;
+	uint32_t chunkBytes;
+};
+
+static_assert(sizeof(CaptureHeader) == 168, "capture header layout changed");
+static_assert(sizeof(CaptureChunkHeader) == 32, "capture chunk header layout changed");
+static_assert(sizeof(CaptureIndexEntry) == 24, "capture index layout changed");
+
+inline uint64_t alignCapture(uint64_t bytes) {
+	return (bytes + CAPTURE_ALIGNMENT - 1) & ~(uint64_t)(CAPTURE_ALIGNMENT - 1);
+}
@@ -0,0 +1,220 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2023  Neuro Software Developers, Inc.
+//
+// Contact Information:
+//
+// Email:
+// info@neurosoftware.com
+//
+// Website:
+// www.neurosoftware.com
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "CaptureReader.h"
+#include "SampleCodec.h"
+#include <string.h>
+
+using namespace std;
+
+CaptureReader::CaptureReader() : fileSize(0), maxChunkBytes(0) {
+	memset(&info, 0, sizeof(info));
+}
+
+bool CaptureReader::open(const string &path) {
+	close();
+	error.clear();
+
+	if (!file.openRead(path)) {
+		error = file.errorString();
+		return false;
+	}
+	if (!file.readAt(0, &info, sizeof(info)) || memcmp(info.magic, CAPTURE_MAGIC, sizeof(CAPTURE_MAGIC)) != 0) {
+		error = path + " is not a capture file.";
+		close();
+		return false;
+	}
+	fileSize = file.size();
+	if (info.version != CAPTURE_VERSION || info.numChannels < 1 || info.sampleRate <= 0 || info.chunkFrames < 1 ||
+		info.headerBytes < sizeof(CaptureHeader) + (uint64_t)info.numChannels * sizeof(CaptureChannel) || info.headerBytes > fileSize) {
+		error = path + " was written by an incompatible version.";
+		close();
+		return false;
+	}
+
+	channels.resize(info.numChannels);
+	if (!file.readAt(sizeof(CaptureHeader), channels.data(), channels.size() * sizeof(CaptureChannel))) {
+		error = file.errorString();
+		close();
+		return false;
+	}
+
+	// no chunk can be larger than a full chunk in the larger of the two encodings
+	size_t rawBytes = (size_t)info.chunkFrames * info.numChannels * sizeof(int16_t);
+	size_t packedBytes = packedFramesBound(info.chunkFrames, (int)info.numChannels);
+	maxChunkBytes = alignCapture(sizeof(CaptureChunkHeader) + (rawBytes > packedBytes ? rawBytes : packedBytes));
+
+	// an index that doesn't fit in the file or doesn't describe consecutive chunks is ignored and rebuilt
+	bool indexed = info.indexOffset >= info.headerBytes && info.indexOffset < fileSize &&
+		info.numChunks <= (fileSize - info.indexOffset) / sizeof(CaptureIndexEntry);
+	if (indexed) {
+		index.resize((size_t)info.numChunks);
+		indexed = file.readAt(info.indexOffset, index.data(), index.size() * sizeof(CaptureIndexEntry));
+	}
+	uint64_t frames = 0;
+	for (size_t i = 0; indexed && i < index.size(); i++) {
+		indexed = validChunk(index[i].firstFrame, index[i].offset, index[i].numFrames, index[i].chunkBytes, frames);
+		frames += index[i].numFrames;
+	}
+	if (indexed && frames != info.totalFrames) indexed = false;
+	if (!indexed && !rebuildIndex()) {
+		close();
+		return false;
+	}
+	return true;
+}
+
+// the recording was cut short: walk the chunk headers from the first chunk until they stop making sense
+bool CaptureReader::rebuildIndex() {
+	index.clear();
+	uint64_t offset = info.headerBytes;
+	uint64_t frames = 0;
+	CaptureChunkHeader chunk;
+
+	while (offset + sizeof(chunk) <= fileSize && file.readAt(offset, &chunk, sizeof(chunk))) {
+		if (chunk.magic != CAPTURE_CHUNK_MAGIC || !validChunk(chunk.firstFrame, offset, chunk.numFrames, chunk.chunkBytes, frames)) {
+			break;
+		}
+		CaptureIndexEntry entry;
+		entry.firstFrame = chunk.firstFrame;
+		entry.offset = offset;
+		entry.numFrames = chunk.numFrames;
+		entry.chunkBytes = chunk.chunkBytes;
+		index.push_back(entry);
+		frames += chunk.numFrames;
+		offset += chunk.chunkBytes;
+	}
+	info.totalFrames = frames;
+	info.numChunks = index.size();
+	return true;
+}
+
+// whether a chunk's place in the file and frame range are possible, given the frames of the chunks before it
+bool CaptureReader::validChunk(uint64_t firstFrame, uint64_t offset, uint32_t numFrames, uint32_t chunkBytes, uint64_t expectedFrame) const {
+	return firstFrame == expectedFrame && numFrames <= info.chunkFrames && offset >= info.headerBytes &&
+		chunkBytes >= sizeof(CaptureChunkHeader) && chunkBytes <= maxChunkBytes && offset <= fileSize && chunkBytes <= fileSize - offset;
+}
+
+void CaptureReader::close() {
+	file.close();
+	index.clear();
+	channels.clear();
+}
+
+ChannelScaling CaptureReader::scaling(int channel) const {
+	ChannelScaling scaling;
+	if (channel >= 0 && channel < (int)channels.size()) {
+		memcpy(scaling.coefficients, channels[channel].coefficients, sizeof(scaling.coefficients));
+	}
+	return scaling;
+}
+
+size_t CaptureReader::findChunk(uint64_t frame) const {
+	size_t low = 0, high = index.size();
+	while (low < high) {
+		size_t middle = (low + high) / 2;
+		if (index[middle].firstFrame + index[middle].numFrames <= frame) low = middle + 1;
+		else high = middle;
+	}
+	return low;
+}
+
+// decodes every chunk on whichever pool thread takes it, noting what went wrong per chunk
+class CaptureReader::DecodeTask : public ParallelTask {
+public:
+	DecodeTask(const CaptureReader &capture, size_t firstChunk, vector<int16_t> *decoded, size_t count) : reader(capture), first(firstChunk),
+		frames(decoded), errors(count) {}
+
+	void run(int item, int) {
+		reader.decodeChunk(first + item, reader.chunkData[item], frames[item], errors[item]);
+	}
+
+	const CaptureReader &reader;
+	size_t first;
+	vector<int16_t> *frames;
+	vector<string> errors;		// empty where the chunk decoded
+};
+
+bool CaptureReader::readChunk(size_t i, vector<int16_t> &frames) {
+	if (chunkData.empty()) chunkData.resize(1);
+	return readChunkData(i, chunkData[0]) && decodeChunk(i, chunkData[0], frames, error);
+}
+
+bool CaptureReader::readChunks(size_t first, size_t count, vector<int16_t> *frames, WorkerPool &pool) {
+	if (chunkData.size() < count) chunkData.resize(count);
+	for (size_t i = 0; i < count; i++) {
+		if (!readChunkData(first + i, chunkData[i])) return false;
+	}
+	DecodeTask task(*this, first, frames, count);
+	pool.run(task, (int)count);
+	for (size_t i = 0; i < count; i++) {
+		if (!task.errors[i].empty()) {
+			error = task.errors[i];
+			return false;
+		}
+	}
+	return true;
+}
+
+bool CaptureReader::readChunkData(size_t i, vector<char> &data) {
+	if (i >= index.size()) {
+		error = "Chunk past the end of the capture.";
+		return false;
+	}
+	// entries were checked against maxChunkBytes when the index was read, so this never grows without bound
+	const CaptureIndexEntry &entry = index[i];
+	if (data.size() < entry.chunkBytes) data.resize(entry.chunkBytes);
+	if (!file.readAt(entry.offset, data.data(), entry.chunkBytes)) {
+		error = file.errorString();
+		return false;
+	}
+	return true;
+}
+
+// decodes chunk i, read into data, on any thread
+bool CaptureReader::decodeChunk(size_t i, const vector<char> &data, vector<int16_t> &frames, string &what) const {
+	const CaptureIndexEntry &entry = index[i];
+	if (entry.chunkBytes < sizeof(CaptureChunkHeader) || data.size() < entry.chunkBytes) {
+		what = "Damaged chunk at frame " + to_string((unsigned long long)entry.firstFrame) + ".";
+		return false;
+	}
+	const CaptureChunkHeader *chunk = (const CaptureChunkHeader *)data.data();
+	const char *payload = data.data() + sizeof(CaptureChunkHeader);
+	size_t samples = (size_t)entry.numFrames * info.numChannels;
+	if (chunk->magic != CAPTURE_CHUNK_MAGIC || chunk->firstFrame != entry.firstFrame || chunk->numFrames != entry.numFrames ||
+		sizeof(CaptureChunkHeader) + (uint64_t)chunk->payloadBytes > entry.chunkBytes) {
+		what = "Damaged chunk at frame " + to_string((unsigned long long)entry.firstFrame) + ".";
+		return false;
+	}
+
+	frames.resize(samples);
+	switch (chunk->encoding) {
+	case CAPTURE_ENCODING_RAW:
+		if (chunk->payloadBytes != samples * sizeof(int16_t)) {
+			what = "Damaged chunk at frame " + to_string((unsigned long long)entry.firstFrame) + ".";
+			return false;
+		}
+		memcpy(frames.data(), payload, chunk->payloadBytes);
+		return true;
+	case CAPTURE_ENCODING_PACKED:
+		if (!unpackFrames((const uint8_t *)payload, chunk->payloadBytes, entry.numFrames, (int)info.numChannels, frames.data())) {
+			what = "Damaged chunk at frame " + to_string((unsigned long long)entry.firstFrame) + ".";
+			return false;
+		}
+		return true;
+	default:
+		what = "Unknown chunk encoding " + to_string((unsigned long long)chunk->encoding) + ".";
+		return false;
+	}
+}
@@ -0,0 +1,67 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2023  Neuro Software Developers, Inc.
+//
+// Contact Information:
+//
+// Email:
+// info@neurosoftware.com
+//
+// Website:
+// www.neurosoftware.com
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include "BinaryFile.h"
+#include "CaptureFormat.h"
+#include "WorkerPool.h"
+
+// Random access to a capture file written by Recorder. The chunk index makes finding the chunk that holds
+// any frame a binary search; a capture that was not closed cleanly gets its index rebuilt from the chunk headers.
+// Chunks decode independently, so readChunks() reads a run of them and decodes them on a worker pool.
+class CaptureReader {
+public:
+	CaptureReader();
+
+	bool open(const std::string &path);
+	void close();
+	bool isOpen() const { return file.isOpen(); }
+
+	const CaptureHeader &header() const { return info; }
+	int numChannels() const { return (int)info.numChannels; }
+	double sampleRate() const { return info.sampleRate; }
+	uint64_t totalFrames() const { return info.totalFrames; }
+	ChannelScaling scaling(int channel) const;
+
+	size_t numChunks() const { return index.size(); }
+	const CaptureIndexEntry &chunk(size_t i) const { return index[i]; }
+	size_t findChunk(uint64_t frame) const;	// chunk holding frame, numChunks() if past the end
+
+	// reads and decodes one chunk into frames (numFrames x numChannels codes), returns false on a damaged chunk
+	bool readChunk(size_t i, std::vector<int16_t> &frames);
+	// count chunks from first into frames[0 .. count - 1], decoded in parallel on pool
+	bool readChunks(size_t first, size_t count, std::vector<int16_t> *frames, WorkerPool &pool);
+
+	const std::string &errorString() const { return error; }
+
+private:
+	class DecodeTask;
+
+	bool rebuildIndex();
+	bool validChunk(uint64_t firstFrame, uint64_t offset, uint32_t numFrames, uint32_t chunkBytes, uint64_t expectedFrame) const;
+	bool readChunkData(size_t i, std::vector<char> &data);
+	bool decodeChunk(size_t i, const std::vector<char> &data, std::vector<int16_t> &frames, std::string &what) const;
+
+	BinaryFile file;
+	CaptureHeader info;
+	std::vector<CaptureChannel> channels;
+	std::vector<CaptureIndexEntry> index;
+	uint64_t fileSize;
+	uint64_t maxChunkBytes;		// header + the larger encoding of chunkFrames frames, aligned
+	std::vector<std::vector<char> > chunkData;	// encoded chunks of the current read
+	std::string error;
+};
@@ -0,0 +1,116 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2023  Neuro Software Developers, Inc.
+//
+// Contact Information:
+//
+// Email:
+// info@neurosoftware.com
+//
+// Website:
+// www.neurosoftware.com
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+#include "ChannelList.h"
+#include <stdlib.h>
+#include <ctype.h>
+
+using namespace std;
+
+static string trim(const string &text) {
+	size_t first = 0, last = text.size();
+	while (first < last && isspace((unsigned char)text[first])) first++;
+	while (last > first && isspace((unsigned char)text[last - 1])) last--;
+	return text.substr(first, last - first);
+}
+
+// a whole non-negative integer, nothing after it
+static bool parseInput(const string &text, int *value) {
+	if (text.empty() || !isdigit((unsigned char)text[0])) return false;
+	char *end;
+	long number = strtol(text.c_str(), &end, 10);
+	if (*end != 0 || number > 0xFFFF) return false;
+	*value = (int)number;
+	return true;
+}
+
+static bool parseVolts(const string &text, double *value) {
+	if (text.empty()) return false;
+	char *end;
+	*value = strtod(text.c_str(), &end);
+	return *end == 0;
+}
+
+bool parseChannelList(const string &text, double minVoltage, double maxVoltage, AcquisitionConfig &config, string &error) {
+	vector<string> devices;
+	vector<ChannelConfig> channels;
+
+	size_t start = 0;
+	while (start <= text.size()) {
+		size_t comma = text.find(',', start);
+		if (comma == string::npos) comma = text.size();
+		string entry = trim(text.substr(start, comma - start));
+		start = comma + 1;
+		if (entry.empty()) continue;
+
+		// range suffix
+		double low = minVoltage, high = maxVoltage;
+		size_t at = entry.find('@');
+		if (at != string::npos) {
+			string range = trim(entry.substr(at + 1));
+			entry = trim(entry.substr(0, at));
+			size_t colon = range.find(':', 1);  // not the sign of a negative minimum
+			bool parsed;
+			if (colon == string::npos) {
+				parsed = parseVolts(range, &high) && high > 0;
+				low = -high;
+			}
+			else {
+				parsed = parseVolts(trim(range.substr(0, colon)), &low) && parseVolts(trim(range.substr(colon + 1)), &high) && high > low;
+			}
+			if (!parsed) {
+				error = "Bad input range \"" + range + "\", expected @V for +-V or @min:max.";
+				return false;
+			}
+		}
+
+		// device/aiN or device/aiN:M
+		size_t slash = entry.rfind('/');
+		if (slash == string::npos || slash == 0 || entry.compare(slash + 1, 2, "ai") != 0) {
+			error = "Bad channel \"" + entry + "\", expected device/aiN or device/aiN:M.";
+			return false;
+		}
+		string device = trim(entry.substr(0, slash));
+		string inputs = entry.substr(slash + 3);
+		size_t colon = inputs.find(':');
+		int first, last;
+		bool parsed = colon == string::npos ? parseInput(inputs, &first) && parseInput(inputs, &last) :
+			parseInput(inputs.substr(0, colon), &first) && parseInput(inputs.substr(colon + 1), &last) && last >= first;
+		if (!parsed) {
+			error = "Bad input numbers in \"" + entry + "\".";
+			return false;
+		}
+
+		int deviceIndex = 0;
+		while (deviceIndex < (int)devices.size() && devices[deviceIndex] != device) deviceIndex++;
+		if (deviceIndex == (int)devices.size()) devices.push_back(device);
+
+		if (channels.size() + (size_t)(last - first + 1) > CHANNEL_LIST_MAX_CHANNELS) {
+			error = "Too many channels, at most " + to_string(CHANNEL_LIST_MAX_CHANNELS) + " can be acquired.";
+			return false;
+		}
+		for (int input = first; input <= last; input++) {
+			channels.push_back(ChannelConfig(deviceIndex, input, low, high));
+		}
+	}
+
+	if (channels.empty()) {
+		error = "The channel list is empty.";
+		return false;
+	}
+	config.devices = devices;
+	config.channels = channels;
+	return true;
+}
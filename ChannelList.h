@@ -0,0 +1,28 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2023  Neuro Software Developers, Inc.
+//
+// Contact Information:
+//
+// Email:
+// info@neurosoftware.com
+//
+// Website:
+// www.neurosoftware.com
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+#pragma once
+
+#include <string>
+#include "AcquisitionSource.h"
+
+#define CHANNEL_LIST_MAX_CHANNELS 1024
+
+// Parses a channel list such as "Dev1/ai0:15, Dev2/ai0:7@5, Dev2/ai8@-1:4" into config.devices and config.channels:
+// comma separated device/aiN inputs or device/aiN:M runs of them, each optionally followed by @V for a +-V input
+// range or @min:max. Inputs without a range get minVoltage..maxVoltage. Devices are numbered in order of first
+// appearance, so the first one named provides the sample clock. Returns false and describes the problem in error
+// if the list can't be parsed; config is only changed on success.
+bool parseChannelList(const std::string &text, double minVoltage, double maxVoltage, AcquisitionConfig &config, std::string &error);
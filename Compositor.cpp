@@ -0,0 +1,141 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2023  Neuro Software Developers, Inc.
+//
+// Contact Information:
+//
+// Email:
+// info@neurosoftware.com
+//
+// Website:
+// www.neurosoftware.com
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "Compositor.h"
+
+RasterRect RasterRect::united(const RasterRect &o) const {
+	if (empty()) return o;
+	if (o.empty()) return *this;
+	return RasterRect(left < o.left ? left : o.left, top < o.top ? top : o.top,
+		right > o.right ? right : o.right, bottom > o.bottom ? bottom : o.bottom);
+}
+
+RasterRect RasterRect::intersected(const RasterRect &o) const {
+	RasterRect r(left > o.left ? left : o.left, top > o.top ? top : o.top,
+		right < o.right ? right : o.right, bottom < o.bottom ? bottom : o.bottom);
+	return r.empty() ? RasterRect() : r;
+}
+
+void DirtyRegion::add(const RasterRect &rect) {
+	if (rect.empty()) return;
+	RasterRect merged = rect;
+
+	// fold in every rectangle it touches, the union is rarely much bigger than the two and keeps the list short
+	for (int i = 0; i < count;) {
+		if (rects[i].touches(merged)) {
+			merged = merged.united(rects[i]);
+			rects[i] = rects[--count];
+			i = 0;
+		}
+		else {
+			i++;
+		}
+	}
+
+	if (count == DIRTY_MAX_RECTS) {
+		// full: merge with whichever rectangle grows the least
+		int best = 0;
+		int bestGrowth = -1;
+		for (int i = 0; i < count; i++) {
+			int growth = rects[i].united(merged).area() - rects[i].area();
+			if (bestGrowth < 0 || growth < bestGrowth) {
+				best = i;
+				bestGrowth = growth;
+			}
+		}
+		merged = merged.united(rects[best]);
+		rects[best] = rects[--count];
+		add(merged);
+		return;
+	}
+	rects[count++] = merged;
+}
+
+RasterRect DirtyRegion::bounds() const {
+	RasterRect r;
+	for (int i = 0; i < count; i++) r = r.united(rects[i]);
+	return r;
+}
+
+int DirtyRegion::area() const {
+	int sum = 0;
+	for (int i = 0; i < count; i++) sum += rects[i].area();
+	return sum;
+}
+
+Compositor::Compositor() : output(NULL), numLayers(0) {
+}
+
+void Compositor::setOutput(Raster *frame) {
+	output = frame;
+	invalidateAll();
+}
+
+int Compositor::addLayer(Raster *layer) {
+	if (numLayers == COMPOSITOR_MAX_LAYERS) return -1;
+	layers[numLayers] = layer;
+	drawn[numLayers] = RasterRect();
+	invalidateAll();
+	return numLayers++;
+}
+
+void Compositor::clearLayers() {
+	numLayers = 0;
+	dirty.clear();
+}
+
+void Compositor::invalidate(const RasterRect &rect) {
+	if (output == NULL) return;
+	dirty.add(rect.intersected(RasterRect(0, 0, output->width(), output->height())));
+}
+
+void Compositor::invalidateAll() {
+	if (output == NULL) return;
+	dirty.clear();
+	dirty.add(RasterRect(0, 0, output->width(), output->height()));
+}
+
+void Compositor::beginLayer(int layer) {
+	if (layer < 0 || layer >= numLayers) return;
+	const RasterRect &r = drawn[layer];
+	if (!r.empty()) {
+		Raster *l = layers[layer];
+		l->resetClip();
+		l->fillRect(r.left, r.top, r.right, r.bottom, PIXEL_TRANSPARENT);
+		invalidate(r);
+	}
+	drawn[layer] = RasterRect();
+}
+
+void Compositor::layerDrawn(int layer, const RasterRect &rect) {
+	if (layer < 0 || layer >= numLayers) return;
+	drawn[layer] = drawn[layer].united(rect);
+	invalidate(rect);
+}
+
+const DirtyRegion &Compositor::compose() {
+	presented = dirty;
+	dirty.clear();
+	if (output == NULL || numLayers == 0) return presented;
+
+	output->resetClip();
+	for (int i = 0; i < presented.size(); i++) {
+		const RasterRect &r = presented[i];
+		output->copy(*layers[0], r.left, r.top, r.right, r.bottom);
+		for (int layer = 1; layer < numLayers; layer++) {
+			output->composite(*layers[layer], r.left, r.top, r.right, r.bottom);
+		}
+	}
+	return presented;
+}
@@ -0,0 +1,85 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2023  Neuro Software Developers, Inc.
+//
+// Contact Information:
+//
+// Email:
+// info@neurosoftware.com
+//
+// Website:
+// www.neurosoftware.com
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "Raster.h"
+
+#define COMPOSITOR_MAX_LAYERS 8
+#define DIRTY_MAX_RECTS 16		// beyond this the region collapses into fewer, bigger rectangles
+
+// right and bottom exclusive
+struct RasterRect {
+	int left, top, right, bottom;
+
+	RasterRect() : left(0), top(0), right(0), bottom(0) {}
+	RasterRect(int l, int t, int r, int b) : left(l), top(t), right(r), bottom(b) {}
+
+	bool empty() const { return right <= left || bottom <= top; }
+	int area() const { return empty() ? 0 : (right - left) * (bottom - top); }
+	RasterRect united(const RasterRect &o) const;
+	RasterRect intersected(const RasterRect &o) const;
+	bool touches(const RasterRect &o) const { return left <= o.right && o.left <= right && top <= o.bottom && o.top <= bottom; }
+};
+
+// the parts of the frame that changed since it was last presented
+class DirtyRegion {
+public:
+	DirtyRegion() : count(0) {}
+
+	void add(const RasterRect &rect);
+	void clear() { count = 0; }
+	bool empty() const { return count == 0; }
+	int size() const { return count; }
+	const RasterRect &operator[](int i) const { return rects[i]; }
+	RasterRect bounds() const;
+	int area() const;
+
+private:
+	RasterRect rects[DIRTY_MAX_RECTS];
+	int count;
+};
+
+// Stacks layers into an output raster, touching only what changed. The bottom layer is copied, every layer
+// above it is composited where it isn't transparent. Static layers (background, grid, labels) are drawn once
+// and only their dirty rectangles get recomposed; layers that are redrawn every frame report what they
+// cover through beginLayer()/layerDrawn() so the previous frame's pixels get cleared and recomposed too.
+class Compositor {
+public:
+	Compositor();
+
+	void setOutput(Raster *frame);
+	int addLayer(Raster *layer);	// bottom to top, returns the layer's index
+	void clearLayers();
+
+	void invalidate(const RasterRect &rect);
+	void invalidateAll();
+	bool pending() const { return !dirty.empty(); }	// something was invalidated since the last compose()
+
+	// for a layer redrawn from scratch: clears (to transparent) and invalidates what it covered last time
+	void beginLayer(int layer);
+	// the layer drew into rect this frame
+	void layerDrawn(int layer, const RasterRect &rect);
+
+	// recomposes every dirty rectangle into the output and returns them, the caller presents just those
+	const DirtyRegion &compose();
+
+private:
+	Raster *output;
+	Raster *layers[COMPOSITOR_MAX_LAYERS];
+	RasterRect drawn[COMPOSITOR_MAX_LAYERS];
+	int numLayers;
+	DirtyRegion dirty;
+	DirtyRegion presented;
+};
@@ -0,0 +1,187 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2023  Neuro Software Developers, Inc.
+//
+// Contact Information:
+//
+// Email:
+// info@neurosoftware.com
+//
+// Website:
+// www.neurosoftware.com
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "Decimator.h"
+#include "SimdSupport.h"
+
+void minMaxRange(const float *samples, size_t count, float *minimum, float *maximum) {
+	size_t i = 0;
+	float mn = samples[0];
+	float mx = samples[0];
+
+#ifdef SCOPE_SSE2
+	if (count >= 16) {
+		// four independent accumulators so the min/max latency chains overlap
+		__m128 min0 = _mm_loadu_ps(samples), max0 = min0;
+		__m128 min1 = _mm_loadu_ps(samples + 4), max1 = min1;
+		__m128 min2 = _mm_loadu_ps(samples + 8), max2 = min2;
+		__m128 min3 = _mm_loadu_ps(samples + 12), max3 = min3;
+		for (i = 16; i + 16 <= count; i += 16) {
+			__m128 a = _mm_loadu_ps(samples + i);
+			__m128 b = _mm_loadu_ps(samples + i + 4);
+			__m128 c = _mm_loadu_ps(samples + i + 8);
+			__m128 d = _mm_loadu_ps(samples + i + 12);
+			min0 = _mm_min_ps(min0, a); max0 = _mm_max_ps(max0, a);
+			min1 = _mm_min_ps(min1, b); max1 = _mm_max_ps(max1, b);
+			min2 = _mm_min_ps(min2, c); max2 = _mm_max_ps(max2, c);
+			min3 = _mm_min_ps(min3, d); max3 = _mm_max_ps(max3, d);
+		}
+		min0 = _mm_min_ps(_mm_min_ps(min0, min1), _mm_min_ps(min2, min3));
+		max0 = _mm_max_ps(_mm_max_ps(max0, max1), _mm_max_ps(max2, max3));
+		// horizontal reduction of the four lanes
+		min0 = _mm_min_ps(min0, _mm_shuffle_ps(min0, min0, _MM_SHUFFLE(1, 0, 3, 2)));
+		max0 = _mm_max_ps(max0, _mm_shuffle_ps(max0, max0, _MM_SHUFFLE(1, 0, 3, 2)));
+		min0 = _mm_min_ps(min0, _mm_shuffle_ps(min0, min0, _MM_SHUFFLE(2, 3, 0, 1)));
+		max0 = _mm_max_ps(max0, _mm_shuffle_ps(max0, max0, _MM_SHUFFLE(2, 3, 0, 1)));
+		mn = _mm_cvtss_f32(min0);
+		mx = _mm_cvtss_f32(max0);
+	}
+#endif
+	for (; i < count; i++) {
+		float v = samples[i];
+		if (v < mn) mn = v;
+		if (v > mx) mx = v;
+	}
+	*minimum = mn;
+	*maximum = mx;
+}
+
+void minMaxRange(const int16_t *samples, size_t count, int16_t *minimum, int16_t *maximum) {
+	size_t i = 0;
+	int16_t mn = samples[0];
+	int16_t mx = samples[0];
+
+#ifdef SCOPE_SSE2
+	if (count >= 32) {
+		// eight codes per register, four registers per iteration
+		__m128i min0 = _mm_loadu_si128((const __m128i *)samples), max0 = min0;
+		__m128i min1 = _mm_loadu_si128((const __m128i *)(samples + 8)), max1 = min1;
+		__m128i min2 = _mm_loadu_si128((const __m128i *)(samples + 16)), max2 = min2;
+		__m128i min3 = _mm_loadu_si128((const __m128i *)(samples + 24)), max3 = min3;
+		for (i = 32; i + 32 <= count; i += 32) {
+			__m128i a = _mm_loadu_si128((const __m128i *)(samples + i));
+			__m128i b = _mm_loadu_si128((const __m128i *)(samples + i + 8));
+			__m128i c = _mm_loadu_si128((const __m128i *)(samples + i + 16));
+			__m128i d = _mm_loadu_si128((const __m128i *)(samples + i + 24));
+			min0 = _mm_min_epi16(min0, a); max0 = _mm_max_epi16(max0, a);
+			min1 = _mm_min_epi16(min1, b); max1 = _mm_max_epi16(max1, b);
+			min2 = _mm_min_epi16(min2, c); max2 = _mm_max_epi16(max2, c);
+			min3 = _mm_min_epi16(min3, d); max3 = _mm_max_epi16(max3, d);
+		}
+		min0 = _mm_min_epi16(_mm_min_epi16(min0, min1), _mm_min_epi16(min2, min3));
+		max0 = _mm_max_epi16(_mm_max_epi16(max0, max1), _mm_max_epi16(max2, max3));
+		// horizontal reduction of the eight lanes
+		min0 = _mm_min_epi16(min0, _mm_shuffle_epi32(min0, _MM_SHUFFLE(1, 0, 3, 2)));
+		max0 = _mm_max_epi16(max0, _mm_shuffle_epi32(max0, _MM_SHUFFLE(1, 0, 3, 2)));
+		min0 = _mm_min_epi16(min0, _mm_shuffle_epi32(min0, _MM_SHUFFLE(2, 3, 0, 1)));
+		max0 = _mm_max_epi16(max0, _mm_shuffle_epi32(max0, _MM_SHUFFLE(2, 3, 0, 1)));
+		min0 = _mm_min_epi16(min0, _mm_srli_epi32(min0, 16));
+		max0 = _mm_max_epi16(max0, _mm_srli_epi32(max0, 16));
+		mn = (int16_t)_mm_cvtsi128_si32(min0);
+		mx = (int16_t)_mm_cvtsi128_si32(max0);
+	}
+#endif
+	for (; i < count; i++) {
+		int16_t v = samples[i];
+		if (v < mn) mn = v;
+		if (v > mx) mx = v;
+	}
+	*minimum = mn;
+	*maximum = mx;
+}
+
+template <typename T>
+PeakDecimator<T>::PeakDecimator() : total(0), columns(0), outMin(0), outMax(0), column(0), position(0), columnEnd(0),
+	runMin(0), runMax(0), runEmpty(true), firstFilled(-1), lastValue(0) {
+}
+
+template <typename T>
+void PeakDecimator<T>::begin(uint64_t numSamples, int numColumns, T *columnMin, T *columnMax) {
+	total = numSamples;
+	columns = numColumns;
+	outMin = columnMin;
+	outMax = columnMax;
+	column = 0;
+	position = 0;
+	columnEnd = columns > 0 ? total / columns : 0;
+	runEmpty = true;
+	firstFilled = -1;
+	lastValue = 0;
+
+	// leading columns that own no samples at all (fewer samples than columns)
+	while (column < columns && columnEnd == position) {
+		emitColumn();
+	}
+}
+
+template <typename T>
+void PeakDecimator<T>::emitColumn() {
+	if (runEmpty) {
+		outMin[column] = lastValue;
+		outMax[column] = lastValue;
+	}
+	else {
+		outMin[column] = runMin;
+		outMax[column] = runMax;
+		if (firstFilled < 0) firstFilled = column;
+	}
+	runEmpty = true;
+	column++;
+	columnEnd = (uint64_t)(column + 1) * total / columns;
+}
+
+template <typename T>
+void PeakDecimator<T>::add(const T *samples, size_t count) {
+	while (count > 0 && column < columns) {
+		uint64_t remaining = columnEnd - position;
+		size_t n = remaining < count ? (size_t)remaining : count;
+
+		T mn, mx;
+		minMaxRange(samples, n, &mn, &mx);
+		if (runEmpty) {
+			runMin = mn;
+			runMax = mx;
+			runEmpty = false;
+		}
+		else {
+			if (mn < runMin) runMin = mn;
+			if (mx > runMax) runMax = mx;
+		}
+		lastValue = samples[n - 1];
+		samples += n;
+		count -= n;
+		position += n;
+
+		while (column < columns && position == columnEnd) {
+			emitColumn();
+		}
+	}
+}
+
+template <typename T>
+void PeakDecimator<T>::end() {
+	while (column < columns) {
+		emitColumn();
+	}
+	// columns before the first sample take the first sample's value
+	if (firstFilled > 0) {
+		for (int c = 0; c < firstFilled; c++) {
+			outMin[c] = outMin[firstFilled];
+			outMax[c] = outMax[firstFilled];
+		}
+	}
+}
+
+template class PeakDecimator<float>;
+template class PeakDecimator<int16_t>;
@@ -0,0 +1,54 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2023  Neuro Software Developers, Inc.
+//
+// Contact Information:
+//
+// Email:
+// info@neurosoftware.com
+//
+// Website:
+// www.neurosoftware.com
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Peak-detect decimation, like the peak-detect acquisition mode of a hardware scope: numSamples samples are
+// split into numColumns equal runs and each run is reduced to its minimum and maximum, so a glitch only one
+// sample wide still shows up in its pixel column. The samples may arrive in several consecutive pieces
+// (e.g. the two halves of a wrapped ring buffer) through add(). Works on volts (float) or on raw ADC codes
+// (int16_t), in which case only the resulting envelope needs scaling.
+template <typename T>
+class PeakDecimator {
+public:
+	PeakDecimator();
+
+	void begin(uint64_t numSamples, int numColumns, T *columnMin, T *columnMax);
+	void add(const T *samples, size_t count);
+	// when there are fewer samples than columns, the empty columns repeat their neighbour
+	void end();
+
+private:
+	void emitColumn();
+
+	uint64_t total;
+	int columns;
+	T *outMin;
+	T *outMax;
+
+	int column;				// column being accumulated
+	uint64_t position;		// samples consumed so far
+	uint64_t columnEnd;		// first sample of the next column
+	T runMin, runMax;
+	bool runEmpty;
+	int firstFilled;		// first column that got a sample, -1 until then
+	T lastValue;
+};
+
+// min and max of count samples, SIMD where available; count must be > 0
+void minMaxRange(const float *samples, size_t count, float *minimum, float *maximum);
+void minMaxRange(const int16_t *samples, size_t count, int16_t *minimum, int16_t *maximum);
@@ -0,0 +1,57 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2023  Neuro Software Developers, Inc.
+//
+// Contact Information:
+//
+// Email:
+// info@neurosoftware.com
+//
+// Website:
+// www.neurosoftware.com
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+#pragma once
+
+#include <stdint.h>
+
+#define EVENT_LOG_SIZE 64  // records kept, a power of two
+#define EVENT_MAX_CHANNELS 16
+
+// What the sample values overlay shows for one read: the newest frame, or the status of a failed read.
+struct EventRecord {
+	uint64_t sequence;
+	uint64_t sampleNum;		// samples read so far
+	uint64_t droppedFrames;
+	int status;				// 0, or the source's error code
+	int numChannels;
+	float volts[EVENT_MAX_CHANNELS];
+};
+
+// Fixed ring of binary event records. Logging one is a few stores and never allocates; turning them into text
+// is left to whoever displays them, so it only happens while they are on screen. Not thread safe.
+class EventLog {
+public:
+	EventLog() : written(0) {}
+
+	void clear() { written = 0; }
+
+	// the next record, overwriting the oldest once the ring is full; the caller fills in everything but sequence
+	EventRecord &append() {
+		EventRecord &record = records[written & (EVENT_LOG_SIZE - 1)];
+		record.sequence = written++;
+		return record;
+	}
+
+	uint64_t count() const { return written; }
+	int size() const { return written < EVENT_LOG_SIZE ? (int)written : EVENT_LOG_SIZE; }
+
+	// age 0 is the newest record, up to size() - 1
+	const EventRecord &recent(int age) const { return records[(written - 1 - age) & (EVENT_LOG_SIZE - 1)]; }
+
+private:
+	EventRecord records[EVENT_LOG_SIZE];
+	uint64_t written;
+};
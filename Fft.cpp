@@ -0,0 +1,136 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2023  Neuro Software Developers, Inc.
+//
+// Contact Information:
+//
+// Email:
+// info@neurosoftware.com
+//
+// Website:
+// www.neurosoftware.com
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "Fft.h"
+#include "SimdSupport.h"
+#include <math.h>
+
+static const double PI = 3.14159265358979323846;
+
+double makeWindow(FftWindow type, int size, float *window) {
+	// cosine sums a0 - a1 cos(x) + a2 cos(2x) - a3 cos(3x) + a4 cos(4x)
+	double a[5] = { 0.5, 0.5, 0, 0, 0 };
+	if (type == WINDOW_BLACKMAN) {
+		a[0] = 0.42; a[1] = 0.5; a[2] = 0.08;
+	}
+	else if (type == WINDOW_FLAT_TOP) {
+		a[0] = 0.21557895; a[1] = 0.41663158; a[2] = 0.277263158; a[3] = 0.083578947; a[4] = 0.006947368;
+	}
+	double sum = 0;
+	for (int i = 0; i < size; i++) {
+		double x = 2 * PI * i / size;  // periodic, the form that suits overlapped spectra
+		double w = a[0] - a[1] * cos(x) + a[2] * cos(2 * x) - a[3] * cos(3 * x) + a[4] * cos(4 * x);
+		window[i] = (float)w;
+		sum += w;
+	}
+	return sum;
+}
+
+FftPlan::FftPlan() : n(0) {
+}
+
+bool FftPlan::create(int size) {
+	if (size < 4 || (size & (size - 1)) != 0) return false;
+	n = size;
+	int bits = 0;
+	while ((1 << bits) < n) bits++;
+	reversed.resize(n);
+	for (int i = 0; i < n; i++) {
+		int r = 0;
+		for (int b = 0; b < bits; b++) {
+			if (i & (1 << b)) r |= 1 << (bits - 1 - b);
+		}
+		reversed[i] = r;
+	}
+	twiddleRe.assign(n, 0.0f);
+	twiddleIm.assign(n, 0.0f);
+	for (int h = 1; h < n; h <<= 1) {
+		for (int j = 0; j < h; j++) {
+			double angle = -PI * j / h;
+			twiddleRe[h + j] = (float)cos(angle);
+			twiddleIm[h + j] = (float)sin(angle);
+		}
+	}
+	return true;
+}
+
+void FftPlan::forward(float *re, float *im) const {
+	for (int i = 0; i < n; i++) {
+		int r = reversed[i];
+		if (r > i) {
+			float t = re[i]; re[i] = re[r]; re[r] = t;
+			t = im[i]; im[i] = im[r]; im[r] = t;
+		}
+	}
+
+	// the first two stages have trivial twiddles (1, and 1 and -i)
+	for (int a = 0; a < n; a += 4) {
+		float r0 = re[a] + re[a + 1], i0 = im[a] + im[a + 1];
+		float r1 = re[a] - re[a + 1], i1 = im[a] - im[a + 1];
+		float r2 = re[a + 2] + re[a + 3], i2 = im[a + 2] + im[a + 3];
+		float r3 = re[a + 2] - re[a + 3], i3 = im[a + 2] - im[a + 3];
+		re[a] = r0 + r2; im[a] = i0 + i2;
+		re[a + 2] = r0 - r2; im[a + 2] = i0 - i2;
+		// (r3 + i i3) * -i = i3 - i r3
+		re[a + 1] = r1 + i3; im[a + 1] = i1 - r3;
+		re[a + 3] = r1 - i3; im[a + 3] = i1 + r3;
+	}
+
+	for (int h = 4; h < n; h <<= 1) {
+		const float *wr = &twiddleRe[h];
+		const float *wi = &twiddleIm[h];
+		for (int start = 0; start < n; start += 2 * h) {
+			float *ar = re + start, *ai = im + start;
+			float *br = ar + h, *bi = ai + h;
+			int j = 0;
+#ifdef SCOPE_SSE2
+			for (; j + 4 <= h; j += 4) {
+				__m128 xr = _mm_loadu_ps(br + j), xi = _mm_loadu_ps(bi + j);
+				__m128 cr = _mm_loadu_ps(wr + j), ci = _mm_loadu_ps(wi + j);
+				__m128 tr = _mm_sub_ps(_mm_mul_ps(xr, cr), _mm_mul_ps(xi, ci));
+				__m128 ti = _mm_add_ps(_mm_mul_ps(xr, ci), _mm_mul_ps(xi, cr));
+				__m128 yr = _mm_loadu_ps(ar + j), yi = _mm_loadu_ps(ai + j);
+				_mm_storeu_ps(br + j, _mm_sub_ps(yr, tr));
+				_mm_storeu_ps(bi + j, _mm_sub_ps(yi, ti));
+				_mm_storeu_ps(ar + j, _mm_add_ps(yr, tr));
+				_mm_storeu_ps(ai + j, _mm_add_ps(yi, ti));
+			}
+#endif
+			for (; j < h; j++) {
+				float tr = br[j] * wr[j] - bi[j] * wi[j];
+				float ti = br[j] * wi[j] + bi[j] * wr[j];
+				br[j] = ar[j] - tr;
+				bi[j] = ai[j] - ti;
+				ar[j] += tr;
+				ai[j] += ti;
+			}
+		}
+	}
+}
+
+void FftPlan::realPairPower(const float *a, const float *b, float *re, float *im, float *powerA, float *powerB) const {
+	for (int i = 0; i < n; i++) {
+		re[i] = a[i];
+		im[i] = b[i];
+	}
+	forward(re, im);
+	// A[k] = (Z[k] + conj(Z[n-k])) / 2, B[k] = (Z[k] - conj(Z[n-k])) / 2i
+	for (int k = 0; k <= n / 2; k++) {
+		int m = (n - k) & (n - 1);
+		float sumRe = re[k] + re[m], diffRe = re[k] - re[m];
+		float sumIm = im[k] + im[m], diffIm = im[k] - im[m];
+		powerA[k] = (sumRe * sumRe + diffIm * diffIm) * 0.25f;
+		powerB[k] = (sumIm * sumIm + diffRe * diffRe) * 0.25f;
+	}
+}
@@ -0,0 +1,52 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2023  Neuro Software Developers, Inc.
+//
+// Contact Information:
+//
+// Email:
+// info@neurosoftware.com
+//
+// Website:
+// www.neurosoftware.com
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <vector>
+
+enum FftWindow {
+	WINDOW_HANN,		// general purpose
+	WINDOW_BLACKMAN,	// lower side lobes, for small signals next to big ones
+	WINDOW_FLAT_TOP		// accurate amplitudes whatever bin a tone falls between
+};
+
+// fills window with size coefficients and returns their sum (the coherent gain times size, for amplitude scaling)
+double makeWindow(FftWindow type, int size, float *window);
+
+// Radix-2 complex FFT of one power-of-two size. The bit reversal permutation and the twiddle factors of every
+// stage are worked out once by create(), stage by stage in the order the butterflies use them, so the inner
+// loops run over contiguous arrays four butterflies at a time. Real and imaginary parts live in separate
+// arrays for the same reason.
+class FftPlan {
+public:
+	FftPlan();
+
+	bool create(int size);	// false unless size is a power of two >= 4
+	int size() const { return n; }
+
+	// in place forward transform
+	void forward(float *re, float *im) const;
+
+	// power spectra |A[k]|^2 and |B[k]|^2, k = 0..size/2, of two real signals with one complex transform (a as the
+	// real part, b as the imaginary part, separated afterwards by the symmetry of real spectra). re and im are
+	// scratch of size() values.
+	void realPairPower(const float *a, const float *b, float *re, float *im, float *powerA, float *powerB) const;
+
+private:
+	int n;
+	std::vector<int> reversed;		// bit reversed index of every index
+	std::vector<float> twiddleRe;	// stage with half size h uses entries h .. 2h-1
+	std::vector<float> twiddleIm;
+};
@@ -0,0 +1,442 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2023  Neuro Software Developers, Inc.
+//
+// Contact Information:
+//
+// Email:
+// info@neurosoftware.com
+//
+// Website:
+// www.neurosoftware.com
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "FilterBank.h"
+#include "SimdSupport.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+using namespace std;
+
+#define PI 3.14159265358979323846
+#define BLOCK_FRAMES 256			// frames deinterleaved and filtered at a time
+#define NOTCH_Q 30					// default notch width: 1/30 of its frequency
+#define FIR_TAPS_PER_FACTOR 24		// decimating FIR length, per unit of decimation
+#define FIR_CUTOFF 0.4				// of the output rate: half amplitude at 80% of the output's Nyquist frequency, flat
+									// below about 55% of it and 74 dB down (Blackman) just past it
+#define COEFFICIENTS 5				// b0, b1, b2, a1, a2
+
+static string trim(const string &text) {
+	size_t first = 0, last = text.size();
+	while (first < last && isspace((unsigned char)text[first])) first++;
+	while (last > first && isspace((unsigned char)text[last - 1])) last--;
+	return text.substr(first, last - first);
+}
+
+static bool parseChannel(const string &text, int *value) {
+	if (text.empty() || !isdigit((unsigned char)text[0])) return false;
+	char *end;
+	long number = strtol(text.c_str(), &end, 10);
+	if (*end != 0 || number > 0xFFFF) return false;
+	*value = (int)number;
+	return true;
+}
+
+// Hz, with an optional k
+static bool parseHertz(const string &text, double *value) {
+	if (text.empty()) return false;
+	char *end;
+	*value = strtod(text.c_str(), &end);
+	if (*end == 'k' || *end == 'K') {
+		*value *= 1000;
+		end++;
+	}
+	return *end == 0 && *value > 0;
+}
+
+bool parseFilterList(const string &text, vector<FilterSpec> &filters, string &error) {
+	vector<FilterSpec> parsed;
+	size_t start = 0;
+	while (start <= text.size()) {
+		size_t semicolon = text.find(';', start);
+		if (semicolon == string::npos) semicolon = text.size();
+		string entry = trim(text.substr(start, semicolon - start));
+		start = semicolon + 1;
+		if (entry.empty()) continue;
+
+		FilterSpec filter;
+		size_t equals = entry.find('=');
+		if (equals != string::npos) {
+			string channels = trim(entry.substr(0, equals));
+			entry = trim(entry.substr(equals + 1));
+			size_t colon = channels.find(':');
+			bool ok = colon == string::npos ? parseChannel(channels, &filter.firstChannel) && parseChannel(channels, &filter.lastChannel) :
+				parseChannel(trim(channels.substr(0, colon)), &filter.firstChannel) && parseChannel(trim(channels.substr(colon + 1)), &filter.lastChannel) &&
+				filter.lastChannel >= filter.firstChannel;
+			if (!ok) {
+				error = "Bad channels \"" + channels + "\", expected N or N:M.";
+				return false;
+			}
+		}
+
+		size_t space = entry.find(' ');
+		string type = entry.substr(0, space);
+		string frequency = space == string::npos ? "" : trim(entry.substr(space + 1));
+		if (type == "lp") filter.type = FILTER_LOWPASS;
+		else if (type == "hp") filter.type = FILTER_HIGHPASS;
+		else if (type == "bp") filter.type = FILTER_BANDPASS;
+		else if (type == "notch") {
+			filter.type = FILTER_NOTCH;
+			filter.order = 2;
+		}
+		else {
+			error = "Unknown filter \"" + type + "\", expected lp, hp, bp or notch.";
+			return false;
+		}
+
+		size_t slash = frequency.find('/');
+		if (slash != string::npos) {
+			int order;
+			if (!parseChannel(trim(frequency.substr(slash + 1)), &order) || order < 2 || order % 2 != 0 || order > 2 * FILTER_MAX_SECTIONS) {
+				error = "Bad order in \"" + entry + "\", expected an even number from 2 to " + to_string(2 * FILTER_MAX_SECTIONS) + ".";
+				return false;
+			}
+			filter.order = order;
+			frequency = trim(frequency.substr(0, slash));
+		}
+		size_t dash = frequency.find('-');
+		bool ok;
+		if (filter.type == FILTER_BANDPASS) {
+			ok = dash != string::npos && parseHertz(trim(frequency.substr(0, dash)), &filter.low) &&
+				parseHertz(trim(frequency.substr(dash + 1)), &filter.high) && filter.high > filter.low;
+		}
+		else if (filter.type == FILTER_NOTCH && dash != string::npos) {
+			// explicit band
+			double low = 0, high = 0;
+			ok = parseHertz(trim(frequency.substr(0, dash)), &low) && parseHertz(trim(frequency.substr(dash + 1)), &high) && high > low;
+			filter.low = sqrt(low * high);
+			filter.high = high - low;
+		}
+		else {
+			ok = dash == string::npos && parseHertz(frequency, &filter.low);
+			filter.high = filter.type == FILTER_NOTCH ? filter.low / NOTCH_Q : 0;
+		}
+		if (!ok) {
+			error = filter.type == FILTER_BANDPASS ? "Bad band in \"" + entry + "\", expected low-high in Hz." : "Bad frequency in \"" + entry + "\".";
+			return false;
+		}
+		parsed.push_back(filter);
+	}
+	filters = parsed;
+	return true;
+}
+
+// RBJ cookbook biquads, normalized so a0 is 1
+static void lowPass(double w0, double q, double *c) {
+	double cosine = cos(w0), alpha = sin(w0) / (2 * q), a0 = 1 + alpha;
+	c[0] = (1 - cosine) / 2 / a0;
+	c[1] = (1 - cosine) / a0;
+	c[2] = c[0];
+	c[3] = -2 * cosine / a0;
+	c[4] = (1 - alpha) / a0;
+}
+
+static void highPass(double w0, double q, double *c) {
+	double cosine = cos(w0), alpha = sin(w0) / (2 * q), a0 = 1 + alpha;
+	c[0] = (1 + cosine) / 2 / a0;
+	c[1] = -(1 + cosine) / a0;
+	c[2] = c[0];
+	c[3] = -2 * cosine / a0;
+	c[4] = (1 - alpha) / a0;
+}
+
+static void notch(double w0, double q, double *c) {
+	double cosine = cos(w0), alpha = sin(w0) / (2 * q), a0 = 1 + alpha;
+	c[0] = 1 / a0;
+	c[1] = -2 * cosine / a0;
+	c[2] = c[0];
+	c[3] = c[1];
+	c[4] = (1 - alpha) / a0;
+}
+
+// Q of section k of a Butterworth filter of the given (even) order, from its pole pair's angle
+static double butterworthQ(int order, int k) {
+	return 1 / (2 * cos(PI * (2 * k + 1) / (2 * order)));
+}
+
+FilterBank::FilterBank() : channels(0), lanes(0), rate(0), factor(1), filtering(false), maxSections(0), delayAt(0), phase(0) {
+}
+
+// the code, fractional, at which the scaling polynomial crosses 0 V: a few Newton steps from the linear part's
+// root, which is the answer for a linear scaling and within a hair of it for a calibration polynomial
+static double zeroCode(const ChannelScaling &scaling) {
+	const double *c = scaling.coefficients;
+	if (c[1] == 0) return 0;
+	double x = -c[0] / c[1];
+	for (int i = 0; i < 4; i++) {
+		double value = c[0] + x * (c[1] + x * (c[2] + x * c[3]));
+		double slope = c[1] + x * (2 * c[2] + x * 3 * c[3]);
+		if (slope == 0) break;
+		x -= value / slope;
+	}
+	return x < -32768 ? -32768 : x > 32767 ? 32767 : x;
+}
+
+bool FilterBank::configure(int numChannels, double sampleRate, const vector<FilterSpec> &filters, int decimation,
+	const ChannelScaling *scaling) {
+	channels = numChannels > 0 ? numChannels : 0;
+	lanes = (channels + 1) & ~1;
+	rate = sampleRate;
+	factor = decimation < 1 ? 1 : decimation > FILTER_MAX_DECIMATION ? FILTER_MAX_DECIMATION : decimation;
+	filtering = false;
+	error.clear();
+	zeroCodes.assign(channels, 0.0);
+	for (int channel = 0; channel < channels && scaling != NULL; channel++) {
+		zeroCodes[channel] = zeroCode(scaling[channel]);
+	}
+
+	// every channel's sections, in cascade order
+	vector<double> designed((size_t)channels * FILTER_MAX_SECTIONS * COEFFICIENTS);
+	channelSections.assign(channels, 0);
+	for (size_t i = 0; i < filters.size(); i++) {
+		const FilterSpec &filter = filters[i];
+		double nyquist = rate / 2;
+		if (filter.low <= 0 || filter.low >= nyquist || (filter.type == FILTER_BANDPASS && filter.high >= nyquist)) {
+			error = "A filter frequency is above half the sample rate (" + to_string((long long)nyquist) + " Hz).";
+			return false;
+		}
+		if (filter.firstChannel >= channels || filter.lastChannel >= channels) {
+			error = "A filter is on channel " + to_string(filter.lastChannel >= channels ? filter.lastChannel : filter.firstChannel) +
+				", only " + to_string(channels) + " are acquired (numbered from 0).";
+			return false;
+		}
+		int last = filter.lastChannel < 0 ? channels - 1 : filter.lastChannel;
+		for (int channel = filter.firstChannel; channel <= last; channel++) {
+			int halves = filter.type == FILTER_BANDPASS ? 2 : 1;
+			int count = filter.order / 2 * halves;
+			if (channelSections[channel] + count > FILTER_MAX_SECTIONS) {
+				error = "Too many filters on channel " + to_string(channel) + ", at most " + to_string(2 * FILTER_MAX_SECTIONS) + " orders in all.";
+				return false;
+			}
+			for (int k = 0; k < count; k++) {
+				double *c = &designed[((size_t)channel * FILTER_MAX_SECTIONS + channelSections[channel]++) * COEFFICIENTS];
+				int order = filter.order, section = k % (order / 2);
+				switch (filter.type) {
+				case FILTER_LOWPASS:
+					lowPass(2 * PI * filter.low / rate, butterworthQ(order, section), c);
+					break;
+				case FILTER_HIGHPASS:
+					highPass(2 * PI * filter.low / rate, butterworthQ(order, section), c);
+					break;
+				case FILTER_BANDPASS:
+					if (k < order / 2) highPass(2 * PI * filter.low / rate, butterworthQ(order, section), c);
+					else lowPass(2 * PI * filter.high / rate, butterworthQ(order, section), c);
+					break;
+				case FILTER_NOTCH:
+					notch(2 * PI * filter.low / rate, filter.low / filter.high, c);
+					break;
+				}
+			}
+			filtering = true;
+		}
+	}
+
+	// interleave them by lane: a pair of channels runs as many sections as the longer of its two cascades, the
+	// shorter one passing through the extra ones (b0 = 1)
+	maxSections = 0;
+	for (int channel = 0; channel < channels; channel++) {
+		if (channelSections[channel] > maxSections) maxSections = channelSections[channel];
+	}
+	coefficients.assign((size_t)maxSections * lanes * COEFFICIENTS, 0.0);
+	for (int s = 0; s < maxSections; s++) {
+		for (int lane = 0; lane < lanes; lane++) {
+			double *c = &coefficients[(((size_t)s * (lanes / 2) + lane / 2) * COEFFICIENTS) * 2 + lane % 2];
+			if (lane < channels && s < channelSections[lane]) {
+				const double *source = &designed[((size_t)lane * FILTER_MAX_SECTIONS + s) * COEFFICIENTS];
+				for (int k = 0; k < COEFFICIENTS; k++) c[2 * k] = source[k];
+			}
+			else {
+				c[0] = 1;
+			}
+		}
+	}
+
+	// windowed sinc (Blackman) low-pass at the output rate, unity gain at DC
+	taps.clear();
+	if (factor > 1) {
+		int length = FIR_TAPS_PER_FACTOR * factor;
+		double cutoff = FIR_CUTOFF / factor;	// cycles per input sample
+		double sum = 0;
+		taps.resize(length);
+		for (int i = 0; i < length; i++) {
+			double t = i - (length - 1) / 2.0;
+			double sinc = t == 0 ? 2 * cutoff : sin(2 * PI * cutoff * t) / (PI * t);
+			double window = 0.42 - 0.5 * cos(2 * PI * i / (length - 1)) + 0.08 * cos(4 * PI * i / (length - 1));
+			taps[i] = sinc * window;
+			sum += taps[i];
+		}
+		// each tap twice, once for either lane of a pair
+		taps.resize(2 * length);
+		for (int i = length - 1; i >= 0; i--) {
+			taps[2 * i] = taps[2 * i + 1] = taps[i] / sum;
+		}
+	}
+
+	block.assign((size_t)BLOCK_FRAMES * lanes, 0.0);
+	decimated.assign(factor > 1 ? (size_t)BLOCK_FRAMES * lanes : 0, 0.0);
+	reset();
+	return true;
+}
+
+void FilterBank::reset() {
+	state.assign((size_t)maxSections * lanes * 2, 0.0);
+	delay.assign(taps.size() * lanes, 0.0);
+	delayAt = 0;
+	phase = 0;
+}
+
+// Transposed direct form II, one pair of channels at a time through all of its sections, each section over the
+// whole block so its coefficients and state stay in registers.
+void FilterBank::runSections(double *samples, size_t numFrames) {
+	int pairs = lanes / 2;
+	for (int p = 0; p < pairs; p++) {
+		double *x0 = samples + (size_t)p * BLOCK_FRAMES * 2;
+		for (int s = 0; s < maxSections; s++) {
+			const double *c = &coefficients[((size_t)s * pairs + p) * COEFFICIENTS * 2];
+			double *z = &state[((size_t)s * pairs + p) * 4];
+#ifdef SCOPE_SSE2
+			__m128d b0 = _mm_loadu_pd(c), b1 = _mm_loadu_pd(c + 2), b2 = _mm_loadu_pd(c + 4);
+			__m128d a1 = _mm_loadu_pd(c + 6), a2 = _mm_loadu_pd(c + 8);
+			__m128d z1 = _mm_loadu_pd(z), z2 = _mm_loadu_pd(z + 2);
+			double *x = x0;
+			for (size_t f = 0; f < numFrames; f++, x += 2) {
+				__m128d in = _mm_loadu_pd(x);
+				__m128d out = _mm_add_pd(_mm_mul_pd(b0, in), z1);
+				z1 = _mm_add_pd(_mm_sub_pd(_mm_mul_pd(b1, in), _mm_mul_pd(a1, out)), z2);
+				z2 = _mm_sub_pd(_mm_mul_pd(b2, in), _mm_mul_pd(a2, out));
+				_mm_storeu_pd(x, out);
+			}
+			_mm_storeu_pd(z, z1);
+			_mm_storeu_pd(z + 2, z2);
+#else
+			for (int lane = 0; lane < 2; lane++) {
+				double b0 = c[lane], b1 = c[2 + lane], b2 = c[4 + lane], a1 = c[6 + lane], a2 = c[8 + lane];
+				double z1 = z[lane], z2 = z[2 + lane];
+				double *x = x0 + lane;
+				for (size_t f = 0; f < numFrames; f++, x += 2) {
+					double in = *x;
+					double out = b0 * in + z1;
+					z1 = b1 * in - a1 * out + z2;
+					z2 = b2 * in - a2 * out;
+					*x = out;
+				}
+				z[lane] = z1;
+				z[2 + lane] = z2;
+			}
+#endif
+		}
+	}
+}
+
+// Keeps every factor-th sample of the FIR's output, computing only those. Each pair's delay line holds its last
+// taps samples twice over, so the window ending at the newest sample is always contiguous.
+size_t FilterBank::decimate(const double *samples, size_t numFrames, double *out) {
+	int pairs = lanes / 2;
+	int length = (int)taps.size() / 2;
+	size_t produced = 0;
+	int at = delayAt, ph = phase;
+	for (int p = 0; p < pairs; p++) {
+		const double *x = samples + (size_t)p * BLOCK_FRAMES * 2;
+		double *line = &delay[(size_t)p * length * 4];
+		double *y = out + (size_t)p * BLOCK_FRAMES * 2;
+		at = delayAt;
+		ph = phase;
+		produced = 0;
+		for (size_t f = 0; f < numFrames; f++, x += 2) {
+			line[2 * at] = line[2 * (at + length)] = x[0];
+			line[2 * at + 1] = line[2 * (at + length) + 1] = x[1];
+			if (++at == length) at = 0;
+			if (++ph < factor) continue;
+			ph = 0;
+
+			// line[at .. at + length) runs from the oldest sample to the newest; the taps are symmetric
+			const double *window = line + 2 * at;
+			const double *h = taps.data();
+#ifdef SCOPE_SSE2
+			// four sums in flight, the length is a multiple of FIR_TAPS_PER_FACTOR
+			__m128d sum0 = _mm_setzero_pd(), sum1 = _mm_setzero_pd(), sum2 = _mm_setzero_pd(), sum3 = _mm_setzero_pd();
+			for (int k = 0; k < 2 * length; k += 8) {
+				sum0 = _mm_add_pd(sum0, _mm_mul_pd(_mm_loadu_pd(h + k), _mm_loadu_pd(window + k)));
+				sum1 = _mm_add_pd(sum1, _mm_mul_pd(_mm_loadu_pd(h + k + 2), _mm_loadu_pd(window + k + 2)));
+				sum2 = _mm_add_pd(sum2, _mm_mul_pd(_mm_loadu_pd(h + k + 4), _mm_loadu_pd(window + k + 4)));
+				sum3 = _mm_add_pd(sum3, _mm_mul_pd(_mm_loadu_pd(h + k + 6), _mm_loadu_pd(window + k + 6)));
+			}
+			_mm_storeu_pd(y, _mm_add_pd(_mm_add_pd(sum0, sum1), _mm_add_pd(sum2, sum3)));
+#else
+			double sum0 = 0, sum1 = 0;
+			for (int k = 0; k < 2 * length; k += 2) {
+				sum0 += h[k] * window[k];
+				sum1 += h[k + 1] * window[k + 1];
+			}
+			y[0] = sum0;
+			y[1] = sum1;
+#endif
+			y += 2;
+			produced++;
+		}
+	}
+	delayAt = at;
+	phase = ph;
+	return produced;
+}
+
+size_t FilterBank::process(const int16_t *in, size_t numFrames, int16_t *out) {
+	if (!active()) {
+		if (out != in) memcpy(out, in, numFrames * channels * sizeof(int16_t));
+		return numFrames;
+	}
+	size_t written = 0;
+	while (numFrames > 0) {
+		size_t n = numFrames < BLOCK_FRAMES ? numFrames : BLOCK_FRAMES;
+
+		// deinterleave into pairs of lanes, [pair][frame][2]
+		for (int c = 0; c < channels; c++) {
+			double *x = &block[(size_t)(c / 2) * BLOCK_FRAMES * 2 + c % 2];
+			const int16_t *code = in + c;
+			double zero = zeroCodes[c];
+			for (size_t f = 0; f < n; f++) {
+				x[2 * f] = *code - zero;
+				code += channels;
+			}
+		}
+		in += n * channels;
+		numFrames -= n;
+
+		runSections(block.data(), n);
+		const double *result = block.data();
+		size_t m = n;
+		if (factor > 1) {
+			m = decimate(block.data(), n, decimated.data());
+			result = decimated.data();
+		}
+
+		// back from 0 V to the codes' origin and round, saturating; out can't overtake in, at most as many frames
+		// come out as went in
+		for (int c = 0; c < channels; c++) {
+			const double *y = result + (size_t)(c / 2) * BLOCK_FRAMES * 2 + c % 2;
+			int16_t *code = out + written * channels + c;
+			double zero = zeroCodes[c];
+			for (size_t f = 0; f < m; f++) {
+				double v = y[2 * f] + zero;
+				v = v < -32768 ? -32768 : v > 32767 ? 32767 : v;
+				*code = (int16_t)(v < 0 ? v - 0.5 : v + 0.5);
+				code += channels;
+			}
+		}
+		written += m;
+	}
+	return written;
+}
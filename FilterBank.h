@@ -0,0 +1,107 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2023  Neuro Software Developers, Inc.
+//
+// Contact Information:
+//
+// Email:
+// info@neurosoftware.com
+//
+// Website:
+// www.neurosoftware.com
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <vector>
+#include <string>
+#include <stdint.h>
+#include <stddef.h>
+#include "Scaling.h"
+
+#define FILTER_MAX_SECTIONS 8		// biquads cascaded on one channel, all of its filters together
+#define FILTER_MAX_DECIMATION 64
+
+enum FilterType {
+	FILTER_LOWPASS,
+	FILTER_HIGHPASS,
+	FILTER_BANDPASS,	// a high-pass at low cascaded with a low-pass at high
+	FILTER_NOTCH		// at low, high - low wide
+};
+
+// one filter on a range of channels; several on the same channel are cascaded in the order given
+struct FilterSpec {
+	int firstChannel, lastChannel;	// frame order, inclusive; lastChannel -1 for every channel from firstChannel on
+	FilterType type;
+	double low, high;				// Hz: the cutoff in low (high-pass, low-pass), or the band
+	int order;						// of the Butterworth low/high-pass (even), of the band-pass's two halves; notches
+									// of order > 2 are repeated to deepen them
+
+	FilterSpec() : firstChannel(0), lastChannel(-1), type(FILTER_LOWPASS), low(0), high(0), order(4) {}
+};
+
+// "notch 60; 0:3=lp 1k/4; 5=bp 100-2k; hp 0.5" -> filters. An entry is [channels=]type frequency[/order], with
+// channels "N" or "N:M" (by position in the frame, default all), type lp, hp, bp or notch, frequencies in Hz with
+// an optional k suffix, and "low-high" for a band-pass (a notch's default width is 1/30 of its frequency).
+bool parseFilterList(const std::string &text, std::vector<FilterSpec> &filters, std::string &error);
+
+// The conditioning stage between acquisition and the history: per channel cascades of biquads, then optionally
+// decimation by a decimating FIR low-pass that brings the stored rate down.
+//
+// It works on raw codes, filtered as numbers and rounded (saturating) back to codes, so the history, the
+// measurements and everything that draws keep working on int16 codes. The filters see each channel's codes
+// relative to the (fractional) code of 0 V under its scaling, which is added back before rounding: a filter
+// that strips DC then settles at 0 V rather than at the scaling's offset, and for the linear part of the
+// scaling filtering these codes is the same as filtering volts. Frames are processed in blocks, deinterleaved into one SIMD
+// lane per channel: each pair of channels shares an SSE2 vector of doubles through the whole cascade, with
+// its own coefficients in its lane. Double because a 50 Hz notch at MS/s rates needs poles closer to the unit
+// circle than a float can place. The FIR only computes the samples it keeps, which is the cost of a polyphase
+// decimator, and its taps stay at one vector per pair however many channels there are. Filter and FIR state
+// carries over from one block to the next, so the output doesn't depend on how the frames are split up.
+class FilterBank {
+public:
+	FilterBank();
+
+	// false (see errorString()) when a filter doesn't fit the sample rate, e.g. a cutoff above half of it;
+	// scaling has one entry per channel, NULL when code 0 is 0 V on every channel
+	bool configure(int numChannels, double sampleRate, const std::vector<FilterSpec> &filters, int decimation,
+		const ChannelScaling *scaling);
+	void reset();	// back to rest, as if no samples had come through yet
+
+	bool active() const { return filtering || factor > 1; }	// does process() change anything
+	int decimation() const { return factor; }
+	double outputRate() const { return rate / factor; }
+	int sections(int channel) const { return channel < (int)channelSections.size() ? channelSections[channel] : 0; }
+	const std::string &errorString() const { return error; }
+
+	// numFrames interleaved frames in, the filtered ones out (numFrames / decimation() of them, give or take one
+	// for the decimation phase carried over); returns how many were written. out may be the same as in.
+	size_t process(const int16_t *in, size_t numFrames, int16_t *out);
+
+private:
+	void runSections(double *block, size_t numFrames);
+	size_t decimate(const double *block, size_t numFrames, double *decimated);
+
+	int channels;
+	int lanes;			// channels rounded up to a whole number of vectors
+	double rate;
+	int factor;
+	bool filtering;
+	std::string error;
+
+	std::vector<int> channelSections;
+	std::vector<double> zeroCodes;	// per channel, the code of 0 V
+	int maxSections;
+	// per section, per pair of lanes: b0, b1, b2, a1, a2 and the state z1, z2, each a vector of 2 lanes
+	std::vector<double> coefficients;
+	std::vector<double> state;
+
+	std::vector<double> taps;		// each one twice, for the two lanes of a vector
+	std::vector<double> delay;		// per pair of lanes, 2 * taps of 2 lanes: a ring stored twice to read straight
+	int delayAt;
+	int phase;						// input samples since the last one kept
+
+	std::vector<double> block;		// a block of frames, lanes per frame
+	std::vector<double> decimated;
+};
@@ -0,0 +1,91 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2023  Neuro Software Developers, Inc.
+//
+// Contact Information:
+//
+// Email:
+// info@neurosoftware.com
+//
+// Website:
+// www.neurosoftware.com
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "FrameScheduler.h"
+
+using namespace std;
+
+#define BUDGET_FRACTION 0.5			// of the frame interval a frame may take, the rest is for the message loop and the OS
+#define BENCHMARK_BUDGET (1.0 / 60)	// unlimited frame rate has no interval, judge it against 60 Hz
+#define BACKLOG_HIGH 0.25			// ring this full at the start of a frame: the display is falling behind
+#define BACKLOG_LOW 0.05
+#define CALM_FRAMES 30				// frames in a row well inside the budget before detail comes back
+#define COST_SMOOTHING 0.1
+
+FrameScheduler::FrameScheduler() : rate(60), interval(1.0 / 60), averageCost(0), level(0), calmFrames(0), countFrames(0),
+	fps(0), rendered(0), skipped(0) {
+	next = began = countStart = Clock::now();
+}
+
+void FrameScheduler::setFrameRate(double framesPerSecond) {
+	rate = framesPerSecond > 0 ? framesPerSecond : FRAME_RATE_UNLIMITED;
+	interval = rate > 0 ? 1.0 / rate : 0;
+	next = Clock::now();
+	level = 0;
+	calmFrames = 0;
+}
+
+bool FrameScheduler::due() const {
+	return Clock::now() >= next;
+}
+
+unsigned int FrameScheduler::waitMilliseconds() const {
+	double wait = chrono::duration<double>(next - Clock::now()).count();
+	return wait > 0 ? (unsigned int)(wait * 1000 + 0.5) : 0;
+}
+
+void FrameScheduler::beginFrame() {
+	began = Clock::now();
+	// the next frame is due an interval after this one started; a late frame doesn't make the following ones bunch up
+	next += chrono::duration_cast<Clock::duration>(chrono::duration<double>(interval));
+	if (next < began) next = began;
+}
+
+void FrameScheduler::endFrame(bool wasRendered, double backlog) {
+	Clock::time_point now = Clock::now();
+	if (!wasRendered) {
+		skipped++;
+		return;
+	}
+	rendered++;
+
+	double cost = chrono::duration<double>(now - began).count();
+	averageCost = averageCost == 0 ? cost : averageCost + (cost - averageCost) * COST_SMOOTHING;
+
+	countFrames++;
+	double counted = chrono::duration<double>(now - countStart).count();
+	if (counted >= 1.0) {
+		fps = countFrames / counted;
+		countFrames = 0;
+		countStart = now;
+	}
+
+	if (benchmark()) return;  // the benchmark measures full detail
+
+	double budget = (interval > 0 ? interval : BENCHMARK_BUDGET) * BUDGET_FRACTION;
+	if ((averageCost > budget || backlog > BACKLOG_HIGH) && level < SCHEDULER_MAX_DETAIL) {
+		level++;
+		calmFrames = 0;
+		averageCost = budget;  // give the new level a chance before judging it
+	}
+	else if (averageCost < budget / 4 && backlog < BACKLOG_LOW) {
+		if (++calmFrames >= CALM_FRAMES && level > 0) {
+			level--;
+			calmFrames = 0;
+		}
+	}
+	else {
+		calmFrames = 0;
+	}
+}
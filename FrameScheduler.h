@@ -0,0 +1,73 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2023  Neuro Software Developers, Inc.
+//
+// Contact Information:
+//
+// Email:
+// info@neurosoftware.com
+//
+// Website:
+// www.neurosoftware.com
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <chrono>
+#include <stdint.h>
+
+#define FRAME_RATE_UNLIMITED 0		// benchmark: a frame as soon as the last one is done, changed or not
+#define SCHEDULER_MAX_DETAIL 4		// coarsest detail level, every 16th run of samples (see sampleStride())
+
+// Decides when the window draws a frame. Frames are due at a fixed rate (e.g. 60 Hz, or the monitor's refresh
+// when the caller syncs to it), and the caller sleeps in between rather than polling; a due frame with nothing
+// new to show is skipped, so an idle or slowly sampled display costs almost nothing.
+//
+// Each frame is timed against a budget of a fraction of the frame interval. When frames run over, or samples
+// pile up in the acquisition ring faster than the display drains them, the detail level goes up: the per sample
+// work of drawing (peak-detect envelope, persistence accumulation) then looks at only some of the samples. The
+// level comes back down once frames are comfortably inside the budget again. Dropping detail keeps the display
+// draining the ring so acquisition never has to drop samples.
+class FrameScheduler {
+public:
+	FrameScheduler();
+
+	// frames per second, or FRAME_RATE_UNLIMITED
+	void setFrameRate(double fps);
+	double frameRate() const { return rate; }
+	bool benchmark() const { return rate == FRAME_RATE_UNLIMITED; }
+
+	bool due() const;
+	unsigned int waitMilliseconds() const;	// until the next frame is due, 0 when it already is
+
+	void beginFrame();
+	// rendered is false when the frame was skipped; backlog is how full the acquisition ring was (0..1)
+	void endFrame(bool rendered, double backlog);
+
+	int detail() const { return level; }	// 0 is full detail
+	int sampleStride() const { return 1 << level; }
+
+	// over the last second or so of rendered frames
+	double framesPerSecond() const { return fps; }
+	double frameMilliseconds() const { return averageCost * 1000; }
+	uint64_t framesRendered() const { return rendered; }
+	uint64_t framesSkipped() const { return skipped; }
+
+private:
+	typedef std::chrono::steady_clock Clock;
+
+	double rate;
+	double interval;			// seconds
+	Clock::time_point next;		// when the next frame is due
+	Clock::time_point began;
+	double averageCost;			// seconds per rendered frame, smoothed
+	int level;
+	int calmFrames;				// rendered frames in a row well inside the budget
+
+	Clock::time_point countStart;
+	uint64_t countFrames;
+	double fps;
+	uint64_t rendered;
+	uint64_t skipped;
+};
@@ -0,0 +1,139 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2023  Neuro Software Developers, Inc.
+//
+// Contact Information:
+//
+// Email:
+// info@neurosoftware.com
+//
+// Website:
+// www.neurosoftware.com
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "HistoryBuffer.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#include <malloc.h>
+#else
+#include <stdlib.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <sys/mman.h>
+#endif
+
+using namespace std;
+
+#define STORAGE_ALIGNMENT 4096
+
+HistoryStorage::HistoryStorage() : base(NULL), size(0), mapped(false) {
+#ifdef _WIN32
+	fileHandle = INVALID_HANDLE_VALUE;
+	mappingHandle = NULL;
+#else
+	fileDescriptor = -1;
+#endif
+}
+
+HistoryStorage::~HistoryStorage() {
+	release();
+}
+
+void *HistoryStorage::allocate(uint64_t bytes, uint64_t ramLimitBytes, const string &spillDirectory) {
+	release();
+	error.clear();
+
+	if ((uint64_t)(size_t)bytes != bytes) {
+		error = "History is larger than this build can address, use the 64 bit build.";
+		return NULL;
+	}
+
+	if (bytes <= ramLimitBytes || spillDirectory.empty()) {
+#ifdef _WIN32
+		base = _aligned_malloc((size_t)bytes, STORAGE_ALIGNMENT);
+#else
+		if (posix_memalign(&base, STORAGE_ALIGNMENT, (size_t)bytes) != 0) base = NULL;
+#endif
+		if (base == NULL) {
+			error = "Not enough memory for the history buffer.";
+			return NULL;
+		}
+		size = bytes;
+		mapped = false;
+		return base;
+	}
+
+	// spill to a temporary file that the OS pages in and out for us
+#ifdef _WIN32
+	char fileName[MAX_PATH];
+	if (GetTempFileNameA(spillDirectory.c_str(), "osc", 0, fileName) == 0) {
+		error = "Could not create a history file in " + spillDirectory;
+		return NULL;
+	}
+	fileHandle = CreateFileA(fileName, GENERIC_READ | GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_TEMPORARY | FILE_FLAG_DELETE_ON_CLOSE, NULL);
+	if (fileHandle == INVALID_HANDLE_VALUE) {
+		error = "Could not open history file " + string(fileName);
+		return NULL;
+	}
+	mappingHandle = CreateFileMappingA(fileHandle, NULL, PAGE_READWRITE, (DWORD)(bytes >> 32), (DWORD)bytes, NULL);
+	if (mappingHandle != NULL) {
+		base = MapViewOfFile(mappingHandle, FILE_MAP_ALL_ACCESS, 0, 0, (size_t)bytes);
+	}
+#else
+	string pattern = spillDirectory + "/oscXXXXXX";
+	fileDescriptor = mkstemp(&pattern[0]);
+	if (fileDescriptor < 0) {
+		error = "Could not create a history file in " + spillDirectory;
+		return NULL;
+	}
+	unlink(pattern.c_str());  // the file disappears with the last reference to it
+	if (ftruncate(fileDescriptor, (off_t)bytes) == 0) {
+		base = mmap(NULL, (size_t)bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fileDescriptor, 0);
+		if (base == MAP_FAILED) base = NULL;
+	}
+#endif
+	if (base == NULL) {
+		error = "Could not map a history file of that size.";
+		release();
+		return NULL;
+	}
+	size = bytes;
+	mapped = true;
+	return base;
+}
+
+void HistoryStorage::release() {
+	if (base != NULL) {
+		if (mapped) {
+#ifdef _WIN32
+			UnmapViewOfFile(base);
+#else
+			munmap(base, (size_t)size);
+#endif
+		}
+		else {
+#ifdef _WIN32
+			_aligned_free(base);
+#else
+			free(base);
+#endif
+		}
+	}
+#ifdef _WIN32
+	if (mappingHandle != NULL) CloseHandle(mappingHandle);
+	if (fileHandle != INVALID_HANDLE_VALUE) CloseHandle(fileHandle);
+	mappingHandle = NULL;
+	fileHandle = INVALID_HANDLE_VALUE;
+#else
+	if (fileDescriptor >= 0) close(fileDescriptor);
+	fileDescriptor = -1;
+#endif
+	base = NULL;
+	size = 0;
+	mapped = false;
+}
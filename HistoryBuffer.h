@@ -0,0 +1,152 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2023  Neuro Software Developers, Inc.
+//
+// Contact Information:
+//
+// Email:
+// info@neurosoftware.com
+//
+// Website:
+// www.neurosoftware.com
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <string>
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#define HISTORY_CHUNK_BYTES 65536	// one chunk of one channel, a multiple of the cache line and page size
+
+// Raw memory behind a HistoryBuffer: page aligned RAM up to ramLimitBytes, beyond that a memory-mapped
+// temporary file in spillDirectory (deleted when released) so captures can be larger than physical memory.
+class HistoryStorage {
+public:
+	HistoryStorage();
+	~HistoryStorage();
+
+	void *allocate(uint64_t bytes, uint64_t ramLimitBytes, const std::string &spillDirectory);
+	void release();
+
+	void *data() const { return base; }
+	uint64_t bytes() const { return size; }
+	bool spilled() const { return mapped; }
+	const std::string &errorString() const { return error; }
+
+private:
+	HistoryStorage(const HistoryStorage &);
+	HistoryStorage &operator=(const HistoryStorage &);
+
+	void *base;
+	uint64_t size;
+	bool mapped;
+	std::string error;
+#ifdef _WIN32
+	void *fileHandle;
+	void *mappingHandle;
+#else
+	int fileDescriptor;
+#endif
+};
+
+// Runtime sized display history of numChannels channels. Each channel is stored as its own run of samples
+// (structure of arrays) split into cache-line aligned chunks; once full it keeps the most recent capacity()
+// samples, overwriting the oldest. Samples are addressed by their absolute index since the last clear().
+template <typename T>
+class HistoryBuffer {
+public:
+	HistoryBuffer() : channels(0), chunkSamples(HISTORY_CHUNK_BYTES / sizeof(T)), numChunks(0), total(0), base(NULL) {}
+
+	// capacity is rounded up to whole chunks; returns false (see errorString()) if the storage can't be had
+	bool allocate(int numChannels, uint64_t capacitySamples, uint64_t ramLimitBytes, const std::string &spillDirectory) {
+		release();
+		uint64_t chunks = (capacitySamples + chunkSamples - 1) / chunkSamples;
+		if (chunks < 1) chunks = 1;
+		base = (unsigned char *)storage.allocate(chunks * numChannels * HISTORY_CHUNK_BYTES, ramLimitBytes, spillDirectory);
+		if (base == NULL) return false;
+		channels = numChannels;
+		numChunks = chunks;
+		total = 0;
+		return true;
+	}
+
+	void release() {
+		storage.release();
+		base = NULL;
+		channels = 0;
+		numChunks = 0;
+		total = 0;
+	}
+
+	// forgets everything, O(1) at any size
+	void clear() { total = 0; }
+
+	// O(1) per sample: appends interleaved frames (one sample per channel each), overwriting the oldest when full
+	void append(const T *frames, size_t numFrames) {
+		while (numFrames > 0) {
+			size_t offset = (size_t)(total % chunkSamples);
+			size_t n = chunkSamples - offset;
+			if (n > numFrames) n = numFrames;
+			uint64_t chunk = (total / chunkSamples) % numChunks;
+			for (int channel = 0; channel < channels; channel++) {
+				T *dst = chunkData(chunk, channel) + offset;
+				const T *src = frames + channel;
+				for (size_t i = 0; i < n; i++) {
+					dst[i] = src[i * channels];
+				}
+			}
+			frames += n * channels;
+			numFrames -= n;
+			total += n;
+		}
+	}
+
+	int numChannels() const { return channels; }
+	uint64_t capacity() const { return numChunks * chunkSamples; }
+	uint64_t written() const { return total; }		// index of the next sample to be appended
+	uint64_t oldest() const { return total > capacity() ? total - capacity() : 0; }
+	uint64_t size() const { return total - oldest(); }
+	bool spilled() const { return storage.spilled(); }
+	const std::string &errorString() const { return storage.errorString(); }
+
+	// points samples at sample index of channel (which must be held) and returns how many of the next
+	// count samples follow it contiguously; walk a range by calling it until the range is used up
+	size_t span(int channel, uint64_t index, uint64_t count, const T **samples) const {
+		size_t offset = (size_t)(index % chunkSamples);
+		*samples = chunkData((index / chunkSamples) % numChunks, channel) + offset;
+		size_t n = chunkSamples - offset;
+		return count < n ? (size_t)count : n;
+	}
+
+	T at(int channel, uint64_t index) const {
+		return chunkData((index / chunkSamples) % numChunks, channel)[index % chunkSamples];
+	}
+
+	// copies count samples of channel starting at index into out
+	void read(int channel, uint64_t index, uint64_t count, T *out) const {
+		while (count > 0) {
+			const T *samples;
+			size_t n = span(channel, index, count, &samples);
+			memcpy(out, samples, n * sizeof(T));
+			out += n;
+			index += n;
+			count -= n;
+		}
+	}
+
+private:
+	// chunks of all channels for one stretch of time sit next to each other, so appends touch nearby memory
+	T *chunkData(uint64_t chunk, int channel) const {
+		return (T *)(base + (chunk * channels + channel) * HISTORY_CHUNK_BYTES);
+	}
+
+	HistoryStorage storage;
+	int channels;
+	size_t chunkSamples;
+	uint64_t numChunks;
+	uint64_t total;
+	unsigned char *base;
+};
@@ -0,0 +1,273 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2023  Neuro Software Developers, Inc.
+//
+// Contact Information:
+//
+// Email:
+// info@neurosoftware.com
+//
+// Website:
+// www.neurosoftware.com
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "Measurements.h"
+#include "SimdSupport.h"
+#include <math.h>
+
+using namespace std;
+
+#define WINDOW_BLOCKS 64			// blocks per window, the granularity at which it slides
+#define MIN_BLOCK_FRAMES 16
+#define MAX_BLOCK_FRAMES (1 << 22)	// keeps in-block sample indices exact in a float
+#define STAGE_FRAMES 256			// frames converted and folded in at a time, short enough for float partial sums
+#define HYSTERESIS 0.05				// of the window's peak-to-peak range
+
+Measurements::Measurements() : channels(0), lanes(0), rate(0), blockFrames(MIN_BLOCK_FRAMES), windowBlocks(1), inBlock(0), blockStart(0), blocksDone(0) {
+}
+
+void Measurements::configure(int numChannels, double sampleRate, const ChannelScaling *scaling, double windowSeconds) {
+	channels = numChannels > 0 ? numChannels : 0;
+	lanes = (channels + 3) & ~3;
+	rate = sampleRate;
+
+	double windowFrames = windowSeconds * sampleRate;
+	double perBlock = windowFrames / WINDOW_BLOCKS;
+	blockFrames = perBlock < MIN_BLOCK_FRAMES ? MIN_BLOCK_FRAMES : perBlock > MAX_BLOCK_FRAMES ? MAX_BLOCK_FRAMES : (size_t)perBlock;
+	windowBlocks = (size_t)ceil(windowFrames / blockFrames);
+	if (windowBlocks < 1) windowBlocks = 1;
+
+	// padding lanes get an all-zero polynomial and just measure silence
+	coefficients.assign(SCALING_COEFFICIENTS * lanes, 0.0f);
+	for (int c = 0; c < channels; c++) {
+		for (int k = 0; k < SCALING_COEFFICIENTS; k++) {
+			coefficients[k * lanes + c] = (float)scaling[c].coefficients[k];
+		}
+	}
+	staged.assign(STAGE_FRAMES * lanes, 0.0f);
+	blocks.resize(windowBlocks * channels);
+	results.resize(channels);
+	reset();
+}
+
+void Measurements::reset() {
+	shift.assign(lanes, 0.0f);
+	low.assign(lanes, 0.0f);
+	high.assign(lanes, 0.0f);
+	level.assign(lanes, 0.0f);
+	armed.assign(lanes, 0.0f);
+	sum.assign(lanes, 0.0);
+	sumSquares.assign(lanes, 0.0);
+	minimum.assign(lanes, 0.0f);
+	maximum.assign(lanes, 0.0f);
+	above.assign(lanes, 0.0);
+	rises.assign(lanes, 0.0);
+	firstRise.assign(lanes, -1.0f);
+	lastRise.assign(lanes, -1.0f);
+	inBlock = 0;
+	blockStart = 0;
+	blocksDone = 0;
+	for (size_t i = 0; i < results.size(); i++) results[i] = Measurement();
+}
+
+void Measurements::add(const int16_t *frames, size_t numFrames) {
+	if (channels == 0) return;
+	while (numFrames > 0) {
+		size_t n = blockFrames - inBlock;
+		if (n > STAGE_FRAMES) n = STAGE_FRAMES;
+		if (n > numFrames) n = numFrames;
+
+		// widen to one lane per channel; the scaling polynomial is applied lane-wise in accumulate
+		float *out = staged.data();
+		for (size_t f = 0; f < n; f++) {
+			for (int c = 0; c < channels; c++) out[c] = frames[c];
+			out += lanes;
+			frames += channels;
+		}
+		accumulate(staged.data(), n);
+		inBlock += n;
+		numFrames -= n;
+		if (inBlock == blockFrames) finishBlock();
+	}
+}
+
+// Folds numFrames staged frames into the current block. Every lane carries its own running state through the
+// batch, so crossings are detected branch-free: a rise is an armed lane going above the high threshold, and a
+// lane re-arms once it drops below the low one.
+void Measurements::accumulate(const float *codes, size_t numFrames) {
+	const float *c0 = &coefficients[0], *c1 = &coefficients[lanes], *c2 = &coefficients[2 * lanes], *c3 = &coefficients[3 * lanes];
+	bool fresh = inBlock == 0;
+#ifdef SCOPE_SSE2
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128 zero = _mm_setzero_ps();
+	for (int g = 0; g < lanes; g += 4) {
+		__m128 k0 = _mm_loadu_ps(c0 + g), k1 = _mm_loadu_ps(c1 + g), k2 = _mm_loadu_ps(c2 + g), k3 = _mm_loadu_ps(c3 + g);
+		__m128 offset = _mm_loadu_ps(&shift[g]);
+		__m128 lo = _mm_loadu_ps(&low[g]), hi = _mm_loadu_ps(&high[g]), mid = _mm_loadu_ps(&level[g]);
+		__m128 arm = _mm_loadu_ps(&armed[g]);
+		__m128 mn, mx;
+		if (fresh) {
+			mn = _mm_set1_ps(3.4e38f);
+			mx = _mm_set1_ps(-3.4e38f);
+		} else {
+			mn = _mm_loadu_ps(&minimum[g]);
+			mx = _mm_loadu_ps(&maximum[g]);
+		}
+		__m128 first = _mm_loadu_ps(&firstRise[g]), last = _mm_loadu_ps(&lastRise[g]);
+		__m128 s = zero, s2 = zero, up = zero, risen = zero;
+		__m128 index = _mm_set1_ps((float)inBlock);
+
+		const float *x = codes + g;
+		for (size_t f = 0; f < numFrames; f++, x += lanes) {
+			__m128 code = _mm_loadu_ps(x);
+			__m128 v = _mm_add_ps(k0, _mm_mul_ps(code, _mm_add_ps(k1, _mm_mul_ps(code, _mm_add_ps(k2, _mm_mul_ps(code, k3))))));
+			__m128 d = _mm_sub_ps(v, offset);
+			s = _mm_add_ps(s, d);
+			s2 = _mm_add_ps(s2, _mm_mul_ps(d, d));
+			mn = _mm_min_ps(mn, v);
+			mx = _mm_max_ps(mx, v);
+			up = _mm_add_ps(up, _mm_and_ps(_mm_cmpgt_ps(v, mid), one));
+
+			__m128 isHigh = _mm_cmpgt_ps(v, hi);
+			__m128 rise = _mm_and_ps(arm, isHigh);
+			risen = _mm_add_ps(risen, _mm_and_ps(rise, one));
+			__m128 setFirst = _mm_and_ps(rise, _mm_cmplt_ps(first, zero));
+			first = _mm_or_ps(_mm_and_ps(setFirst, index), _mm_andnot_ps(setFirst, first));
+			last = _mm_or_ps(_mm_and_ps(rise, index), _mm_andnot_ps(rise, last));
+			arm = _mm_or_ps(_mm_andnot_ps(isHigh, arm), _mm_cmplt_ps(v, lo));
+			index = _mm_add_ps(index, one);
+		}
+
+		float partial[4][4];
+		_mm_storeu_ps(partial[0], s);
+		_mm_storeu_ps(partial[1], s2);
+		_mm_storeu_ps(partial[2], up);
+		_mm_storeu_ps(partial[3], risen);
+		for (int i = 0; i < 4; i++) {
+			sum[g + i] += partial[0][i];
+			sumSquares[g + i] += partial[1][i];
+			above[g + i] += partial[2][i];
+			rises[g + i] += partial[3][i];
+		}
+		_mm_storeu_ps(&minimum[g], mn);
+		_mm_storeu_ps(&maximum[g], mx);
+		_mm_storeu_ps(&firstRise[g], first);
+		_mm_storeu_ps(&lastRise[g], last);
+		_mm_storeu_ps(&armed[g], arm);
+	}
+#else
+	for (int l = 0; l < lanes; l++) {
+		float mn = fresh ? 3.4e38f : minimum[l], mx = fresh ? -3.4e38f : maximum[l];
+		float s = 0, s2 = 0, up = 0, risen = 0;
+		bool arm = armed[l] != 0;
+		const float *x = codes + l;
+		for (size_t f = 0; f < numFrames; f++, x += lanes) {
+			float code = *x;
+			float v = c0[l] + code * (c1[l] + code * (c2[l] + code * c3[l]));
+			float d = v - shift[l];
+			s += d;
+			s2 += d * d;
+			if (v < mn) mn = v;
+			if (v > mx) mx = v;
+			if (v > level[l]) up++;
+			if (arm && v > high[l]) {
+				risen++;
+				if (firstRise[l] < 0) firstRise[l] = (float)(inBlock + f);
+				lastRise[l] = (float)(inBlock + f);
+				arm = false;
+			}
+			if (v < low[l]) arm = true;
+		}
+		sum[l] += s;
+		sumSquares[l] += s2;
+		above[l] += up;
+		rises[l] += risen;
+		minimum[l] = mn;
+		maximum[l] = mx;
+		armed[l] = arm ? 1.0f : 0.0f;  // any non-zero value, the SSE2 path keeps an all-ones mask
+	}
+#endif
+}
+
+void Measurements::finishBlock() {
+	double n = (double)inBlock;
+	size_t slot = (size_t)(blocksDone % windowBlocks);
+	for (int c = 0; c < channels; c++) {
+		BlockStats &b = blocks[slot * channels + c];
+		double deviation = sum[c] / n;
+		b.count = n;
+		b.mean = shift[c] + deviation;
+		b.m2 = sumSquares[c] - sum[c] * deviation;
+		if (b.m2 < 0) b.m2 = 0;
+		b.minimum = minimum[c];
+		b.maximum = maximum[c];
+		b.above = above[c];
+		b.rises = rises[c];
+		b.firstRise = firstRise[c] >= 0 ? blockStart + (int64_t)firstRise[c] : -1;
+		b.lastRise = lastRise[c] >= 0 ? blockStart + (int64_t)lastRise[c] : -1;
+	}
+	blocksDone++;
+	blockStart += inBlock;
+	inBlock = 0;
+
+	// merge the window oldest block first, so the first and last crossings fall out in order
+	size_t count = blocksDone < windowBlocks ? (size_t)blocksDone : windowBlocks;
+	size_t oldest = (size_t)((blocksDone - count) % windowBlocks);
+	for (int c = 0; c < channels; c++) {
+		double total = 0, mean = 0, m2 = 0, up = 0, risen = 0;
+		float mn = 3.4e38f, mx = -3.4e38f;
+		int64_t first = -1, last = -1;
+		for (size_t i = 0; i < count; i++) {
+			const BlockStats &b = blocks[((oldest + i) % windowBlocks) * channels + c];
+			double merged = total + b.count;
+			double delta = b.mean - mean;
+			mean += delta * b.count / merged;
+			m2 += b.m2 + delta * delta * total * b.count / merged;
+			total = merged;
+			if (b.minimum < mn) mn = b.minimum;
+			if (b.maximum > mx) mx = b.maximum;
+			up += b.above;
+			risen += b.rises;
+			if (b.firstRise >= 0 && first < 0) first = b.firstRise;
+			if (b.lastRise >= 0) last = b.lastRise;
+		}
+
+		Measurement &m = results[c];
+		m.valid = true;
+		m.minimum = mn;
+		m.maximum = mx;
+		m.mean = mean;
+		m.rms = sqrt(mean * mean + m2 / total);
+		m.peakToPeak = (double)mx - mn;
+		m.dutyCycle = up / total;
+		if (risen >= 2 && last > first) {
+			m.period = (double)(last - first) / (risen - 1) / rate;
+			m.frequency = 1.0 / m.period;
+		} else {
+			m.period = 0;
+			m.frequency = 0;
+		}
+
+		// the next block deviates from this window's mean and crosses at its mid level
+		float mid = (float)((mn + (double)mx) / 2);
+		float hysteresis = (float)(m.peakToPeak * HYSTERESIS);
+		shift[c] = (float)mean;
+		level[c] = mid;
+		low[c] = mid - hysteresis;
+		high[c] = mid + hysteresis;
+
+		sum[c] = 0;
+		sumSquares[c] = 0;
+		above[c] = 0;
+		rises[c] = 0;
+		firstRise[c] = -1;
+		lastRise[c] = -1;
+	}
+}
+
+bool Measurements::result(int channel, Measurement &measurement) const {
+	if (channel < 0 || channel >= channels) return false;
+	measurement = results[channel];
+	return true;
+}
@@ -0,0 +1,96 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2023  Neuro Software Developers, Inc.
+//
+// Contact Information:
+//
+// Email:
+// info@neurosoftware.com
+//
+// Website:
+// www.neurosoftware.com
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <vector>
+#include <stdint.h>
+#include <stddef.h>
+#include "Scaling.h"
+
+struct Measurement {
+	bool valid;				// false until the first block of the window is complete
+	double minimum;			// volts
+	double maximum;
+	double mean;
+	double rms;				// of the whole signal, DC included
+	double peakToPeak;
+	double frequency;		// Hz from rising crossings of the mid level, 0 with fewer than two crossings
+	double period;			// seconds, 0 likewise
+	double dutyCycle;		// fraction of the time above the mid level
+
+	Measurement() : valid(false), minimum(0), maximum(0), mean(0), rms(0), peakToPeak(0), frequency(0), period(0), dutyCycle(0) {}
+};
+
+// Continuously updated measurements of every channel over a sliding window of the last windowSeconds.
+//
+// Samples are folded in as they are acquired, straight from the interleaved frames, with one SIMD lane per
+// channel. The window is a ring of blocks of about 1/64 of its length: each block keeps the count, mean and
+// sum of squared deviations of its samples (accumulated relative to the previous block's mean, so a large DC
+// offset doesn't eat the precision of a small AC signal) along with its extremes and crossings. When a block
+// completes, the blocks of the window are merged with the pairwise (Chan et al.) update, which is stable for any
+// window length, and the results are ready for the UI without ever rescanning the samples.
+//
+// Frequency comes from rising crossings of the window's mid level, with a hysteresis of 5% of its peak-to-peak
+// range; the duty cycle is the share of samples above the mid level.
+class Measurements {
+public:
+	Measurements();
+
+	void configure(int numChannels, double sampleRate, const ChannelScaling *scaling, double windowSeconds);
+	void reset();
+
+	// interleaved frames of raw codes, numChannels samples each
+	void add(const int16_t *frames, size_t numFrames);
+
+	// over the window as of the last completed block; false for a channel that isn't measured
+	bool result(int channel, Measurement &measurement) const;
+	int numChannels() const { return channels; }
+	double windowSeconds() const { return rate > 0 ? (double)blockFrames * windowBlocks / rate : 0; }
+
+private:
+	struct BlockStats {
+		double count;
+		double mean;
+		double m2;			// sum of squared deviations from mean
+		float minimum, maximum;
+		double above;
+		double rises;
+		int64_t firstRise;	// absolute sample index, -1 if none
+		int64_t lastRise;
+	};
+
+	void accumulate(const float *codes, size_t numFrames);
+	void finishBlock();
+
+	int channels;
+	int lanes;				// channels rounded up to whole SIMD vectors
+	double rate;
+	size_t blockFrames;
+	size_t windowBlocks;
+
+	std::vector<float> coefficients;	// 4 arrays of lanes: the scaling polynomial per channel
+	std::vector<float> staged;			// a batch of frames widened to float codes, lanes per frame
+
+	// the current block, one value per lane
+	std::vector<float> shift, low, high, level;
+	std::vector<float> minimum, maximum, firstRise, lastRise, armed;
+	std::vector<double> sum, sumSquares, above, rises;	// batches are added up in float, blocks in double
+	size_t inBlock;
+	int64_t blockStart;
+
+	std::vector<BlockStats> blocks;		// ring of windowBlocks per channel
+	uint64_t blocksDone;
+	std::vector<Measurement> results;
+};
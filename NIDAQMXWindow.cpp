@@ -1,809 +1,2076 @@
-///////////////////////////////////////////////////////////////////////////////////////////////////
-//
-// Copyright (C) 2023  Neuro Software Developers, Inc.
-//
-// Contact Information:
-//
-// Email:
-// info@neurosoftware.com
-//
-// Website:
-// www.neurosoftware.com
-//
-///////////////////////////////////////////////////////////////////////////////////////////////////
-
-#include "stdafx.h"
-#include "NIDAQMXWindow.h"
-#include <iostream>
-#include <sstream>
-#include <iomanip> //setprecision
-#include <vector>
-#include <algorithm>
-#include "NIDAQmx.h"
-
-using namespace std;
-
-#define NUM_CHANNELS 8 // some cards have 16 channels, and depends also if wired differential or single ended
-
-int numChannelsToPlot = 1;
-TaskHandle taskHandle = 0;
-int daqDeviceIndexChosen = 2;
-int32 terminalConfig = DAQmx_Val_Cfg_Default;
-vector<string>daqDevices;
-const int arraySizeInSamps = NUM_CHANNELS;
-float64 readArray[NUM_CHANNELS];
-
-#define BUFFER_SIZE 1024  // arbitrary number of bytes that I want to buffer in my computer's RAM
-
-float widthWindow = 1024;
-float heightWindow = 768;
-HDC hdcBackGround = NULL;
-HBITMAP screenMain = NULL; 
-HPEN color[NUM_CHANNELS];
-HPEN colorGray;
-HPEN colorGrayDashed;
-HPEN colorGrayDot;
-HBRUSH backgroundBrush;
-HBRUSH backgroundBrush2;
-
-string daqMessage[10];
-int daqMessageIndex = 0;
-
-float pix[NUM_CHANNELS][BUFFER_SIZE];
-int sampleNum = 0;
-
-int show2D = 1;
-int pauseScreen = -1;
-int showSampleValues = -1;
-int hideGrid = -1;
-
-void StopDAQ();
-
-void InitDAQ() {
-
-	StopDAQ();
-
-	int32 status = 0;
-	char errorString[MAX_PATH];
-
-	/*********************************************/
-	// DAQmx Configure Code
-	/*********************************************/
-	status = DAQmxCreateTask("", &taskHandle);
-
-	if (status != 0) {
-		DAQmxGetErrorString(status, errorString, MAX_PATH);
-		MessageBoxA(0, errorString, "Oscilloscope-NIDAQmx", MB_ICONERROR);
-		return;
-	}
-
-	/* terminalConfig Options:
-	DAQmx_Val_Cfg_Default
-	DAQmx_Val_RSE
-	DAQmx_Val_NRSE
-	DAQmx_Val_Diff
-	DAQmx_Val_PseudoDiff
-	*/
-
-	//int32 terminalConfig = DAQmx_Val_RSE;
-	//int32 terminalConfig = DAQmx_Val_Diff;
-
-	int32 units = DAQmx_Val_Volts;
-
-	char channelStr[] = "ai0:7";
-	char nameToAssignToChannel[255] = {""};
-
-	sprintf_s(nameToAssignToChannel, "%s/%s", daqDevices[daqDeviceIndexChosen].c_str(), channelStr);
-
-	status = DAQmxCreateAIVoltageChan(taskHandle, nameToAssignToChannel, "", terminalConfig, -10.0, 10.0, units, NULL);
-	if (status != 0) {
-		DAQmxGetErrorString(status, errorString, MAX_PATH);
-		MessageBoxA(0, errorString, "Oscilloscope-NIDAQmx", MB_ICONERROR);
-		return;
-	}
-	/* activeEdge Options:
-	DAQmx_Val_Rising // Acquire or generate samples on the rising edges of the Sample Clock.
-	DAQmx_Val_Falling // Acquire or generate samples on the falling edges of the Sample Clock.
-	*/
-	int32 activeEdge = DAQmx_Val_Rising;
-
-	/* sampleMode Options:
-	DAQmx_Val_FiniteSamps //Acquire or generate a finite number of samples.
-	DAQmx_Val_ContSamps // Acquire or generate samples until you stop the task.
-	DAQmx_Val_HWTimedSinglePoint //Acquire or generate samples continuously using hardware timing without a buffer. Hardware timed single point sample mode is supported only for the sample clock and change detection timing types. (http://zone.ni.com/reference/en-XX/help/370466AC-01/mxcncpts/hwtspsamplemode/)
-	*/
-//	int32 sampleMode = DAQmx_Val_HWTimedSinglePoint;
-	int32 sampleMode = DAQmx_Val_ContSamps;
-
-	/*
-	One of the most important parameters of an analog input or output system is the rate at which the measurement device samples an incoming signal or generates the output signal.
-	The sampling rate, which is called the scan rate in Traditional NI-DAQ (Legacy), is the speed at which a device acquires or generates a sample on each channel.
-	A fast input sampling rate acquires more points in a given time and can form a better representation of the original signal than a slow sampling rate.
-	Generating a 1 Hz signal using 1000 points per cycle at 1000 S/s produces a much finer representation than using 10 points per cycle at a sample rate of 10 S/s.
-	Sampling too slowly results in a poor representation of the analog signal. Undersampling causes the signal to appear as if it has a different frequency than it actually does.
-	This misrepresentation of a signal is called aliasing.
-	*/
-
-	float64 sampleRate = 50; //The sampling rate in samples per second per channel. If you use an external source for the Sample Clock, set this value to the maximum expected rate of that clock.
-
-	/*
-	The number of samples to acquire or generate for each channel in the task if sampleMode is DAQmx_Val_FiniteSamps.
-	If sampleMode is DAQmx_Val_ContSamps, NIDAQmx uses this value to determine the buffer size.
-	*/
-	uInt64 sampsPerChanToAcquire = 4;
-
-	/* DAQmxCfgSampClkTiming
-	Sets the source of the Sample Clock, the rate of the Sample Clock, and the number of samples to acquire or generate.
-	*/
-	status = DAQmxCfgSampClkTiming(taskHandle, "", sampleRate, activeEdge, sampleMode, sampsPerChanToAcquire);
-	if (status != 0) {
-		DAQmxGetErrorString(status, errorString, MAX_PATH);
-		MessageBoxA(0, errorString, "Oscilloscope-NIDAQmx", MB_ICONERROR);
-		return;
-	}
-
-	/*********************************************/
-	// start the data acquisition
-	/*********************************************/
-	status = DAQmxStartTask(taskHandle);
-	if (status != 0) {
-		DAQmxGetErrorString(status, errorString, MAX_PATH);
-		MessageBoxA(0, errorString, "Oscilloscope-NIDAQmx", MB_ICONERROR);
-		return;
-	}
-
-}
-
-void clearData() {
-	for (int channel = 0; channel < NUM_CHANNELS; channel++) {
-		for (int x = 0; x < BUFFER_SIZE; x++) {
-			pix[channel][x] = readArray[channel];
-//			pix[channel][x] = 0;
-		}
-	}
-}
-
-string daqRead() {
-	static int firstSample = 0;
-	/*********************************************/
-	// DAQmx Read Code
-	/*********************************************/
-	const int numSampsPerChan = 1;
-
-	int32 sampsPerChanRead = -1;
-	float64 timeOut = 0;
-	stringstream message;
-	int32 status = DAQmxReadAnalogF64(taskHandle, numSampsPerChan, timeOut, DAQmx_Val_GroupByChannel, readArray, arraySizeInSamps, &sampsPerChanRead, NULL);
-
-	if (status != 0) {
-		char errorString[MAX_PATH];
-		DAQmxGetErrorString(status, errorString, MAX_PATH);
-		message << "(" + to_string(sampleNum) + ")" + " DAQmxReadAnalogF64() status:" << status << " " << errorString;
-	}
-	//if (DAQmxErrorSamplesNotYetAvailable == status || DAQmxErrorSamplesNoLongerAvailable == status) {
-	//	message << "status:" << status << " continue" << std::endl;
-	//	OutputDebugStringA(message.str().c_str());
-
-	//}
-	//else if (status < 0) {
-	//	message << "status:" << status << "breaking" << std::endl;
-	//}
-	else {
-		if (firstSample == 0)  // do this only on startup 
-		{
-			firstSample = 1;
-
-			clearData();
-		}
-		else {  // do this on every subsequent sample after the initial one
-			int pixIndex = (sampleNum++) % BUFFER_SIZE;
-			message << std::fixed << std::setprecision(2);
-			message << "(" << to_string(sampleNum) << ")";
-			for (int channel = 0; channel < arraySizeInSamps; channel++) {
-				message << readArray[channel];
-				if (channel < arraySizeInSamps - 1)
-					message << ", ";
-				pix[channel][pixIndex] = readArray[channel];
-			}
-		}
-	}
-	message << endl;
-	//OutputDebugStringA(message.str().c_str());
-	return message.str();
-}
-
-void StopDAQ() {
-	int32 status;
-	char errorString[MAX_PATH];
-
-	if (taskHandle == NULL)
-		return;
-	status = DAQmxStopTask(taskHandle);
-	if (status != 0) {
-		DAQmxGetErrorString(status, errorString, MAX_PATH);
-		MessageBoxA(0, errorString, "Oscilloscope-NIDAQmx", MB_ICONERROR);
-		return;
-	}
-
-	status = DAQmxClearTask(taskHandle);
-	if (status != 0) {
-		DAQmxGetErrorString(status, errorString, MAX_PATH);
-		MessageBoxA(0, errorString, "Oscilloscope-NIDAQmx", MB_ICONERROR);
-		return;
-	}
-}
-
-// the rest is mostly boiler plate code except where I call the above functions and graph the data in the WM_TIMER message section of the WndProc
-
-#define MAX_LOADSTRING 100
-
-// Global Variables:
-HINSTANCE hInst;                                // current instance
-CHAR szTitle[MAX_LOADSTRING];                  // The title bar text
-CHAR szWindowClass[MAX_LOADSTRING];            // the main window class name
-
-// Forward declarations of functions included in this code module:
-ATOM                MyRegisterClass(HINSTANCE hInstance);
-BOOL                InitInstance(HINSTANCE, int);
-LRESULT CALLBACK    WndProc(HWND, UINT, WPARAM, LPARAM);
-INT_PTR CALLBACK    About(HWND, UINT, WPARAM, LPARAM);
-INT_PTR CALLBACK    ChoseDAQ(HWND, UINT, WPARAM, LPARAM);
-void				EnumerateDAQDevices(HWND hWnd);
-
-int APIENTRY wWinMain(_In_ HINSTANCE hInstance,
-                     _In_opt_ HINSTANCE hPrevInstance,
-                     _In_ LPWSTR    lpCmdLine,
-                     _In_ int       nCmdShow)
-{
-    UNREFERENCED_PARAMETER(hPrevInstance);
-    UNREFERENCED_PARAMETER(lpCmdLine);
-
-    // Initialize global strings
-    //LoadStringW(hInstance, IDS_APP_TITLE, szTitle, MAX_LOADSTRING);
-	strcpy_s(szTitle, "Digital Oscilloscope for Space / Time Testing");
-	strcpy_s(szWindowClass, "NIDAQMXWINDOW");
-    //LoadStringW(hInstance, IDC_NIDAQMXWINDOW, szWindowClass, MAX_LOADSTRING);
-    MyRegisterClass(hInstance);
-
-    // Perform application initialization:
-    if (!InitInstance (hInstance, nCmdShow))
-    {
-        return FALSE;
-    }
-
-    HACCEL hAccelTable = LoadAccelerators(hInstance, MAKEINTRESOURCE(IDC_NIDAQMXWINDOW));
-
-
-    MSG msg;
-
-    // Main message loop:
-    while (GetMessage(&msg, nullptr, 0, 0))
-    {
-        if (!TranslateAccelerator(msg.hwnd, hAccelTable, &msg))
-        {
-            TranslateMessage(&msg);
-            DispatchMessage(&msg);
-        }
-    }
-
-    return (int) msg.wParam;
-}
-
-
-
-//
-//  FUNCTION: MyRegisterClass()
-//
-//  PURPOSE: Registers the window class.
-//
-ATOM MyRegisterClass(HINSTANCE hInstance)
-{
-    WNDCLASSEX wcex;
-
-    wcex.cbSize = sizeof(WNDCLASSEX);
-
-    wcex.style          = CS_HREDRAW | CS_VREDRAW;
-    wcex.lpfnWndProc    = WndProc;
-    wcex.cbClsExtra     = 0;
-    wcex.cbWndExtra     = 0;
-    wcex.hInstance      = hInstance;
-    wcex.hIcon          = LoadIcon(hInstance, MAKEINTRESOURCE(IDI_NIDAQMXWINDOW));
-    wcex.hCursor        = LoadCursor(nullptr, IDC_ARROW);
-    wcex.hbrBackground  = (HBRUSH)(COLOR_WINDOW+1);
-    wcex.lpszMenuName   = MAKEINTRESOURCE(IDC_NIDAQMXWINDOW);
-    wcex.lpszClassName  = szWindowClass;
-    wcex.hIconSm        = LoadIcon(hInstance, MAKEINTRESOURCE(IDI_NIDAQMXWINDOW));
-
-    return RegisterClassEx(&wcex);
-}
-
-//
-//   FUNCTION: InitInstance(HINSTANCE, int)
-//
-//   PURPOSE: Saves instance handle and creates main window
-//
-//   COMMENTS:
-//
-//        In this function, we save the instance handle in a global variable and
-//        create and display the main program window.
-//
-BOOL InitInstance(HINSTANCE hInstance, int nCmdShow)
-{
-   hInst = hInstance; // Store instance handle in our global variable
-
-   HWND hWnd = CreateWindow(szWindowClass, szTitle, WS_OVERLAPPEDWINDOW,
-	   CW_USEDEFAULT, CW_USEDEFAULT, widthWindow, heightWindow, nullptr, nullptr, hInstance, nullptr);
-
-   if (!hWnd)
-   {
-      return FALSE;
-   }
-
-   ShowWindow(hWnd, nCmdShow);
-   UpdateWindow(hWnd);
-
-   return TRUE;
-}
-
-//
-//  FUNCTION: WndProc(HWND, UINT, WPARAM, LPARAM)
-//
-//  PURPOSE:  Processes messages for the main window.
-//
-//  WM_COMMAND  - process the application menu
-//  WM_PAINT    - Paint the main window
-//  WM_DESTROY  - post a quit message and return
-//
-//
-
-LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
-{
-	static HDC hdcBack;
-	HDC hdcTemp;
-    switch (message)
-    {
-	case WM_CREATE:
-	{
-		// set these colors manually because I can't think of a better way
-		color[0] = CreatePen(PS_SOLID, 1, RGB(0, 255, 0));
-		color[1] = CreatePen(PS_SOLID, 1, RGB(0, 205, 0));
-		color[2] = CreatePen(PS_SOLID, 1, RGB(255, 255, 0));
-		color[3] = CreatePen(PS_SOLID, 1, RGB(205, 205, 0));
-		color[4] = CreatePen(PS_SOLID, 1, RGB(0, 255, 255));
-		color[5] = CreatePen(PS_SOLID, 1, RGB(0, 205, 205));
-		color[6] = CreatePen(PS_SOLID, 1, RGB(255, 0, 0));
-		color[7] = CreatePen(PS_SOLID, 1, RGB(205, 0, 0));
-
-		colorGray = CreatePen(PS_SOLID, 1, RGB(180, 180, 180));
-		colorGrayDashed = CreatePen(PS_DASH, 1, RGB(180, 180, 180));
-		colorGrayDot = CreatePen(PS_DOT, 1, RGB(180, 180, 180));
-		backgroundBrush = CreateSolidBrush(RGB(88, 88, 88));
-		backgroundBrush2 = CreateSolidBrush(RGB(58, 58, 58));
-
-		memset(pix, 0, sizeof(float)*NUM_CHANNELS*BUFFER_SIZE);  // optional, I do it as a precaution.
-
-		EnumerateDAQDevices(hWnd);
-		
-		SetTimer(hWnd, WM_TIMER, 0, (TIMERPROC)NULL);
-	}
-		break;
-	case WM_SIZE:
-		widthWindow = LOWORD(lParam);
-		heightWindow = HIWORD(lParam);
-
-		hdcTemp = GetDC(hWnd);
-
-		// create DC for back buffer
-		if (hdcBack) {
-			DeleteDC(hdcBack); hdcBack = NULL;
-		}
-		hdcBack = CreateCompatibleDC(hdcTemp);
-
-		// create DC for the background
-		if (hdcBackGround) {
-			DeleteDC(hdcBackGround); hdcBackGround = NULL;
-		}
-		hdcBackGround = CreateCompatibleDC(hdcTemp);
-
-		if (screenMain) {
-			DeleteObject(screenMain); screenMain = NULL;
-		}
-		screenMain = CreateCompatibleBitmap(hdcTemp, widthWindow, heightWindow);  // must be created with hdcTemp, same that is used to create hdcBack
-
-		SelectObject(hdcBack, screenMain);
-
-		// set the text drawing properties into the DC
-		SetBkMode(hdcBack, TRANSPARENT);
-
-		// finished creating everything, release temporary DC
-		ReleaseDC(hWnd, hdcTemp);
-		break;
-	case WM_COMMAND:
-        {
-            int wmId = LOWORD(wParam);
-            // Parse the menu selections:
-            switch (wmId)
-            {
-			case ID_FILE_CLEARSCREEN:
-				clearData();
-				break;
-			case ID_FILE_SHOW2D:
-				show2D *= -1;
-				if (show2D == -1) {
-					CheckMenuItem(GetMenu(hWnd), ID_FILE_SHOW2D, MF_CHECKED);
-				}
-				else {
-					CheckMenuItem(GetMenu(hWnd), ID_FILE_SHOW2D, MF_UNCHECKED);
-				}
-				break;
-			case ID_FILE_PAUSE:
-				pauseScreen *= -1;
-				if (pauseScreen == 1) {
-					CheckMenuItem(GetMenu(hWnd), ID_FILE_PAUSE, MF_CHECKED);
-				}
-				else if (pauseScreen == -1) {
-					CheckMenuItem(GetMenu(hWnd), ID_FILE_PAUSE, MF_UNCHECKED);
-				}
-				break;
-			case ID_FILE_SHOWSAMPLEVALUES:
-				showSampleValues *= -1;
-				if (showSampleValues == 1) {
-					CheckMenuItem(GetMenu(hWnd), ID_FILE_SHOWSAMPLEVALUES, MF_CHECKED);
-				}
-				else if (showSampleValues == -1) {
-					CheckMenuItem(GetMenu(hWnd), ID_FILE_SHOWSAMPLEVALUES, MF_UNCHECKED);
-				}
-				break;
-			case ID_FILE_SHOWGRID:
-				hideGrid *= -1;
-				if (hideGrid == 1) {
-					CheckMenuItem(GetMenu(hWnd), ID_FILE_SHOWGRID, MF_CHECKED);
-				}
-				else if (hideGrid == -1) {
-					CheckMenuItem(GetMenu(hWnd), ID_FILE_SHOWGRID, MF_UNCHECKED);
-				}		
-				break;
-			case IDM_DAQ:
-				DialogBox(hInst, MAKEINTRESOURCE(IDD_CHOOSE_DAQ), hWnd, ChoseDAQ);
-				break;
-            case IDM_ABOUT:
-                DialogBox(hInst, MAKEINTRESOURCE(IDD_ABOUTBOX), hWnd, About);
-                break;
-            case IDM_EXIT:
-                DestroyWindow(hWnd);
-                break;
-            default:
-                return DefWindowProc(hWnd, message, wParam, lParam);
-            }
-        }
-        break;
-	case WM_ERASEBKGND:                // APPENDED FLICKER FREE
-		return TRUE;
-	case WM_TIMER:
-
-		if (pauseScreen == 1) {
-			break;
-		}
-		else {
-			int sampleIndex = sampleNum%BUFFER_SIZE;
-			int messageIndex = (daqMessageIndex++) % 10;
-			daqMessage[messageIndex] = daqRead();
-
-			const int edge = 40;
-
-			HDC hdc = GetDC(hWnd);
-
-			RECT rect = { 0,0,widthWindow, heightWindow};
-			FillRect(hdcBack, &rect, backgroundBrush);
-			float x = 0;
-			float y = 0;
-
-			// draw a vertical line demarcating the Y-axis boundary			
-			SelectObject(hdcBack, colorGray);
-			MoveToEx(hdcBack, edge, y, NULL);
-			LineTo(hdcBack, edge, heightWindow);
-
-			// plots the y axis
-			SetTextColor(hdcBack, RGB(180, 180, 180));
-			for (float yAxis = 0; yAxis < 20; yAxis++) {
-				y = yAxis / 20 * heightWindow;
-				MoveToEx(hdcBack, edge, y, NULL);
-
-				stringstream buffer;
-				int value = ((yAxis - 10)*-1);
-
-				if (value <= 0) {
-					buffer << value << "V";
-				}
-				else {
-					buffer << "+" << value << "V";
-				}
-				TextOutA(hdcBack, 11, y - 8, buffer.str().c_str(), buffer.str().length());
-
-				if (hideGrid == 1) {
-					LineTo(hdcBack, edge + 7, y);
-				}
-				else {
-					if (value % 5 == 0) {
-						SelectObject(hdcBack, colorGrayDashed);
-					}
-					else {
-						SelectObject(hdcBack, colorGrayDot);
-					}
-					LineTo(hdcBack, widthWindow, y);
-				}
-			}
-
-			/*
-			1 = 0,1
-			2 = 2,3
-			3 = 4,5
-			4 = 6,7
-			*/
-			// render data from all analog input channels
-			int xP = 0;
-//			for (int channel = 0; channel < NUM_CHANNELS; channel++) {
-//			for (int channel = 0; channel < numChannelsToPlot*2; channel++) {
-			for (int channel = numChannelsToPlot * 2 - 2; channel < numChannelsToPlot * 2; channel++) {
-
-				xP = sampleNum%BUFFER_SIZE;
-				y = (pix[channel][xP] + 10) / 20 * heightWindow * -1;
-				MoveToEx(hdcBack, edge, heightWindow+y, NULL);
-				SelectObject(hdcBack, color[channel]);
-
-				for (int x = 1; x < BUFFER_SIZE; x++) {
-					xP = (xP + 1) % BUFFER_SIZE;								// increment to next data value INDEX (wrap if necessary)
-					y = (pix[channel][xP] + 10.0) / 20.0 * heightWindow*-1;			// get data value based on INDEX and scale into window's space. First scale from -10/10V to 0-1 (normalized)
-					
-					int xPosition = ((float)x / (float)BUFFER_SIZE*(widthWindow-edge));
-
-					LineTo(hdcBack, xPosition + edge, heightWindow + y);
-					MoveToEx(hdcBack, xPosition + edge, heightWindow+y, NULL);
-				}
-			}
-
-			// render XY Plot
-			if (show2D == 1) {
-				float hyp = sqrt(widthWindow*widthWindow + heightWindow*heightWindow);
-				float side2D = hyp * 1.0 / 8.0;
-				float edge2D = side2D * 1.0 / 10.0;
-				RECT rect = { widthWindow - edge2D - side2D, edge2D, widthWindow - edge2D, edge2D + side2D };
-				int height2D = rect.bottom - rect.top;
-				int width2D = rect.right - rect.left;
-
-				// render the background
-				SelectObject(hdcBack, backgroundBrush2);
-				SelectObject(hdcBack, colorGray);
-				Rectangle(hdcBack, rect.left, rect.top, rect.right, rect.bottom);
-				// render the x axis
-				MoveToEx(hdcBack, rect.left, rect.top / 2 + rect.bottom / 2, NULL);
-				LineTo(hdcBack, rect.right, rect.top / 2 + rect.bottom / 2);
-				// render the y axis
-				MoveToEx(hdcBack, rect.left + (width2D) / 2, rect.top, NULL);
-				LineTo(hdcBack, rect.left + (width2D) / 2, rect.top + rect.bottom - edge2D);
-
-				// render the data
-				char sampleNumStr[255] = { "" };
-				sprintf_s(sampleNumStr, "[%i] ", sampleNum);
-
-				SelectObject(hdcBack, GetStockObject(NULL_BRUSH));
-
-				int diameter2D = 1;
-
-				//for (int channel = 0; channel < numChannelsToPlot; channel++) {
-				for (int channel = numChannelsToPlot-1; channel < numChannelsToPlot; channel++) {
-
-					MoveToEx(hdcBack, x + rect.left+width2D/2, y+height2D/2+edge2D, NULL);
-
-
-					// show trail
-					xP = 0;
-					SelectObject(hdcBack, color[channel * 1]);
-
-					for (int i = 1; i < BUFFER_SIZE; i++) {
-						xP = (xP + 1) % BUFFER_SIZE;								
-
-						x = pix[channel * 2 + 0][xP];
-						y = pix[channel * 2 + 1][xP];
-
-						x = (x + 10.0) / 20.0;
-						y = (y + 10.0) / 20.0;
-
-						x = x * (float)width2D;
-						y = y * (float)height2D;
-
-						Ellipse(hdcBack, x + rect.left - diameter2D + 1, y + edge2D - diameter2D + 1, x + rect.left + diameter2D + 1, y + edge2D + diameter2D);
-					}
-					// show trail end
-
-
-					// show current location
-					SelectObject(hdcBack, color[channel * 2]);
-
-					float x = pix[channel * 2 + 0][sampleIndex-1];
-					float y = pix[channel * 2 + 1][sampleIndex-1];
-
-					if (showSampleValues == 1) sprintf_s(sampleNumStr, "%s(%4.2f, %4.2f)", sampleNumStr, x, y);
-
-					x = (x + 10.0) / 20.0;
-					y = (y + 10.0) / 20.0;
-					
-					x = x * (float)width2D;
-					y = y * (float)height2D;
-
-					diameter2D = 7;
-
-					Ellipse(hdcBack, x + rect.left - diameter2D + 1, y + edge2D - diameter2D + 1, x + rect.left + diameter2D + 1, y + edge2D + diameter2D);
-					// show current location end
-				}
-
-				if (showSampleValues == 1) TextOut(hdcBack, rect.left + 1, rect.top - 20, sampleNumStr, strlen(sampleNumStr));
-			}
-
-			if (showSampleValues == 1) {
-
-				int x = widthWindow / 2 - 150;
-				int y = edge;
-				RECT rect = { x, y, x + 350, y + 200 };
-
-				FillRect(hdcBack, &rect, backgroundBrush);
-				SetTextColor(hdcBack, RGB(180, 180, 180));
-				for (int i = 0; i < 10; i++) {
-					string result = string("[" + to_string(daqMessageIndex) + "] " + daqMessage[i]);
-
-					TextOutA(hdcBack, x, y + 20 * i, result.c_str(), result.length());
-				}
-			}
-
-
-			// render everything to screen
-			BitBlt(hdc, 0, 0, widthWindow, heightWindow, hdcBack, 0, 0, SRCCOPY);
-
-			ReleaseDC(hWnd, hdc);
-		}
-		break;
-    case WM_PAINT:
-        {
-            PAINTSTRUCT ps;
-            HDC hdc = BeginPaint(hWnd, &ps);
-
-			// TODO: Add any drawing code that uses hdc here...
-			
-			EndPaint(hWnd, &ps);
-        }
-        break;
-    case WM_DESTROY:
-		StopDAQ();
-		KillTimer(hWnd, 0);
-		if (backgroundBrush) {
-			DeleteObject(backgroundBrush); backgroundBrush = NULL;
-		}
-		if (backgroundBrush2) {
-			DeleteObject(backgroundBrush2); backgroundBrush2 = NULL;
-		}
-		if (hdcBack) {
-			DeleteDC(hdcBack); hdcBack = NULL;
-		}
-
-		if (hdcBackGround) {
-			DeleteDC(hdcBackGround); hdcBackGround = NULL;
-		}
-
-		if (screenMain) {
-			DeleteObject(screenMain); screenMain = NULL;
-		}
-		for (int channel = 0; channel < NUM_CHANNELS; channel++) {
-			DeleteObject(color[channel]);
-		}
-		DeleteObject(colorGray);
-		DeleteObject(colorGrayDashed);
-		DeleteObject(colorGrayDot);
-		PostQuitMessage(0);
-        break;
-    default:
-        return DefWindowProc(hWnd, message, wParam, lParam);
-    }
-    return 0;
-}
-
-// Message handler for about box.
-INT_PTR CALLBACK About(HWND hDlg, UINT message, WPARAM wParam, LPARAM lParam)
-{
-    UNREFERENCED_PARAMETER(lParam);
-    switch (message)
-    {
-    case WM_INITDIALOG:
-        return (INT_PTR)TRUE;
-
-    case WM_COMMAND:
-        if (LOWORD(wParam) == IDOK || LOWORD(wParam) == IDCANCEL)
-        {
-            EndDialog(hDlg, LOWORD(wParam));
-            return (INT_PTR)TRUE;
-        }
-        break;
-    }
-    return (INT_PTR)FALSE;
-}
-
-INT_PTR CALLBACK ChoseDAQ(HWND hDlg, UINT message, WPARAM wParam, LPARAM lParam)
-{
-	UNREFERENCED_PARAMETER(lParam);
-	static int terminalIndex = 0;
-	char terminalModes[5][255] = { "Default", "RSE", "NRSE", "Differential", "PseudoDiff" };
-
-	switch (message)
-	{
-	case WM_INITDIALOG:
-		for (int i = 1; i <= 4; i++) {
-			SendMessage(GetDlgItem(hDlg, IDC_COMBO_DAQ_CHANNELS), CB_ADDSTRING, 0, (LPARAM)to_string(i).c_str());
-		}
-		SendMessage(GetDlgItem(hDlg, IDC_COMBO_DAQ_CHANNELS), CB_SETCURSEL, numChannelsToPlot-1, NULL);
-
-		for (auto deviceName : daqDevices) {
-			SendMessage(GetDlgItem(hDlg, IDC_COMBO_DAQ_DEVICES), CB_ADDSTRING, 0, (LPARAM)deviceName.c_str());
-		}
-		SendMessage(GetDlgItem(hDlg, IDC_COMBO_DAQ_DEVICES), CB_SETCURSEL, daqDeviceIndexChosen, NULL);
-
-		for (int i = 0; i < 5; i++) {
-			SendMessage(GetDlgItem(hDlg, IDC_COMBO_DAQ_MODE), CB_ADDSTRING, 0, (LPARAM)&terminalModes[i]);
-		}
-		SendMessage(GetDlgItem(hDlg, IDC_COMBO_DAQ_MODE), CB_SETCURSEL, terminalIndex, NULL);
-
-		return (INT_PTR)TRUE;
-
-	case WM_COMMAND:
-		switch (HIWORD(wParam))
-		{
-		case CBN_SELCHANGE:		// drop down control changed
-			daqDeviceIndexChosen = SendMessage(GetDlgItem(hDlg, IDC_COMBO_DAQ_DEVICES), CB_GETCURSEL, 0, 0);
-			numChannelsToPlot = SendMessage(GetDlgItem(hDlg, IDC_COMBO_DAQ_CHANNELS), CB_GETCURSEL, 0, 0) + 1;
-			terminalIndex = SendMessage(GetDlgItem(hDlg, IDC_COMBO_DAQ_MODE), CB_GETCURSEL, 0, 0);
-
-			switch (terminalIndex) {
-			case 0:terminalConfig = DAQmx_Val_Cfg_Default; break;
-			case 1:terminalConfig = DAQmx_Val_RSE; break;
-			case 2:terminalConfig = DAQmx_Val_NRSE; break;
-			case 3:terminalConfig = DAQmx_Val_Diff; break;
-			case 4:terminalConfig = DAQmx_Val_PseudoDiff; break;
-			default:terminalConfig = DAQmx_Val_Cfg_Default; break;
-
-			}
-		default:
-			break;
-		}
-
-		if (LOWORD(wParam) == IDOK || LOWORD(wParam) == IDCANCEL)
-		{
-			InitDAQ();
-			EndDialog(hDlg, LOWORD(wParam));
-			return (INT_PTR)TRUE;
-		}
-		break;
-	}
-	return (INT_PTR)FALSE;
-}
-
-vector<string> splitString(std::string str, char delimiter) {
-	vector<string> v;
-	stringstream src(str);
-	string buf;
-
-	while (getline(src, buf, delimiter)) {
-		v.push_back(buf);
-	}
-	return v;
-}
-
-void EnumerateDAQDevices(HWND hWnd) {
-
-	char deviceNamesStr[255] = {"\0"};
-	DAQmxGetSystemInfoAttribute(DAQmx_Sys_DevNames, deviceNamesStr, 255); // this will query the nidaq driver to see what cards are detected
-
-	string deviceNames = deviceNamesStr;
-	deviceNames.erase(std::remove_if(deviceNames.begin(), deviceNames.end(), isspace), deviceNames.end());
-
-	daqDevices = splitString(deviceNames, ',');
-
-	DialogBox(hInst, MAKEINTRESOURCE(IDD_CHOOSE_DAQ), hWnd, ChoseDAQ);
-}
+///////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2023  Neuro Software Developers, Inc.
+//
+// Contact Information:
+//
+// Email:
+// info@neurosoftware.com
+//
+// Website:
+// www.neurosoftware.com
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "stdafx.h"
+#include "NIDAQMXWindow.h"
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include "NIDAQmx.h"
+#include "AcquisitionSession.h"
+#include "HistoryBuffer.h"
+#include "Scaling.h"
+#include "Compositor.h"
+#include "TraceView.h"
+#include "WorkerPool.h"
+#include "Phosphor.h"
+#include "FrameScheduler.h"
+#include "Trigger.h"
+#include "Decimator.h"
+#include "Spectrum.h"
+#include "Measurements.h"
+#include "EventLog.h"
+#include "Telemetry.h"
+#include "AllocationCounter.h"
+#include <commdlg.h>  // GetSaveFileName, not pulled in by WIN32_LEAN_AND_MEAN
+#include <mmsystem.h>  // timeBeginPeriod
+#include <dwmapi.h>  // DwmFlush
+
+using namespace std;
+
+// what to acquire, see DAQ Settings: ai0..ai(inputsPerDevice - 1) of the chosen device at +-inputRange, unless a
+// channel list names the inputs, their devices and ranges itself (e.g. "Dev1/ai0:15, Dev2/ai0:15@5")
+int inputsPerDevice = 8; // some cards have 16 channels, and depends also if wired differential or single ended
+const int inputCounts[] = { 2, 4, 8, 16, 32, 64, 128 };
+double inputRange = 10;
+const int numInputCounts = sizeof(inputCounts) / sizeof(inputCounts[0]);
+const double inputRanges[] = { 10, 5, 2, 1, 0.5, 0.2 };
+const int numInputRanges = sizeof(inputRanges) / sizeof(inputRanges[0]);
+string channelList;
+#define MAX_PLOT_PAIRS 64  // entries in the DAQ Settings pair list, clamped to the channels actually acquired
+
+int numChannelsToPlot = 1;  // the plotted pair: channels numChannelsToPlot * 2 - 2 and - 1 (XY plot, trigger, spectrum)
+int daqDeviceIndexChosen = 2;
+int32 terminalConfig = DAQmx_Val_Cfg_Default;
+int terminalIndex = 0;
+const char *terminalModes[5] = { "Default", "RSE", "NRSE", "Differential", "PseudoDiff" };
+vector<string>daqDevices;
+float64 sampleRate = 50; //The sampling rate in samples per second per channel. If you use an external source for the Sample Clock, set this value to the maximum expected rate of that clock.
+
+#define XY_TRAIL_SIZE 1024  // how many of the most recent samples the XY plot draws as its trail
+
+// File > Persistence: the XY plot accumulates every sample into a fading density map instead of drawing the trail
+#define PERSISTENCE_SECONDS 1.0  // time for the glow to fall to 1/e
+#define PERSISTENCE_SATURATION 64  // hits per pixel that show at full brightness
+#define PERSISTENCE_MAX_SAMPLES (1 << 22)  // per frame, after a long stall only the newest samples are fed in
+Phosphor phosphor;
+uInt64 phosphorAt = 0;  // history.written() when samples were last fed into the phosphor
+chrono::steady_clock::time_point phosphorDecayedAt;
+
+// display history of raw ADC codes, sized at runtime from historySeconds and the sample rate
+#define HISTORY_RAM_LIMIT_MB 1024  // bigger histories spill to a memory-mapped file in the temp directory
+HistoryBuffer<int16_t> history;
+vector<ChannelScaling> channelScaling;  // codes -> volts, applied only to what is drawn
+vector<float> channelLow, channelHigh;  // each channel's input range, volts
+float64 historySeconds = 20;
+const float64 historyLengths[] = { 1, 5, 20, 60, 600, 3600 };
+const int numHistoryLengths = sizeof(historyLengths) / sizeof(historyLengths[0]);
+
+// DAQ Settings: filters and decimation between acquisition and the history, so the display and the measurements
+// see the conditioned signal; recordings and the spectrum get the samples as acquired
+string filterList;
+int decimation = 1;
+const int decimations[] = { 1, 2, 4, 8, 16, 32, 64 };
+const int numDecimations = sizeof(decimations) / sizeof(decimations[0]);
+
+// acquisition runs on its own thread and hands samples to the UI thread through a lock-free ring; the session
+// picks the backend (DAQmx, one of the "Sim-" devices, or a capture opened with File > Open Capture), owns the
+// filters and streams every acquired block to disk while File > Record is on
+#define RING_SECONDS 4  // how much data the ring can hold if the window stops draining it (e.g. while a dialog or resize is modal)
+#define BLOCK_MILLISECONDS 10  // target duration of one block read from the driver
+#define RECORD_QUEUE_SECONDS 4  // how far the disk may fall behind before blocks are dropped from the capture
+#define BROADCAST_MEGABYTES 64  // shared memory ring for local readers of the live samples, about 1 s of 32 channels at 1 MHz
+AcquisitionSession session;
+AcquisitionEngine &acquisition = session.engine();
+FilterBank &filterBank = session.filters();
+Recorder &recorder = session.recorder();
+PlaybackSource &playbackSource = session.playback();
+string playbackFile;  // non-empty while a capture is being played back instead of a device
+const double playbackSpeeds[] = { 0.1, 0.5, 1, 2, 10, 100, PLAYBACK_AS_FAST_AS_POSSIBLE };  // Playback > Speed, ID_PLAYBACK_SPEED0 + index
+
+HWND hWndMain = NULL;  // for the File > Record check mark when recording stops on its own
+
+// the message loop draws a frame whenever the scheduler says one is due and sleeps in between, see Display menu
+FrameScheduler frameScheduler;
+#define FRAME_RATE_MONITOR -1  // the monitor's refresh rate, presenting in step with it
+const double frameRates[] = { 30, 60, 120, FRAME_RATE_MONITOR, FRAME_RATE_UNLIMITED };  // Display menu, ID_DISPLAY_FPS0 + index
+bool syncToMonitor = false;  // present right before the monitor's vertical blank (DwmFlush after each frame)
+#define FRAME_TIMER_ID 1
+#define KEEPALIVE_MILLISECONDS 100  // frame timer while the message loop runs: only keeps modal dialogs draining the ring
+
+const float64 sampleRates[] = { 50, 100, 500, 1000, 5000, 10000, 50000, 100000, 500000, 1000000, 2000000 };
+const int numSampleRates = sizeof(sampleRates) / sizeof(sampleRates[0]);
+
+float widthWindow = 1024;
+float heightWindow = 768;
+HDC hdcBack = NULL;
+HDC hdcBackGround = NULL;
+HBITMAP screenMain = NULL;  // 32 bit top-down DIB section behind hdcBack, what gets presented
+HBITMAP screenBackground = NULL;  // DIB section behind hdcBackGround, the static background layer with its text
+Raster frame;  // screenMain's pixels
+Raster backgroundLayer;  // screenBackground's pixels
+Raster traceLayer;
+Raster xyFrameLayer;
+Raster xyLayer;
+Compositor compositor;
+#define BACKGROUND_LAYER 0  // layer indices, in the order they're added to the compositor
+#define TRACE_LAYER 1
+#define XY_FRAME_LAYER 2
+#define XY_LAYER 3
+bool staticLayersDirty = true;  // background and XY frame need redrawing (resize, Hide Grid, Hide 2D Plot)
+bool tracesDirty = true;
+uInt64 tracesDrawnAt = 0;  // history.written() when the traces were last drawn
+DirtyRegion previousOverlay;
+char xySampleText[255] = { "" };
+const int edge = 40;  // left margin of the plot, room for the y axis labels
+#define CHANNEL_PALETTE_SIZE 8
+Pixel channelPalette[CHANNEL_PALETTE_SIZE];  // channels take these colors in turn
+Pixel gridColor;
+
+Pixel channelColor(int channel) {
+	return channelPalette[channel % CHANNEL_PALETTE_SIZE];
+}
+Pixel backgroundColor;
+Pixel plotBackgroundColor;
+
+// Display menu: the plotted pair on a shared y axis, every channel on it, or every channel in a strip of its own
+#define TRACE_LAYOUT_PAIR 0
+#define TRACE_LAYOUT_OVERLAID 1
+#define TRACE_LAYOUT_STACKED 2
+int traceLayout = TRACE_LAYOUT_PAIR;
+
+// what the sample values overlay lists, formatted only while it is shown
+#define SAMPLE_VALUE_LINES 10
+EventLog eventLog;
+
+#ifdef SCOPE_COUNT_ALLOCATIONS
+// heap allocations by any thread between the last two frames, which should settle at 0
+uint64_t allocationsAt = 0;
+uint64_t frameAllocations = 0;
+#endif
+
+uInt64 sampleNum = 0;
+
+// peak-detect envelope of the trace, one min/max pair per pixel column, scrolled rather than redrawn as samples arrive
+TraceView traceView;
+// the UI thread and these draw the trace's channels in parallel; Display menu, ID_DISPLAY_THREADS0 + index
+#define RENDER_THREADS_ALL_CORES 0
+const int renderThreadCounts[] = { 1, 2, 4, RENDER_THREADS_ALL_CORES };
+WorkerPool renderPool;
+
+// Trigger menu: instead of scrolling, show sweeps of sweepSeconds around trigger events on the first plotted channel
+#define TRIGGER_HYSTERESIS_VOLTS 0.1
+#define TRIGGER_LEVEL_STEP_VOLTS 0.1  // Up/Down keys
+#define TRIGGER_POSITION_STEP 0.05  // Page Up/Down keys, fraction of the sweep
+#define TRIGGER_AUTO_SECONDS 0.1  // auto mode sweeps on its own after this long (or one sweep length) without a trigger
+Trigger trigger;
+TriggerMode triggerMode = TRIGGER_FREE_RUN;
+TriggerType triggerType = TRIGGER_EDGE;
+bool triggerRising = true;
+double triggerLevelVolts = 0;  // for the slope trigger the change within 1% of the sweep
+double triggerPosition = 0.25;  // part of the sweep before the trigger point
+double sweepSeconds = 0.01;
+const double sweepLengths[] = { 0.001, 0.01, 0.1, 1 };  // Trigger > Sweep, ID_TRIGGER_SWEEP0 + index
+vector<int16_t> sweepCodes[2];  // the plotted pair's samples of the last sweep, held until the next one
+uInt64 sweepPreTrigger = 0;
+bool sweepForced = false;
+bool sweepValid = false;
+
+// Spectrum menu: the trace area shows the spectra of the plotted pair over a scrolling spectrogram of the first one
+#define SPECTRUM_TOP_DB 20  // dB volts peak at the top of the spectrum plot
+#define SPECTRUM_BOTTOM_DB -140
+#define SPECTRUM_SPLIT 0.55  // share of the plot height that goes to the spectrum, the spectrogram gets the rest
+SpectrumAnalyzer spectrumAnalyzer;
+SpectrumSettings spectrumSettings;
+const int fftSizes[] = { 1024, 4096, 16384 };  // Spectrum menu, ID_SPECTRUM_SIZE0 + index
+int showSpectrum = -1;
+uInt64 spectrumDrawnAt = 0;  // spectrumAnalyzer.version() when the spectra were last drawn
+uint64_t waterfallCursor = 0;
+Pixel waterfallColors[256];
+char spectrumText[255] = { "" };
+
+// Measure menu: min/max/mean/RMS/Vpp/frequency/duty of every channel, kept up to date as the samples arrive
+Measurements measurements;
+const double measureWindows[] = { 0.1, 1, 10 };  // seconds, Measure menu, ID_MEASURE_WINDOW0 + index
+double measureSeconds = 1;
+int showMeasurements = -1;
+
+// Display > Show Telemetry: what the reader thread and each stage of the frame did over the last second, and
+// how old the newest samples were when they reached the screen; File > Telemetry Log writes it to a file
+#define TELEMETRY_PERIOD_SECONDS 1
+#define TELEMETRY_LINES 5
+Telemetry telemetry;
+int showTelemetry = -1;
+char telemetryText[TELEMETRY_LINES][160];
+int telemetryLines = 0;
+
+int show2D = 1;
+int pauseScreen = -1;
+int showSampleValues = -1;
+int hideGrid = -1;
+int showPersistence = -1;
+
+void StopDAQ();
+void StopRecording();
+void applyTrigger();
+void setFrameRate(HWND hWnd, int index);
+void StartSpectrum();
+void StopSpectrum();
+void StopTelemetryLog();
+
+// the rate of the samples in the history, after decimation
+double historyRate() {
+	return session.running() ? session.outputRate() : sampleRate;
+}
+
+bool allocateHistory() {
+	char tempPath[MAX_PATH] = { "" };
+	GetTempPathA(MAX_PATH, tempPath);
+
+	AcquisitionSource *source = session.source();
+	const AcquisitionConfig &activeConfig = session.config();
+	uInt64 capacity = (uInt64)(historySeconds * historyRate());
+	if (!history.allocate(source->numChannels(), capacity, (uInt64)HISTORY_RAM_LIMIT_MB << 20, tempPath)) {
+		MessageBoxA(0, history.errorString().c_str(), "Oscilloscope-NIDAQmx", MB_ICONERROR);
+		return false;
+	}
+	int count = source->numChannels();
+	channelScaling.resize(count);
+	channelLow.resize(count);
+	channelHigh.resize(count);
+	for (int channel = 0; channel < count; channel++) {
+		channelScaling[channel] = source->scaling(channel);
+		// the range the channel was configured for; playback knows only the codes' span
+		bool configured = channel < activeConfig.numChannels() && !session.playingBack();
+		channelLow[channel] = (float)(configured ? activeConfig.channels[channel].minVoltage : channelScaling[channel].toVolts(-32768));
+		channelHigh[channel] = (float)(configured ? activeConfig.channels[channel].maxVoltage : channelScaling[channel].toVolts(32767));
+	}
+	measurements.configure(count, historyRate(), channelScaling.data(), measureSeconds);
+	sampleNum = 0;
+	return true;
+}
+
+void InitDAQ() {
+
+	StopDAQ();
+
+	if (daqDevices.empty() && playbackFile.empty()) {
+		return;
+	}
+	if (daqDeviceIndexChosen < 0 || daqDeviceIndexChosen >= (int)daqDevices.size()) {
+		daqDeviceIndexChosen = 0;
+	}
+
+	SessionSettings settings;
+	settings.playbackFile = playbackFile;
+	settings.channelList = channelList;
+	settings.device = daqDevices.empty() ? "" : daqDevices[daqDeviceIndexChosen];
+	settings.inputs = inputsPerDevice;
+	settings.inputRange = inputRange;
+	settings.sampleRate = sampleRate;
+	settings.terminalConfig = terminalConfig;
+	settings.filterList = filterList;
+	settings.decimation = decimation;
+	settings.minimumChannels = 2;  // the XY plot, trigger and spectrum all work on a pair
+	settings.blockMilliseconds = BLOCK_MILLISECONDS;
+	settings.ringSeconds = RING_SECONDS;
+	bool broadcasting = session.broadcasting();
+	if (!session.start(settings)) {
+		MessageBoxA(0, session.errorString().c_str(), "Oscilloscope-NIDAQmx", MB_ICONERROR);
+		return;
+	}
+	if (broadcasting && !session.broadcasting()) {
+		// the new channels didn't fit the broadcast, so it was dropped
+		MessageBoxA(0, session.errorString().c_str(), "Oscilloscope-NIDAQmx", MB_ICONERROR);
+		if (hWndMain) CheckMenuItem(GetMenu(hWndMain), ID_FILE_BROADCAST, MF_UNCHECKED);
+	}
+	if (numChannelsToPlot > session.config().numChannels() / 2) {
+		numChannelsToPlot = session.config().numChannels() / 2;
+	}
+	staticLayersDirty = true;  // axis labels follow the channels' ranges
+
+	if (!allocateHistory()) {
+		StopDAQ();
+		return;
+	}
+
+	applyTrigger();
+	StartSpectrum();
+}
+
+// turns the Trigger menu's settings (volts, seconds) into the trigger's (codes, samples) for the running source
+void applyTrigger() {
+	double rate = historyRate();
+	int channel = numChannelsToPlot * 2 - 2;
+	if (channel >= (int)channelScaling.size()) {
+		return;  // nothing acquired yet, or not that pair; InitDAQ applies it once there is
+	}
+	const ChannelScaling &scaling = channelScaling[channel];
+
+	TriggerSettings settings;
+	settings.mode = triggerMode;
+	settings.type = triggerType;
+	settings.rising = triggerRising;
+	settings.channel = channel;
+
+	uInt64 window = (uInt64)(sweepSeconds * rate);
+	if (window < 16) window = 16;
+	if (history.capacity() > 0 && window > history.capacity() / 2) window = history.capacity() / 2;
+	settings.preTrigger = (uInt64)(window * triggerPosition);
+	settings.postTrigger = window - settings.preTrigger;
+
+	int zero = scaling.toCode(0);
+	int hysteresis = abs(scaling.toCode(TRIGGER_HYSTERESIS_VOLTS) - zero);
+	if (triggerType == TRIGGER_SLOPE) {
+		settings.slopeSamples = window / 100 > 1 ? (int)(window / 100) : 1;
+		settings.level = (int16_t)abs(scaling.toCode(triggerLevelVolts) - zero);
+	}
+	else {
+		settings.level = scaling.toCode(triggerLevelVolts);
+	}
+	settings.hysteresis = (int16_t)(hysteresis > 0 ? hysteresis : 1);
+	// pulses from 1% to half of the sweep, so the whole pulse is on screen
+	settings.minWidth = window / 100;
+	settings.maxWidth = window / 2;
+	settings.autoTimeout = (uInt64)(rate * TRIGGER_AUTO_SECONDS) > window ? (uInt64)(rate * TRIGGER_AUTO_SECONDS) : window;
+	trigger.configure(settings);
+}
+
+void clearData() {
+	history.clear();
+	phosphor.clear();
+	phosphorAt = 0;
+	trigger.reset(0);
+	measurements.reset();
+	sweepValid = false;
+	tracesDirty = true;
+}
+
+// runs on the UI thread: drains everything the reader thread pushed since the last frame into the history, and
+// logs the newest frame (or the read error) for the sample values overlay
+void daqRead() {
+	const int framesPerPop = 4096;
+	static vector<int16_t> frames;
+
+	int status = acquisition.status();
+	size_t framesRead = 0;
+	size_t numFrames;
+	int16_t newest[EVENT_MAX_CHANNELS];		// the newest frame that made it into the history
+	int newestChannels = 0;
+
+	if (!session.running()) {
+		return;
+	}
+	int channels = session.source()->numChannels();
+	if (frames.size() < (size_t)framesPerPop * channels) {
+		frames.resize((size_t)framesPerPop * channels);  // only when the channel count grows
+	}
+
+	while ((numFrames = acquisition.drain(frames.data(), framesPerPop)) > 0) {
+		framesRead += numFrames;
+		sampleNum += numFrames;
+		if (filterBank.active()) {
+			numFrames = filterBank.process(frames.data(), numFrames, frames.data());
+			if (numFrames == 0) continue;  // all went into the decimator
+		}
+		history.append(frames.data(), numFrames);
+		measurements.add(frames.data(), numFrames);
+		// copied now: a later batch the decimator swallows whole leaves frames holding raw samples
+		newestChannels = channels < EVENT_MAX_CHANNELS ? channels : EVENT_MAX_CHANNELS;
+		memcpy(newest, &frames[(numFrames - 1) * channels], newestChannels * sizeof(int16_t));
+	}
+
+	if (status != 0 || newestChannels > 0) {
+		EventRecord &event = eventLog.append();
+		event.sampleNum = sampleNum;
+		event.droppedFrames = acquisition.droppedFrames();
+		event.status = status;
+		event.numChannels = newestChannels;
+		for (int channel = 0; channel < newestChannels; channel++) {
+			event.volts[channel] = channelScaling[channel].toVolts(newest[channel]);
+		}
+	}
+}
+
+// "[sequence] (samples)v0, v1, ... dropped:n", or the status and error message of a failed read
+void formatEvent(const EventRecord &event, char *text, size_t size) {
+	int length = sprintf_s(text, size, "[%llu] (%llu)", (unsigned long long)event.sequence, (unsigned long long)event.sampleNum);
+	if (event.status != 0) {
+		// the error text comes from the driver as a string, fine for something that only shows up on failure
+		length += sprintf_s(text + length, size - length, " read() status:%d %s", event.status,
+			session.running() ? session.source()->errorString(event.status).c_str() : "");
+	}
+	else {
+		for (int channel = 0; channel < event.numChannels && length < (int)size - 16; channel++) {
+			length += sprintf_s(text + length, size - length, channel > 0 ? ", %.2f" : "%.2f", event.volts[channel]);
+		}
+	}
+	if (event.droppedFrames > 0 && length < (int)size - 32) {
+		sprintf_s(text + length, size - length, " dropped:%llu", (unsigned long long)event.droppedFrames);
+	}
+}
+
+void StopDAQ() {
+	if (!session.running())
+		return;
+
+	StopRecording();
+	StopSpectrum();
+	session.stop();
+	if (!session.errorString().empty()) {
+		MessageBoxA(0, session.errorString().c_str(), "Oscilloscope-NIDAQmx", MB_ICONERROR);
+	}
+}
+
+bool StartRecording(HWND hWnd) {
+	if (!session.running()) {
+		MessageBoxA(0, "Start acquisition before recording.", "Oscilloscope-NIDAQmx", MB_ICONERROR);
+		return false;
+	}
+	if (session.playingBack()) {
+		MessageBoxA(0, "Recording is not available while a capture is playing back.", "Oscilloscope-NIDAQmx", MB_ICONERROR);
+		return false;
+	}
+
+	char path[MAX_PATH] = { "capture.osc" };
+	OPENFILENAMEA dialog;
+	ZeroMemory(&dialog, sizeof(dialog));
+	dialog.lStructSize = sizeof(dialog);
+	dialog.hwndOwner = hWnd;
+	dialog.lpstrFilter = "Oscilloscope capture (*.osc)\0*.osc\0All files (*.*)\0*.*\0";
+	dialog.lpstrFile = path;
+	dialog.nMaxFile = MAX_PATH;
+	dialog.lpstrDefExt = "osc";
+	dialog.Flags = OFN_OVERWRITEPROMPT | OFN_PATHMUSTEXIST;
+	if (!GetSaveFileNameA(&dialog)) {
+		return false;
+	}
+
+	if (!session.startRecording(path, RECORD_QUEUE_SECONDS)) {
+		MessageBoxA(0, session.errorString().c_str(), "Oscilloscope-NIDAQmx", MB_ICONERROR);
+		return false;
+	}
+	return true;
+}
+
+bool OpenCapture(HWND hWnd) {
+	char path[MAX_PATH] = { "" };
+	OPENFILENAMEA dialog;
+	ZeroMemory(&dialog, sizeof(dialog));
+	dialog.lStructSize = sizeof(dialog);
+	dialog.hwndOwner = hWnd;
+	dialog.lpstrFilter = "Oscilloscope capture (*.osc)\0*.osc\0All files (*.*)\0*.*\0";
+	dialog.lpstrFile = path;
+	dialog.nMaxFile = MAX_PATH;
+	dialog.Flags = OFN_FILEMUSTEXIST | OFN_PATHMUSTEXIST;
+	if (!GetOpenFileNameA(&dialog)) {
+		return false;
+	}
+
+	StopDAQ();
+	playbackSource.close();  // opened afresh, so playback starts at the beginning even of the same file
+	playbackFile = path;
+	InitDAQ();
+	if (!session.running()) {
+		playbackFile.clear();  // back to the device
+		InitDAQ();
+		return false;
+	}
+	return true;
+}
+
+// jumps playback to frame; only the chunk index lookup and a prefetch restart, the history starts over from there
+void SeekPlayback(int64_t frame) {
+	if (!session.playingBack())
+		return;
+
+	bool restarted = session.seekPlayback(frame < 0 ? 0 : (uint64_t)frame);
+	clearData();
+	sampleNum = playbackSource.position();
+	if (!restarted) {
+		MessageBoxA(0, session.errorString().c_str(), "Oscilloscope-NIDAQmx", MB_ICONERROR);
+	}
+}
+
+// the analyzer runs only while its view is shown, it costs a few cores' worth at high rates
+void StartSpectrum() {
+	if (!session.running() || showSpectrum != 1) {
+		return;
+	}
+	AcquisitionSource *source = session.source();
+	spectrumSettings.waterfallChannel = numChannelsToPlot * 2 - 2;
+	if (!spectrumAnalyzer.start(spectrumSettings, source->numChannels(), source->sampleRate(), channelScaling.data())) {
+		MessageBoxA(0, "Could not start the spectrum analyzer.", "Oscilloscope-NIDAQmx", MB_ICONERROR);
+		return;
+	}
+	waterfallCursor = 0;
+	spectrumDrawnAt = 0;
+	acquisition.attach(&spectrumAnalyzer);
+}
+
+void StopSpectrum() {
+	if (!spectrumAnalyzer.running())
+		return;
+
+	acquisition.detach(&spectrumAnalyzer);
+	spectrumAnalyzer.stop();
+}
+
+void StopRecording() {
+	if (!session.recording())
+		return;
+
+	session.stopRecording();
+	if (!recorder.errorString().empty()) {
+		MessageBoxA(0, recorder.errorString().c_str(), "Oscilloscope-NIDAQmx", MB_ICONERROR);
+	}
+	if (hWndMain) CheckMenuItem(GetMenu(hWndMain), ID_FILE_RECORD, MF_UNCHECKED);
+}
+
+// CSV when the file ends in .csv, JSON lines otherwise; a line per second until the log is stopped
+bool StartTelemetryLog(HWND hWnd) {
+	char path[MAX_PATH] = { "telemetry.csv" };
+	OPENFILENAMEA dialog;
+	ZeroMemory(&dialog, sizeof(dialog));
+	dialog.lStructSize = sizeof(dialog);
+	dialog.hwndOwner = hWnd;
+	dialog.lpstrFilter = "CSV (*.csv)\0*.csv\0JSON lines (*.jsonl)\0*.jsonl\0All files (*.*)\0*.*\0";
+	dialog.lpstrFile = path;
+	dialog.nMaxFile = MAX_PATH;
+	dialog.lpstrDefExt = "csv";
+	dialog.Flags = OFN_OVERWRITEPROMPT | OFN_PATHMUSTEXIST;
+	if (!GetSaveFileNameA(&dialog)) {
+		return false;
+	}
+	if (!telemetry.openLog(path)) {
+		MessageBoxA(0, telemetry.errorString().c_str(), "Oscilloscope-NIDAQmx", MB_ICONERROR);
+		return false;
+	}
+	return true;
+}
+
+void StopTelemetryLog() {
+	string error = telemetry.errorString();  // of a failed write, closeLog() clears it
+	telemetry.closeLog();
+	if (!error.empty()) {
+		MessageBoxA(0, error.c_str(), "Oscilloscope-NIDAQmx", MB_ICONERROR);
+	}
+	if (hWndMain) CheckMenuItem(GetMenu(hWndMain), ID_FILE_TELEMETRYLOG, MF_UNCHECKED);
+}
+
+// Rendering is split into layers the compositor stacks into the frame: the background (fill, grid, axis
+// labels) and the XY plot frame only change with the window size or the Hide Grid / Hide 2D Plot options,
+// the traces and XY points change when samples arrive, and text overlays are drawn over the composed frame.
+HBITMAP createFrameDIB(HDC hdc, int width, int height, Raster &raster) {
+	// a DIB section, so the rasterizer can write the pixels directly and GDI can still draw text into them
+	BITMAPINFO info;
+	ZeroMemory(&info, sizeof(info));
+	info.bmiHeader.biSize = sizeof(info.bmiHeader);
+	info.bmiHeader.biWidth = width;
+	info.bmiHeader.biHeight = -height;  // negative: top-down rows
+	info.bmiHeader.biPlanes = 1;
+	info.bmiHeader.biBitCount = 32;
+	info.bmiHeader.biCompression = BI_RGB;
+	void *bits = NULL;
+	HBITMAP bitmap = CreateDIBSection(hdc, &info, DIB_RGB_COLORS, &bits, NULL, 0);
+	if (bitmap && bits) {
+		raster.attach((Pixel *)bits, width, height, width);
+	}
+	return bitmap;
+}
+
+// the channels the trace area shows, first up to but not including last
+void plottedChannels(int *first, int *last) {
+	/*
+	1 = 0,1
+	2 = 2,3
+	3 = 4,5
+	4 = 6,7
+	*/
+	if (traceLayout == TRACE_LAYOUT_PAIR) {
+		*first = numChannelsToPlot * 2 - 2;
+		*last = *first + 2;
+	}
+	else {
+		*first = 0;
+		*last = (int)channelScaling.size();
+	}
+}
+
+// +- volts of the shared y axis, wide enough for the widest range among the plotted channels
+float axisVolts() {
+	int first, last;
+	plottedChannels(&first, &last);
+	float volts = 0;
+	for (int channel = first; channel < last && channel < (int)channelHigh.size(); channel++) {
+		if (channelHigh[channel] > volts) volts = channelHigh[channel];
+		if (-channelLow[channel] > volts) volts = -channelLow[channel];
+	}
+	return volts > 0 ? volts : 10.0f;
+}
+
+RasterRect xyPlotRect() {
+	float hyp = sqrt(widthWindow*widthWindow + heightWindow*heightWindow);
+	float side2D = hyp * 1.0 / 8.0;
+	float edge2D = side2D * 1.0 / 10.0;
+	return RasterRect((int)(widthWindow - edge2D - side2D), (int)edge2D, (int)(widthWindow - edge2D), (int)(edge2D + side2D));
+}
+
+void drawStaticLayers() {
+	int width = (int)widthWindow;
+	int height = (int)heightWindow;
+
+	backgroundLayer.resetClip();
+	backgroundLayer.fill(backgroundColor);
+
+	// draw a vertical line demarcating the Y-axis boundary
+	backgroundLayer.vline(edge, 0, height - 1, gridColor);
+
+	// plots the y axis
+	SetTextColor(hdcBackGround, RGB(180, 180, 180));
+	if (traceLayout == TRACE_LAYOUT_STACKED) {
+		// a strip per channel, numbered when there is room for the label
+		int count = (int)channelScaling.size();
+		for (int channel = 0; channel < count; channel++) {
+			int top = channel * height / count;
+			int bottom = (channel + 1) * height / count;
+			if (channel > 0) {
+				backgroundLayer.hlinePattern(edge, width - 1, top, gridColor, 3, 3);  // PS_DOT
+			}
+			if (bottom - top >= 24 && hideGrid != 1) {
+				backgroundLayer.hlinePattern(edge, width - 1, (top + bottom) / 2, gridColor, 18, 6);  // 0 V of a symmetric range
+			}
+			if (bottom - top >= 14) {
+				char label[8];
+				int length = sprintf_s(label, "%d", channel);
+				TextOutA(hdcBackGround, 11, (top + bottom) / 2 - 8, label, length);
+			}
+		}
+	}
+	else {
+		float volts = axisVolts();
+		for (float yAxis = 0; yAxis < 20; yAxis++) {
+			int yGrid = (int)(yAxis / 20 * heightWindow);
+
+			char label[16];
+			int step = (int)((yAxis - 10)*-1);
+			float value = step * volts / 10;
+			int length = sprintf_s(label, value <= 0 ? "%gV" : "+%gV", value);
+			TextOutA(hdcBackGround, 2, yGrid - 8, label, length);
+
+			if (hideGrid == 1) {
+				backgroundLayer.hline(edge, edge + 7, yGrid, gridColor);
+			}
+			else if (step % 5 == 0) {
+				backgroundLayer.hlinePattern(edge, width - 1, yGrid, gridColor, 18, 6);  // the PS_DASH pattern
+			}
+			else {
+				backgroundLayer.hlinePattern(edge, width - 1, yGrid, gridColor, 3, 3);  // PS_DOT
+			}
+		}
+	}
+	GdiFlush();  // the labels must be in the pixels before the compositor copies them
+
+	// the XY plot's box and axes, over the traces
+	xyFrameLayer.resetClip();
+	xyFrameLayer.fill(PIXEL_TRANSPARENT);
+	if (show2D == 1) {
+		RasterRect rect = xyPlotRect();
+		int width2D = rect.right - rect.left;
+
+		xyFrameLayer.fillRect(rect.left, rect.top, rect.right, rect.bottom, plotBackgroundColor);
+		xyFrameLayer.rect(rect.left, rect.top, rect.right, rect.bottom, gridColor);
+		// render the x axis
+		xyFrameLayer.hline(rect.left, rect.right - 1, rect.top / 2 + rect.bottom / 2, gridColor);
+		// render the y axis
+		xyFrameLayer.vline(rect.left + (width2D) / 2, rect.top, rect.bottom - 1, gridColor);
+
+		// the density map is as big as the box, so a resize starts it over
+		if (phosphor.width() != width2D || phosphor.height() != rect.bottom - rect.top) {
+			phosphor.allocate(width2D, rect.bottom - rect.top);
+		}
+	}
+
+	compositor.invalidateAll();
+}
+
+void drawTraces() {
+	int first, last;
+	plottedChannels(&first, &last);
+	if (last > (int)channelScaling.size()) {
+		return;
+	}
+
+	// reused every frame, they only grow when the channel count does
+	static vector<int> channels;
+	static vector<Pixel> colors;
+	int count = last - first;
+	channels.resize(count);
+	colors.resize(count);
+	for (int i = 0; i < count; i++) {
+		channels[i] = first + i;
+		colors[i] = channelColor(first + i);
+	}
+
+	// the plot spans the whole history, newest sample at the right edge; until the history has
+	// filled up the trace grows in from the right
+	float volts = axisVolts();
+	traceView.setArea(RasterRect(edge, 0, (int)widthWindow, (int)heightWindow), -volts, volts);
+	traceView.setLayout(traceLayout == TRACE_LAYOUT_STACKED ? TRACES_STACKED : TRACES_OVERLAID);
+	traceView.setChannels(channels.data(), colors.data(), &channelScaling[first], count, &channelLow[first], &channelHigh[first]);
+	compositor.invalidate(traceView.update(traceLayer, history));
+}
+
+// copies the plotted pair's samples of the trigger's latest sweep out of the history
+bool captureSweep() {
+	uInt64 start = trigger.sweepStart();
+	size_t length = (size_t)trigger.sweepLength();
+	if (start < history.oldest() || start + length > history.written() || numChannelsToPlot * 2 > history.numChannels()) {
+		return false;
+	}
+	int channels[2] = { numChannelsToPlot * 2 - 2, numChannelsToPlot * 2 - 1 };
+	for (int i = 0; i < 2; i++) {
+		sweepCodes[i].resize(length);
+		history.read(channels[i], start, length, sweepCodes[i].data());
+	}
+	sweepPreTrigger = trigger.settings().preTrigger;
+	sweepForced = trigger.sweepForced();
+	sweepValid = true;
+	return true;
+}
+
+int voltsToY(float volts) {
+	float axis = axisVolts();
+	return (int)((axis - volts) / (2 * axis) * heightWindow);
+}
+
+// the held sweep, drawn from scratch: a polyline through every sample when they fit, otherwise a peak-detect envelope
+void drawSweep() {
+	RasterRect plot(edge, 0, (int)widthWindow, (int)heightWindow);
+	int width = plot.right - plot.left;
+	traceLayer.resetClip();
+	traceLayer.fillRect(plot.left, plot.top, plot.right, plot.bottom, PIXEL_TRANSPARENT);
+	compositor.invalidate(plot);
+	if (!sweepValid || width <= 1) {
+		return;
+	}
+
+	static vector<int16_t> codeMin, codeMax;
+	static vector<float> voltMin, voltMax;
+	static vector<int> xs, ys;  // polyline points, or the top and bottom of each column's span
+	size_t length = sweepCodes[0].size();
+	for (int i = 0; i < 2; i++) {
+		int channel = numChannelsToPlot * 2 - 2 + i;
+		if (length <= (size_t)width) {
+			voltMin.resize(length);
+			xs.resize(length);
+			ys.resize(length);
+			scaleToVolts(sweepCodes[i].data(), length, channelScaling[channel], voltMin.data());
+			for (size_t j = 0; j < length; j++) {
+				xs[j] = plot.left + (int)(j * (width - 1) / (length > 1 ? length - 1 : 1));
+				ys[j] = voltsToY(voltMin[j]);
+			}
+			traceLayer.polyline(xs.data(), ys.data(), length, channelColor(channel));
+		}
+		else {
+			codeMin.resize(width);
+			codeMax.resize(width);
+			voltMin.resize(width);
+			voltMax.resize(width);
+			xs.resize(width);
+			ys.resize(width);
+			PeakDecimator<int16_t> decimator;
+			decimator.begin(length, width, codeMin.data(), codeMax.data());
+			decimator.add(sweepCodes[i].data(), length);
+			decimator.end();
+			scaleToVolts(codeMin.data(), width, channelScaling[channel], voltMin.data());
+			scaleToVolts(codeMax.data(), width, channelScaling[channel], voltMax.data());
+			for (int column = 0; column < width; column++) {
+				// stretch each span to reach the previous column so the trace stays connected
+				float lo = voltMin[column], hi = voltMax[column];
+				if (column > 0) {
+					if (voltMax[column - 1] < lo) lo = voltMax[column - 1];
+					if (voltMin[column - 1] > hi) hi = voltMin[column - 1];
+				}
+				xs[column] = voltsToY(hi);
+				ys[column] = voltsToY(lo);
+			}
+			traceLayer.columnSpans(plot.left, xs.data(), ys.data(), width, channelColor(channel));
+		}
+	}
+
+	// where the trigger fired, and the level it fired at
+	Pixel markerColor = pixelRGB(255, 160, 0);
+	int x = plot.left + (int)(sweepPreTrigger * (width - 1) / (length > 1 ? length - 1 : 1));
+	for (int y = plot.top; y < plot.bottom; y += 6) {
+		traceLayer.vline(x, y, y + 2, markerColor);
+	}
+	if (triggerType != TRIGGER_SLOPE) {
+		traceLayer.hlinePattern(plot.left, plot.right - 1, voltsToY((float)triggerLevelVolts), markerColor, 6, 6);
+	}
+}
+
+// the scrolling traces, the trigger sweeps and the spectrum share the trace layer, switching starts it over
+void resetTraceLayer() {
+	traceLayer.resetClip();
+	traceLayer.fill(PIXEL_TRANSPARENT);
+	traceView.invalidate();
+	compositor.invalidateAll();
+	sweepValid = false;
+	tracesDirty = true;
+}
+
+void setTriggerMode(HWND hWnd, TriggerMode mode) {
+	if (mode == TRIGGER_SINGLE) {
+		trigger.arm();  // picking Single again takes another sweep
+	}
+	if (mode != triggerMode) {
+		triggerMode = mode;
+		resetTraceLayer();
+		applyTrigger();
+		trigger.reset(history.written());
+	}
+	CheckMenuRadioItem(GetMenu(hWnd), ID_TRIGGER_MODE0, ID_TRIGGER_MODE3, ID_TRIGGER_MODE0 + mode, MF_BYCOMMAND);
+}
+
+int dbToY(float db, const RasterRect &rect) {
+	float t = (SPECTRUM_TOP_DB - db) / (SPECTRUM_TOP_DB - SPECTRUM_BOTTOM_DB);
+	if (t < 0) t = 0;
+	if (t > 1) t = 1;
+	return rect.top + (int)(t * (rect.bottom - rect.top - 1));
+}
+
+// one spectrum across rect, 0 Hz on the left; with more bins than columns each column shows its loudest bin
+void drawSpectrumLine(const vector<float> &db, const RasterRect &rect, Pixel color) {
+	static vector<int> xs, ys;
+	int width = rect.right - rect.left;
+	size_t bins = db.size();
+	if (bins < 2 || width < 2) return;
+	size_t points = bins > (size_t)width ? (size_t)width : bins;
+	xs.resize(points);
+	ys.resize(points);
+	for (size_t i = 0; i < points; i++) {
+		float loudest = db[i];
+		if (points < bins) {
+			size_t first = i * bins / points, last = (i + 1) * bins / points;
+			loudest = db[first];
+			for (size_t k = first + 1; k < last; k++) {
+				if (db[k] > loudest) loudest = db[k];
+			}
+		}
+		xs[i] = rect.left + (int)(i * (width - 1) / (points - 1));
+		ys[i] = dbToY(loudest, rect);
+	}
+	traceLayer.polyline(xs.data(), ys.data(), points, color);
+}
+
+// the spectra whenever the analyzer published new ones, and the spectrogram scrolled left by the rows it added
+void drawSpectrum(bool redrawAll) {
+	RasterRect plot(edge, 0, (int)widthWindow, (int)heightWindow);
+	int split = (int)(heightWindow * SPECTRUM_SPLIT);
+	RasterRect spectrumRect(plot.left, plot.top, plot.right, split);
+	RasterRect waterfallRect(plot.left, split, plot.right, plot.bottom);
+	int width = plot.right - plot.left;
+	if (width < 2 || waterfallRect.empty()) {
+		return;
+	}
+	traceLayer.resetClip();
+
+	static vector<float> db, peak, rows;
+	if (redrawAll || spectrumAnalyzer.version() != spectrumDrawnAt) {
+		spectrumDrawnAt = spectrumAnalyzer.version();
+		traceLayer.fillRect(spectrumRect.left, spectrumRect.top, spectrumRect.right, spectrumRect.bottom, PIXEL_TRANSPARENT);
+		compositor.invalidate(spectrumRect);
+		traceLayer.setClip(spectrumRect.left, spectrumRect.top, spectrumRect.right, spectrumRect.bottom);
+		spectrumText[0] = 0;
+		for (int i = 1; i >= 0; i--) {
+			int channel = numChannelsToPlot * 2 - 2 + i;
+			if (!spectrumAnalyzer.spectrum(channel, db, &peak)) continue;
+			Pixel color = channelColor(channel);
+			if (spectrumSettings.peakHold) {
+				drawSpectrumLine(peak, spectrumRect, pixelRGB(((color >> 16) & 255) / 2, ((color >> 8) & 255) / 2, (color & 255) / 2));
+			}
+			drawSpectrumLine(db, spectrumRect, color);
+			if (i == 0) {
+				size_t loudest = 1;  // past DC
+				for (size_t k = 2; k < db.size(); k++) {
+					if (db[k] > db[loudest]) loudest = k;
+				}
+				if (db.size() > 2) {
+					sprintf_s(spectrumText, "0 - %g kHz   FFT %d   %.1f Hz/bin   peak %.1f Hz  %.1f dBV", spectrumAnalyzer.binHz() * (db.size() - 1) / 1000,
+						spectrumSettings.fftSize, spectrumAnalyzer.binHz(), loudest * spectrumAnalyzer.binHz(), db[loudest]);
+				}
+			}
+		}
+		traceLayer.resetClip();
+	}
+
+	if (redrawAll) {
+		traceLayer.fillRect(waterfallRect.left, waterfallRect.top, waterfallRect.right, waterfallRect.bottom, waterfallColors[0]);
+		compositor.invalidate(waterfallRect);
+	}
+	int bins = spectrumAnalyzer.bins();
+	int height = waterfallRect.bottom - waterfallRect.top;
+	size_t count = spectrumAnalyzer.waterfallRows(&waterfallCursor, rows, (size_t)width);
+	if (count == 0 || bins < 2) {
+		return;
+	}
+	// time runs left to right like the traces, 0 Hz at the bottom; each pixel shows the loudest of its bins
+	traceLayer.scrollLeft(waterfallRect.left, waterfallRect.top, waterfallRect.right, waterfallRect.bottom, (int)count);
+	for (size_t r = 0; r < count; r++) {
+		const float *row = &rows[r * bins];
+		int x = waterfallRect.right - (int)count + (int)r;
+		for (int y = 0; y < height; y++) {
+			int first = (height - 1 - y) * bins / height, last = (height - y) * bins / height;
+			float loudest = row[first];
+			for (int k = first + 1; k < last; k++) {
+				if (row[k] > loudest) loudest = row[k];
+			}
+			int level = (int)((loudest - SPECTRUM_BOTTOM_DB) * 255 / (SPECTRUM_TOP_DB - SPECTRUM_BOTTOM_DB));
+			traceLayer.row(waterfallRect.top + y)[x] = waterfallColors[level < 0 ? 0 : (level > 255 ? 255 : level)];
+		}
+	}
+	compositor.invalidate(waterfallRect);
+}
+
+// dark blue through cyan and yellow to white
+void buildWaterfallColors() {
+	const int stops[5][3] = { { 0, 0, 32 }, { 0, 0, 200 }, { 0, 200, 200 }, { 240, 240, 0 }, { 255, 255, 255 } };
+	for (int i = 0; i < 256; i++) {
+		int segment = i * 4 / 256;
+		int t = i * 4 % 256;
+		const int *a = stops[segment], *b = stops[segment + 1];
+		waterfallColors[i] = pixelRGB(a[0] + (b[0] - a[0]) * t / 255, a[1] + (b[1] - a[1]) * t / 255, a[2] + (b[2] - a[2]) * t / 255);
+	}
+}
+
+void drawXYPlot() {
+	compositor.beginLayer(XY_LAYER);
+	sprintf_s(xySampleText, "[%llu] ", sampleNum);
+
+	uInt64 available = history.size();
+	if (show2D != 1 || available == 0 || numChannelsToPlot * 2 > (int)channelScaling.size()) {
+		return;
+	}
+	RasterRect rect = xyPlotRect();
+	int height2D = rect.bottom - rect.top;
+	int width2D = rect.right - rect.left;
+
+	// both axes span +- the wider of the pair's ranges
+	float xyVolts = 0;
+	for (int channel = numChannelsToPlot * 2 - 2; channel < numChannelsToPlot * 2; channel++) {
+		if (channelHigh[channel] > xyVolts) xyVolts = channelHigh[channel];
+		if (-channelLow[channel] > xyVolts) xyVolts = -channelLow[channel];
+	}
+	if (xyVolts <= 0) xyVolts = 10.0f;
+
+	// render the data
+	//for (int channel = 0; channel < numChannelsToPlot; channel++) {
+	for (int channel = numChannelsToPlot-1; channel < numChannelsToPlot; channel++) {
+
+		static int16_t trailCodes[XY_TRAIL_SIZE];
+		static float trailX[XY_TRAIL_SIZE];
+		static float trailY[XY_TRAIL_SIZE];
+		static int trailPixelX[XY_TRAIL_SIZE];
+		static int trailPixelY[XY_TRAIL_SIZE];
+		if (showPersistence == 1) {
+			// fade what is there by the time since the last frame, then add every sample that arrived since
+			chrono::steady_clock::time_point now = chrono::steady_clock::now();
+			double elapsed = chrono::duration<double>(now - phosphorDecayedAt).count();
+			phosphorDecayedAt = now;
+			phosphor.decay(elapsed < 1.0 ? elapsed : 1.0);
+
+			uInt64 from = phosphorAt;
+			if (from < history.oldest()) from = history.oldest();
+			if (history.written() - from > PERSISTENCE_MAX_SAMPLES) from = history.written() - PERSISTENCE_MAX_SAMPLES;
+			while (from < history.written()) {
+				uInt64 remaining = history.written() - from;
+				size_t count = remaining > XY_TRAIL_SIZE ? XY_TRAIL_SIZE : (size_t)remaining;
+				history.read(channel * 2 + 0, from, count, trailCodes);
+				scaleToVolts(trailCodes, count, channelScaling[channel * 2 + 0], trailX);
+				history.read(channel * 2 + 1, from, count, trailCodes);
+				scaleToVolts(trailCodes, count, channelScaling[channel * 2 + 1], trailY);
+				phosphor.accumulate(trailX, trailY, count, -xyVolts, xyVolts, frameScheduler.sampleStride());
+				from += count;
+			}
+			phosphorAt = history.written();
+
+			phosphor.setColor(channelColor(channel * 1));
+			xyLayer.setClip(rect.left, rect.top, rect.right, rect.bottom);
+			phosphor.render(xyLayer, rect.left, rect.top);
+		}
+		else {
+		// show trail
+		size_t trailLength = available > XY_TRAIL_SIZE ? XY_TRAIL_SIZE : (size_t)available;
+		uInt64 trailStart = history.written() - trailLength;
+		history.read(channel * 2 + 0, trailStart, trailLength, trailCodes);
+		scaleToVolts(trailCodes, trailLength, channelScaling[channel * 2 + 0], trailX);
+		history.read(channel * 2 + 1, trailStart, trailLength, trailCodes);
+		scaleToVolts(trailCodes, trailLength, channelScaling[channel * 2 + 1], trailY);
+
+		for (size_t i = 0; i < trailLength; i++) {
+			trailPixelX[i] = (int)((trailX[i] + xyVolts) / (2 * xyVolts) * width2D) + rect.left;
+			trailPixelY[i] = (int)((trailY[i] + xyVolts) / (2 * xyVolts) * height2D) + rect.top;
+		}
+		xyLayer.setClip(rect.left, rect.top, rect.right, rect.bottom);
+		xyLayer.dots(trailPixelX, trailPixelY, trailLength, channelColor(channel * 1));
+		}
+		// show trail end
+
+
+		// show current location
+		float x = channelScaling[channel * 2 + 0].toVolts(history.at(channel * 2 + 0, history.written() - 1));
+		float y = channelScaling[channel * 2 + 1].toVolts(history.at(channel * 2 + 1, history.written() - 1));
+
+		if (showSampleValues == 1) sprintf_s(xySampleText, "%s(%4.2f, %4.2f)", xySampleText, x, y);
+
+		x = (x + xyVolts) / (2 * xyVolts);
+		y = (y + xyVolts) / (2 * xyVolts);
+
+		x = x * (float)width2D;
+		y = y * (float)height2D;
+
+		xyLayer.resetClip();
+		xyLayer.circle((int)x + rect.left, (int)y + rect.top, 6, channelColor(channel * 2));
+		// show current location end
+	}
+	// the marker circle may poke out of the box by its radius
+	compositor.layerDrawn(XY_LAYER, RasterRect(rect.left - 7, rect.top - 7, rect.right + 7, rect.bottom + 7));
+}
+
+// Measure menu table, a line per channel (as many as fit) under a heading, below the status lines
+int measurementLines() {
+	int fit = ((int)heightWindow - 64) / 20 - 1;
+	return measurements.numChannels() < fit ? measurements.numChannels() : (fit > 0 ? fit : 0);
+}
+
+RasterRect measurementsBox() {
+	return RasterRect(edge + 10, 44, edge + 10 + 640, 44 + 20 * (measurementLines() + 1));
+}
+
+RasterRect telemetryBox() {
+	int bottom = (int)heightWindow - 28;  // above the trigger line
+	return RasterRect(edge + 10, bottom - 20 * TELEMETRY_LINES, edge + 10 + 800, bottom);
+}
+
+// frame rate in the benchmark, and a warning when the display had to cut detail to keep up; always in debug
+// builds, which also count the heap allocations made since the previous frame
+bool showFrameStats() {
+#ifdef SCOPE_COUNT_ALLOCATIONS
+	return true;
+#else
+	return frameScheduler.benchmark() || frameScheduler.detail() > 0;
+#endif
+}
+
+// where the text overlays go this frame; they're drawn over the composed frame, so these get recomposed every time
+void overlayRegion(DirtyRegion &region) {
+	region.clear();
+	if (show2D == 1 && showSampleValues == 1) {
+		RasterRect rect = xyPlotRect();
+		region.add(RasterRect(rect.left + 1, rect.top - 20, (int)widthWindow, rect.top));
+	}
+	if (showSampleValues == 1) {
+		int x = (int)widthWindow / 2 - 150;
+		region.add(RasterRect(x, edge, x + 350, edge + 200));
+	}
+	if (recorder.recording() || session.playingBack()) {
+		region.add(RasterRect(edge + 10, 4, (int)widthWindow, 24));
+	}
+	if (showFrameStats()) {
+		region.add(RasterRect(edge + 10, 24, (int)widthWindow, 44));
+	}
+	if (triggerMode != TRIGGER_FREE_RUN) {
+		region.add(RasterRect(edge + 10, (int)heightWindow - 24, (int)widthWindow, (int)heightWindow - 4));
+	}
+	if (showSpectrum == 1) {
+		int split = (int)(heightWindow * SPECTRUM_SPLIT);
+		region.add(RasterRect(edge + 10, split - 20, (int)widthWindow, split));
+	}
+	if (showMeasurements == 1) {
+		region.add(measurementsBox());
+	}
+	if (showTelemetry == 1) {
+		region.add(telemetryBox());
+	}
+}
+
+void drawTextClipped(int x, int y, const RasterRect &clip, const char *text) {
+	RECT rect = { clip.left, clip.top, clip.right, clip.bottom };
+	ExtTextOutA(hdcBack, x, y, ETO_CLIPPED, &rect, text, (UINT)strlen(text), NULL);
+}
+
+void drawOverlay() {
+	if (show2D == 1 && showSampleValues == 1) {
+		RasterRect rect = xyPlotRect();
+		SetTextColor(hdcBack, RGB(180, 180, 180));
+		drawTextClipped(rect.left + 1, rect.top - 20, RasterRect(rect.left + 1, rect.top - 20, (int)widthWindow, rect.top), xySampleText);
+	}
+
+	if (showSampleValues == 1) {
+
+		int x = widthWindow / 2 - 150;
+		int y = edge;
+		RasterRect box(x, y, x + 350, y + 200);
+
+		frame.fillRect(box.left, box.top, box.right, box.bottom, backgroundColor);
+		SetTextColor(hdcBack, RGB(180, 180, 180));
+		int lines = eventLog.size() < SAMPLE_VALUE_LINES ? eventLog.size() : SAMPLE_VALUE_LINES;
+		for (int i = 0; i < lines; i++) {
+			char line[256];
+			formatEvent(eventLog.recent(lines - 1 - i), line, sizeof(line));
+			drawTextClipped(x, y + 20 * i, box, line);
+		}
+	}
+
+	RasterRect statusLine(edge + 10, 4, (int)widthWindow, 24);
+	if (recorder.recording()) {
+		RecorderStats stats = recorder.stats();
+		char recordStr[200];
+		sprintf_s(recordStr, "REC %.1f MB (%.0f%%)  %.1f MB/s  queue %d%% (peak %d%%)  dropped %llu",
+			stats.bytesWritten / 1e6, stats.compressionRatio * 100, stats.recentMBps, (int)(stats.queueFill * 100), (int)(stats.peakQueueFill * 100),
+			(unsigned long long)stats.droppedFrames);
+		SetTextColor(hdcBack, stats.droppedFrames > 0 ? RGB(255, 80, 80) : RGB(180, 180, 180));
+		drawTextClipped(statusLine.left, statusLine.top, statusLine, recordStr);
+	}
+
+	if (session.playingBack()) {
+		char playStr[200];
+		double speed = playbackSource.speed();
+		sprintf_s(playStr, "%s %.1f / %.1f s  %s%gx  %.1f MS/s", playbackSource.finished() ? "END" : "PLAY",
+			playbackSource.position() / playbackSource.sampleRate(), playbackSource.totalFrames() / playbackSource.sampleRate(),
+			speed > 0 ? "" : "max ", speed > 0 ? speed : playbackSource.throughput() / playbackSource.sampleRate(),
+			playbackSource.throughput() * playbackSource.numChannels() / 1e6);
+		SetTextColor(hdcBack, RGB(180, 180, 180));
+		drawTextClipped(statusLine.left, statusLine.top, statusLine, playStr);
+	}
+
+	if (showFrameStats()) {
+		RasterRect frameLine(edge + 10, 24, (int)widthWindow, 44);
+		char frameStr[200];
+		sprintf_s(frameStr, "%s %.0f fps  %.2f ms/frame  detail 1/%d  %d render thread%s", frameScheduler.benchmark() ? "BENCHMARK" : (frameScheduler.detail() > 0 ? "BEHIND" : "DEBUG"),
+			frameScheduler.framesPerSecond(), frameScheduler.frameMilliseconds(), frameScheduler.sampleStride(),
+			renderPool.threads(), renderPool.threads() > 1 ? "s" : "");
+#ifdef SCOPE_COUNT_ALLOCATIONS
+		size_t length = strlen(frameStr);
+		sprintf_s(frameStr + length, sizeof(frameStr) - length, "  %llu allocations", (unsigned long long)frameAllocations);
+#endif
+		SetTextColor(hdcBack, frameScheduler.detail() > 0 ? RGB(255, 180, 80) : RGB(180, 180, 180));
+		drawTextClipped(frameLine.left, frameLine.top, frameLine, frameStr);
+	}
+
+	if (triggerMode != TRIGGER_FREE_RUN) {
+		static const char *modeNames[] = { "", "Auto", "Normal", "Single" };
+		static const char *typeNames[] = { "edge", "level", "slope", "pulse" };
+		RasterRect triggerLine(edge + 10, (int)heightWindow - 24, (int)widthWindow, (int)heightWindow - 4);
+		const char *state = !trigger.waiting() ? "STOP" : (trigger.triggered() ? "TRIG'D" : (sweepValid && sweepForced ? "AUTO" : "READY"));
+		char triggerStr[200];
+		sprintf_s(triggerStr, "%s  %s %s %s  ch %d  %.2f V%s  pre %d%%  sweep %g ms  (%llu sweeps)", state, modeNames[triggerMode],
+			triggerRising ? "rising" : "falling", typeNames[triggerType], trigger.settings().channel, triggerLevelVolts,
+			triggerType == TRIGGER_SLOPE ? " per 1%" : "", (int)(triggerPosition * 100 + 0.5), sweepSeconds * 1000,
+			(unsigned long long)trigger.sweepCount());
+		SetTextColor(hdcBack, RGB(255, 160, 0));
+		drawTextClipped(triggerLine.left, triggerLine.top, triggerLine, triggerStr);
+	}
+
+	if (showSpectrum == 1) {
+		int split = (int)(heightWindow * SPECTRUM_SPLIT);
+		RasterRect spectrumLine(edge + 10, split - 20, (int)widthWindow, split);
+		SetTextColor(hdcBack, RGB(180, 180, 180));
+		drawTextClipped(spectrumLine.left, spectrumLine.top, spectrumLine, spectrumText);
+	}
+
+	if (showMeasurements == 1) {
+		RasterRect box = measurementsBox();
+		frame.fillRect(box.left, box.top, box.right, box.bottom, backgroundColor);
+		SetTextColor(hdcBack, RGB(180, 180, 180));
+		char line[200];
+		sprintf_s(line, "over %g s      min        max       mean        RMS        Vpp        freq      period    duty", measurements.windowSeconds());
+		drawTextClipped(box.left, box.top, box, line);
+		for (int channel = 0; channel < measurementLines(); channel++) {
+			Measurement m;
+			measurements.result(channel, m);
+			if (!m.valid) {
+				sprintf_s(line, "ch %d", channel);
+			}
+			else if (m.frequency > 0) {
+				sprintf_s(line, "ch %d  %9.4f  %9.4f  %9.4f  %9.4f  %9.4f  %9.2f Hz  %9.3g s  %5.1f%%", channel, m.minimum, m.maximum, m.mean,
+					m.rms, m.peakToPeak, m.frequency, m.period, m.dutyCycle * 100);
+			}
+			else {
+				sprintf_s(line, "ch %d  %9.4f  %9.4f  %9.4f  %9.4f  %9.4f         -- Hz         -- s      --", channel, m.minimum, m.maximum, m.mean,
+					m.rms, m.peakToPeak);
+			}
+			drawTextClipped(box.left, box.top + 20 * (channel + 1), box, line);
+		}
+	}
+
+	if (showTelemetry == 1) {
+		RasterRect box = telemetryBox();
+		frame.fillRect(box.left, box.top, box.right, box.bottom, backgroundColor);
+		const TelemetryReport &report = telemetry.report();
+		SetTextColor(hdcBack, report.framesDropped > 0 || report.overruns > 0 ? RGB(255, 80, 80) : RGB(180, 180, 180));
+		for (int i = 0; i < telemetryLines; i++) {
+			drawTextClipped(box.left, box.top + 20 * i, box, telemetryText[i]);
+		}
+	}
+}
+
+// one frame: drain the ring, redraw whatever the new samples changed and present it. Skipped, at next to no
+// cost, when nothing arrived and nothing else needs drawing.
+void renderFrame(HWND hWnd) {
+	frameScheduler.beginFrame();
+	double backlog = session.running() && acquisition.capacity() > 0 ? (double)acquisition.backlog() / acquisition.capacity() : 0;
+	traceView.setSampleStride(frameScheduler.sampleStride());
+	if (telemetry.update(acquisition)) {
+		telemetryLines = telemetry.formatLines(telemetryText, TELEMETRY_LINES);
+		if (!telemetry.logging() && !telemetry.errorString().empty()) {
+			StopTelemetryLog();  // the write failed
+		}
+	}
+	telemetry.beginFrame(backlog);
+	Telemetry::Clock::time_point mark = Telemetry::Clock::now();
+
+#ifdef SCOPE_COUNT_ALLOCATIONS
+	uint64_t allocations = allocationCount();
+	frameAllocations = allocations - allocationsAt;
+	allocationsAt = allocations;
+#endif
+
+	uInt64 before = sampleNum;
+	daqRead();
+	bool arrived = sampleNum != before;
+	telemetry.lap(STAGE_DRAIN, mark);
+
+	bool glowing = show2D == 1 && showPersistence == 1 && phosphor.glowing();
+	bool benchmark = frameScheduler.benchmark();
+	bool spectrumChanged = showSpectrum == 1 && spectrumAnalyzer.version() != spectrumDrawnAt;
+	if (!arrived && !staticLayersDirty && !tracesDirty && !glowing && !benchmark && !spectrumChanged && !compositor.pending()) {
+		frameScheduler.endFrame(false, backlog);
+		telemetry.endFrame(false);
+		return;
+	}
+
+	// GDI may still be drawing text into the DIBs from the last frame, finish that before the rasterizer writes
+	GdiFlush();
+
+	if (staticLayersDirty) {
+		drawStaticLayers();
+		staticLayersDirty = false;
+		tracesDirty = true;
+	}
+	// the traces only change when samples arrive (or the history was cleared), the
+	// persistence display also while it is still fading out
+	bool newSamples = tracesDirty || history.written() != tracesDrawnAt;
+	if (showSpectrum == 1) {
+		if (tracesDirty || spectrumAnalyzer.version() != spectrumDrawnAt) {
+			drawSpectrum(tracesDirty);
+		}
+	}
+	else if (triggerMode == TRIGGER_FREE_RUN) {
+		if (newSamples) {
+			drawTraces();
+		}
+	}
+	else if (newSamples) {
+		// a triggered display only changes when a sweep completes
+		bool swept = trigger.update(history) && captureSweep();
+		if (swept || tracesDirty) {
+			drawSweep();
+		}
+	}
+	telemetry.lap(STAGE_DRAW, mark);
+	if (newSamples || glowing) {
+		drawXYPlot();
+	}
+	telemetry.lap(STAGE_XY, mark);
+	if (newSamples) {
+		tracesDirty = false;
+		tracesDrawnAt = history.written();
+	}
+	if (benchmark) {
+		compositor.invalidateAll();  // the benchmark measures composing and presenting the whole window every frame
+	}
+
+	DirtyRegion overlay;
+	overlayRegion(overlay);
+	for (int i = 0; i < previousOverlay.size(); i++) compositor.invalidate(previousOverlay[i]);
+	for (int i = 0; i < overlay.size(); i++) compositor.invalidate(overlay[i]);
+	previousOverlay = overlay;
+
+	const DirtyRegion &region = compositor.compose();
+	telemetry.lap(STAGE_COMPOSE, mark);
+	if (region.empty()) {
+		frameScheduler.endFrame(false, backlog);
+		telemetry.endFrame(false);
+		return;  // nothing changed, nothing to present
+	}
+	drawOverlay();
+	telemetry.lap(STAGE_TEXT, mark);
+
+	// present only what changed, straight from the DIB the rasterizer and the text share
+	HDC hdc = GetDC(hWnd);
+	for (int i = 0; i < region.size(); i++) {
+		const RasterRect &r = region[i];
+		BitBlt(hdc, r.left, r.top, r.right - r.left, r.bottom - r.top, hdcBack, r.left, r.top, SRCCOPY);
+	}
+	ReleaseDC(hWnd, hdc);
+	frameScheduler.endFrame(true, backlog);
+	telemetry.lap(STAGE_PRESENT, mark);
+	telemetry.endFrame(true);
+
+	if (syncToMonitor) {
+		GdiFlush();
+		DwmFlush();  // returns at the next vertical blank, so the next frame starts in step with the monitor
+	}
+
+	// the newest sample this frame showed, from when the driver had it to when the frame went to the screen
+	int64_t sampledAt;
+	if (arrived && acquisition.newestSampleTime(&sampledAt)) {
+		int64_t now = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+		telemetry.sampleLatency((now - sampledAt) / 1e9);
+	}
+}
+
+void setFrameRate(HWND hWnd, int index) {
+	double rate = frameRates[index];
+	syncToMonitor = rate == FRAME_RATE_MONITOR;
+	if (syncToMonitor) {
+		HDC hdc = GetDC(hWnd);
+		rate = GetDeviceCaps(hdc, VREFRESH);
+		ReleaseDC(hWnd, hdc);
+		if (rate <= 1) rate = 60;  // "hardware default"
+	}
+	frameScheduler.setFrameRate(rate);
+	compositor.invalidateAll();
+	CheckMenuRadioItem(GetMenu(hWnd), ID_DISPLAY_FPS0, ID_DISPLAY_FPS4, ID_DISPLAY_FPS0 + index, MF_BYCOMMAND);
+}
+
+void setRenderThreads(HWND hWnd, int index) {
+	int threads = renderThreadCounts[index];
+	if (threads == RENDER_THREADS_ALL_CORES) {
+		threads = (int)thread::hardware_concurrency();
+	}
+	renderPool.start(threads);
+	traceView.setPool(&renderPool);
+	CheckMenuRadioItem(GetMenu(hWnd), ID_DISPLAY_THREADS0, ID_DISPLAY_THREADS3, ID_DISPLAY_THREADS0 + index, MF_BYCOMMAND);
+}
+
+// the rest is mostly boiler plate code except where I call the above functions and graph the data in the WM_TIMER message section of the WndProc
+
+#define MAX_LOADSTRING 100
+
+// Global Variables:
+HINSTANCE hInst;                                // current instance
+CHAR szTitle[MAX_LOADSTRING];                  // The title bar text
+CHAR szWindowClass[MAX_LOADSTRING];            // the main window class name
+
+// Forward declarations of functions included in this code module:
+ATOM                MyRegisterClass(HINSTANCE hInstance);
+BOOL                InitInstance(HINSTANCE, int);
+LRESULT CALLBACK    WndProc(HWND, UINT, WPARAM, LPARAM);
+INT_PTR CALLBACK    About(HWND, UINT, WPARAM, LPARAM);
+INT_PTR CALLBACK    ChoseDAQ(HWND, UINT, WPARAM, LPARAM);
+void				EnumerateDAQDevices(HWND hWnd);
+
+int APIENTRY wWinMain(_In_ HINSTANCE hInstance,
+                     _In_opt_ HINSTANCE hPrevInstance,
+                     _In_ LPWSTR    lpCmdLine,
+                     _In_ int       nCmdShow)
+{
+    UNREFERENCED_PARAMETER(hPrevInstance);
+    UNREFERENCED_PARAMETER(lpCmdLine);
+
+    // Initialize global strings
+    //LoadStringW(hInstance, IDS_APP_TITLE, szTitle, MAX_LOADSTRING);
+	strcpy_s(szTitle, "Digital Oscilloscope for Space / Time Testing");
+	strcpy_s(szWindowClass, "NIDAQMXWINDOW");
+    //LoadStringW(hInstance, IDC_NIDAQMXWINDOW, szWindowClass, MAX_LOADSTRING);
+    MyRegisterClass(hInstance);
+
+    // Perform application initialization:
+    if (!InitInstance (hInstance, nCmdShow))
+    {
+        return FALSE;
+    }
+
+    HACCEL hAccelTable = LoadAccelerators(hInstance, MAKEINTRESOURCE(IDC_NIDAQMXWINDOW));
+
+
+    MSG msg = {};
+
+    // Main message loop: handle whatever messages are waiting, draw a frame if one is due, then sleep until
+    // the next one is due or a message arrives. The 1 ms timer resolution keeps the sleeps from being rounded
+    // up to the 15.6 ms system tick, which would make 60 Hz frames alternate between 1 and 2 ticks.
+    timeBeginPeriod(1);
+    bool quit = false;
+    while (!quit)
+    {
+        while (PeekMessage(&msg, nullptr, 0, 0, PM_REMOVE))
+        {
+            if (msg.message == WM_QUIT)
+            {
+                quit = true;
+                break;
+            }
+            if (!TranslateAccelerator(msg.hwnd, hAccelTable, &msg))
+            {
+                TranslateMessage(&msg);
+                DispatchMessage(&msg);
+            }
+        }
+        if (quit) break;
+
+        if (pauseScreen != 1 && frameScheduler.due())
+        {
+            renderFrame(hWndMain);
+            continue;
+        }
+        MsgWaitForMultipleObjectsEx(0, NULL, pauseScreen == 1 ? INFINITE : frameScheduler.waitMilliseconds(), QS_ALLINPUT, MWMO_INPUTAVAILABLE);
+    }
+    timeEndPeriod(1);
+
+    return (int) msg.wParam;
+}
+
+
+
+//
+//  FUNCTION: MyRegisterClass()
+//
+//  PURPOSE: Registers the window class.
+//
+ATOM MyRegisterClass(HINSTANCE hInstance)
+{
+    WNDCLASSEX wcex;
+
+    wcex.cbSize = sizeof(WNDCLASSEX);
+
+    wcex.style          = CS_HREDRAW | CS_VREDRAW;
+    wcex.lpfnWndProc    = WndProc;
+    wcex.cbClsExtra     = 0;
+    wcex.cbWndExtra     = 0;
+    wcex.hInstance      = hInstance;
+    wcex.hIcon          = LoadIcon(hInstance, MAKEINTRESOURCE(IDI_NIDAQMXWINDOW));
+    wcex.hCursor        = LoadCursor(nullptr, IDC_ARROW);
+    wcex.hbrBackground  = (HBRUSH)(COLOR_WINDOW+1);
+    wcex.lpszMenuName   = MAKEINTRESOURCE(IDC_NIDAQMXWINDOW);
+    wcex.lpszClassName  = szWindowClass;
+    wcex.hIconSm        = LoadIcon(hInstance, MAKEINTRESOURCE(IDI_NIDAQMXWINDOW));
+
+    return RegisterClassEx(&wcex);
+}
+
+//
+//   FUNCTION: InitInstance(HINSTANCE, int)
+//
+//   PURPOSE: Saves instance handle and creates main window
+//
+//   COMMENTS:
+//
+//        In this function, we save the instance handle in a global variable and
+//        create and display the main program window.
+//
+BOOL InitInstance(HINSTANCE hInstance, int nCmdShow)
+{
+   hInst = hInstance; // Store instance handle in our global variable
+
+   HWND hWnd = CreateWindow(szWindowClass, szTitle, WS_OVERLAPPEDWINDOW,
+	   CW_USEDEFAULT, CW_USEDEFAULT, widthWindow, heightWindow, nullptr, nullptr, hInstance, nullptr);
+
+   if (!hWnd)
+   {
+      return FALSE;
+   }
+
+   hWndMain = hWnd;
+
+   ShowWindow(hWnd, nCmdShow);
+   UpdateWindow(hWnd);
+
+   return TRUE;
+}
+
+//
+//  FUNCTION: WndProc(HWND, UINT, WPARAM, LPARAM)
+//
+//  PURPOSE:  Processes messages for the main window.
+//
+//  WM_COMMAND  - process the application menu
+//  WM_PAINT    - Paint the main window
+//  WM_DESTROY  - post a quit message and return
+//
+//
+
+LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
+{
+	HDC hdcTemp;
+    switch (message)
+    {
+	case WM_CREATE:
+	{
+		// set these colors manually because I can't think of a better way
+		channelPalette[0] = pixelRGB(0, 255, 0);
+		channelPalette[1] = pixelRGB(0, 205, 0);
+		channelPalette[2] = pixelRGB(255, 255, 0);
+		channelPalette[3] = pixelRGB(205, 205, 0);
+		channelPalette[4] = pixelRGB(0, 255, 255);
+		channelPalette[5] = pixelRGB(0, 205, 205);
+		channelPalette[6] = pixelRGB(255, 0, 0);
+		channelPalette[7] = pixelRGB(205, 0, 0);
+
+		gridColor = pixelRGB(180, 180, 180);
+		backgroundColor = pixelRGB(88, 88, 88);
+		plotBackgroundColor = pixelRGB(58, 58, 58);
+
+		EnumerateDAQDevices(hWnd);
+		CheckMenuRadioItem(GetMenu(hWnd), ID_PLAYBACK_SPEED0, ID_PLAYBACK_SPEED6, ID_PLAYBACK_SPEED2, MF_BYCOMMAND);  // 1x
+		
+		CheckMenuRadioItem(GetMenu(hWnd), ID_TRIGGER_MODE0, ID_TRIGGER_MODE3, ID_TRIGGER_MODE0, MF_BYCOMMAND);  // free run
+		CheckMenuRadioItem(GetMenu(hWnd), ID_TRIGGER_TYPE0, ID_TRIGGER_TYPE3, ID_TRIGGER_TYPE0, MF_BYCOMMAND);  // edge
+		CheckMenuRadioItem(GetMenu(hWnd), ID_TRIGGER_RISING, ID_TRIGGER_FALLING, ID_TRIGGER_RISING, MF_BYCOMMAND);
+		CheckMenuRadioItem(GetMenu(hWnd), ID_TRIGGER_SWEEP0, ID_TRIGGER_SWEEP3, ID_TRIGGER_SWEEP1, MF_BYCOMMAND);  // 10 ms
+		CheckMenuRadioItem(GetMenu(hWnd), ID_SPECTRUM_WINDOW0, ID_SPECTRUM_WINDOW2, ID_SPECTRUM_WINDOW0 + spectrumSettings.window, MF_BYCOMMAND);
+		CheckMenuRadioItem(GetMenu(hWnd), ID_SPECTRUM_AVERAGE0, ID_SPECTRUM_AVERAGE2, ID_SPECTRUM_AVERAGE0 + spectrumSettings.averaging, MF_BYCOMMAND);
+		CheckMenuRadioItem(GetMenu(hWnd), ID_SPECTRUM_SIZE0, ID_SPECTRUM_SIZE2, ID_SPECTRUM_SIZE1, MF_BYCOMMAND);  // 4096
+		CheckMenuRadioItem(GetMenu(hWnd), ID_MEASURE_WINDOW0, ID_MEASURE_WINDOW2, ID_MEASURE_WINDOW1, MF_BYCOMMAND);  // 1 s
+		CheckMenuRadioItem(GetMenu(hWnd), ID_DISPLAY_LAYOUT0, ID_DISPLAY_LAYOUT2, ID_DISPLAY_LAYOUT0, MF_BYCOMMAND);  // plotted pair
+		buildWaterfallColors();
+		setFrameRate(hWnd, 1);  // 60 Hz
+		setRenderThreads(hWnd, 3);  // all cores
+		telemetry.start(TELEMETRY_PERIOD_SECONDS);
+		// frames normally come from the message loop, the timer keeps them going inside modal loops (menus,
+		// dialogs, dragging the window) that don't return to it
+		SetTimer(hWnd, FRAME_TIMER_ID, KEEPALIVE_MILLISECONDS, (TIMERPROC)NULL);
+	}
+		break;
+	case WM_SIZE:
+		widthWindow = LOWORD(lParam);
+		heightWindow = HIWORD(lParam);
+
+		hdcTemp = GetDC(hWnd);
+
+		// create DC for back buffer
+		if (hdcBack) {
+			DeleteDC(hdcBack); hdcBack = NULL;
+		}
+		hdcBack = CreateCompatibleDC(hdcTemp);
+
+		// create DC for the background
+		if (hdcBackGround) {
+			DeleteDC(hdcBackGround); hdcBackGround = NULL;
+		}
+		hdcBackGround = CreateCompatibleDC(hdcTemp);
+
+		frame.release();
+		backgroundLayer.release();
+		if (screenMain) {
+			DeleteObject(screenMain); screenMain = NULL;
+		}
+		if (screenBackground) {
+			DeleteObject(screenBackground); screenBackground = NULL;
+		}
+		{
+			int width = widthWindow > 1 ? (int)widthWindow : 1;
+			int height = heightWindow > 1 ? (int)heightWindow : 1;
+			screenMain = createFrameDIB(hdcTemp, width, height, frame);
+			screenBackground = createFrameDIB(hdcTemp, width, height, backgroundLayer);
+			traceLayer.allocate(width, height);
+			xyFrameLayer.allocate(width, height);
+			xyLayer.allocate(width, height);
+			traceView.invalidate();  // its layer was just replaced
+		}
+
+		SelectObject(hdcBack, screenMain);
+		SelectObject(hdcBackGround, screenBackground);
+
+		// set the text drawing properties into the DCs
+		SetBkMode(hdcBack, TRANSPARENT);
+		SetBkMode(hdcBackGround, TRANSPARENT);
+
+		compositor.clearLayers();
+		compositor.setOutput(&frame);
+		compositor.addLayer(&backgroundLayer);
+		compositor.addLayer(&traceLayer);
+		compositor.addLayer(&xyFrameLayer);
+		compositor.addLayer(&xyLayer);
+		staticLayersDirty = true;
+
+		// finished creating everything, release temporary DC
+		ReleaseDC(hWnd, hdcTemp);
+		break;
+	case WM_COMMAND:
+        {
+            int wmId = LOWORD(wParam);
+            // Parse the menu selections:
+            switch (wmId)
+            {
+			case ID_FILE_CLEARSCREEN:
+				clearData();
+				break;
+			case ID_FILE_SHOW2D:
+				show2D *= -1;
+				staticLayersDirty = true;
+				if (show2D == -1) {
+					CheckMenuItem(GetMenu(hWnd), ID_FILE_SHOW2D, MF_CHECKED);
+				}
+				else {
+					CheckMenuItem(GetMenu(hWnd), ID_FILE_SHOW2D, MF_UNCHECKED);
+				}
+				break;
+			case ID_FILE_PERSISTENCE:
+				showPersistence *= -1;
+				phosphor.clear();
+				phosphorAt = history.written();  // start glowing from now on rather than with the whole history at once
+				phosphorDecayedAt = chrono::steady_clock::now();
+				tracesDirty = true;
+				CheckMenuItem(GetMenu(hWnd), ID_FILE_PERSISTENCE, showPersistence == 1 ? MF_CHECKED : MF_UNCHECKED);
+				break;
+			case ID_TRIGGER_MODE0:
+			case ID_TRIGGER_MODE1:
+			case ID_TRIGGER_MODE2:
+			case ID_TRIGGER_MODE3:
+				setTriggerMode(hWnd, (TriggerMode)(wmId - ID_TRIGGER_MODE0));
+				break;
+			case ID_TRIGGER_TYPE0:
+			case ID_TRIGGER_TYPE1:
+			case ID_TRIGGER_TYPE2:
+			case ID_TRIGGER_TYPE3:
+				triggerType = (TriggerType)(wmId - ID_TRIGGER_TYPE0);
+				applyTrigger();
+				tracesDirty = true;
+				CheckMenuRadioItem(GetMenu(hWnd), ID_TRIGGER_TYPE0, ID_TRIGGER_TYPE3, wmId, MF_BYCOMMAND);
+				break;
+			case ID_TRIGGER_RISING:
+			case ID_TRIGGER_FALLING:
+				triggerRising = wmId == ID_TRIGGER_RISING;
+				applyTrigger();
+				CheckMenuRadioItem(GetMenu(hWnd), ID_TRIGGER_RISING, ID_TRIGGER_FALLING, wmId, MF_BYCOMMAND);
+				break;
+			case ID_TRIGGER_SWEEP0:
+			case ID_TRIGGER_SWEEP1:
+			case ID_TRIGGER_SWEEP2:
+			case ID_TRIGGER_SWEEP3:
+				sweepSeconds = sweepLengths[wmId - ID_TRIGGER_SWEEP0];
+				applyTrigger();
+				CheckMenuRadioItem(GetMenu(hWnd), ID_TRIGGER_SWEEP0, ID_TRIGGER_SWEEP3, wmId, MF_BYCOMMAND);
+				break;
+			case ID_SPECTRUM_SHOW:
+				showSpectrum *= -1;
+				resetTraceLayer();
+				if (showSpectrum == 1) StartSpectrum();
+				else StopSpectrum();
+				CheckMenuItem(GetMenu(hWnd), ID_SPECTRUM_SHOW, showSpectrum == 1 ? MF_CHECKED : MF_UNCHECKED);
+				break;
+			case ID_SPECTRUM_WINDOW0:
+			case ID_SPECTRUM_WINDOW1:
+			case ID_SPECTRUM_WINDOW2:
+			case ID_SPECTRUM_AVERAGE0:
+			case ID_SPECTRUM_AVERAGE1:
+			case ID_SPECTRUM_AVERAGE2:
+			case ID_SPECTRUM_PEAKHOLD:
+			case ID_SPECTRUM_SIZE0:
+			case ID_SPECTRUM_SIZE1:
+			case ID_SPECTRUM_SIZE2:
+				if (wmId >= ID_SPECTRUM_WINDOW0 && wmId <= ID_SPECTRUM_WINDOW2) {
+					spectrumSettings.window = (FftWindow)(wmId - ID_SPECTRUM_WINDOW0);
+					CheckMenuRadioItem(GetMenu(hWnd), ID_SPECTRUM_WINDOW0, ID_SPECTRUM_WINDOW2, wmId, MF_BYCOMMAND);
+				}
+				else if (wmId >= ID_SPECTRUM_AVERAGE0 && wmId <= ID_SPECTRUM_AVERAGE2) {
+					spectrumSettings.averaging = (SpectrumAveraging)(wmId - ID_SPECTRUM_AVERAGE0);
+					CheckMenuRadioItem(GetMenu(hWnd), ID_SPECTRUM_AVERAGE0, ID_SPECTRUM_AVERAGE2, wmId, MF_BYCOMMAND);
+				}
+				else if (wmId == ID_SPECTRUM_PEAKHOLD) {
+					spectrumSettings.peakHold = !spectrumSettings.peakHold;  // the held peaks start over either way
+					CheckMenuItem(GetMenu(hWnd), ID_SPECTRUM_PEAKHOLD, spectrumSettings.peakHold ? MF_CHECKED : MF_UNCHECKED);
+				}
+				else {
+					spectrumSettings.fftSize = fftSizes[wmId - ID_SPECTRUM_SIZE0];
+					CheckMenuRadioItem(GetMenu(hWnd), ID_SPECTRUM_SIZE0, ID_SPECTRUM_SIZE2, wmId, MF_BYCOMMAND);
+				}
+				// restart the analyzer with the new settings
+				StopSpectrum();
+				StartSpectrum();
+				tracesDirty = true;
+				break;
+			case ID_MEASURE_SHOW:
+				showMeasurements *= -1;
+				CheckMenuItem(GetMenu(hWnd), ID_MEASURE_SHOW, showMeasurements == 1 ? MF_CHECKED : MF_UNCHECKED);
+				break;
+			case ID_MEASURE_WINDOW0:
+			case ID_MEASURE_WINDOW1:
+			case ID_MEASURE_WINDOW2:
+				measureSeconds = measureWindows[wmId - ID_MEASURE_WINDOW0];
+				if (session.running()) {
+					// starts over on the samples that arrive from now on
+					measurements.configure(session.source()->numChannels(), historyRate(), channelScaling.data(), measureSeconds);
+				}
+				CheckMenuRadioItem(GetMenu(hWnd), ID_MEASURE_WINDOW0, ID_MEASURE_WINDOW2, wmId, MF_BYCOMMAND);
+				break;
+			case ID_DISPLAY_LAYOUT0:
+			case ID_DISPLAY_LAYOUT1:
+			case ID_DISPLAY_LAYOUT2:
+				traceLayout = wmId - ID_DISPLAY_LAYOUT0;
+				staticLayersDirty = true;  // the y axis labels or the strips
+				resetTraceLayer();
+				CheckMenuRadioItem(GetMenu(hWnd), ID_DISPLAY_LAYOUT0, ID_DISPLAY_LAYOUT2, wmId, MF_BYCOMMAND);
+				break;
+			case ID_DISPLAY_FPS0:
+			case ID_DISPLAY_FPS1:
+			case ID_DISPLAY_FPS2:
+			case ID_DISPLAY_FPS3:
+			case ID_DISPLAY_FPS4:
+				setFrameRate(hWnd, wmId - ID_DISPLAY_FPS0);
+				break;
+			case ID_DISPLAY_THREADS0:
+			case ID_DISPLAY_THREADS1:
+			case ID_DISPLAY_THREADS2:
+			case ID_DISPLAY_THREADS3:
+				setRenderThreads(hWnd, wmId - ID_DISPLAY_THREADS0);
+				break;
+			case ID_FILE_PAUSE:
+				pauseScreen *= -1;
+				if (pauseScreen == 1) {
+					CheckMenuItem(GetMenu(hWnd), ID_FILE_PAUSE, MF_CHECKED);
+				}
+				else if (pauseScreen == -1) {
+					CheckMenuItem(GetMenu(hWnd), ID_FILE_PAUSE, MF_UNCHECKED);
+				}
+				break;
+			case ID_FILE_SHOWSAMPLEVALUES:
+				showSampleValues *= -1;
+				if (showSampleValues == 1) {
+					CheckMenuItem(GetMenu(hWnd), ID_FILE_SHOWSAMPLEVALUES, MF_CHECKED);
+				}
+				else if (showSampleValues == -1) {
+					CheckMenuItem(GetMenu(hWnd), ID_FILE_SHOWSAMPLEVALUES, MF_UNCHECKED);
+				}
+				break;
+			case ID_FILE_SHOWGRID:
+				hideGrid *= -1;
+				staticLayersDirty = true;
+				if (hideGrid == 1) {
+					CheckMenuItem(GetMenu(hWnd), ID_FILE_SHOWGRID, MF_CHECKED);
+				}
+				else if (hideGrid == -1) {
+					CheckMenuItem(GetMenu(hWnd), ID_FILE_SHOWGRID, MF_UNCHECKED);
+				}		
+				break;
+			case ID_FILE_RECORD:
+				if (recorder.recording()) {
+					StopRecording();
+				}
+				else if (StartRecording(hWnd)) {
+					CheckMenuItem(GetMenu(hWnd), ID_FILE_RECORD, MF_CHECKED);
+				}
+				break;
+			case ID_FILE_OPENCAPTURE:
+				OpenCapture(hWnd);
+				break;
+			case ID_FILE_TELEMETRYLOG:
+				if (telemetry.logging()) {
+					StopTelemetryLog();
+				}
+				else if (StartTelemetryLog(hWnd)) {
+					CheckMenuItem(GetMenu(hWnd), ID_FILE_TELEMETRYLOG, MF_CHECKED);
+				}
+				break;
+			case ID_FILE_BROADCAST:
+				// other processes on this machine can follow the samples with a BroadcastReader
+				if (session.broadcasting()) {
+					session.stopBroadcast();
+					CheckMenuItem(GetMenu(hWnd), ID_FILE_BROADCAST, MF_UNCHECKED);
+				}
+				else if (!session.startBroadcast(BROADCAST_DEFAULT_NAME, BROADCAST_MEGABYTES)) {
+					MessageBoxA(0, session.errorString().c_str(), "Oscilloscope-NIDAQmx", MB_ICONERROR);
+				}
+				else {
+					CheckMenuItem(GetMenu(hWnd), ID_FILE_BROADCAST, MF_CHECKED);
+				}
+				break;
+			case ID_FILE_STREAM:
+				// viewers on other machines connect with a StreamClient (StreamViewer.exe) to this port
+				if (session.streaming()) {
+					session.stopStreaming();
+					CheckMenuItem(GetMenu(hWnd), ID_FILE_STREAM, MF_UNCHECKED);
+				}
+				else if (!session.startStreaming(STREAM_DEFAULT_PORT, false)) {
+					MessageBoxA(0, session.errorString().c_str(), "Oscilloscope-NIDAQmx", MB_ICONERROR);
+				}
+				else {
+					CheckMenuItem(GetMenu(hWnd), ID_FILE_STREAM, MF_CHECKED);
+				}
+				break;
+			case ID_DISPLAY_TELEMETRY:
+				showTelemetry *= -1;
+				CheckMenuItem(GetMenu(hWnd), ID_DISPLAY_TELEMETRY, showTelemetry == 1 ? MF_CHECKED : MF_UNCHECKED);
+				break;
+			case ID_PLAYBACK_REWIND:
+				SeekPlayback(0);
+				break;
+			case ID_PLAYBACK_SPEED0:
+			case ID_PLAYBACK_SPEED1:
+			case ID_PLAYBACK_SPEED2:
+			case ID_PLAYBACK_SPEED3:
+			case ID_PLAYBACK_SPEED4:
+			case ID_PLAYBACK_SPEED5:
+			case ID_PLAYBACK_SPEED6:
+				playbackSource.setSpeed(playbackSpeeds[wmId - ID_PLAYBACK_SPEED0]);
+				CheckMenuRadioItem(GetMenu(hWnd), ID_PLAYBACK_SPEED0, ID_PLAYBACK_SPEED6, wmId, MF_BYCOMMAND);
+				break;
+			case IDM_DAQ:
+				DialogBox(hInst, MAKEINTRESOURCE(IDD_CHOOSE_DAQ), hWnd, ChoseDAQ);
+				break;
+            case IDM_ABOUT:
+                DialogBox(hInst, MAKEINTRESOURCE(IDD_ABOUTBOX), hWnd, About);
+                break;
+            case IDM_EXIT:
+                DestroyWindow(hWnd);
+                break;
+            default:
+                return DefWindowProc(hWnd, message, wParam, lParam);
+            }
+        }
+        break;
+	case WM_KEYDOWN:
+		// trigger level (Up/Down) and where the trigger point sits in the sweep (Page Up/Down)
+		if (triggerMode != TRIGGER_FREE_RUN) {
+			switch (wParam) {
+			case VK_UP: triggerLevelVolts = triggerLevelVolts + TRIGGER_LEVEL_STEP_VOLTS > 10 ? 10 : triggerLevelVolts + TRIGGER_LEVEL_STEP_VOLTS; break;
+			case VK_DOWN: triggerLevelVolts = triggerLevelVolts - TRIGGER_LEVEL_STEP_VOLTS < -10 ? -10 : triggerLevelVolts - TRIGGER_LEVEL_STEP_VOLTS; break;
+			case VK_PRIOR: triggerPosition = triggerPosition - TRIGGER_POSITION_STEP < 0 ? 0 : triggerPosition - TRIGGER_POSITION_STEP; break;
+			case VK_NEXT: triggerPosition = triggerPosition + TRIGGER_POSITION_STEP > 1 ? 1 : triggerPosition + TRIGGER_POSITION_STEP; break;
+			}
+			if (wParam == VK_UP || wParam == VK_DOWN || wParam == VK_PRIOR || wParam == VK_NEXT) {
+				applyTrigger();
+				tracesDirty = true;  // the level marker moved
+			}
+		}
+		// playback seeking: Home rewinds, the arrow keys jump half a screen (history length) back or forward
+		if (session.playingBack()) {
+			int64_t step = (int64_t)(historySeconds * playbackSource.sampleRate() / 2);
+			switch (wParam) {
+			case VK_HOME: SeekPlayback(0); break;
+			case VK_LEFT: SeekPlayback((int64_t)playbackSource.position() - step); break;
+			case VK_RIGHT: SeekPlayback((int64_t)playbackSource.position() + step); break;
+			}
+		}
+		break;
+	case WM_ENTERSIZEMOVE:
+	case WM_ENTERMENULOOP:
+		// the message loop is suspended until the drag or menu ends, let the timer pace the frames meanwhile
+		SetTimer(hWnd, FRAME_TIMER_ID, (UINT)(frameScheduler.benchmark() ? USER_TIMER_MINIMUM : 1000 / frameScheduler.frameRate()), (TIMERPROC)NULL);
+		break;
+	case WM_EXITSIZEMOVE:
+	case WM_EXITMENULOOP:
+		SetTimer(hWnd, FRAME_TIMER_ID, KEEPALIVE_MILLISECONDS, (TIMERPROC)NULL);
+		break;
+	case WM_ERASEBKGND:                // APPENDED FLICKER FREE
+		return TRUE;
+	case WM_TIMER:
+
+		if (pauseScreen == 1) {
+			break;
+		}
+		else if (frameScheduler.due()) {
+			renderFrame(hWnd);
+		}
+		break;
+    case WM_PAINT:
+        {
+            PAINTSTRUCT ps;
+            HDC hdc = BeginPaint(hWnd, &ps);
+
+			// the last composed frame, for when part of the window was uncovered
+			if (hdcBack) {
+				RECT &r = ps.rcPaint;
+				BitBlt(hdc, r.left, r.top, r.right - r.left, r.bottom - r.top, hdcBack, r.left, r.top, SRCCOPY);
+			}
+
+			EndPaint(hWnd, &ps);
+        }
+        break;
+    case WM_DESTROY:
+		StopDAQ();
+		session.stopBroadcast();  // tells the readers it is gone
+		session.stopStreaming();
+		telemetry.closeLog();
+		KillTimer(hWnd, FRAME_TIMER_ID);
+		if (hdcBack) {
+			DeleteDC(hdcBack); hdcBack = NULL;
+		}
+
+		if (hdcBackGround) {
+			DeleteDC(hdcBackGround); hdcBackGround = NULL;
+		}
+
+		frame.release();
+		backgroundLayer.release();
+		if (screenMain) {
+			DeleteObject(screenMain); screenMain = NULL;
+		}
+		if (screenBackground) {
+			DeleteObject(screenBackground); screenBackground = NULL;
+		}
+		PostQuitMessage(0);
+        break;
+    default:
+        return DefWindowProc(hWnd, message, wParam, lParam);
+    }
+    return 0;
+}
+
+// Message handler for about box.
+INT_PTR CALLBACK About(HWND hDlg, UINT message, WPARAM wParam, LPARAM lParam)
+{
+    UNREFERENCED_PARAMETER(lParam);
+    switch (message)
+    {
+    case WM_INITDIALOG:
+        return (INT_PTR)TRUE;
+
+    case WM_COMMAND:
+        if (LOWORD(wParam) == IDOK || LOWORD(wParam) == IDCANCEL)
+        {
+            EndDialog(hDlg, LOWORD(wParam));
+            return (INT_PTR)TRUE;
+        }
+        break;
+    }
+    return (INT_PTR)FALSE;
+}
+
+INT_PTR CALLBACK ChoseDAQ(HWND hDlg, UINT message, WPARAM wParam, LPARAM lParam)
+{
+	UNREFERENCED_PARAMETER(lParam);
+
+	switch (message)
+	{
+	case WM_INITDIALOG:
+		for (int i = 1; i <= MAX_PLOT_PAIRS; i++) {
+			SendMessage(GetDlgItem(hDlg, IDC_COMBO_DAQ_CHANNELS), CB_ADDSTRING, 0, (LPARAM)to_string(i).c_str());
+		}
+		SendMessage(GetDlgItem(hDlg, IDC_COMBO_DAQ_CHANNELS), CB_SETCURSEL, numChannelsToPlot-1, NULL);
+
+		for (int i = 0; i < numInputCounts; i++) {
+			SendMessage(GetDlgItem(hDlg, IDC_COMBO_DAQ_INPUTS), CB_ADDSTRING, 0, (LPARAM)to_string(inputCounts[i]).c_str());
+			if (inputCounts[i] == inputsPerDevice) {
+				SendMessage(GetDlgItem(hDlg, IDC_COMBO_DAQ_INPUTS), CB_SETCURSEL, i, NULL);
+			}
+		}
+		for (int i = 0; i < numInputRanges; i++) {
+			char range[16];
+			sprintf_s(range, "%g", inputRanges[i]);
+			SendMessage(GetDlgItem(hDlg, IDC_COMBO_DAQ_RANGE), CB_ADDSTRING, 0, (LPARAM)range);
+			if (inputRanges[i] == inputRange) {
+				SendMessage(GetDlgItem(hDlg, IDC_COMBO_DAQ_RANGE), CB_SETCURSEL, i, NULL);
+			}
+		}
+		SetDlgItemTextA(hDlg, IDC_EDIT_DAQ_CHANNELS, channelList.c_str());
+		SetDlgItemTextA(hDlg, IDC_EDIT_DAQ_FILTERS, filterList.c_str());
+		for (int i = 0; i < numDecimations; i++) {
+			SendMessage(GetDlgItem(hDlg, IDC_COMBO_DAQ_DECIMATE), CB_ADDSTRING, 0, (LPARAM)to_string(decimations[i]).c_str());
+			if (decimations[i] == decimation) {
+				SendMessage(GetDlgItem(hDlg, IDC_COMBO_DAQ_DECIMATE), CB_SETCURSEL, i, NULL);
+			}
+		}
+
+		for (auto deviceName : daqDevices) {
+			SendMessage(GetDlgItem(hDlg, IDC_COMBO_DAQ_DEVICES), CB_ADDSTRING, 0, (LPARAM)deviceName.c_str());
+		}
+		SendMessage(GetDlgItem(hDlg, IDC_COMBO_DAQ_DEVICES), CB_SETCURSEL, daqDeviceIndexChosen, NULL);
+
+		for (int i = 0; i < 5; i++) {
+			SendMessage(GetDlgItem(hDlg, IDC_COMBO_DAQ_MODE), CB_ADDSTRING, 0, (LPARAM)terminalModes[i]);
+		}
+		SendMessage(GetDlgItem(hDlg, IDC_COMBO_DAQ_MODE), CB_SETCURSEL, terminalIndex, NULL);
+
+		for (int i = 0; i < numHistoryLengths; i++) {
+			SendMessage(GetDlgItem(hDlg, IDC_COMBO_DAQ_HISTORY), CB_ADDSTRING, 0, (LPARAM)to_string((long long)historyLengths[i]).c_str());
+			if (historyLengths[i] == historySeconds) {
+				SendMessage(GetDlgItem(hDlg, IDC_COMBO_DAQ_HISTORY), CB_SETCURSEL, i, NULL);
+			}
+		}
+
+		for (int i = 0; i < numSampleRates; i++) {
+			SendMessage(GetDlgItem(hDlg, IDC_COMBO_DAQ_RATE), CB_ADDSTRING, 0, (LPARAM)to_string((long long)sampleRates[i]).c_str());
+			if (sampleRates[i] == sampleRate) {
+				SendMessage(GetDlgItem(hDlg, IDC_COMBO_DAQ_RATE), CB_SETCURSEL, i, NULL);
+			}
+		}
+
+		return (INT_PTR)TRUE;
+
+	case WM_COMMAND:
+		switch (HIWORD(wParam))
+		{
+		case CBN_SELCHANGE:		// drop down control changed
+			daqDeviceIndexChosen = SendMessage(GetDlgItem(hDlg, IDC_COMBO_DAQ_DEVICES), CB_GETCURSEL, 0, 0);
+			numChannelsToPlot = SendMessage(GetDlgItem(hDlg, IDC_COMBO_DAQ_CHANNELS), CB_GETCURSEL, 0, 0) + 1;
+			terminalIndex = SendMessage(GetDlgItem(hDlg, IDC_COMBO_DAQ_MODE), CB_GETCURSEL, 0, 0);
+			{
+				int rateIndex = SendMessage(GetDlgItem(hDlg, IDC_COMBO_DAQ_RATE), CB_GETCURSEL, 0, 0);
+				if (rateIndex >= 0 && rateIndex < numSampleRates) sampleRate = sampleRates[rateIndex];
+				int historyIndex = SendMessage(GetDlgItem(hDlg, IDC_COMBO_DAQ_HISTORY), CB_GETCURSEL, 0, 0);
+				if (historyIndex >= 0 && historyIndex < numHistoryLengths) historySeconds = historyLengths[historyIndex];
+				int inputsIndex = SendMessage(GetDlgItem(hDlg, IDC_COMBO_DAQ_INPUTS), CB_GETCURSEL, 0, 0);
+				if (inputsIndex >= 0 && inputsIndex < numInputCounts) inputsPerDevice = inputCounts[inputsIndex];
+				int rangeIndex = SendMessage(GetDlgItem(hDlg, IDC_COMBO_DAQ_RANGE), CB_GETCURSEL, 0, 0);
+				if (rangeIndex >= 0 && rangeIndex < numInputRanges) inputRange = inputRanges[rangeIndex];
+				int decimateIndex = SendMessage(GetDlgItem(hDlg, IDC_COMBO_DAQ_DECIMATE), CB_GETCURSEL, 0, 0);
+				if (decimateIndex >= 0 && decimateIndex < numDecimations) decimation = decimations[decimateIndex];
+			}
+
+			switch (terminalIndex) {
+			case 0:terminalConfig = DAQmx_Val_Cfg_Default; break;
+			case 1:terminalConfig = DAQmx_Val_RSE; break;
+			case 2:terminalConfig = DAQmx_Val_NRSE; break;
+			case 3:terminalConfig = DAQmx_Val_Diff; break;
+			case 4:terminalConfig = DAQmx_Val_PseudoDiff; break;
+			default:terminalConfig = DAQmx_Val_Cfg_Default; break;
+
+			}
+		default:
+			break;
+		}
+
+		if (LOWORD(wParam) == IDOK || LOWORD(wParam) == IDCANCEL)
+		{
+			if (LOWORD(wParam) == IDOK) {
+				playbackFile.clear();  // a device was chosen, leave playback
+				char list[1024] = { "" };
+				GetDlgItemTextA(hDlg, IDC_EDIT_DAQ_CHANNELS, list, sizeof(list));
+				channelList = list;
+				char filters[1024] = { "" };
+				GetDlgItemTextA(hDlg, IDC_EDIT_DAQ_FILTERS, filters, sizeof(filters));
+				filterList = filters;
+			}
+			InitDAQ();
+			EndDialog(hDlg, LOWORD(wParam));
+			return (INT_PTR)TRUE;
+		}
+		break;
+	}
+	return (INT_PTR)FALSE;
+}
+
+void EnumerateDAQDevices(HWND hWnd) {
+
+	// this will query the nidaq driver to see what cards are detected; the simulated devices are always
+	// available, e.g. to try the scope without hardware
+	daqDevices = AcquisitionSession::deviceNames();
+
+	DialogBox(hInst, MAKEINTRESOURCE(IDD_CHOOSE_DAQ), hWnd, ChoseDAQ);
+}
\ No newline at end of file
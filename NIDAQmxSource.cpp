@@ -0,0 +1,228 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2023  Neuro Software Developers, Inc.
+//
+// Contact Information:
+//
+// Email:
+// info@neurosoftware.com
+//
+// Website:
+// www.neurosoftware.com
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "NIDAQmxSource.h"
+#include <sstream>
+#include <algorithm>
+#include <ctype.h>
+#include <stdio.h>
+
+using namespace std;
+
+#define ERROR_STRING_SIZE 2048
+
+NIDAQmxSource::NIDAQmxSource() : taskHandle(0), channels(0), rate(0) {
+}
+
+NIDAQmxSource::~NIDAQmxSource() {
+	stop();
+}
+
+bool NIDAQmxSource::failed(int32 status) {
+	if (status >= 0) return false;
+	error = errorString(status);
+	return true;
+}
+
+string NIDAQmxSource::errorString(int status) const {
+	char errorString[ERROR_STRING_SIZE];
+	DAQmxGetErrorString(status, errorString, ERROR_STRING_SIZE);
+	return errorString;
+}
+
+bool NIDAQmxSource::start(const AcquisitionConfig &config) {
+
+	stop();
+	error.clear();
+
+	/*********************************************/
+	// DAQmx Configure Code
+	/*********************************************/
+	if (failed(DAQmxCreateTask("", &taskHandle))) {
+		return false;
+	}
+
+	/* terminalConfig Options:
+	DAQmx_Val_Cfg_Default
+	DAQmx_Val_RSE
+	DAQmx_Val_NRSE
+	DAQmx_Val_Diff
+	DAQmx_Val_PseudoDiff
+	*/
+	int32 terminalConfig = config.terminalConfig;
+
+	int32 units = DAQmx_Val_Volts;
+
+	if (config.channels.empty() || config.devices.empty()) {
+		error = "No channels to acquire.";
+		stop();
+		return false;
+	}
+
+	/*
+	One task holds every channel, in frame order, even when they span several devices: DAQmx then runs a
+	multidevice task, starting all of them together off the first device's sample clock (devices in a PXI chassis
+	or cDAQ share it over the backplane, others need an RTSI cable registered in MAX). Consecutive inputs of one
+	device with the same range go in as one aiN:M run.
+	*/
+	const vector<ChannelConfig> &list = config.channels;
+	for (size_t first = 0; first < list.size();) {
+		size_t last = first;
+		while (last + 1 < list.size() && list[last + 1].device == list[first].device && list[last + 1].input == list[last].input + 1 &&
+			list[last + 1].minVoltage == list[first].minVoltage && list[last + 1].maxVoltage == list[first].maxVoltage) {
+			last++;
+		}
+		const ChannelConfig &channel = list[first];
+		char nameToAssignToChannel[255] = { "" };
+		snprintf(nameToAssignToChannel, sizeof(nameToAssignToChannel), "%s/ai%d:%d", config.devices[channel.device].c_str(), channel.input, list[last].input);
+
+		if (failed(DAQmxCreateAIVoltageChan(taskHandle, nameToAssignToChannel, "", terminalConfig, channel.minVoltage, channel.maxVoltage, units, NULL))) {
+			stop();
+			return false;
+		}
+		first = last + 1;
+	}
+	/* activeEdge Options:
+	DAQmx_Val_Rising // Acquire or generate samples on the rising edges of the Sample Clock.
+	DAQmx_Val_Falling // Acquire or generate samples on the falling edges of the Sample Clock.
+	*/
+	int32 activeEdge = DAQmx_Val_Rising;
+
+	/* sampleMode Options:
+	DAQmx_Val_FiniteSamps //Acquire or generate a finite number of samples.
+	DAQmx_Val_ContSamps // Acquire or generate samples until you stop the task.
+	DAQmx_Val_HWTimedSinglePoint //Acquire or generate samples continuously using hardware timing without a buffer. Hardware timed single point sample mode is supported only for the sample clock and change detection timing types. (http://zone.ni.com/reference/en-XX/help/370466AC-01/mxcncpts/hwtspsamplemode/)
+	*/
+//	int32 sampleMode = DAQmx_Val_HWTimedSinglePoint;
+	int32 sampleMode = DAQmx_Val_ContSamps;
+
+	/*
+	One of the most important parameters of an analog input or output system is the rate at which the measurement device samples an incoming signal or generates the output signal.
+	The sampling rate, which is called the scan rate in Traditional NI-DAQ (Legacy), is the speed at which a device acquires or generates a sample on each channel.
+	A fast input sampling rate acquires more points in a given time and can form a better representation of the original signal than a slow sampling rate.
+	Generating a 1 Hz signal using 1000 points per cycle at 1000 S/s produces a much finer representation than using 10 points per cycle at a sample rate of 10 S/s.
+	Sampling too slowly results in a poor representation of the analog signal. Undersampling causes the signal to appear as if it has a different frequency than it actually does.
+	This misrepresentation of a signal is called aliasing.
+	*/
+	float64 sampleRate = config.sampleRate; //The sampling rate in samples per second per channel. If you use an external source for the Sample Clock, set this value to the maximum expected rate of that clock.
+
+	/*
+	The number of samples to acquire or generate for each channel in the task if sampleMode is DAQmx_Val_FiniteSamps.
+	If sampleMode is DAQmx_Val_ContSamps, NIDAQmx uses this value to determine the buffer size.
+	Ask for a few seconds of driver buffer so a late wakeup of the reader thread doesn't overrun it.
+	*/
+	uInt64 sampsPerChanToAcquire = (uInt64)(sampleRate * 4);
+	if (sampsPerChanToAcquire < 4) sampsPerChanToAcquire = 4;
+
+	/* DAQmxCfgSampClkTiming
+	Sets the source of the Sample Clock, the rate of the Sample Clock, and the number of samples to acquire or generate.
+	*/
+	if (failed(DAQmxCfgSampClkTiming(taskHandle, "", sampleRate, activeEdge, sampleMode, sampsPerChanToAcquire))) {
+		stop();
+		return false;
+	}
+
+	/*
+	Samples are read as the raw 16 bit ADC codes (a quarter of the bandwidth of float64) and only converted to volts
+	where they are drawn or analysed, using the calibrated polynomial the device reports for each channel. Devices
+	with wider converters (24 bit DSA boards) would be truncated by DAQmxReadBinaryI16, so they are refused.
+	*/
+	scalings.resize(list.size());
+	for (size_t channel = 0; channel < list.size(); channel++) {
+		char physicalChannel[255] = { "" };
+		snprintf(physicalChannel, sizeof(physicalChannel), "%s/ai%d", config.devices[list[channel].device].c_str(), list[channel].input);
+
+		uInt32 rawBits = 0;
+		if (failed(DAQmxGetAIRawSampSize(taskHandle, physicalChannel, &rawBits))) {
+			stop();
+			return false;
+		}
+		if (rawBits > 16) {
+			ostringstream message;
+			message << physicalChannel << " returns " << rawBits << " bit samples; only devices with 16 bit or narrower raw samples can be read.";
+			stop();
+			error = message.str();
+			return false;
+		}
+
+		float64 coefficients[SCALING_COEFFICIENTS] = { 0 };
+		if (failed(DAQmxGetAIDevScalingCoeff(taskHandle, physicalChannel, coefficients, SCALING_COEFFICIENTS))) {
+			stop();
+			return false;
+		}
+		for (int i = 0; i < SCALING_COEFFICIENTS; i++) {
+			scalings[channel].coefficients[i] = coefficients[i];
+		}
+	}
+
+	/*********************************************/
+	// start the data acquisition
+	/*********************************************/
+	if (failed(DAQmxStartTask(taskHandle))) {
+		stop();
+		return false;
+	}
+
+	channels = config.numChannels();
+	rate = sampleRate;
+	return true;
+}
+
+int NIDAQmxSource::read(int16_t *frames, int framesPerChannel, double timeOut, int *framesRead) {
+	/*********************************************/
+	// DAQmx Read Code
+	/*********************************************/
+	uInt32 arraySizeInSamps = (uInt32)framesPerChannel * channels;
+
+	int32 sampsPerChanRead = 0;
+	int32 status = DAQmxReadBinaryI16(taskHandle, framesPerChannel, timeOut, DAQmx_Val_GroupByScanNumber, frames, arraySizeInSamps, &sampsPerChanRead, NULL);
+	if (status == DAQmxErrorTimeout) {
+		status = 0;  // nothing (or only part of a block) arrived yet because of a slow sample clock, not an error
+	}
+	if (sampsPerChanRead < 0) sampsPerChanRead = 0;
+
+	*framesRead = sampsPerChanRead;
+	return status < 0 ? status : 0;
+}
+
+int64_t NIDAQmxSource::available() {
+	uInt32 frames = 0;
+	if (taskHandle == 0 || DAQmxGetReadAvailSampPerChan(taskHandle, &frames) < 0) return -1;
+	return frames;
+}
+
+void NIDAQmxSource::stop() {
+	if (taskHandle == 0)
+		return;
+
+	DAQmxStopTask(taskHandle);
+	failed(DAQmxClearTask(taskHandle));
+	taskHandle = 0;
+}
+
+vector<string> NIDAQmxSource::deviceNames() {
+	char deviceNamesStr[ERROR_STRING_SIZE] = {"\0"};
+	DAQmxGetSystemInfoAttribute(DAQmx_Sys_DevNames, deviceNamesStr, ERROR_STRING_SIZE); // this will query the nidaq driver to see what cards are detected
+
+	string deviceNames = deviceNamesStr;
+	deviceNames.erase(remove_if(deviceNames.begin(), deviceNames.end(), [](char c) { return isspace((unsigned char)c) != 0; }), deviceNames.end());
+
+	vector<string> v;
+	stringstream src(deviceNames);
+	string buf;
+	while (getline(src, buf, ',')) {
+		if (!buf.empty()) v.push_back(buf);
+	}
+	return v;
+}
@@ -0,0 +1,48 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2023  Neuro Software Developers, Inc.
+//
+// Contact Information:
+//
+// Email:
+// info@neurosoftware.com
+//
+// Website:
+// www.neurosoftware.com
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <vector>
+#include "AcquisitionSource.h"
+#include "NIDAQmx.h"
+
+// AcquisitionSource backed by a continuous NIDAQmx analog input task
+class NIDAQmxSource : public AcquisitionSource {
+public:
+	NIDAQmxSource();
+	~NIDAQmxSource();
+
+	bool start(const AcquisitionConfig &config);
+	int read(int16_t *frames, int framesPerChannel, double timeOut, int *framesRead);
+	void stop();
+
+	int numChannels() const { return channels; }
+	double sampleRate() const { return rate; }
+	ChannelScaling scaling(int channel) const { return scalings[channel]; }
+	int64_t available();
+	bool overrun(int status) const { return status == DAQmxErrorSamplesNoLongerAvailable; }
+	std::string errorString(int status) const;
+
+	// names of the devices the NIDAQmx driver detects, e.g. "Dev1"
+	static std::vector<std::string> deviceNames();
+
+private:
+	bool failed(int32 status);
+
+	TaskHandle taskHandle;
+	int channels;
+	double rate;
+	std::vector<ChannelScaling> scalings;
+};
@@ -0,0 +1,148 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2023  Neuro Software Developers, Inc.
+//
+// Contact Information:
+//
+// Email:
+// info@neurosoftware.com
+//
+// Website:
+// www.neurosoftware.com
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "Phosphor.h"
+#include "SimdSupport.h"
+#include <math.h>
+
+#define FADED_OUT 0.5f			// below half a hit a pixel is dark, and cleared so the buffer settles to exact zeros
+#define MAX_SATURATION 16384.0f	// keeps sqrt(FADED_OUT) above the first color level
+
+Phosphor::Phosphor() : w(0), h(0), persistence(1.0f), saturation(64.0f), lit(false) {
+	setColor(pixelRGB(0, 255, 0));
+}
+
+void Phosphor::allocate(int width, int height) {
+	w = width > 0 ? width : 0;
+	h = height > 0 ? height : 0;
+	density.assign((size_t)w * h + 4, 0.0f);  // a little slack so the SIMD loops can run over the end
+	lit = false;
+}
+
+void Phosphor::setSaturation(float hits) {
+	if (hits < 1) hits = 1;
+	if (hits > MAX_SATURATION) hits = MAX_SATURATION;
+	saturation = hits;
+}
+
+void Phosphor::clear() {
+	for (size_t i = 0; i < density.size(); i++) density[i] = 0;
+	lit = false;
+}
+
+void Phosphor::setColor(Pixel color) {
+	float r = (float)((color >> 16) & 255), g = (float)((color >> 8) & 255), b = (float)(color & 255);
+	colorMap[0] = PIXEL_TRANSPARENT;
+	for (int i = 1; i < PHOSPHOR_LEVELS; i++) {
+		float t = (float)i / (PHOSPHOR_LEVELS - 1);
+		float rr, gg, bb;
+		if (t < 0.75f) {
+			// dim to full color
+			float k = 0.15f + 0.85f * t / 0.75f;
+			rr = r * k; gg = g * k; bb = b * k;
+		}
+		else {
+			// full color to white hot
+			float k = (t - 0.75f) / 0.25f;
+			rr = r + (255 - r) * k; gg = g + (255 - g) * k; bb = b + (255 - b) * k;
+		}
+		colorMap[i] = pixelRGB((int)rr, (int)gg, (int)bb);
+	}
+}
+
+void Phosphor::accumulate(const float *x, const float *y, size_t count, float minVolts, float maxVolts, int stride) {
+	if (w == 0 || h == 0 || count == 0) return;
+	if (stride < 1) stride = 1;
+	float hit = (float)stride;
+	float scaleX = w / (maxVolts - minVolts);
+	float scaleY = h / (maxVolts - minVolts);
+	float *d = density.data();
+	for (size_t i = 0; i < count; i += stride) {
+		int px = (int)((x[i] - minVolts) * scaleX);
+		int py = (int)((y[i] - minVolts) * scaleY);
+		if ((unsigned)px < (unsigned)w && (unsigned)py < (unsigned)h) {
+			d[(size_t)py * w + px] += hit;
+		}
+	}
+	lit = true;
+}
+
+void Phosphor::decay(double seconds) {
+	if (!lit || persistence <= 0) return;
+	float factor = (float)exp(-seconds / persistence);
+	float *d = density.data();
+	size_t n = (size_t)w * h;
+	size_t i = 0;
+	bool any = false;
+#ifdef SCOPE_SSE2
+	__m128 k = _mm_set1_ps(factor);
+	__m128 floor = _mm_set1_ps(FADED_OUT);
+	__m128 anyLit = _mm_setzero_ps();
+	for (; i + 4 <= n; i += 4) {
+		__m128 v = _mm_mul_ps(_mm_loadu_ps(d + i), k);
+		__m128 on = _mm_cmpge_ps(v, floor);
+		v = _mm_and_ps(v, on);  // flush what faded out to zero
+		anyLit = _mm_or_ps(anyLit, on);
+		_mm_storeu_ps(d + i, v);
+	}
+	any = _mm_movemask_ps(anyLit) != 0;
+#endif
+	for (; i < n; i++) {
+		float v = d[i] * factor;
+		if (v < FADED_OUT) v = 0;
+		else any = true;
+		d[i] = v;
+	}
+	lit = any;
+}
+
+// the color index goes with the square root of the hit count, so a trace seen once in a while and the
+// dense center of a Lissajous figure both stay visible. Lit pixels hold at least FADED_OUT, and with the
+// saturation capped that always maps past level 0, so only empty pixels come out transparent.
+void Phosphor::render(Raster &layer, int left, int top) const {
+	float k = (PHOSPHOR_LEVELS - 1) / sqrtf(saturation);
+	for (int y = 0; y < h; y++) {
+		int row = top + y;
+		if (row < layer.clipTop() || row >= layer.clipBottom()) continue;
+		const float *d = &density[(size_t)y * w];
+		Pixel *p = layer.row(row) + left;
+		int x0 = left < layer.clipLeft() ? layer.clipLeft() - left : 0;
+		int x1 = left + w > layer.clipRight() ? layer.clipRight() - left : w;
+		int x = x0;
+#ifdef SCOPE_SSE2
+		__m128 scale = _mm_set1_ps(k);
+		__m128 ceiling = _mm_set1_ps((float)(PHOSPHOR_LEVELS - 1));
+		for (; x + 4 <= x1; x += 4) {
+			__m128 v = _mm_loadu_ps(d + x);
+			if (_mm_movemask_ps(_mm_cmpgt_ps(v, _mm_setzero_ps())) == 0) {
+				_mm_storeu_si128((__m128i *)(p + x), _mm_setzero_si128());
+				continue;
+			}
+			__m128i level = _mm_cvttps_epi32(_mm_min_ps(_mm_mul_ps(_mm_sqrt_ps(v), scale), ceiling));
+			int levels[4];
+			_mm_storeu_si128((__m128i *)levels, level);
+			p[x] = colorMap[levels[0]];
+			p[x + 1] = colorMap[levels[1]];
+			p[x + 2] = colorMap[levels[2]];
+			p[x + 3] = colorMap[levels[3]];
+		}
+#endif
+		for (; x < x1; x++) {
+			float v = d[x];
+			int level = (int)(sqrtf(v) * k);
+			if (level > PHOSPHOR_LEVELS - 1) level = PHOSPHOR_LEVELS - 1;
+			p[x] = colorMap[level];
+		}
+	}
+}
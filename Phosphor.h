@@ -0,0 +1,59 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2023  Neuro Software Developers, Inc.
+//
+// Contact Information:
+//
+// Email:
+// info@neurosoftware.com
+//
+// Website:
+// www.neurosoftware.com
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <vector>
+#include <stddef.h>
+#include "Compositor.h"
+
+#define PHOSPHOR_LEVELS 256
+
+// Persistence display for the XY plot, like the phosphor of an analog scope: every (x, y) sample adds a hit
+// to its pixel of a density buffer, the whole buffer fades exponentially with time, and what is left is drawn
+// through a color map. The cost is O(new samples + pixels) per frame however long the visible history is.
+class Phosphor {
+public:
+	Phosphor();
+
+	// density buffer of width x height pixels, cleared
+	void allocate(int width, int height);
+	void clear();
+
+	// seconds for the glow to fall to 1/e, and the hit count (per pixel) that saturates the color map
+	void setPersistence(float seconds) { persistence = seconds; }
+	void setSaturation(float hits);
+	// ramp from a dim version of color through color to white
+	void setColor(Pixel color);
+
+	// adds one hit per pair; x and y in volts, minVolts..maxVolts across the buffer (y grows downwards). With a
+	// stride only every stride-th pair is taken, counting for stride hits so the brightness stays the same.
+	void accumulate(const float *x, const float *y, size_t count, float minVolts, float maxVolts, int stride = 1);
+	// fades everything by the time since the last call
+	void decay(double seconds);
+	// draws the density into rect of layer (same size as the buffer), leaving empty pixels transparent
+	void render(Raster &layer, int left, int top) const;
+
+	int width() const { return w; }
+	int height() const { return h; }
+	bool glowing() const { return lit; }	// false once everything faded out, there is nothing left to redraw
+
+private:
+	int w, h;
+	std::vector<float> density;
+	float persistence;
+	float saturation;
+	Pixel colorMap[PHOSPHOR_LEVELS];
+	bool lit;
+};
@@ -0,0 +1,211 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2023  Neuro Software Developers, Inc.
+//
+// Contact Information:
+//
+// Email:
+// info@neurosoftware.com
+//
+// Website:
+// www.neurosoftware.com
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "PlaybackSource.h"
+#include <string.h>
+
+using namespace std;
+
+#define PREFETCH_CHUNKS 4			// decoded chunks kept ahead of the reader thread
+#define MAX_CATCH_UP_SECONDS 1.0	// if the reader falls further behind the playback clock, restart the clock instead of bursting
+
+PlaybackSource::PlaybackSource() : channels(0), running(false), keepPrefetching(false), endOfCapture(false), readFailed(false),
+	startFrame(0), playSpeed(1.0), delivered(0), anchorSpeed(1.0), anchorFrame(0), anchorTicks(0), anchorDelivered(0) {
+}
+
+PlaybackSource::~PlaybackSource() {
+	stop();
+}
+
+bool PlaybackSource::open(const string &path) {
+	stop();
+	error.clear();
+	if (!reader.open(path)) {
+		error = reader.errorString();
+		return false;
+	}
+	startFrame = 0;
+	delivered = 0;
+	return true;
+}
+
+void PlaybackSource::close() {
+	stop();
+	reader.close();
+}
+
+string PlaybackSource::errorString(int status) const {
+	switch (status) {
+	case 0: return "";
+	case PLAYBACK_ERROR_FILE: return "Playback: " + error;
+	case PLAYBACK_ERROR_CONFIG: return "Playback: no capture is open.";
+	default: return "Playback: unknown error.";
+	}
+}
+
+ChannelScaling PlaybackSource::scaling(int channel) const {
+	return channel < reader.numChannels() ? reader.scaling(channel) : ChannelScaling();
+}
+
+bool PlaybackSource::start(const AcquisitionConfig &config) {
+	stop();
+	error.clear();
+	if (!reader.isOpen() || config.numChannels() < 1) {
+		error = errorString(PLAYBACK_ERROR_CONFIG);
+		return false;
+	}
+
+	channels = config.numChannels();
+	size_t chunkFrames = reader.header().chunkFrames > 0 ? reader.header().chunkFrames : 65536;
+	queue.allocate(channels, chunkFrames * PREFETCH_CHUNKS);
+	unsigned int cores = thread::hardware_concurrency();
+	int threads = cores > 2 ? (int)cores - 1 : 1;  // leave a core for the acquisition and UI threads
+	if (threads > PREFETCH_CHUNKS) threads = PREFETCH_CHUNKS;
+	if (decodePool.threads() != threads) decodePool.start(threads);
+
+	delivered = startFrame;
+	endOfCapture = false;
+	readFailed = false;
+	rebase(playSpeed);
+	running = true;
+
+	keepPrefetching = true;
+	prefetchThread = thread(&PlaybackSource::prefetch, this);
+	return true;
+}
+
+void PlaybackSource::stop() {
+	keepPrefetching = false;
+	if (prefetchThread.joinable()) {
+		prefetchThread.join();
+	}
+	if (running) {
+		startFrame = delivered;  // a later start() carries on where this one left off
+	}
+	running = false;
+}
+
+void PlaybackSource::seek(uint64_t frame) {
+	if (frame > reader.totalFrames()) frame = reader.totalFrames();
+	startFrame = frame;
+	delivered = frame;
+}
+
+void PlaybackSource::rebase(double speed) {
+	anchorSpeed = speed;
+	anchorFrame = delivered;
+	anchorTime = chrono::steady_clock::now();
+	anchorTicks = anchorTime.time_since_epoch().count();
+	anchorDelivered = anchorFrame;
+}
+
+double PlaybackSource::throughput() const {
+	chrono::steady_clock::time_point since = chrono::steady_clock::time_point(chrono::steady_clock::duration(anchorTicks));
+	double elapsed = chrono::duration<double>(chrono::steady_clock::now() - since).count();
+	return elapsed > 0 ? (delivered - anchorDelivered) / elapsed : 0;
+}
+
+// prefetch thread: decodes chunks from startFrame on into the queue, a pool's worth at a time, remapped to the output channel count
+void PlaybackSource::prefetch() {
+	vector<vector<int16_t> > chunks(decodePool.threads());
+	vector<int16_t> mapped;
+	int fileChannels = reader.numChannels();
+	int copyChannels = fileChannels < channels ? fileChannels : channels;
+
+	size_t i = reader.findChunk(startFrame);
+	uint64_t skip = i < reader.numChunks() ? startFrame - reader.chunk(i).firstFrame : 0;
+
+	while (i < reader.numChunks() && keepPrefetching) {
+		size_t count = reader.numChunks() - i < chunks.size() ? reader.numChunks() - i : chunks.size();
+		if (!reader.readChunks(i, count, chunks.data(), decodePool)) {
+			error = reader.errorString();
+			readFailed = true;
+			break;
+		}
+		i += count;
+
+		for (size_t c = 0; c < count && keepPrefetching; c++, skip = 0) {
+			size_t numFrames = chunks[c].size() / fileChannels - (size_t)skip;
+			const int16_t *frames = chunks[c].data() + skip * fileChannels;
+
+			if (fileChannels != channels) {
+				mapped.assign(numFrames * channels, 0);
+				for (size_t frame = 0; frame < numFrames; frame++) {
+					memcpy(&mapped[frame * channels], &frames[frame * fileChannels], copyChannels * sizeof(int16_t));
+				}
+				frames = mapped.data();
+			}
+
+			while (numFrames > 0 && keepPrefetching) {
+				size_t pushed = queue.push(frames, numFrames);
+				frames += pushed * channels;
+				numFrames -= pushed;
+				if (numFrames > 0) this_thread::sleep_for(chrono::milliseconds(1));
+			}
+		}
+	}
+	endOfCapture = true;
+}
+
+int PlaybackSource::read(int16_t *frames, int framesPerChannel, double timeOut, int *framesRead) {
+	*framesRead = 0;
+	if (!running) return PLAYBACK_ERROR_CONFIG;
+
+	chrono::steady_clock::time_point now = chrono::steady_clock::now();
+	chrono::steady_clock::time_point deadline = now + chrono::duration_cast<chrono::steady_clock::duration>(chrono::duration<double>(timeOut));
+	double speed = playSpeed;
+	if (speed != anchorSpeed) rebase(speed);
+
+	int numFrames = framesPerChannel;
+	if (speed > 0) {
+		// the playback clock runs at speed x the capture's sample rate from the anchor on
+		double framesPerSecond = reader.sampleRate() * speed;
+		double elapsed = chrono::duration<double>(now - anchorTime).count();
+		if (elapsed - (delivered - anchorFrame) / framesPerSecond > MAX_CATCH_UP_SECONDS) {
+			rebase(speed);
+			elapsed = 0;
+		}
+
+		double due = (delivered - anchorFrame + framesPerChannel) / framesPerSecond;
+		if (due <= elapsed + timeOut) {
+			this_thread::sleep_until(anchorTime + chrono::duration_cast<chrono::steady_clock::duration>(chrono::duration<double>(due)));
+		}
+		else {
+			// time out with whatever the clock released by the deadline
+			this_thread::sleep_until(deadline);
+			numFrames = (int)((int64_t)((elapsed + timeOut) * framesPerSecond) - (int64_t)(delivered - anchorFrame));
+			if (numFrames < 0) numFrames = 0;
+			if (numFrames > framesPerChannel) numFrames = framesPerChannel;
+		}
+	}
+
+	// normally the prefetch is far ahead; if the disk can't keep up, wait for it until the deadline
+	size_t got = queue.pop(frames, numFrames);
+	while ((int)got < numFrames && !endOfCapture && chrono::steady_clock::now() < deadline) {
+		this_thread::sleep_for(chrono::milliseconds(1));
+		got += queue.pop(frames + got * channels, numFrames - got);
+	}
+	if ((int)got < numFrames && endOfCapture) {
+		got += queue.pop(frames + got * channels, numFrames - got);
+	}
+
+	delivered += got;
+	*framesRead = (int)got;
+
+	if (got == 0 && readFailed) return PLAYBACK_ERROR_FILE;
+	if (got == 0 && endOfCapture) {
+		this_thread::sleep_until(deadline);  // nothing left to play, don't spin the reader thread
+	}
+	return 0;
+}
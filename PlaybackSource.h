@@ -0,0 +1,92 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2023  Neuro Software Developers, Inc.
+//
+// Contact Information:
+//
+// Email:
+// info@neurosoftware.com
+//
+// Website:
+// www.neurosoftware.com
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <vector>
+#include "AcquisitionSource.h"
+#include "CaptureReader.h"
+#include "SampleRing.h"
+#include "WorkerPool.h"
+
+#define PLAYBACK_ERROR_FILE (-1)		// the capture could not be read (see lastError())
+#define PLAYBACK_ERROR_CONFIG (-2)
+#define PLAYBACK_AS_FAST_AS_POSSIBLE 0.0	// setSpeed() value that drops the pacing
+
+// Replays a capture file as if it were a device, so everything downstream of the AcquisitionEngine
+// (history, trace, XY plot, recorder) can't tell it from live data. A prefetch thread reads and decodes
+// whole chunks ahead of the reader thread, several at a time on a worker pool for compressed captures, so
+// neither disk latency nor decoding shows up in read(); read() paces the frames to the capture's sample clock
+// times the playback speed.
+class PlaybackSource : public AcquisitionSource {
+public:
+	PlaybackSource();
+	~PlaybackSource();
+
+	// call while stopped; the capture's own rate and scaling replace the ones in AcquisitionConfig
+	bool open(const std::string &path);
+	void close();
+	bool isOpen() const { return reader.isOpen(); }
+	const CaptureHeader &capture() const { return reader.header(); }
+
+	// delivers config.numChannels() channels: extra channels in the file are skipped, missing ones read 0 V
+	bool start(const AcquisitionConfig &config);
+	int read(int16_t *frames, int framesPerChannel, double timeOut, int *framesRead);
+	void stop();
+
+	int numChannels() const { return channels; }
+	double sampleRate() const { return reader.sampleRate(); }
+	ChannelScaling scaling(int channel) const;
+	std::string errorString(int status) const;
+
+	// any thread, takes effect on the next read(); PLAYBACK_AS_FAST_AS_POSSIBLE doubles as a pipeline benchmark
+	void setSpeed(double speed) { playSpeed = speed; }
+	double speed() const { return playSpeed; }
+
+	// call while stopped, the next start() resumes from frame; the index makes this a binary search
+	void seek(uint64_t frame);
+	uint64_t position() const { return delivered; }	// next frame read() hands out
+	uint64_t totalFrames() const { return reader.totalFrames(); }
+	bool finished() const { return endOfCapture && queue.readable() == 0; }
+
+	// frames per second read() delivered since start (or the last speed change)
+	double throughput() const;
+
+private:
+	void prefetch();
+	void rebase(double speed);
+
+	CaptureReader reader;
+	int channels;
+	bool running;
+
+	SampleRing<int16_t> queue;		// decoded frames in the output channel layout, filled by prefetchThread
+	std::thread prefetchThread;
+	WorkerPool decodePool;			// prefetchThread's helpers
+	std::atomic<bool> keepPrefetching;
+	std::atomic<bool> endOfCapture;
+	std::atomic<bool> readFailed;
+	uint64_t startFrame;
+
+	std::atomic<double> playSpeed;
+	std::atomic<uint64_t> delivered;
+	double anchorSpeed;				// pacing is relative to the last speed change
+	uint64_t anchorFrame;
+	std::chrono::steady_clock::time_point anchorTime;
+	std::atomic<int64_t> anchorTicks;	// anchorTime for throughput(), which runs on another thread
+	std::atomic<uint64_t> anchorDelivered;
+};
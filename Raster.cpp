@@ -0,0 +1,354 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2023  Neuro Software Developers, Inc.
+//
+// Contact Information:
+//
+// Email:
+// info@neurosoftware.com
+//
+// Website:
+// www.neurosoftware.com
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "Raster.h"
+#include "SimdSupport.h"
+#include <stdlib.h>
+#include <string.h>
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+
+#define SPAN_BLOCK 64	// columns per block when columnSpans decides between column and row order
+
+static void *allocateRows(size_t bytes) {
+#ifdef _WIN32
+	return _aligned_malloc(bytes, 16);
+#else
+	void *p = NULL;
+	return posix_memalign(&p, 16, bytes) == 0 ? p : NULL;
+#endif
+}
+
+static void freeRows(void *p) {
+#ifdef _WIN32
+	_aligned_free(p);
+#else
+	free(p);
+#endif
+}
+
+void fillPixels(Pixel *p, size_t count, Pixel color) {
+	size_t i = 0;
+#ifdef SCOPE_SSE2
+	if (count >= 8) {
+		__m128i c = _mm_set1_epi32((int)color);
+		// one unaligned store to reach a 16 byte boundary, then aligned stores
+		_mm_storeu_si128((__m128i *)p, c);
+		i = (16 - ((uintptr_t)p & 15)) / sizeof(Pixel) & 3;
+		for (; i + 8 <= count; i += 8) {
+			_mm_store_si128((__m128i *)(p + i), c);
+			_mm_store_si128((__m128i *)(p + i + 4), c);
+		}
+		if (i + 4 <= count) {
+			_mm_store_si128((__m128i *)(p + i), c);
+			i += 4;
+		}
+	}
+#endif
+	for (; i < count; i++) {
+		p[i] = color;
+	}
+}
+
+Raster::Raster() : data(NULL), owned(false), w(0), h(0), pitch(0), clipX0(0), clipY0(0), clipX1(0), clipY1(0) {
+}
+
+Raster::~Raster() {
+	release();
+}
+
+bool Raster::allocate(int width, int height) {
+	release();
+	if (width < 1 || height < 1) return false;
+	int rowPixels = (width + 3) & ~3;  // whole 16 byte rows
+	data = (Pixel *)allocateRows((size_t)rowPixels * height * sizeof(Pixel));
+	if (data == NULL) return false;
+	memset(data, 0, (size_t)rowPixels * height * sizeof(Pixel));
+	owned = true;
+	w = width;
+	h = height;
+	pitch = rowPixels;
+	resetClip();
+	return true;
+}
+
+void Raster::attach(Pixel *pixels, int width, int height, int stridePixels) {
+	release();
+	data = pixels;
+	w = width;
+	h = height;
+	pitch = stridePixels;
+	resetClip();
+}
+
+void Raster::release() {
+	if (owned) freeRows(data);
+	data = NULL;
+	owned = false;
+	w = h = pitch = 0;
+	clipX0 = clipY0 = clipX1 = clipY1 = 0;
+}
+
+void Raster::setClip(int left, int top, int right, int bottom) {
+	clipX0 = left < 0 ? 0 : left;
+	clipY0 = top < 0 ? 0 : top;
+	clipX1 = right > w ? w : right;
+	clipY1 = bottom > h ? h : bottom;
+	if (clipX1 < clipX0) clipX1 = clipX0;
+	if (clipY1 < clipY0) clipY1 = clipY0;
+}
+
+bool Raster::clipRect(int &left, int &top, int &right, int &bottom) const {
+	if (left < clipX0) left = clipX0;
+	if (top < clipY0) top = clipY0;
+	if (right > clipX1) right = clipX1;
+	if (bottom > clipY1) bottom = clipY1;
+	return left < right && top < bottom;
+}
+
+void Raster::fillRect(int left, int top, int right, int bottom, Pixel color) {
+	if (!clipRect(left, top, right, bottom)) return;
+	for (int y = top; y < bottom; y++) {
+		fillPixels(row(y) + left, right - left, color);
+	}
+}
+
+void Raster::rect(int left, int top, int right, int bottom, Pixel color) {
+	hline(left, right - 1, top, color);
+	hline(left, right - 1, bottom - 1, color);
+	vline(left, top, bottom - 1, color);
+	vline(right - 1, top, bottom - 1, color);
+}
+
+void Raster::hline(int x0, int x1, int y, Pixel color) {
+	if (x1 < x0) { int t = x0; x0 = x1; x1 = t; }
+	if (y < clipY0 || y >= clipY1) return;
+	if (x0 < clipX0) x0 = clipX0;
+	if (x1 >= clipX1) x1 = clipX1 - 1;
+	if (x0 > x1) return;
+	fillPixels(row(y) + x0, x1 - x0 + 1, color);
+}
+
+void Raster::vline(int x, int y0, int y1, Pixel color) {
+	if (y1 < y0) { int t = y0; y0 = y1; y1 = t; }
+	if (x < clipX0 || x >= clipX1) return;
+	if (y0 < clipY0) y0 = clipY0;
+	if (y1 >= clipY1) y1 = clipY1 - 1;
+	Pixel *p = row(y0) + x;
+	for (int y = y0; y <= y1; y++, p += pitch) {
+		*p = color;
+	}
+}
+
+void Raster::hlinePattern(int x0, int x1, int y, Pixel color, int on, int off) {
+	if (x1 < x0) { int t = x0; x0 = x1; x1 = t; }
+	int period = on + off;
+	if (period <= 0) return;
+	// the pattern is anchored at x0 so it doesn't crawl when the clip changes
+	for (int x = x0; x <= x1; x += period) {
+		hline(x, x + on - 1 < x1 ? x + on - 1 : x1, y, color);
+	}
+}
+
+// Cohen-Sutherland against the clip rectangle, then Bresenham over what is left
+void Raster::line(int x0, int y0, int x1, int y1, Pixel color) {
+	if (y0 == y1) { hline(x0, x1, y0, color); return; }
+	if (x0 == x1) { vline(x0, y0, y1, color); return; }
+	if (clipX1 <= clipX0 || clipY1 <= clipY0) return;
+
+	double ax = x0, ay = y0, bx = x1, by = y1;
+	double left = clipX0, top = clipY0, right = clipX1 - 1, bottom = clipY1 - 1;
+	for (;;) {
+		int codeA = (ax < left) | ((ax > right) << 1) | ((ay < top) << 2) | ((ay > bottom) << 3);
+		int codeB = (bx < left) | ((bx > right) << 1) | ((by < top) << 2) | ((by > bottom) << 3);
+		if ((codeA | codeB) == 0) break;
+		if (codeA & codeB) return;
+		int code = codeA ? codeA : codeB;
+		double x, y;
+		if (code & 8) { x = ax + (bx - ax) * (bottom - ay) / (by - ay); y = bottom; }
+		else if (code & 4) { x = ax + (bx - ax) * (top - ay) / (by - ay); y = top; }
+		else if (code & 2) { y = ay + (by - ay) * (right - ax) / (bx - ax); x = right; }
+		else { y = ay + (by - ay) * (left - ax) / (bx - ax); x = left; }
+		if (code == codeA) { ax = x; ay = y; }
+		else { bx = x; by = y; }
+	}
+	x0 = (int)(ax + 0.5); y0 = (int)(ay + 0.5);
+	x1 = (int)(bx + 0.5); y1 = (int)(by + 0.5);
+
+	int dx = x1 > x0 ? x1 - x0 : x0 - x1;
+	int dy = y1 > y0 ? y0 - y1 : y1 - y0;  // negative
+	int stepX = x0 < x1 ? 1 : -1;
+	ptrdiff_t stepY = y0 < y1 ? pitch : -pitch;
+	int error = dx + dy;
+	int n = (dx > -dy ? dx : -dy) + 1;  // Bresenham sets one pixel per step along the major axis
+	Pixel *p = row(y0) + x0;
+	for (int i = 0; i < n; i++) {
+		*p = color;
+		int e2 = 2 * error;
+		if (e2 >= dy) { error += dy; p += stepX; }
+		if (e2 <= dx) { error += dx; p += stepY; }
+	}
+}
+
+void Raster::polyline(const int *x, const int *y, size_t count, Pixel color) {
+	if (count == 1) plot(x[0], y[0], color);
+	for (size_t i = 1; i < count; i++) {
+		// a trace is mostly steps between neighbouring columns, which come out as a vertical span plus a pixel
+		if (x[i] == x[i - 1] + 1 || x[i] == x[i - 1]) {
+			vline(x[i], y[i - 1], y[i], color);
+		}
+		else {
+			line(x[i - 1], y[i - 1], x[i], y[i], color);
+		}
+	}
+}
+
+void Raster::dots(const int *x, const int *y, size_t count, Pixel color) {
+	for (size_t i = 0; i < count; i++) {
+		plot(x[i], y[i], color);
+	}
+}
+
+// midpoint circle
+void Raster::circle(int cx, int cy, int radius, Pixel color) {
+	int x = radius, y = 0, error = 1 - radius;
+	while (x >= y) {
+		plot(cx + x, cy + y, color); plot(cx - x, cy + y, color);
+		plot(cx + x, cy - y, color); plot(cx - x, cy - y, color);
+		plot(cx + y, cy + x, color); plot(cx - y, cy + x, color);
+		plot(cx + y, cy - x, color); plot(cx - y, cy - x, color);
+		y++;
+		if (error < 0) {
+			error += 2 * y + 1;
+		}
+		else {
+			x--;
+			error += 2 * (y - x) + 1;
+		}
+	}
+}
+
+// Spans are drawn one block of columns at a time. Short spans (a slow trace) go column by column; when the
+// spans of a block cover much of its height (a dense, noisy envelope) it is cheaper to walk the rows and set
+// four columns per SSE2 store, selecting the pixels inside their span with compares instead of branches.
+void Raster::columnSpans(int x0, const int *top, const int *bottom, size_t count, Pixel color) {
+	for (size_t block = 0; block < count; block += SPAN_BLOCK) {
+		size_t n = count - block < SPAN_BLOCK ? count - block : SPAN_BLOCK;
+		int firstX = x0 + (int)block;
+
+		// clip the block's columns and spans, and measure them
+		int spanTop[SPAN_BLOCK], spanBottom[SPAN_BLOCK];
+		int blockTop = clipY1, blockBottom = clipY0 - 1;
+		size_t spanPixels = 0;
+		for (size_t i = 0; i < n; i++) {
+			int x = firstX + (int)i;
+			int t = top[block + i], b = bottom[block + i];
+			if (t > b) { int swap = t; t = b; b = swap; }
+			if (t < clipY0) t = clipY0;
+			if (b >= clipY1) b = clipY1 - 1;
+			if (x < clipX0 || x >= clipX1 || t > b) { t = clipY1; b = clipY0 - 1; }  // nothing to draw
+			spanTop[i] = t;
+			spanBottom[i] = b;
+			if (t <= b) {
+				spanPixels += b - t + 1;
+				if (t < blockTop) blockTop = t;
+				if (b > blockBottom) blockBottom = b;
+			}
+		}
+		if (blockTop > blockBottom) continue;
+
+#ifdef SCOPE_SSE2
+		size_t rowPixels = (size_t)(blockBottom - blockTop + 1) * ((n + 3) & ~(size_t)3);
+		int columnLeft = firstX < clipX0 ? clipX0 - firstX : 0;
+		int columnRight = firstX + (int)n > clipX1 ? clipX1 - firstX : (int)n;
+		if (spanPixels * 4 > rowPixels && columnRight - columnLeft >= 4) {
+			__m128i c = _mm_set1_epi32((int)color);
+			int i;
+			for (int y = blockTop; y <= blockBottom; y++) {
+				Pixel *p = row(y) + firstX;
+				__m128i yy = _mm_set1_epi32(y);
+				for (i = columnLeft; i + 4 <= columnRight; i += 4) {
+					__m128i t = _mm_loadu_si128((const __m128i *)(spanTop + i));
+					__m128i b = _mm_loadu_si128((const __m128i *)(spanBottom + i));
+					// inside = t <= y && y <= b
+					__m128i inside = _mm_andnot_si128(_mm_or_si128(_mm_cmpgt_epi32(t, yy), _mm_cmpgt_epi32(yy, b)), _mm_set1_epi32(-1));
+					__m128i old = _mm_loadu_si128((const __m128i *)(p + i));
+					_mm_storeu_si128((__m128i *)(p + i), _mm_or_si128(_mm_and_si128(inside, c), _mm_andnot_si128(inside, old)));
+				}
+				for (; i < columnRight; i++) {
+					if (spanTop[i] <= y && y <= spanBottom[i]) p[i] = color;
+				}
+			}
+			continue;
+		}
+#endif
+		for (size_t i = 0; i < n; i++) {
+			if (spanTop[i] > spanBottom[i]) continue;
+			Pixel *p = row(spanTop[i]) + firstX + i;
+			for (int y = spanTop[i]; y <= spanBottom[i]; y++, p += pitch) {
+				*p = color;
+			}
+		}
+	}
+}
+
+void Raster::scrollLeft(int left, int top, int right, int bottom, int columns) {
+	if (columns <= 0 || !clipRect(left, top, right, bottom)) return;
+	int keep = right - left - columns;
+	for (int y = top; y < bottom; y++) {
+		Pixel *p = row(y) + left;
+		if (keep > 0) {
+			memmove(p, p + columns, (size_t)keep * sizeof(Pixel));
+			fillPixels(p + keep, columns, PIXEL_TRANSPARENT);
+		}
+		else {
+			fillPixels(p, right - left, PIXEL_TRANSPARENT);
+		}
+	}
+}
+
+void Raster::copy(const Raster &src, int left, int top, int right, int bottom) {
+	if (!clipRect(left, top, right, bottom)) return;
+	if (right > src.w) right = src.w;
+	if (bottom > src.h) bottom = src.h;
+	for (int y = top; y < bottom; y++) {
+		memcpy(row(y) + left, src.row(y) + left, (size_t)(right - left) * sizeof(Pixel));
+	}
+}
+
+void Raster::composite(const Raster &src, int left, int top, int right, int bottom) {
+	if (!clipRect(left, top, right, bottom)) return;
+	if (right > src.w) right = src.w;
+	if (bottom > src.h) bottom = src.h;
+	for (int y = top; y < bottom; y++) {
+		const Pixel *s = src.row(y);
+		Pixel *d = row(y);
+		int x = left;
+		// any nonzero alpha counts as drawn, in both paths
+#ifdef SCOPE_SSE2
+		__m128i alpha = _mm_set1_epi32((int)0xFF000000u), zero = _mm_setzero_si128();
+		for (; x + 4 <= right; x += 4) {
+			__m128i over = _mm_loadu_si128((const __m128i *)(s + x));
+			__m128i clear = _mm_cmpeq_epi32(_mm_and_si128(over, alpha), zero);  // alpha 0 -> all ones
+			if (_mm_movemask_epi8(clear) == 0xFFFF) continue;
+			__m128i under = _mm_loadu_si128((const __m128i *)(d + x));
+			_mm_storeu_si128((__m128i *)(d + x), _mm_or_si128(_mm_andnot_si128(clear, over), _mm_and_si128(clear, under)));
+		}
+#endif
+		for (; x < right; x++) {
+			if (s[x] & 0xFF000000u) d[x] = s[x];
+		}
+	}
+}
@@ -0,0 +1,94 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2023  Neuro Software Developers, Inc.
+//
+// Contact Information:
+//
+// Email:
+// info@neurosoftware.com
+//
+// Website:
+// www.neurosoftware.com
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+// 0xAARRGGBB, the memory layout of a 32 bpp top-down DIB. Drawn pixels are opaque (alpha 0xFF); a cleared
+// pixel (0) is transparent, which is what lets layers be composited over each other.
+typedef uint32_t Pixel;
+
+#define PIXEL_TRANSPARENT 0u
+
+inline Pixel pixelRGB(int r, int g, int b) {
+	return 0xFF000000u | ((Pixel)r << 16) | ((Pixel)g << 8) | (Pixel)b;
+}
+
+// Software rasterizer over a 32 bit pixel buffer, either its own or one it is attached to (a DIB section).
+// Everything is clipped to the clip rectangle, so several threads can draw disjoint tiles of one buffer.
+// Coordinates are pixel indices; spans and lines include both end points.
+class Raster {
+public:
+	Raster();
+	~Raster();
+
+	bool allocate(int width, int height);  // owned, 16 byte aligned rows, cleared to transparent
+	void attach(Pixel *pixels, int width, int height, int stridePixels);
+	void release();
+
+	int width() const { return w; }
+	int height() const { return h; }
+	int stride() const { return pitch; }
+	Pixel *pixels() const { return data; }
+	Pixel *row(int y) const { return data + (ptrdiff_t)y * pitch; }
+
+	// right and bottom are exclusive; the clip is always kept inside the buffer
+	void setClip(int left, int top, int right, int bottom);
+	void resetClip() { setClip(0, 0, w, h); }
+	int clipLeft() const { return clipX0; }
+	int clipTop() const { return clipY0; }
+	int clipRight() const { return clipX1; }
+	int clipBottom() const { return clipY1; }
+
+	void fill(Pixel color) { fillRect(clipX0, clipY0, clipX1, clipY1, color); }
+	void fillRect(int left, int top, int right, int bottom, Pixel color);	// right and bottom exclusive
+	void rect(int left, int top, int right, int bottom, Pixel color);		// outline, right and bottom exclusive
+
+	void plot(int x, int y, Pixel color) {
+		if (x >= clipX0 && x < clipX1 && y >= clipY0 && y < clipY1) data[(ptrdiff_t)y * pitch + x] = color;
+	}
+	void hline(int x0, int x1, int y, Pixel color);
+	void vline(int x, int y0, int y1, Pixel color);
+	void hlinePattern(int x0, int x1, int y, Pixel color, int on, int off);	// dashes of on pixels every on + off
+	void line(int x0, int y0, int x1, int y1, Pixel color);
+	void polyline(const int *x, const int *y, size_t count, Pixel color);
+	void dots(const int *x, const int *y, size_t count, Pixel color);
+	void circle(int cx, int cy, int radius, Pixel color);	// outline
+
+	// one vertical span [top[i], bottom[i]] in column x0 + i for every i: the peak-detect envelope of a trace
+	void columnSpans(int x0, const int *top, const int *bottom, size_t count, Pixel color);
+
+	// moves the rectangle's pixels left by columns, clearing (to transparent) what scrolls in at the right
+	void scrollLeft(int left, int top, int right, int bottom, int columns);
+
+	// copies (or composites, keeping our pixel wherever the source is transparent) the same rectangle of src
+	void copy(const Raster &src, int left, int top, int right, int bottom);
+	void composite(const Raster &src, int left, int top, int right, int bottom);
+
+private:
+	Raster(const Raster &);
+	Raster &operator=(const Raster &);
+
+	bool clipRect(int &left, int &top, int &right, int &bottom) const;
+
+	Pixel *data;
+	bool owned;
+	int w, h, pitch;
+	int clipX0, clipY0, clipX1, clipY1;
+};
+
+// fills count pixels starting at p, vectorized
+void fillPixels(Pixel *p, size_t count, Pixel color);
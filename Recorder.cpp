@@ -0,0 +1,341 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2023  Neuro Software Developers, Inc.
+//
+// Contact Information:
+//
+// Email:
+// info@neurosoftware.com
+//
+// Website:
+// www.neurosoftware.com
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "Recorder.h"
+#include "SampleCodec.h"
+#include <string.h>
+#include <time.h>
+
+using namespace std;
+
+#define CHUNK_TARGET_BYTES (1 << 20)	// payload per chunk, large enough that every write is a big sequential one
+#define WRITER_IDLE_MILLISECONDS 5
+#define MAX_PACK_THREADS 4				// packing runs at a few hundred MB/s a core, more only takes cores from the display
+
+struct Recorder::Slot {
+	char *buffer;				// aligned, holds one chunk header + payload + padding
+	vector<int16_t> frames;		// the frames to pack, when compressing
+	size_t numFrames;
+	uint32_t encoding;
+	uint32_t payloadBytes;
+};
+
+// packs every slot's frames into its chunk buffer, each on whichever pool thread takes it
+class Recorder::PackTask : public ParallelTask {
+public:
+	PackTask(vector<Slot *> &chunks, int numChannels) : slots(chunks), channels(numChannels) {}
+
+	void run(int item, int) {
+		Slot &slot = *slots[item];
+		uint8_t *payload = (uint8_t *)slot.buffer + sizeof(CaptureChunkHeader);
+		size_t rawBytes = slot.numFrames * channels * sizeof(int16_t);
+		size_t packedBytes = packFrames(slot.frames.data(), slot.numFrames, channels, payload);
+		if (packedBytes < rawBytes) {
+			slot.encoding = CAPTURE_ENCODING_PACKED;
+			slot.payloadBytes = (uint32_t)packedBytes;
+		}
+		else {
+			// noise that doesn't pack, keep it as it is
+			memcpy(payload, slot.frames.data(), rawBytes);
+			slot.encoding = CAPTURE_ENCODING_RAW;
+			slot.payloadBytes = (uint32_t)rawBytes;
+		}
+	}
+
+private:
+	vector<Slot *> &slots;
+	int channels;
+};
+
+Recorder::Recorder() : channels(0), chunkFrames(0), chunkBufferBytes(0), fileOffset(0), compress(true),
+	keepRunning(false), failed(false), framesWritten(0), bytesWritten(0), packNanoseconds(0), dropped(0), writeNanoseconds(0),
+	peakQueued(0), rateBytes(0), recentRate(0) {
+	memset(&header, 0, sizeof(header));
+}
+
+Recorder::~Recorder() {
+	stop();
+}
+
+bool Recorder::start(const string &path, const CaptureInfo &info, double queueSeconds) {
+	stop();
+	error.clear();
+
+	channels = info.numChannels;
+	if (channels < 1 || info.sampleRate <= 0) {
+		error = "Nothing to record, acquisition is not running.";
+		return false;
+	}
+
+	if (!file.create(path, true)) {
+		error = file.errorString();
+		return false;
+	}
+	filePath = path;
+
+	// header block: CaptureHeader followed by the per channel scaling table
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, CAPTURE_MAGIC, sizeof(CAPTURE_MAGIC));
+	header.version = CAPTURE_VERSION;
+	header.headerBytes = (uint32_t)alignCapture(sizeof(CaptureHeader) + channels * sizeof(CaptureChannel));
+	snprintf(header.device, sizeof(header.device), "%s", info.device.c_str());
+	snprintf(header.terminalConfigName, sizeof(header.terminalConfigName), "%s", info.terminalConfigName.c_str());
+	header.terminalConfig = info.terminalConfig;
+	header.numChannels = channels;
+	header.sampleRate = info.sampleRate;
+	header.minVoltage = info.minVoltage;
+	header.maxVoltage = info.maxVoltage;
+	header.startTime = (int64_t)time(NULL);
+
+	chunkFrames = CHUNK_TARGET_BYTES / (channels * sizeof(int16_t));
+	if (chunkFrames < 1) chunkFrames = 1;
+	header.chunkFrames = (uint32_t)chunkFrames;
+
+	headerBlock.assign(header.headerBytes, 0);
+	CaptureChannel *table = (CaptureChannel *)&headerBlock[sizeof(CaptureHeader)];
+	for (int channel = 0; channel < channels; channel++) {
+		ChannelScaling scaling = channel < (int)info.scaling.size() ? info.scaling[channel] : ChannelScaling::linear(info.minVoltage, info.maxVoltage);
+		memcpy(table[channel].coefficients, scaling.coefficients, sizeof(table[channel].coefficients));
+	}
+
+	// compressing, the writer has a chunk in hand for every pool thread; the buffers fit a chunk packed or not
+	int threads = 1;
+	if (compress) {
+		unsigned int cores = thread::hardware_concurrency();
+		threads = cores > 2 ? (int)cores - 1 : 1;  // leave a core for the acquisition and UI threads
+		if (threads > MAX_PACK_THREADS) threads = MAX_PACK_THREADS;
+	}
+	size_t payloadBytes = chunkFrames * channels * sizeof(int16_t);
+	if (compress && packedFramesBound(chunkFrames, channels) > payloadBytes) payloadBytes = packedFramesBound(chunkFrames, channels);
+	chunkBufferBytes = (size_t)alignCapture(sizeof(CaptureChunkHeader) + payloadBytes);
+	for (int i = 0; i < threads; i++) {
+		Slot *slot = new Slot();
+		slot->buffer = (char *)BinaryFile::allocateAligned(chunkBufferBytes);
+		slots.push_back(slot);
+		if (slot->buffer == NULL) {
+			error = "Not enough memory for the recorder.";
+			freeSlots();
+			file.close();
+			return false;
+		}
+		if (compress) slot->frames.resize(chunkFrames * channels);
+	}
+	pool.start(threads);
+
+	// the header goes out now (so a crash still leaves a readable file) and again with the index at the end
+	char *staging = slots[0]->buffer;
+	memcpy(&headerBlock[0], &header, sizeof(header));
+	memcpy(staging, &headerBlock[0], header.headerBytes <= chunkBufferBytes ? header.headerBytes : chunkBufferBytes);
+	if (header.headerBytes > chunkBufferBytes || !file.writeAt(0, staging, header.headerBytes)) {
+		error = file.errorString();
+		freeSlots();
+		file.close();
+		return false;
+	}
+	fileOffset = header.headerBytes;
+	index.clear();
+
+	size_t queueFrames = (size_t)(info.sampleRate * queueSeconds);
+	if (queueFrames < chunkFrames * (slots.size() + 1)) queueFrames = chunkFrames * (slots.size() + 1);
+	queue.allocate(channels, queueFrames);
+
+	failed = false;
+	framesWritten = 0;
+	bytesWritten = 0;
+	packNanoseconds = 0;
+	dropped = 0;
+	writeNanoseconds = 0;
+	peakQueued = 0;
+	startTime = chrono::steady_clock::now();
+	rateTime = startTime;
+	rateBytes = 0;
+	recentRate = 0;
+
+	keepRunning = true;
+	writerThread = thread(&Recorder::run, this);
+	return true;
+}
+
+void Recorder::consume(const int16_t *frames, size_t numFrames) {
+	if (!keepRunning || failed) {
+		dropped += numFrames;
+		return;
+	}
+	size_t pushed = queue.push(frames, numFrames);
+	if (pushed < numFrames) {
+		dropped += numFrames - pushed;
+	}
+	size_t queued = queue.readable();
+	if (queued > peakQueued) peakQueued = queued;
+}
+
+void Recorder::run() {
+	size_t batchFrames = chunkFrames * slots.size();
+	for (;;) {
+		bool stopping = !keepRunning;
+		size_t queued = queue.readable();
+
+		if (queued >= chunkFrames || (stopping && queued > 0)) {
+			// whole chunks, as many as there are slots, until the last one
+			size_t numFrames = queued < batchFrames ? queued : batchFrames;
+			if (!stopping) numFrames -= numFrames % chunkFrames;
+			if (!failed && !writeChunks(numFrames)) {
+				failed = true;
+			}
+			if (failed) {
+				// keep draining so consume() can tell it's pointless, but count the frames as lost
+				size_t n = queue.pop((int16_t *)(slots[0]->buffer + sizeof(CaptureChunkHeader)), queued < chunkFrames ? queued : chunkFrames);
+				dropped += n;
+			}
+			continue;
+		}
+		if (stopping) break;
+		this_thread::sleep_for(chrono::milliseconds(WRITER_IDLE_MILLISECONDS));
+	}
+}
+
+// takes numFrames off the queue as up to slots.size() chunks, packs them in parallel if compressing and writes them in order
+bool Recorder::writeChunks(size_t numFrames) {
+	size_t count = 0;
+	while (numFrames > 0 && count < slots.size()) {
+		Slot &slot = *slots[count++];
+		size_t n = numFrames < chunkFrames ? numFrames : chunkFrames;
+		int16_t *target = compress ? slot.frames.data() : (int16_t *)(slot.buffer + sizeof(CaptureChunkHeader));
+		slot.numFrames = queue.pop(target, n);
+		slot.encoding = CAPTURE_ENCODING_RAW;
+		slot.payloadBytes = (uint32_t)(slot.numFrames * channels * sizeof(int16_t));
+		numFrames -= n;
+	}
+	if (compress) {
+		chrono::steady_clock::time_point before = chrono::steady_clock::now();
+		PackTask task(slots, channels);
+		pool.run(task, (int)count);
+		packNanoseconds += chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - before).count();
+	}
+
+	for (size_t i = 0; i < count; i++) {
+		Slot &slot = *slots[i];
+		CaptureChunkHeader *chunk = (CaptureChunkHeader *)slot.buffer;
+		uint32_t chunkBytes = (uint32_t)alignCapture(sizeof(CaptureChunkHeader) + slot.payloadBytes);
+		memset(slot.buffer + sizeof(CaptureChunkHeader) + slot.payloadBytes, 0, chunkBytes - sizeof(CaptureChunkHeader) - slot.payloadBytes);
+
+		chunk->magic = CAPTURE_CHUNK_MAGIC;
+		chunk->encoding = slot.encoding;
+		chunk->firstFrame = framesWritten;
+		chunk->numFrames = (uint32_t)slot.numFrames;
+		chunk->payloadBytes = slot.payloadBytes;
+		chunk->chunkBytes = chunkBytes;
+		chunk->reserved = 0;
+
+		chrono::steady_clock::time_point before = chrono::steady_clock::now();
+		if (!file.writeAt(fileOffset, slot.buffer, chunkBytes)) {
+			error = file.errorString();
+			return false;
+		}
+		writeNanoseconds += chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - before).count();
+
+		CaptureIndexEntry entry;
+		entry.firstFrame = framesWritten;
+		entry.offset = fileOffset;
+		entry.numFrames = (uint32_t)slot.numFrames;
+		entry.chunkBytes = chunkBytes;
+		index.push_back(entry);
+
+		fileOffset += chunkBytes;
+		framesWritten += slot.numFrames;
+		bytesWritten += chunkBytes;
+	}
+	return true;
+}
+
+// writes the chunk index and the final header, called by stop() once the writer thread is done
+bool Recorder::finish() {
+	header.totalFrames = framesWritten;
+	header.numChunks = index.size();
+	header.indexOffset = fileOffset;
+
+	size_t indexBytes = (size_t)alignCapture(index.size() * sizeof(CaptureIndexEntry));
+	if (indexBytes > 0) {
+		char *buffer = (char *)BinaryFile::allocateAligned(indexBytes);
+		if (buffer == NULL) {
+			error = "Not enough memory for the capture index.";
+			return false;
+		}
+		memset(buffer, 0, indexBytes);
+		memcpy(buffer, index.data(), index.size() * sizeof(CaptureIndexEntry));
+		bool written = file.writeAt(fileOffset, buffer, indexBytes);
+		BinaryFile::freeAligned(buffer);
+		if (!written) {
+			error = file.errorString();
+			return false;
+		}
+	}
+
+	memcpy(&headerBlock[0], &header, sizeof(header));
+	memcpy(slots[0]->buffer, &headerBlock[0], header.headerBytes);
+	if (!file.writeAt(0, slots[0]->buffer, header.headerBytes)) {
+		error = file.errorString();
+		return false;
+	}
+	return true;
+}
+
+void Recorder::stop() {
+	if (!writerThread.joinable()) return;
+
+	keepRunning = false;  // the writer flushes what is queued and exits
+	writerThread.join();
+
+	if (!failed) finish();
+	file.close();
+	freeSlots();
+}
+
+void Recorder::freeSlots() {
+	for (size_t i = 0; i < slots.size(); i++) {
+		BinaryFile::freeAligned(slots[i]->buffer);
+		delete slots[i];
+	}
+	slots.clear();
+}
+
+RecorderStats Recorder::stats() const {
+	RecorderStats stats;
+	chrono::steady_clock::time_point now = chrono::steady_clock::now();
+	double elapsed = chrono::duration<double>(now - startTime).count();
+	uint64_t bytes = bytesWritten;
+
+	stats.framesWritten = framesWritten;
+	stats.bytesWritten = bytes;
+	stats.sampleBytes = stats.framesWritten * channels * sizeof(int16_t);
+	stats.compressionRatio = stats.sampleBytes > 0 ? (double)bytes / stats.sampleBytes : 1;
+	uint64_t packing = packNanoseconds;
+	stats.compressMBps = packing > 0 ? stats.sampleBytes / (packing / 1e9) / 1e6 : 0;
+	stats.droppedFrames = dropped;
+	stats.averageMBps = elapsed > 0 ? bytes / elapsed / 1e6 : 0;
+
+	double sinceRate = chrono::duration<double>(now - rateTime).count();
+	if (sinceRate >= 1.0) {
+		recentRate = (bytes - rateBytes) / sinceRate / 1e6;
+		rateTime = now;
+		rateBytes = bytes;
+	}
+	stats.recentMBps = recentRate;
+
+	double capacity = (double)queue.capacityFrames();
+	stats.queueFill = capacity > 0 ? queue.readable() / capacity : 0;
+	stats.peakQueueFill = capacity > 0 ? peakQueued / capacity : 0;
+	stats.diskBusy = elapsed > 0 ? writeNanoseconds / 1e9 / elapsed : 0;
+	return stats;
+}
@@ -0,0 +1,120 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2023  Neuro Software Developers, Inc.
+//
+// Contact Information:
+//
+// Email:
+// info@neurosoftware.com
+//
+// Website:
+// www.neurosoftware.com
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include "AcquisitionEngine.h"
+#include "BinaryFile.h"
+#include "CaptureFormat.h"
+#include "SampleRing.h"
+#include "WorkerPool.h"
+
+// what goes into the capture header
+struct CaptureInfo {
+	std::string device;
+	std::string terminalConfigName;
+	int terminalConfig;
+	int numChannels;
+	double sampleRate;
+	double minVoltage;
+	double maxVoltage;
+	std::vector<ChannelScaling> scaling;	// one per channel
+
+	CaptureInfo() : terminalConfig(-1), numChannels(0), sampleRate(0), minVoltage(-10), maxVoltage(10) {}
+};
+
+struct RecorderStats {
+	uint64_t framesWritten;
+	uint64_t bytesWritten;
+	uint64_t sampleBytes;		// what the frames written take uncompressed
+	double compressionRatio;	// bytesWritten / sampleBytes, 1 uncompressed
+	double compressMBps;		// uncompressed MB the pool packs per second of packing
+	uint64_t droppedFrames;		// frames lost because the writer fell behind (backpressure)
+	double averageMBps;			// since start
+	double recentMBps;			// over roughly the last second
+	double queueFill;			// 0..1, how much of the hand-off queue is in use
+	double peakQueueFill;		// highest queueFill seen
+	double diskBusy;			// fraction of the time the writer spent inside write calls
+};
+
+// Streams every acquired block to a capture file (see CaptureFormat.h). consume() runs on the acquisition
+// thread and only copies into a lock-free queue; a writer thread packs the queue into large aligned chunks
+// and writes them, so a slow disk shows up as queue fill and dropped frames, never as a stalled acquisition.
+// With compression (the default) the writer takes several chunks off the queue at a time and a worker pool
+// packs them losslessly in parallel (SampleCodec.h); a chunk that doesn't get smaller is written raw.
+class Recorder : public BlockSink {
+public:
+	Recorder();
+	~Recorder();
+
+	bool start(const std::string &path, const CaptureInfo &info, double queueSeconds);
+	void stop();  // flushes the queue, writes the chunk index and closes the file
+	bool recording() const { return writerThread.joinable(); }
+
+	// call while stopped, applies from the next start()
+	void setCompression(bool enabled) { compress = enabled; }
+	bool compression() const { return compress; }
+
+	void consume(const int16_t *frames, size_t numFrames);
+
+	RecorderStats stats() const;
+	const std::string &errorString() const { return error; }
+	const std::string &path() const { return filePath; }
+
+private:
+	struct Slot;
+	class PackTask;
+
+	void run();
+	bool writeChunks(size_t numFrames);
+	bool finish();
+	void freeSlots();
+
+	BinaryFile file;
+	std::string filePath;
+	std::string error;
+	CaptureHeader header;
+	std::vector<char> headerBlock;
+	std::vector<CaptureIndexEntry> index;
+
+	SampleRing<int16_t> queue;
+	int channels;
+	size_t chunkFrames;
+	std::vector<Slot *> slots;	// the chunks the writer has in hand at once, one per pool thread
+	size_t chunkBufferBytes;	// of each slot's chunk buffer
+	uint64_t fileOffset;
+	bool compress;
+	WorkerPool pool;
+
+	std::thread writerThread;
+	std::atomic<bool> keepRunning;
+	std::atomic<bool> failed;
+	std::atomic<uint64_t> framesWritten;
+	std::atomic<uint64_t> bytesWritten;
+	std::atomic<uint64_t> packNanoseconds;
+	std::atomic<uint64_t> dropped;
+	std::atomic<uint64_t> writeNanoseconds;
+	std::atomic<size_t> peakQueued;
+	std::chrono::steady_clock::time_point startTime;
+
+	// recent throughput, sampled by stats()
+	mutable std::chrono::steady_clock::time_point rateTime;
+	mutable uint64_t rateBytes;
+	mutable double recentRate;
+};
@@ -0,0 +1,140 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2023  Neuro Software Developers, Inc.
+//
+// Contact Information:
+//
+// Email:
+// info@neurosoftware.com
+//
+// Website:
+// www.neurosoftware.com
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "SampleCodec.h"
+#include <string.h>
+
+#define PREDICT_DELTA 0
+#define PREDICT_LINE 1
+#define PREDICT_NONE 2			// the samples themselves, for groups no predictor helps (noise, square edges)
+#define MAX_BITS 18				// zigzag of a second order residual of int16 samples
+
+static inline uint32_t zigzag(int32_t value) {
+	return ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+}
+
+static inline int32_t unzigzag(uint32_t value) {
+	return (int32_t)(value >> 1) ^ -(int32_t)(value & 1);
+}
+
+static inline int bitsFor(uint32_t value) {
+	int bits = 0;
+	while (value != 0) {
+		bits++;
+		value >>= 1;
+	}
+	return bits;
+}
+
+size_t packedFramesBound(size_t numFrames, int numChannels) {
+	size_t groups = (numFrames + SAMPLE_CODEC_GROUP - 1) / SAMPLE_CODEC_GROUP;
+	return (size_t)numChannels * (sizeof(int16_t) + groups + (numFrames * MAX_BITS + 7) / 8 + 8);
+}
+
+size_t packFrames(const int16_t *frames, size_t numFrames, int numChannels, uint8_t *packed) {
+	uint8_t *out = packed;
+	if (numFrames == 0)
+		return 0;
+
+	uint32_t residuals[2][SAMPLE_CODEC_GROUP];
+	for (int channel = 0; channel < numChannels; channel++) {
+		const int16_t *in = frames + channel;
+		int32_t previous = in[0], beforePrevious = in[0];
+		memcpy(out, &in[0], sizeof(int16_t));
+		out += sizeof(int16_t);
+
+		for (size_t start = 1; start < numFrames; start += SAMPLE_CODEC_GROUP) {
+			size_t count = numFrames - start < SAMPLE_CODEC_GROUP ? numFrames - start : SAMPLE_CODEC_GROUP;
+			// both predictors' residuals, OR-ed together to find their widths
+			uint32_t any[2] = { 0, 0 };
+			for (size_t i = 0; i < count; i++) {
+				int32_t sample = in[(start + i) * numChannels];
+				residuals[PREDICT_DELTA][i] = zigzag(sample - previous);
+				residuals[PREDICT_LINE][i] = zigzag(sample - (2 * previous - beforePrevious));
+				any[PREDICT_DELTA] |= residuals[PREDICT_DELTA][i];
+				any[PREDICT_LINE] |= residuals[PREDICT_LINE][i];
+				beforePrevious = previous;
+				previous = sample;
+			}
+			int predictor = bitsFor(any[PREDICT_LINE]) < bitsFor(any[PREDICT_DELTA]) ? PREDICT_LINE : PREDICT_DELTA;
+			int bits = bitsFor(any[predictor]);
+			if (bits > 16) {
+				predictor = PREDICT_NONE;
+				bits = 16;
+				for (size_t i = 0; i < count; i++) {
+					residuals[PREDICT_DELTA][i] = (uint16_t)in[(start + i) * numChannels];
+				}
+			}
+			*out++ = (uint8_t)(predictor << 5 | bits);
+
+			const uint32_t *residual = residuals[predictor == PREDICT_NONE ? PREDICT_DELTA : predictor];
+			uint64_t buffer = 0;
+			int buffered = 0;
+			for (size_t i = 0; i < count && bits > 0; i++) {
+				buffer |= (uint64_t)residual[i] << buffered;
+				buffered += bits;
+				while (buffered >= 8) {
+					*out++ = (uint8_t)buffer;
+					buffer >>= 8;
+					buffered -= 8;
+				}
+			}
+			if (buffered > 0) *out++ = (uint8_t)buffer;
+		}
+	}
+	return out - packed;
+}
+
+bool unpackFrames(const uint8_t *packed, size_t packedBytes, size_t numFrames, int numChannels, int16_t *frames) {
+	const uint8_t *in = packed, *end = packed + packedBytes;
+	if (numFrames == 0)
+		return packedBytes == 0;
+
+	for (int channel = 0; channel < numChannels; channel++) {
+		int16_t *out = frames + channel;
+		if (end - in < (ptrdiff_t)sizeof(int16_t)) return false;
+		memcpy(&out[0], in, sizeof(int16_t));
+		in += sizeof(int16_t);
+		int32_t previous = out[0], beforePrevious = out[0];
+
+		for (size_t start = 1; start < numFrames; start += SAMPLE_CODEC_GROUP) {
+			size_t count = numFrames - start < SAMPLE_CODEC_GROUP ? numFrames - start : SAMPLE_CODEC_GROUP;
+			if (in >= end) return false;
+			int predictor = *in >> 5;
+			int bits = *in & 31;
+			in++;
+			if (predictor > PREDICT_NONE || bits > MAX_BITS || end - in < (ptrdiff_t)((count * bits + 7) / 8)) return false;
+
+			uint32_t mask = (1u << bits) - 1;
+			uint64_t buffer = 0;
+			int buffered = 0;
+			for (size_t i = 0; i < count; i++) {
+				while (buffered < bits) {
+					buffer |= (uint64_t)*in++ << buffered;
+					buffered += 8;
+				}
+				uint32_t code = (uint32_t)buffer & mask;
+				buffer >>= bits;
+				buffered -= bits;
+				int32_t sample;
+				if (predictor == PREDICT_NONE) sample = (int16_t)code;
+				else sample = unzigzag(code) + (predictor == PREDICT_LINE ? 2 * previous - beforePrevious : previous);
+				out[(start + i) * numChannels] = (int16_t)sample;
+				beforePrevious = previous;
+				previous = sample;
+			}
+		}
+	}
+	return in == end;
+}
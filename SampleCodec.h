@@ -0,0 +1,38 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2023  Neuro Software Developers, Inc.
+//
+// Contact Information:
+//
+// Email:
+// info@neurosoftware.com
+//
+// Website:
+// www.neurosoftware.com
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Lossless packing of interleaved int16 frames for the wire and for disk. Each channel is coded on its own, in
+// groups of SAMPLE_CODEC_GROUP samples: the first sample of the block as is, then per group the residuals of
+// whichever predictor fits the group best, the previous sample (delta) or the line through the previous two
+// (second order), zigzag coded and bit packed at the width of the group's largest residual, or the samples
+// themselves when no predictor gets them under 16 bits:
+//
+//	per channel: int16 first sample, then per group one byte (predictor << 5 | bits) and the packed residuals
+//
+// Slowly moving signals pack to a few bits a sample, noise costs its own entropy plus a little, and nothing
+// grows by more than a byte a group. A packed block decodes on its own, without anything that came before.
+
+#define SAMPLE_CODEC_GROUP 128
+
+// bytes packFrames() may need at most
+size_t packedFramesBound(size_t numFrames, int numChannels);
+// returns the bytes written to packed
+size_t packFrames(const int16_t *frames, size_t numFrames, int numChannels, uint8_t *packed);
+// false if packed isn't exactly numFrames frames of numChannels packed by packFrames()
+bool unpackFrames(const uint8_t *packed, size_t packedBytes, size_t numFrames, int numChannels, int16_t *frames);
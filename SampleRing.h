@@ -0,0 +1,116 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2023  Neuro Software Developers, Inc.
+//
+// Contact Information:
+//
+// Email:
+// info@neurosoftware.com
+//
+// Website:
+// www.neurosoftware.com
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <atomic>
+#include <vector>
+#include <string.h>
+
+// Lock-free single-producer/single-consumer ring of interleaved sample frames.
+// One frame holds one sample for every channel (DAQmx_Val_GroupByScanNumber order).
+// The acquisition thread is the only writer and the UI thread the only reader, so the
+// two monotonically increasing frame counters are all the synchronization we need.
+template <typename T>
+class SampleRing {
+public:
+	SampleRing() : channels(0), capacity(0), mask(0), cachedTail(0), cachedHead(0) {
+		head.store(0);
+		tail.store(0);
+	}
+
+	// not thread safe, call before the producer and consumer are started
+	void allocate(int numChannels, size_t capacityFrames) {
+		size_t frames = 1;
+		while (frames < capacityFrames) frames <<= 1;  // power of two so wrapping is a mask
+		channels = numChannels;
+		capacity = frames;
+		mask = frames - 1;
+		data.assign(frames * numChannels, T());
+		reset();
+	}
+
+	// not thread safe, call only while the producer is stopped
+	void reset() {
+		head.store(0, std::memory_order_relaxed);
+		tail.store(0, std::memory_order_relaxed);
+		cachedTail = 0;
+		cachedHead = 0;
+	}
+
+	int numChannels() const { return channels; }
+	size_t capacityFrames() const { return capacity; }
+
+	// producer: copies up to numFrames frames in, returns how many fit
+	size_t push(const T* frames, size_t numFrames) {
+		size_t h = head.load(std::memory_order_relaxed);
+		if (capacity - (h - cachedTail) < numFrames) {
+			cachedTail = tail.load(std::memory_order_acquire);
+		}
+		size_t space = capacity - (h - cachedTail);
+		if (numFrames > space) numFrames = space;
+		if (numFrames == 0) return 0;
+
+		size_t start = h & mask;
+		size_t first = capacity - start;
+		if (first > numFrames) first = numFrames;
+		memcpy(&data[start * channels], frames, first * channels * sizeof(T));
+		if (numFrames > first) {
+			memcpy(&data[0], frames + first * channels, (numFrames - first) * channels * sizeof(T));
+		}
+		head.store(h + numFrames, std::memory_order_release);
+		return numFrames;
+	}
+
+	// consumer: copies up to maxFrames frames out, returns how many were available
+	size_t pop(T* frames, size_t maxFrames) {
+		size_t t = tail.load(std::memory_order_relaxed);
+		if (cachedHead - t < maxFrames) {
+			cachedHead = head.load(std::memory_order_acquire);
+		}
+		size_t numFrames = cachedHead - t;
+		if (numFrames > maxFrames) numFrames = maxFrames;
+		if (numFrames == 0) return 0;
+
+		size_t start = t & mask;
+		size_t first = capacity - start;
+		if (first > numFrames) first = numFrames;
+		memcpy(frames, &data[start * channels], first * channels * sizeof(T));
+		if (numFrames > first) {
+			memcpy(frames + first * channels, &data[0], (numFrames - first) * channels * sizeof(T));
+		}
+		tail.store(t + numFrames, std::memory_order_release);
+		return numFrames;
+	}
+
+	// approximate when called from the producer side, exact from the consumer side
+	size_t readable() const {
+		return head.load(std::memory_order_acquire) - tail.load(std::memory_order_relaxed);
+	}
+
+private:
+	int channels;
+	size_t capacity;
+	size_t mask;
+	std::vector<T> data;
+
+	// keep the producer and consumer counters on separate cache lines so the two threads don't false share
+	char pad0[64];
+	std::atomic<size_t> head;		// frames written, owned by the producer
+	size_t cachedTail;				// producer's last view of tail
+	char pad1[64];
+	std::atomic<size_t> tail;		// frames read, owned by the consumer
+	size_t cachedHead;				// consumer's last view of head
+	char pad2[64];
+};
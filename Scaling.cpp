@@ -0,0 +1,111 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2023  Neuro Software Developers, Inc.
+//
+// Contact Information:
+//
+// Email:
+// info@neurosoftware.com
+//
+// Website:
+// www.neurosoftware.com
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "Scaling.h"
+#include "SimdSupport.h"
+#include <math.h>
+
+ChannelScaling ChannelScaling::linear(double minVoltage, double maxVoltage) {
+	ChannelScaling scaling;
+	scaling.coefficients[0] = (minVoltage + maxVoltage) / 2;
+	scaling.coefficients[1] = (maxVoltage - minVoltage) / 65536.0;
+	scaling.coefficients[2] = 0;
+	scaling.coefficients[3] = 0;
+	return scaling;
+}
+
+int16_t ChannelScaling::toCode(double volts) const {
+	double c0 = coefficients[0], c1 = coefficients[1];
+	if (c1 == 0) return 0;
+	double x = (volts - c0) / c1;
+
+	// a few Newton steps take care of the (small) higher order calibration terms
+	if (coefficients[2] != 0 || coefficients[3] != 0) {
+		for (int i = 0; i < 4; i++) {
+			double f = c0 + x * (c1 + x * (coefficients[2] + x * coefficients[3])) - volts;
+			double slope = c1 + x * (2 * coefficients[2] + x * 3 * coefficients[3]);
+			if (slope == 0) break;
+			x -= f / slope;
+		}
+	}
+	x = floor(x + 0.5);
+	if (x < -32768) x = -32768;
+	if (x > 32767) x = 32767;
+	return (int16_t)x;
+}
+
+void scaleToVolts(const int16_t *codes, size_t count, const ChannelScaling &scaling, float *volts) {
+	size_t i = 0;
+	float c0 = (float)scaling.coefficients[0];
+	float c1 = (float)scaling.coefficients[1];
+	float c2 = (float)scaling.coefficients[2];
+	float c3 = (float)scaling.coefficients[3];
+
+#ifdef SCOPE_SSE2
+	__m128 k0 = _mm_set1_ps(c0), k1 = _mm_set1_ps(c1), k2 = _mm_set1_ps(c2), k3 = _mm_set1_ps(c3);
+	bool linear = c2 == 0 && c3 == 0;
+	for (; i + 8 <= count; i += 8) {
+		__m128i raw = _mm_loadu_si128((const __m128i *)(codes + i));
+		// sign extend the eight int16 codes to two vectors of int32 and convert to float
+		__m128 lo = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(raw, raw), 16));
+		__m128 hi = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(raw, raw), 16));
+		__m128 a, b;
+		if (linear) {
+			a = _mm_add_ps(k0, _mm_mul_ps(lo, k1));
+			b = _mm_add_ps(k0, _mm_mul_ps(hi, k1));
+		}
+		else {
+			// Horner's rule
+			a = _mm_add_ps(k2, _mm_mul_ps(lo, k3));
+			b = _mm_add_ps(k2, _mm_mul_ps(hi, k3));
+			a = _mm_add_ps(k1, _mm_mul_ps(lo, a));
+			b = _mm_add_ps(k1, _mm_mul_ps(hi, b));
+			a = _mm_add_ps(k0, _mm_mul_ps(lo, a));
+			b = _mm_add_ps(k0, _mm_mul_ps(hi, b));
+		}
+		_mm_storeu_ps(volts + i, a);
+		_mm_storeu_ps(volts + i + 4, b);
+	}
+#endif
+	for (; i < count; i++) {
+		float x = codes[i];
+		volts[i] = c0 + x * (c1 + x * (c2 + x * c3));
+	}
+}
+
+void voltsToCodes(const float *volts, size_t count, const ChannelScaling &scaling, int16_t *codes) {
+	size_t i = 0;
+	float c0 = (float)scaling.coefficients[0];
+	float inverse = scaling.coefficients[1] != 0 ? (float)(1.0 / scaling.coefficients[1]) : 0;
+
+	// linear term only, which is all the simulated source needs. Both paths round half to even (the SSE default)
+	// and clamp before converting, so a value beyond the int32 range can't wrap to the wrong end of the scale.
+#ifdef SCOPE_SSE2
+	__m128 k0 = _mm_set1_ps(c0), k1 = _mm_set1_ps(inverse);
+	__m128 lowest = _mm_set1_ps(-32768.0f), highest = _mm_set1_ps(32767.0f);
+	for (; i + 8 <= count; i += 8) {
+		__m128 x = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(volts + i), k0), k1);
+		__m128 y = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(volts + i + 4), k0), k1);
+		__m128i a = _mm_cvtps_epi32(_mm_min_ps(_mm_max_ps(x, lowest), highest));
+		__m128i b = _mm_cvtps_epi32(_mm_min_ps(_mm_max_ps(y, lowest), highest));
+		_mm_storeu_si128((__m128i *)(codes + i), _mm_packs_epi32(a, b));
+	}
+#endif
+	for (; i < count; i++) {
+		float x = nearbyintf((volts[i] - c0) * inverse);
+		if (x < -32768.0f) x = -32768.0f;
+		if (x > 32767.0f) x = 32767.0f;
+		codes[i] = (int16_t)x;
+	}
+}
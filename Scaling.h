@@ -0,0 +1,48 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2023  Neuro Software Developers, Inc.
+//
+// Contact Information:
+//
+// Email:
+// info@neurosoftware.com
+//
+// Website:
+// www.neurosoftware.com
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define SCALING_COEFFICIENTS 4
+
+// Converts a channel's raw ADC codes to volts: volts = c[0] + c[1]*code + c[2]*code^2 + c[3]*code^3,
+// the same polynomial form as the device scaling coefficients DAQmx reports (DAQmx_AI_DevScalingCoeff).
+struct ChannelScaling {
+	double coefficients[SCALING_COEFFICIENTS];
+
+	ChannelScaling() {
+		coefficients[0] = 0;
+		coefficients[1] = 20.0 / 65536.0;  // +-10 V over 16 bits
+		coefficients[2] = 0;
+		coefficients[3] = 0;
+	}
+
+	// linear scaling spreading the 16 bit code range over minVoltage..maxVoltage
+	static ChannelScaling linear(double minVoltage, double maxVoltage);
+
+	float toVolts(int16_t code) const {
+		double x = code;
+		return (float)(coefficients[0] + x * (coefficients[1] + x * (coefficients[2] + x * coefficients[3])));
+	}
+
+	// nearest code for a voltage, saturated to the int16 range (used for thresholds and simulated signals)
+	int16_t toCode(double volts) const;
+};
+
+// Vectorized conversions, only ever run on the samples that are about to be drawn, analysed or exported.
+void scaleToVolts(const int16_t *codes, size_t count, const ChannelScaling &scaling, float *volts);
+void voltsToCodes(const float *volts, size_t count, const ChannelScaling &scaling, int16_t *codes);
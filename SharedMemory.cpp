@@ -0,0 +1,139 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2023  Neuro Software Developers, Inc.
+//
+// Contact Information:
+//
+// Email:
+// info@neurosoftware.com
+//
+// Website:
+// www.neurosoftware.com
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "SharedMemory.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+using namespace std;
+
+SharedMemory::SharedMemory() : base(NULL), bytes(0), preexisting(false), owner(false) {
+#ifdef _WIN32
+	mapping = NULL;
+#endif
+}
+
+SharedMemory::~SharedMemory() {
+	close();
+}
+
+bool SharedMemory::fail(const string &what) {
+#ifdef _WIN32
+	error = what + " " + regionName + " (error " + to_string((unsigned long long)GetLastError()) + ")";
+	if (mapping != NULL) CloseHandle(mapping);
+	mapping = NULL;
+#else
+	error = what + " " + regionName + " (" + strerror(errno) + ")";
+#endif
+	base = NULL;
+	bytes = 0;
+	return false;
+}
+
+bool SharedMemory::create(const string &name, size_t size) {
+	close();
+	regionName = name;
+	error.clear();
+#ifdef _WIN32
+	mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, (DWORD)((uint64_t)size >> 32), (DWORD)size, name.c_str());
+	if (mapping == NULL) return fail("Could not create shared memory");
+	preexisting = GetLastError() == ERROR_ALREADY_EXISTS;
+	base = MapViewOfFile(mapping, FILE_MAP_READ | FILE_MAP_WRITE, 0, 0, 0);
+	if (base == NULL) return fail("Could not map shared memory");
+	MEMORY_BASIC_INFORMATION info;
+	VirtualQuery(base, &info, sizeof(info));
+	bytes = preexisting ? info.RegionSize : size;
+#else
+	string path = "/" + name;
+	int descriptor = shm_open(path.c_str(), O_RDWR | O_CREAT | O_EXCL, 0644);
+	preexisting = descriptor < 0 && errno == EEXIST;
+	if (preexisting) descriptor = shm_open(path.c_str(), O_RDWR, 0644);
+	if (descriptor < 0) return fail("Could not create shared memory");
+	struct stat status;
+	if (!preexisting && ftruncate(descriptor, (off_t)size) != 0) {
+		::close(descriptor);
+		shm_unlink(path.c_str());
+		return fail("Could not size shared memory");
+	}
+	bytes = size;
+	if (preexisting && fstat(descriptor, &status) == 0) bytes = (size_t)status.st_size;
+	void *mapped = bytes > 0 ? mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, descriptor, 0) : MAP_FAILED;
+	::close(descriptor);
+	if (mapped == MAP_FAILED) return fail("Could not map shared memory");
+	base = mapped;
+#endif
+	owner = true;
+	return true;
+}
+
+bool SharedMemory::open(const string &name, bool readOnly) {
+	close();
+	regionName = name;
+	error.clear();
+	preexisting = true;
+#ifdef _WIN32
+	DWORD access = readOnly ? FILE_MAP_READ : FILE_MAP_READ | FILE_MAP_WRITE;
+	mapping = OpenFileMappingA(access, FALSE, name.c_str());
+	if (mapping == NULL) return fail("Could not open shared memory");
+	base = MapViewOfFile(mapping, access, 0, 0, 0);
+	if (base == NULL) return fail("Could not map shared memory");
+	MEMORY_BASIC_INFORMATION info;
+	VirtualQuery(base, &info, sizeof(info));
+	bytes = info.RegionSize;
+#else
+	string path = "/" + name;
+	int descriptor = shm_open(path.c_str(), readOnly ? O_RDONLY : O_RDWR, 0);
+	if (descriptor < 0) return fail("Could not open shared memory");
+	struct stat status;
+	if (fstat(descriptor, &status) != 0 || status.st_size <= 0) {
+		::close(descriptor);
+		return fail("Could not size shared memory");
+	}
+	bytes = (size_t)status.st_size;
+	void *mapped = mmap(NULL, bytes, readOnly ? PROT_READ : PROT_READ | PROT_WRITE, MAP_SHARED, descriptor, 0);
+	::close(descriptor);
+	if (mapped == MAP_FAILED) return fail("Could not map shared memory");
+	base = mapped;
+#endif
+	owner = false;
+	return true;
+}
+
+void SharedMemory::close() {
+	if (base == NULL)
+		return;
+
+#ifdef _WIN32
+	UnmapViewOfFile(base);
+	CloseHandle(mapping);
+	mapping = NULL;
+#else
+	munmap(base, bytes);
+	if (owner) shm_unlink(("/" + regionName).c_str());
+#endif
+	base = NULL;
+	bytes = 0;
+	owner = false;
+}
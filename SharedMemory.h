@@ -0,0 +1,55 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2023  Neuro Software Developers, Inc.
+//
+// Contact Information:
+//
+// Email:
+// info@neurosoftware.com
+//
+// Website:
+// www.neurosoftware.com
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <string>
+#include <stddef.h>
+
+// A named region of memory shared between processes on this machine: CreateFileMapping / OpenFileMapping on
+// Windows (in the session's namespace), shm_open / mmap elsewhere. The creator's region lives until it and every
+// process that opened it have closed it on Windows; elsewhere the creator unlinks the name when it closes.
+class SharedMemory {
+public:
+	SharedMemory();
+	~SharedMemory();
+
+	// maps name read/write, creating it with bytes if it doesn't exist yet; an existing region keeps its own size
+	bool create(const std::string &name, size_t bytes);
+	// maps an existing region
+	bool open(const std::string &name, bool readOnly);
+	void close();
+	bool isOpen() const { return base != NULL; }
+
+	void *data() const { return base; }
+	size_t size() const { return bytes; }
+	bool existed() const { return preexisting; }	// create() found the region already there
+	const std::string &errorString() const { return error; }
+
+private:
+	SharedMemory(const SharedMemory &);
+	SharedMemory &operator=(const SharedMemory &);
+
+	bool fail(const std::string &what);
+
+	std::string regionName;
+	std::string error;
+	void *base;
+	size_t bytes;
+	bool preexisting;
+	bool owner;				// created by us, so ours to unlink
+#ifdef _WIN32
+	void *mapping;
+#endif
+};
@@ -0,0 +1,34 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2023  Neuro Software Developers, Inc.
+//
+// Contact Information:
+//
+// Email:
+// info@neurosoftware.com
+//
+// Website:
+// www.neurosoftware.com
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+// SSE2 is part of every x64 target and of the /arch:SSE2 x86 default since VS2012, so the hot loops use it
+// directly and keep a scalar path for anything else (e.g. ARM build boxes).
+#if defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#define SCOPE_SSE2 1
+#include <emmintrin.h>
+#endif
+
+// index of the lowest set bit of a non-zero mask, e.g. the first matching lane of a _mm_movemask_epi8
+#ifdef _MSC_VER
+#include <intrin.h>
+inline int lowestSetBit(unsigned int mask) {
+	unsigned long index;
+	_BitScanForward(&index, mask);
+	return (int)index;
+}
+#else
+inline int lowestSetBit(unsigned int mask) { return __builtin_ctz(mask); }
+#endif
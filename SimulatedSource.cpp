@@ -0,0 +1,237 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2023  Neuro Software Developers, Inc.
+//
+// Contact Information:
+//
+// Email:
+// info@neurosoftware.com
+//
+// Website:
+// www.neurosoftware.com
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "SimulatedSource.h"
+#include <math.h>
+#include <thread>
+
+using namespace std;
+
+#define TWO_PI 6.283185307179586
+#define SIM_BUFFER_SECONDS 4.0		// like the NIDAQmx task buffer, how far the reader may fall behind before an overrun
+#define CHIRP_UPDATE 64				// samples between recomputing the chirp phasor rotation
+
+static const char *simulatedDevices[] = { "Sim-Sine", "Sim-Square", "Sim-Noise", "Sim-Chirp" };
+
+SimulatedSource::SimulatedSource() : channels(0), rate(0), realTime(true), running(false), framesDelivered(0) {
+}
+
+vector<string> SimulatedSource::deviceNames() {
+	return vector<string>(simulatedDevices, simulatedDevices + 4);
+}
+
+bool SimulatedSource::isSimulatedDevice(const string &device) {
+	return device.compare(0, 4, "Sim-") == 0;
+}
+
+void SimulatedSource::setSignal(const SimulatedSignal &signal) {
+	for (int channel = 0; channel < SIM_MAX_CHANNELS; channel++) {
+		signals[channel] = signal;
+	}
+}
+
+void SimulatedSource::setChannelSignal(int channel, const SimulatedSignal &signal) {
+	if (channel >= 0 && channel < SIM_MAX_CHANNELS) {
+		signals[channel] = signal;
+	}
+}
+
+string SimulatedSource::errorString(int status) const {
+	switch (status) {
+	case 0: return "";
+	case SIM_ERROR_OVERRUN: return "Simulated device: samples were overwritten before they were read, the reader fell behind the sample clock.";
+	case SIM_ERROR_CONFIG: return "Simulated device: unsupported channel count or sample rate.";
+	default: return "Simulated device: unknown error.";
+	}
+}
+
+bool SimulatedSource::start(const AcquisitionConfig &config) {
+	stop();
+	error.clear();
+
+	if (config.numChannels() < 1 || config.numChannels() > SIM_MAX_CHANNELS || config.sampleRate <= 0) {
+		error = errorString(SIM_ERROR_CONFIG);
+		return false;
+	}
+
+	channels = config.numChannels();
+	rate = config.sampleRate;
+
+	// the name of a channel's device picks its waveform, e.g. "Sim-Square/ai0:3, Sim-Sine/ai0:3"
+	codeScaling.resize(channels);
+	for (int channel = 0; channel < channels; channel++) {
+		const ChannelConfig &input = config.channels[channel];
+		const string &device = input.device < (int)config.devices.size() ? config.devices[input.device] : config.device();
+		for (int i = 0; i < 4; i++) {
+			if (device == simulatedDevices[i]) {
+				signals[channel].waveform = (SimulatedWaveform)i;
+			}
+		}
+		codeScaling[channel] = ChannelScaling::linear(input.minVoltage, input.maxVoltage);
+	}
+
+	state.assign(channels, ChannelState());
+	for (int channel = 0; channel < channels; channel++) {
+		ChannelState &s = state[channel];
+		s.signal = signals[channel];
+		double frequency = s.signal.frequency > 0 ? s.signal.frequency : rate / 50.0;
+		frequency *= 1 + (channel / 2) % 8;  // each pair a harmonic higher so the traces can be told apart
+		double startPhase = (channel % 2) * 0.25;
+
+		s.phase = startPhase;
+		s.re = cos(TWO_PI * startPhase);
+		s.im = sin(TWO_PI * startPhase);
+		s.step = frequency / rate;
+		s.sweepSamples = (uint64_t)(s.signal.chirpSeconds * rate);
+		if (s.sweepSamples < 1) s.sweepSamples = 1;
+		double endFrequency = s.signal.chirpEndFrequency > 0 ? s.signal.chirpEndFrequency : rate / 4.0;
+		s.stepDelta = (endFrequency - frequency) / rate / s.sweepSamples;
+		s.sweepPosition = 0;
+		s.random = 0x9E3779B9u ^ (uint32_t)(channel * 7919 + 1);
+	}
+
+	framesDelivered = 0;
+	startTime = chrono::steady_clock::now();
+	running = true;
+	return true;
+}
+
+void SimulatedSource::stop() {
+	running = false;
+}
+
+int SimulatedSource::read(int16_t *frames, int framesPerChannel, double timeOut, int *framesRead) {
+	*framesRead = 0;
+	if (!running) return SIM_ERROR_CONFIG;
+
+	int numFrames = framesPerChannel;
+	if (realTime) {
+		// a hardware clock would have produced this many frames since start
+		chrono::steady_clock::time_point now = chrono::steady_clock::now();
+		double elapsed = chrono::duration<double>(now - startTime).count();
+		double produced = elapsed * rate;
+
+		if (produced - framesDelivered > rate * SIM_BUFFER_SECONDS + framesPerChannel) {
+			// the "driver buffer" wrapped, drop what was overwritten and report it like DAQmx does
+			framesDelivered = (uint64_t)produced;
+			return SIM_ERROR_OVERRUN;
+		}
+
+		double due = (framesDelivered + framesPerChannel) / rate;
+		double deadline = elapsed + timeOut;
+		if (due <= deadline) {
+			this_thread::sleep_until(startTime + chrono::duration_cast<chrono::steady_clock::duration>(chrono::duration<double>(due)));
+		}
+		else {
+			// time out with whatever the clock produced by the deadline
+			this_thread::sleep_until(now + chrono::duration_cast<chrono::steady_clock::duration>(chrono::duration<double>(timeOut)));
+			numFrames = (int)((uint64_t)(deadline * rate) - framesDelivered);
+			if (numFrames < 0) numFrames = 0;
+			if (numFrames > framesPerChannel) numFrames = framesPerChannel;
+		}
+	}
+
+	generate(frames, numFrames);
+	framesDelivered += numFrames;
+	*framesRead = numFrames;
+	return 0;
+}
+
+// what the simulated sample clock has produced that wasn't read yet
+int64_t SimulatedSource::available() {
+	if (!running || !realTime) return 0;
+	double produced = chrono::duration<double>(chrono::steady_clock::now() - startTime).count() * rate;
+	return produced > framesDelivered ? (int64_t)(produced - framesDelivered) : 0;
+}
+
+// cheap bell shaped noise: sum of the two 16 bit halves of one xorshift step (triangular distribution)
+float SimulatedSource::gaussian(ChannelState &s) {
+	s.random ^= s.random << 13;
+	s.random ^= s.random >> 17;
+	s.random ^= s.random << 5;
+	float sum = (float)(s.random & 0xFFFF) + (float)(s.random >> 16);
+	return (sum * (1.0f / 65536.0f) - 1.0f) * 2.4494897f;  // zero mean, unit variance
+}
+
+void SimulatedSource::generate(int16_t *frames, int numFrames) {
+	if (volts.size() < (size_t)numFrames) {
+		volts.resize(numFrames);
+		codes.resize(numFrames);
+	}
+
+	for (int channel = 0; channel < channels; channel++) {
+		ChannelState &s = state[channel];
+		const SimulatedSignal &signal = s.signal;
+		float amplitude = (float)signal.amplitude;
+		float offset = (float)signal.offset;
+		float noise = (float)signal.noise;
+		float *out = volts.data();
+
+		double rotRe = cos(TWO_PI * s.step);
+		double rotIm = sin(TWO_PI * s.step);
+
+		for (int i = 0; i < numFrames; i++) {
+			float value;
+			switch (signal.waveform) {
+			case SIM_SQUARE:
+				value = s.phase < 0.5 ? amplitude : -amplitude;
+				s.phase += s.step;
+				if (s.phase >= 1.0) s.phase -= 1.0;
+				break;
+			case SIM_NOISE:
+				value = amplitude * 0.25f * gaussian(s);
+				break;
+			case SIM_SINE:
+			case SIM_CHIRP:
+			default:
+				value = amplitude * (float)s.im;
+				{
+					double re = s.re * rotRe - s.im * rotIm;
+					s.im = s.re * rotIm + s.im * rotRe;
+					s.re = re;
+				}
+				if (signal.waveform == SIM_CHIRP) {
+					s.step += s.stepDelta;
+					if (++s.sweepPosition >= s.sweepSamples) {
+						s.step -= s.stepDelta * s.sweepSamples;
+						s.sweepPosition = 0;
+					}
+					if (i % CHIRP_UPDATE == 0) {
+						rotRe = cos(TWO_PI * s.step);
+						rotIm = sin(TWO_PI * s.step);
+					}
+				}
+				break;
+			}
+			if (signal.waveform != SIM_NOISE && noise > 0) {
+				value += noise * gaussian(s);
+			}
+			out[i] = value + offset;
+		}
+
+		// quantize (saturating at the input range like an ADC would) and interleave into the frames
+		voltsToCodes(out, numFrames, codeScaling[channel], codes.data());
+		int16_t *frame = frames + channel;
+		for (int i = 0; i < numFrames; i++) {
+			frame[(size_t)i * channels] = codes[i];
+		}
+
+		// renormalize the phasor once per block so rounding can't make it grow or shrink
+		double magnitude = sqrt(s.re * s.re + s.im * s.im);
+		if (magnitude > 0) {
+			s.re /= magnitude;
+			s.im /= magnitude;
+		}
+	}
+}
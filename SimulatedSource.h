@@ -0,0 +1,99 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2023  Neuro Software Developers, Inc.
+//
+// Contact Information:
+//
+// Email:
+// info@neurosoftware.com
+//
+// Website:
+// www.neurosoftware.com
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <vector>
+#include <chrono>
+#include <stdint.h>
+#include "AcquisitionSource.h"
+
+enum SimulatedWaveform {
+	SIM_SINE,
+	SIM_SQUARE,
+	SIM_NOISE,
+	SIM_CHIRP
+};
+
+struct SimulatedSignal {
+	SimulatedWaveform waveform;
+	double frequency;			// Hz, 0 picks sampleRate / 50 so a cycle spans 50 samples at any rate
+	double amplitude;			// volts, peak
+	double offset;				// volts
+	double noise;				// volts, standard deviation of the added noise
+	double chirpEndFrequency;	// Hz, SIM_CHIRP sweeps frequency -> chirpEndFrequency (0 picks sampleRate / 4)
+	double chirpSeconds;		// duration of one sweep
+
+	SimulatedSignal() : waveform(SIM_SINE), frequency(0), amplitude(5.0), offset(0), noise(0.05), chirpEndFrequency(0), chirpSeconds(1.0) {}
+};
+
+#define SIM_MAX_CHANNELS 1024
+#define SIM_ERROR_OVERRUN (-1)		// the reader fell further behind than the simulated driver buffer holds
+#define SIM_ERROR_CONFIG (-2)
+
+// Built-in signal generator. Delivers blocks on the same schedule a hardware sample clock would
+// (a read of N frames returns after N / sampleRate seconds), or as fast as possible for benchmarking.
+// Signals are quantized to 16 bit codes over the configured input range, like a real ADC.
+// Channel pairs (0,1), (2,3), ... are 90 degrees apart so the XY plot draws a figure.
+class SimulatedSource : public AcquisitionSource {
+public:
+	SimulatedSource();
+
+	bool start(const AcquisitionConfig &config);
+	int read(int16_t *frames, int framesPerChannel, double timeOut, int *framesRead);
+	void stop();
+
+	int numChannels() const { return channels; }
+	double sampleRate() const { return rate; }
+	ChannelScaling scaling(int channel) const { return codeScaling[channel]; }
+	int64_t available();
+	bool overrun(int status) const { return status == SIM_ERROR_OVERRUN; }
+	std::string errorString(int status) const;
+
+	// applies to all channels (or one channel) on the next start()
+	void setSignal(const SimulatedSignal &signal);
+	void setChannelSignal(int channel, const SimulatedSignal &signal);
+	void setRealTime(bool paceToSampleClock) { realTime = paceToSampleClock; }
+
+	// device names that select a simulated backend (and its waveform) in AcquisitionConfig::device
+	static std::vector<std::string> deviceNames();
+	static bool isSimulatedDevice(const std::string &device);
+
+private:
+	struct ChannelState {
+		SimulatedSignal signal;
+		double phase;		// cycles, [0, 1) for the square wave
+		double re, im;		// phasor for sine and chirp
+		double step;		// phase increment per sample, cycles
+		double stepDelta;	// chirp: increment change per sample
+		uint64_t sweepSamples;
+		uint64_t sweepPosition;
+		uint32_t random;
+	};
+
+	void generate(int16_t *frames, int numFrames);
+	float gaussian(ChannelState &state);
+
+	SimulatedSignal signals[SIM_MAX_CHANNELS];
+	std::vector<ChannelState> state;
+	int channels;
+	double rate;
+	std::vector<ChannelScaling> codeScaling;	// the simulated 16 bit ADC spans each channel's configured input range
+	std::vector<float> volts;
+	std::vector<int16_t> codes;
+	bool realTime;
+	bool running;
+	std::chrono::steady_clock::time_point startTime;
+	uint64_t framesDelivered;
+};
@@ -0,0 +1,262 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2023  Neuro Software Developers, Inc.
+//
+// Contact Information:
+//
+// Email:
+// info@neurosoftware.com
+//
+// Website:
+// www.neurosoftware.com
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "Socket.h"
+#include <stdio.h>
+#include <string.h>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <winsock2.h>
+#include <ws2tcpip.h>
+typedef int socklen_t;
+#define SOCKET_ERROR_CODE WSAGetLastError()
+#define WOULD_BLOCK(code) ((code) == WSAEWOULDBLOCK)
+#define IN_PROGRESS(code) ((code) == WSAEWOULDBLOCK || (code) == WSAEINPROGRESS)
+#define closeSocket closesocket
+#else
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <sys/select.h>
+typedef int SOCKET;
+#define INVALID_SOCKET (-1)
+#define SOCKET_ERROR_CODE errno
+#define WOULD_BLOCK(code) ((code) == EWOULDBLOCK || (code) == EAGAIN)
+#define IN_PROGRESS(code) ((code) == EINPROGRESS)
+#define closeSocket ::close
+#endif
+
+using namespace std;
+
+#ifdef _WIN32
+// Winsock wants WSAStartup() once per process before the first socket
+static bool startWinsock() {
+	static bool started = false;
+	if (!started) {
+		WSADATA data;
+		started = WSAStartup(MAKEWORD(2, 2), &data) == 0;
+	}
+	return started;
+}
+#endif
+
+TcpSocket::TcpSocket() : handle(-1) {
+}
+
+TcpSocket::~TcpSocket() {
+	close();
+}
+
+bool TcpSocket::fail(const string &what) {
+	int code = SOCKET_ERROR_CODE;
+#ifdef _WIN32
+	error = what + " (error " + to_string((long long)code) + ")";
+#else
+	error = what + " (" + strerror(code) + ")";
+#endif
+	close();
+	return false;
+}
+
+bool TcpSocket::isOpen() const {
+	return handle != -1;
+}
+
+void TcpSocket::close() {
+	if (handle == -1)
+		return;
+
+	closeSocket((SOCKET)handle);
+	handle = -1;
+}
+
+// non-blocking, and small writes go out at once instead of waiting for more (we batch ourselves)
+void TcpSocket::configure() {
+#ifdef _WIN32
+	u_long on = 1;
+	ioctlsocket((SOCKET)handle, FIONBIO, &on);
+#else
+	fcntl((int)handle, F_SETFL, fcntl((int)handle, F_GETFL, 0) | O_NONBLOCK);
+#endif
+	int noDelay = 1;
+	setsockopt((SOCKET)handle, IPPROTO_TCP, TCP_NODELAY, (const char *)&noDelay, sizeof(noDelay));
+}
+
+bool TcpSocket::listen(int port, bool loopbackOnly) {
+	close();
+	error.clear();
+#ifdef _WIN32
+	if (!startWinsock()) return fail("Could not start Winsock");
+#endif
+	SOCKET s = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+	if (s == INVALID_SOCKET) return fail("Could not create a socket");
+	handle = (intptr_t)s;
+	int reuse = 1;
+	setsockopt(s, SOL_SOCKET, SO_REUSEADDR, (const char *)&reuse, sizeof(reuse));
+
+	sockaddr_in address;
+	memset(&address, 0, sizeof(address));
+	address.sin_family = AF_INET;
+	address.sin_port = htons((unsigned short)port);
+	address.sin_addr.s_addr = htonl(loopbackOnly ? INADDR_LOOPBACK : INADDR_ANY);
+	if (::bind(s, (sockaddr *)&address, sizeof(address)) != 0) return fail("Could not bind port " + to_string((long long)port));
+	if (::listen(s, SOMAXCONN) != 0) return fail("Could not listen on port " + to_string((long long)port));
+	configure();
+	return true;
+}
+
+bool TcpSocket::accept(TcpSocket &connection) {
+	if (handle == -1)
+		return false;
+
+	SOCKET s = ::accept((SOCKET)handle, NULL, NULL);
+	if (s == INVALID_SOCKET) return false;
+	connection.close();
+	connection.error.clear();
+	connection.handle = (intptr_t)s;
+	connection.configure();
+	return true;
+}
+
+bool TcpSocket::connect(const string &host, int port, double timeOut) {
+	close();
+	error.clear();
+#ifdef _WIN32
+	if (!startWinsock()) return fail("Could not start Winsock");
+#endif
+	addrinfo hints, *found = NULL;
+	memset(&hints, 0, sizeof(hints));
+	hints.ai_family = AF_INET;
+	hints.ai_socktype = SOCK_STREAM;
+	if (getaddrinfo(host.c_str(), to_string((long long)port).c_str(), &hints, &found) != 0 || found == NULL) {
+		error = "Could not find " + host;
+		return false;
+	}
+	SOCKET s = socket(found->ai_family, found->ai_socktype, found->ai_protocol);
+	if (s == INVALID_SOCKET) {
+		freeaddrinfo(found);
+		return fail("Could not create a socket");
+	}
+	handle = (intptr_t)s;
+	configure();
+
+	// non-blocking connect, then wait for it to complete (writable) or fail
+	int result = ::connect(s, found->ai_addr, (socklen_t)found->ai_addrlen);
+	freeaddrinfo(found);
+	string where = host + ":" + to_string((long long)port);
+	if (result != 0) {
+		if (!IN_PROGRESS(SOCKET_ERROR_CODE)) return fail("Could not connect to " + where);
+		TcpSocket *self = this;
+		bool want = true, readable, writable;
+		if (wait(&self, &want, 1, timeOut, &readable, &writable) <= 0 || !writable) {
+			error = "Timed out connecting to " + where;
+			close();
+			return false;
+		}
+		int code = 0;
+		socklen_t length = sizeof(code);
+		getsockopt(s, SOL_SOCKET, SO_ERROR, (char *)&code, &length);
+		if (code != 0) {
+#ifdef _WIN32
+			WSASetLastError(code);
+#else
+			errno = code;
+#endif
+			return fail("Could not connect to " + where);
+		}
+	}
+	return true;
+}
+
+int TcpSocket::send(const void *data, size_t bytes) {
+	if (handle == -1)
+		return -1;
+
+	int sent = ::send((SOCKET)handle, (const char *)data, (int)(bytes > 0x40000000 ? 0x40000000 : bytes), 0
+#ifdef MSG_NOSIGNAL
+		| MSG_NOSIGNAL		// a vanished client is an error return, not SIGPIPE
+#endif
+		);
+	if (sent >= 0) return sent;
+	if (WOULD_BLOCK(SOCKET_ERROR_CODE)) return 0;
+	fail("Connection lost");
+	return -1;
+}
+
+int TcpSocket::receive(void *data, size_t bytes) {
+	if (handle == -1)
+		return -1;
+
+	int received = ::recv((SOCKET)handle, (char *)data, (int)(bytes > 0x40000000 ? 0x40000000 : bytes), 0);
+	if (received > 0) return received;
+	if (received == 0) {
+		error = "Connection closed";
+		close();
+		return -1;
+	}
+	if (WOULD_BLOCK(SOCKET_ERROR_CODE)) return 0;
+	fail("Connection lost");
+	return -1;
+}
+
+int TcpSocket::wait(TcpSocket *const *sockets, const bool *wantWrite, int count, double timeOut, bool *readable, bool *writable) {
+	fd_set readSet, writeSet;
+	FD_ZERO(&readSet);
+	FD_ZERO(&writeSet);
+	SOCKET highest = 0;
+	for (int i = 0; i < count; i++) {
+		readable[i] = writable[i] = false;
+		if (sockets[i] == NULL || sockets[i]->handle == -1) continue;
+		SOCKET s = (SOCKET)sockets[i]->handle;
+		FD_SET(s, &readSet);
+		if (wantWrite != NULL && wantWrite[i]) FD_SET(s, &writeSet);
+		if (s > highest) highest = s;
+	}
+	timeval limit;
+	limit.tv_sec = (long)timeOut;
+	limit.tv_usec = (long)((timeOut - limit.tv_sec) * 1e6);
+	int ready = select((int)highest + 1, &readSet, &writeSet, NULL, &limit);
+	if (ready <= 0) return ready;
+	for (int i = 0; i < count; i++) {
+		if (sockets[i] == NULL || sockets[i]->handle == -1) continue;
+		SOCKET s = (SOCKET)sockets[i]->handle;
+		readable[i] = FD_ISSET(s, &readSet) != 0;
+		writable[i] = FD_ISSET(s, &writeSet) != 0;
+	}
+	return ready;
+}
+
+int TcpSocket::port() const {
+	sockaddr_in address;
+	socklen_t length = sizeof(address);
+	if (handle == -1 || getsockname((SOCKET)handle, (sockaddr *)&address, &length) != 0) return 0;
+	return ntohs(address.sin_port);
+}
+
+string TcpSocket::peer() const {
+	sockaddr_in address;
+	socklen_t length = sizeof(address);
+	if (handle == -1 || getpeername((SOCKET)handle, (sockaddr *)&address, &length) != 0) return "";
+	char text[64];
+	unsigned long ip = ntohl(address.sin_addr.s_addr);
+	snprintf(text, sizeof(text), "%lu.%lu.%lu.%lu:%d", (ip >> 24) & 255, (ip >> 16) & 255, (ip >> 8) & 255, ip & 255, ntohs(address.sin_port));
+	return text;
+}
@@ -0,0 +1,58 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2023  Neuro Software Developers, Inc.
+//
+// Contact Information:
+//
+// Email:
+// info@neurosoftware.com
+//
+// Website:
+// www.neurosoftware.com
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <string>
+#include <stdint.h>
+#include <stddef.h>
+
+// Thin TCP socket wrapper over Winsock / BSD sockets, non-blocking once connected. send() and receive() never
+// wait: they move what the kernel takes or has and return 0 when that is nothing; wait() is where a thread sleeps.
+class TcpSocket {
+public:
+	TcpSocket();
+	~TcpSocket();
+
+	// listens on port, on every interface or only on 127.0.0.1
+	bool listen(int port, bool loopbackOnly);
+	// the next pending connection of a listening socket; false if there is none
+	bool accept(TcpSocket &connection);
+	// host name or address, gives up after timeOut seconds
+	bool connect(const std::string &host, int port, double timeOut);
+	void close();
+	bool isOpen() const;
+
+	// bytes moved, 0 if the kernel's buffer is full (send) or empty (receive), -1 once the connection is gone
+	int send(const void *data, size_t bytes);
+	int receive(void *data, size_t bytes);
+
+	// waits up to timeOut seconds until one of the sockets can be read (or written, where wantWrite is set);
+	// readable and writable say which, the return value how many are ready (0 on timeout, -1 on error)
+	static int wait(TcpSocket *const *sockets, const bool *wantWrite, int count, double timeOut, bool *readable, bool *writable);
+
+	int port() const;			// the local port, useful after listen(0, ...)
+	std::string peer() const;	// address:port of the other end
+	const std::string &errorString() const { return error; }
+
+private:
+	TcpSocket(const TcpSocket &);
+	TcpSocket &operator=(const TcpSocket &);
+
+	bool fail(const std::string &what);
+	void configure();
+
+	std::string error;
+	intptr_t handle;			// SOCKET or file descriptor, -1 when closed
+};
@@ -0,0 +1,265 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2023  Neuro Software Developers, Inc.
+//
+// Contact Information:
+//
+// Email:
+// info@neurosoftware.com
+//
+// Website:
+// www.neurosoftware.com
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "Spectrum.h"
+#include <math.h>
+#include <string.h>
+
+using namespace std;
+
+#define QUEUE_SECONDS 1				// per worker, how far it may fall behind before blocks are dropped
+#define WORKER_BLOCK_FRAMES 4096	// frames popped at a time
+#define WORKER_IDLE_MILLISECONDS 2
+#define WATERFALL_ROWS 2048
+#define FLOOR_DB -200.0f
+
+static float toDb(float power) {
+	float db = 10.0f * log10f(power + 1e-20f);
+	return db > FLOOR_DB ? db : FLOOR_DB;
+}
+
+SpectrumAnalyzer::SpectrumAnalyzer() : channelCount(0), rate(0), hop(0), emitEvery(1), windowSum(1), waterfallWritten(0) {
+	keepRunning = false;
+	dropped = 0;
+	published = 0;
+}
+
+SpectrumAnalyzer::~SpectrumAnalyzer() {
+	stop();
+}
+
+bool SpectrumAnalyzer::start(const SpectrumSettings &settings, int numChannels, double sampleRate, const ChannelScaling *channelScaling) {
+	stop();
+	if (!plan.create(settings.fftSize) || numChannels < 1 || sampleRate <= 0) {
+		return false;
+	}
+	s = settings;
+	channelCount = numChannels;
+	rate = sampleRate;
+	scaling.assign(channelScaling, channelScaling + numChannels);
+
+	int n = s.fftSize;
+	window.resize(n);
+	windowSum = makeWindow(s.window, n, window.data());
+	hop = (size_t)(n * (1.0 - s.overlap));
+	if (hop < 1) hop = 1;
+	if (hop > (size_t)n) hop = n;
+	double transformsPerSecond = rate / hop;
+	emitEvery = s.publishesPerSecond > 0 && transformsPerSecond > s.publishesPerSecond ? (int)(transformsPerSecond / s.publishesPerSecond) : 1;
+
+	displayDb.assign(numChannels, vector<float>(bins(), FLOOR_DB));
+	peakDb.assign(numChannels, vector<float>(bins(), FLOOR_DB));
+	waterfall.assign((size_t)WATERFALL_ROWS * bins(), FLOOR_DB);
+	waterfallWritten = 0;
+	published = 0;
+	dropped = 0;
+
+	// channel pairs share a transform, pairs are dealt out to the workers
+	int pairs = (numChannels + 1) / 2;
+	unsigned int cores = thread::hardware_concurrency();
+	int threads = cores > 2 ? (int)cores - 1 : 1;  // leave a core for the acquisition and UI threads
+	if (threads > pairs) threads = pairs;
+	for (int t = 0; t < threads; t++) {
+		Worker *worker = new Worker();
+		worker->queue.allocate(numChannels, (size_t)(QUEUE_SECONDS * rate) + WORKER_BLOCK_FRAMES);
+		worker->filled = 0;
+		worker->sinceEmit = 0;
+		worker->frames.resize((size_t)WORKER_BLOCK_FRAMES * numChannels);
+		worker->codes.resize(WORKER_BLOCK_FRAMES);
+		worker->re.resize(n);
+		worker->im.resize(n);
+		worker->zeros.assign(n, 0.0f);
+		worker->spare.resize(bins());
+		for (int pair = t; pair < pairs; pair += threads) {
+			for (int channel = pair * 2; channel < pair * 2 + 2 && channel < numChannels; channel++) {
+				Channel c;
+				c.index = channel;
+				c.samples.assign(n, 0.0f);
+				c.windowed.resize(n);
+				c.power.resize(bins());
+				c.average.assign(bins(), 0.0f);
+				c.peak.assign(bins(), 0.0f);
+				c.rowPeak.assign(bins(), 0.0f);
+				c.db.resize(bins());
+				c.peakDb.resize(bins());
+				c.rowDb.resize(bins());
+				c.averaged = false;
+				worker->channels.push_back(c);
+			}
+		}
+		workers.push_back(worker);
+	}
+
+	keepRunning = true;
+	for (size_t t = 0; t < workers.size(); t++) {
+		workers[t]->thread = thread(&SpectrumAnalyzer::run, this, workers[t]);
+	}
+	return true;
+}
+
+void SpectrumAnalyzer::stop() {
+	keepRunning = false;
+	for (size_t t = 0; t < workers.size(); t++) {
+		if (workers[t]->thread.joinable()) workers[t]->thread.join();
+		delete workers[t];
+	}
+	workers.clear();
+}
+
+void SpectrumAnalyzer::consume(const int16_t *frames, size_t numFrames) {
+	if (!keepRunning) return;
+	size_t lost = 0;
+	for (size_t t = 0; t < workers.size(); t++) {
+		size_t pushed = workers[t]->queue.push(frames, numFrames);
+		if (numFrames - pushed > lost) lost = numFrames - pushed;
+	}
+	dropped += lost;
+}
+
+void SpectrumAnalyzer::run(Worker *worker) {
+	size_t n = s.fftSize;
+	while (keepRunning) {
+		size_t want = n - worker->filled;
+		if (want > WORKER_BLOCK_FRAMES) want = WORKER_BLOCK_FRAMES;
+		size_t got = worker->queue.pop(worker->frames.data(), want);
+		if (got == 0) {
+			this_thread::sleep_for(chrono::milliseconds(WORKER_IDLE_MILLISECONDS));
+			continue;
+		}
+
+		// pick this worker's channels out of the interleaved frames, in volts
+		for (size_t i = 0; i < worker->channels.size(); i++) {
+			Channel &c = worker->channels[i];
+			const int16_t *in = worker->frames.data() + c.index;
+			for (size_t f = 0; f < got; f++) {
+				worker->codes[f] = in[f * channelCount];
+			}
+			scaleToVolts(worker->codes.data(), got, scaling[c.index], &c.samples[worker->filled]);
+		}
+		worker->filled += got;
+
+		if (worker->filled == n) {
+			transform(*worker);
+			// keep the overlap for the next transform
+			for (size_t i = 0; i < worker->channels.size(); i++) {
+				Channel &c = worker->channels[i];
+				memmove(c.samples.data(), c.samples.data() + hop, (n - hop) * sizeof(float));
+			}
+			worker->filled = n - hop;
+		}
+	}
+}
+
+void SpectrumAnalyzer::transform(Worker &worker) {
+	int n = s.fftSize;
+	int numBins = bins();
+	for (size_t i = 0; i < worker.channels.size(); i++) {
+		Channel &c = worker.channels[i];
+		for (int k = 0; k < n; k++) {
+			c.windowed[k] = c.samples[k] * window[k];
+		}
+	}
+	for (size_t i = 0; i < worker.channels.size(); i += 2) {
+		Channel &a = worker.channels[i];
+		Channel *b = i + 1 < worker.channels.size() ? &worker.channels[i + 1] : NULL;
+		plan.realPairPower(a.windowed.data(), b ? b->windowed.data() : worker.zeros.data(), worker.re.data(), worker.im.data(),
+			a.power.data(), b ? b->power.data() : worker.spare.data());
+	}
+
+	// a tone of amplitude A comes out of the transform as A * windowSum / 2
+	float norm = (float)(4.0 / (windowSum * windowSum));
+	float alpha = s.averaging == AVERAGE_NONE || s.averages <= 1 ? 1.0f : 1.0f / s.averages;
+	for (size_t i = 0; i < worker.channels.size(); i++) {
+		Channel &c = worker.channels[i];
+		float a = c.averaged ? alpha : 1.0f;
+		for (int k = 0; k < numBins; k++) {
+			float p = c.power[k] * norm;
+			float shown;
+			if (s.averaging == AVERAGE_LINEAR) {
+				c.average[k] += (sqrtf(p) - c.average[k]) * a;
+				shown = c.average[k] * c.average[k];
+			}
+			else {
+				c.average[k] += (p - c.average[k]) * a;
+				shown = c.average[k];
+			}
+			if (shown > c.peak[k]) c.peak[k] = shown;
+			if (shown > c.rowPeak[k]) c.rowPeak[k] = shown;
+		}
+		c.averaged = true;
+	}
+
+	if (++worker.sinceEmit >= emitEvery) {
+		worker.sinceEmit = 0;
+		emit(worker);
+	}
+}
+
+// converts the worker's spectra to dB and hands them to the UI
+void SpectrumAnalyzer::emit(Worker &worker) {
+	int numBins = bins();
+	for (size_t i = 0; i < worker.channels.size(); i++) {
+		Channel &c = worker.channels[i];
+		for (int k = 0; k < numBins; k++) {
+			float shown = s.averaging == AVERAGE_LINEAR ? c.average[k] * c.average[k] : c.average[k];
+			c.db[k] = toDb(shown);
+		}
+		if (s.peakHold) {
+			for (int k = 0; k < numBins; k++) c.peakDb[k] = toDb(c.peak[k]);
+		}
+		if (c.index == s.waterfallChannel) {
+			// the loudest of everything since the last row, so a burst between rows still shows
+			for (int k = 0; k < numBins; k++) {
+				c.rowDb[k] = toDb(c.rowPeak[k]);
+				c.rowPeak[k] = 0;
+			}
+		}
+	}
+
+	lock_guard<mutex> guard(lock);
+	for (size_t i = 0; i < worker.channels.size(); i++) {
+		Channel &c = worker.channels[i];
+		displayDb[c.index] = c.db;
+		if (s.peakHold) peakDb[c.index] = c.peakDb;
+		if (c.index == s.waterfallChannel) {
+			memcpy(&waterfall[(size_t)(waterfallWritten % WATERFALL_ROWS) * numBins], c.rowDb.data(), numBins * sizeof(float));
+			waterfallWritten++;
+		}
+	}
+	published++;
+}
+
+bool SpectrumAnalyzer::spectrum(int channel, vector<float> &db, vector<float> *peak) const {
+	lock_guard<mutex> guard(lock);
+	if (channel < 0 || channel >= (int)displayDb.size()) return false;
+	db = displayDb[channel];
+	if (peak != NULL) *peak = peakDb[channel];
+	return true;
+}
+
+size_t SpectrumAnalyzer::waterfallRows(uint64_t *cursor, vector<float> &rows, size_t maxRows) const {
+	lock_guard<mutex> guard(lock);
+	int numBins = bins();
+	uint64_t first = *cursor;
+	if (first > waterfallWritten) first = waterfallWritten;  // restarted
+	if (waterfallWritten - first > maxRows) first = waterfallWritten - maxRows;
+	if (waterfallWritten - first > WATERFALL_ROWS) first = waterfallWritten - WATERFALL_ROWS;
+	size_t count = (size_t)(waterfallWritten - first);
+	rows.resize(count * numBins);
+	for (size_t r = 0; r < count; r++) {
+		memcpy(&rows[r * numBins], &waterfall[(size_t)((first + r) % WATERFALL_ROWS) * numBins], numBins * sizeof(float));
+	}
+	*cursor = waterfallWritten;
+	return count;
+}
@@ -0,0 +1,122 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2023  Neuro Software Developers, Inc.
+//
+// Contact Information:
+//
+// Email:
+// info@neurosoftware.com
+//
+// Website:
+// www.neurosoftware.com
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <vector>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include "AcquisitionEngine.h"
+#include "SampleRing.h"
+#include "Scaling.h"
+#include "Fft.h"
+
+enum SpectrumAveraging {
+	AVERAGE_NONE,
+	AVERAGE_LINEAR,		// of the magnitudes: steady tones keep their level, noise gets smoother
+	AVERAGE_POWER		// of the squared magnitudes (RMS): the noise floor settles at its true power
+};
+
+struct SpectrumSettings {
+	int fftSize;
+	FftWindow window;
+	double overlap;				// 0..1, fraction of each transform shared with the previous one
+	SpectrumAveraging averaging;
+	int averages;				// exponential averaging over about this many spectra
+	bool peakHold;
+	int waterfallChannel;		// the channel whose spectra also go into the spectrogram
+	double publishesPerSecond;	// how often the display spectra are refreshed, and spectrogram rows added
+
+	SpectrumSettings() : fftSize(4096), window(WINDOW_HANN), overlap(0.5), averaging(AVERAGE_POWER), averages(8),
+		peakHold(false), waterfallChannel(0), publishesPerSecond(60) {}
+};
+
+// Streaming spectrum analyzer. consume() runs on the acquisition thread and only copies the block into the
+// queue of every worker thread; each worker owns a pair of channels (transformed together by one complex FFT)
+// so 8 channels at the full sample rate are spread over up to 4 cores. The workers keep the averaged and peak
+// held spectra of their channels and publish them, in dB volts peak, a few dozen times a second for the UI.
+class SpectrumAnalyzer : public BlockSink {
+public:
+	SpectrumAnalyzer();
+	~SpectrumAnalyzer();
+
+	// starts the workers for numChannels channels of the given rate; false if fftSize isn't a power of two
+	bool start(const SpectrumSettings &settings, int numChannels, double sampleRate, const ChannelScaling *scaling);
+	void stop();
+	bool running() const { return !workers.empty(); }
+	const SpectrumSettings &settings() const { return s; }
+
+	void consume(const int16_t *frames, size_t numFrames);
+
+	int bins() const { return s.fftSize / 2 + 1; }
+	double binHz() const { return rate / s.fftSize; }
+	uint64_t version() const { return published; }	// goes up every time new spectra were published
+	uint64_t droppedFrames() const { return dropped; }
+
+	// the latest spectrum of channel (and its peak hold), bins() values from 0 Hz to half the sample rate
+	bool spectrum(int channel, std::vector<float> &db, std::vector<float> *peakDb) const;
+	// spectrogram rows newer than *cursor, oldest first, bins() values each; advances *cursor, returns the count
+	size_t waterfallRows(uint64_t *cursor, std::vector<float> &rows, size_t maxRows) const;
+
+private:
+	struct Channel {
+		int index;
+		std::vector<float> samples;		// the next transform's input, filled up to Worker::filled
+		std::vector<float> windowed;
+		std::vector<float> power;		// of the latest transform
+		std::vector<float> average;		// magnitude or power, by averaging mode
+		std::vector<float> peak;		// power
+		std::vector<float> rowPeak;		// power, highest since the last spectrogram row
+		std::vector<float> db, peakDb, rowDb;	// converted outside the lock, then published
+		bool averaged;
+	};
+	struct Worker {
+		SampleRing<int16_t> queue;
+		std::vector<Channel> channels;
+		std::thread thread;
+		size_t filled;
+		int sinceEmit;
+		std::vector<int16_t> frames;
+		std::vector<int16_t> codes;
+		std::vector<float> re, im;
+		std::vector<float> zeros;		// the partner of an odd channel out
+		std::vector<float> spare;
+	};
+
+	void run(Worker *worker);
+	void transform(Worker &worker);
+	void emit(Worker &worker);
+
+	SpectrumSettings s;
+	int channelCount;
+	double rate;
+	size_t hop;
+	int emitEvery;			// transforms between publishes
+	FftPlan plan;
+	std::vector<float> window;
+	double windowSum;
+	std::vector<ChannelScaling> scaling;
+	std::vector<Worker *> workers;
+	std::atomic<bool> keepRunning;
+	std::atomic<uint64_t> dropped;
+
+	// what the UI reads
+	mutable std::mutex lock;
+	std::vector<std::vector<float> > displayDb;		// per channel
+	std::vector<std::vector<float> > peakDb;
+	std::vector<float> waterfall;					// ring of rows, bins() each
+	uint64_t waterfallWritten;						// rows ever added
+	std::atomic<uint64_t> published;
+};
@@ -0,0 +1,185 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2023  Neuro Software Developers, Inc.
+//
+// Contact Information:
+//
+// Email:
+// info@neurosoftware.com
+//
+// Website:
+// www.neurosoftware.com
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "StreamClient.h"
+#include "SampleCodec.h"
+#include <chrono>
+#include <string.h>
+
+using namespace std;
+
+#define RECEIVE_CHUNK (256 * 1024)
+
+StreamClient::StreamClient() : inboxUsed(0), received(0) {
+	memset(&hello, 0, sizeof(hello));
+	memset(&block, 0, sizeof(block));
+	memset(&envelope, 0, sizeof(envelope));
+}
+
+bool StreamClient::fail(const string &what) {
+	error = what;
+	socket.close();
+	return false;
+}
+
+bool StreamClient::connect(const string &host, int port, double timeOut) {
+	close();
+	error.clear();
+	if (!socket.connect(host, port, timeOut)) return fail(socket.errorString());
+	int type = receive(timeOut);
+	if (type != STREAM_HELLO) return fail(type < 0 ? error : host + " did not greet like a scope.");
+	return true;
+}
+
+void StreamClient::close() {
+	socket.close();
+	inbox.clear();
+	inboxUsed = 0;
+	memset(&hello, 0, sizeof(hello));
+	channels.clear();
+}
+
+bool StreamClient::subscribe(int mode, int encoding, int columns, double sweepSeconds) {
+	StreamMessage message = { STREAM_SUBSCRIBE, sizeof(StreamSubscribe) };
+	StreamSubscribe subscription;
+	memset(&subscription, 0, sizeof(subscription));
+	subscription.mode = mode;
+	subscription.encoding = encoding;
+	subscription.columns = columns;
+	subscription.sweepSeconds = sweepSeconds;
+	uint8_t bytes[sizeof(message) + sizeof(subscription)];
+	memcpy(bytes, &message, sizeof(message));
+	memcpy(bytes + sizeof(message), &subscription, sizeof(subscription));
+
+	// tiny, the kernel takes it at once unless the connection is gone
+	size_t sent = 0;
+	chrono::steady_clock::time_point began = chrono::steady_clock::now();
+	while (sent < sizeof(bytes)) {
+		int count = socket.send(bytes + sent, sizeof(bytes) - sent);
+		if (count < 0) return fail(socket.errorString());
+		sent += count;
+		if (chrono::steady_clock::now() - began > chrono::seconds(5)) return fail("Timed out subscribing.");
+	}
+	return true;
+}
+
+string StreamClient::device() const {
+	return string(hello.device, strnlen(hello.device, sizeof(hello.device)));
+}
+
+ChannelScaling StreamClient::scaling(int index) const {
+	ChannelScaling scaling;
+	memcpy(scaling.coefficients, channels[index].coefficients, sizeof(scaling.coefficients));
+	return scaling;
+}
+
+// the next whole message in the inbox: its type, 0 if it isn't all there yet, -1 if it makes no sense
+int StreamClient::parse() {
+	size_t waiting = inbox.size() - inboxUsed;
+	if (waiting < sizeof(StreamMessage))
+		return 0;
+
+	StreamMessage message;
+	memcpy(&message, &inbox[inboxUsed], sizeof(message));
+	if (message.bytes > STREAM_MAX_MESSAGE) return fail("The stream is garbled."), -1;
+	if (waiting < sizeof(message) + message.bytes)
+		return 0;
+
+	const uint8_t *payload = &inbox[inboxUsed + sizeof(message)];
+	inboxUsed += sizeof(message) + message.bytes;
+	switch (message.type) {
+	case STREAM_HELLO: {
+		StreamHello greeting;
+		if (message.bytes < sizeof(greeting)) return fail("The stream is garbled."), -1;
+		memcpy(&greeting, payload, sizeof(greeting));
+		if (memcmp(greeting.magic, STREAM_MAGIC, sizeof(greeting.magic)) != 0 || greeting.version != STREAM_VERSION) {
+			return fail("The server speaks another version of the stream protocol."), -1;
+		}
+		if (message.bytes != sizeof(greeting) + greeting.numChannels * sizeof(StreamChannel)) return fail("The stream is garbled."), -1;
+		hello = greeting;
+		channels.resize(greeting.numChannels);
+		if (!channels.empty()) memcpy(channels.data(), payload + sizeof(greeting), channels.size() * sizeof(StreamChannel));
+		return STREAM_HELLO;
+	}
+	case STREAM_BLOCK: {
+		if (message.bytes < sizeof(block)) return fail("The stream is garbled."), -1;
+		memcpy(&block, payload, sizeof(block));
+		size_t bytes = message.bytes - sizeof(block);
+		size_t samples = (size_t)block.numFrames * hello.numChannels;
+		// checked before anything is allocated for the frames: raw ones must be the payload, packed ones no more
+		// than the server ever puts in a block
+		if (block.encoding == STREAM_ENCODING_RAW ? bytes != samples * sizeof(int16_t) :
+			block.encoding != STREAM_ENCODING_PACKED || block.numFrames > maxStreamBlockFrames(hello.numChannels)) {
+			return fail("The stream is garbled."), -1;
+		}
+		decoded.resize(samples);
+		bool valid = true;
+		if (block.encoding == STREAM_ENCODING_PACKED) {
+			valid = unpackFrames(payload + sizeof(block), bytes, block.numFrames, hello.numChannels, decoded.data());
+		}
+		else if (bytes > 0) {
+			memcpy(decoded.data(), payload + sizeof(block), bytes);
+		}
+		if (!valid) return fail("The stream is garbled."), -1;
+		return STREAM_BLOCK;
+	}
+	case STREAM_ENVELOPE: {
+		if (message.bytes < sizeof(envelope)) return fail("The stream is garbled."), -1;
+		memcpy(&envelope, payload, sizeof(envelope));
+		size_t samples = (size_t)envelope.numColumns * hello.numChannels * 2;
+		if (message.bytes - sizeof(envelope) != samples * sizeof(int16_t)) return fail("The stream is garbled."), -1;
+		envelopeColumns.resize(samples);
+		if (samples > 0) memcpy(envelopeColumns.data(), payload + sizeof(envelope), samples * sizeof(int16_t));
+		return STREAM_ENVELOPE;
+	}
+	default:
+		return parse();  // from a newer server, skip it
+	}
+}
+
+int StreamClient::receive(double timeOut) {
+	chrono::steady_clock::time_point deadline = chrono::steady_clock::now() + chrono::microseconds((int64_t)(timeOut * 1e6));
+	for (;;) {
+		int type = parse();
+		if (type != 0) return type;
+		if (!socket.isOpen()) {
+			if (error.empty()) error = socket.errorString();
+			return -1;
+		}
+
+		// drop what was parsed before reading more
+		if (inboxUsed > 0) {
+			inbox.erase(inbox.begin(), inbox.begin() + inboxUsed);
+			inboxUsed = 0;
+		}
+		size_t had = inbox.size();
+		inbox.resize(had + RECEIVE_CHUNK);
+		int count = socket.receive(inbox.data() + had, RECEIVE_CHUNK);
+		inbox.resize(had + (count > 0 ? count : 0));
+		if (count < 0) {
+			error = socket.errorString();
+			return -1;
+		}
+		if (count > 0) {
+			received += count;
+			continue;
+		}
+
+		double left = chrono::duration<double>(deadline - chrono::steady_clock::now()).count();
+		if (left <= 0) return 0;
+		TcpSocket *self = &socket;
+		bool readable, writable;
+		TcpSocket::wait(&self, NULL, 1, left, &readable, &writable);
+	}
+}
@@ -0,0 +1,87 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2023  Neuro Software Developers, Inc.
+//
+// Contact Information:
+//
+// Email:
+// info@neurosoftware.com
+//
+// Website:
+// www.neurosoftware.com
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include "Socket.h"
+#include "StreamFormat.h"
+
+// The viewer's end of a StreamServer connection (see StreamFormat.h): connects, subscribes to every frame or to
+// envelopes for a view of some width, and hands out the messages decoded, one receive() at a time.
+//
+//	StreamClient client;
+//	client.connect("scope-pc", STREAM_DEFAULT_PORT, 5);
+//	client.subscribe(STREAM_MODE_BLOCKS, STREAM_ENCODING_PACKED, 0, 0);
+//	for (;;) {
+//		int type = client.receive(0.1);
+//		if (type == STREAM_BLOCK) ... client.frames(), client.numFrames() frames of client.numChannels() codes ...
+//		else if (type < 0) ... client.errorString(), connect again ...
+//	}
+class StreamClient {
+public:
+	StreamClient();
+
+	// connects and waits for the server's hello
+	bool connect(const std::string &host, int port, double timeOut);
+	void close();
+	bool isOpen() const { return socket.isOpen(); }
+
+	bool subscribe(int mode, int encoding, int columns, double sweepSeconds);
+
+	// waits up to timeOut seconds for the next message: its STREAM_... type, 0 if none came, -1 once the
+	// connection is gone or the server sent something that isn't the protocol
+	int receive(double timeOut);
+
+	// the layout of the newest hello
+	bool live() const { return hello.live != 0; }
+	int numChannels() const { return (int)hello.numChannels; }
+	double sampleRate() const { return hello.sampleRate; }
+	std::string device() const;
+	const StreamChannel &channel(int index) const { return channels[index]; }
+	ChannelScaling scaling(int index) const;
+
+	// the newest block, decoded to interleaved frames of codes
+	const int16_t *frames() const { return decoded.data(); }
+	size_t numFrames() const { return block.numFrames; }
+	const StreamBlock &blockHeader() const { return block; }
+	// the newest envelope: numColumns x numChannels x (min, max)
+	const int16_t *columns() const { return envelopeColumns.data(); }
+	const StreamEnvelope &envelopeHeader() const { return envelope; }
+
+	uint64_t bytesReceived() const { return received; }
+	const std::string &errorString() const { return error; }
+
+private:
+	StreamClient(const StreamClient &);
+	StreamClient &operator=(const StreamClient &);
+
+	bool fail(const std::string &what);
+	int parse();
+
+	TcpSocket socket;
+	std::string error;
+	std::vector<uint8_t> inbox;
+	size_t inboxUsed;				// bytes of inbox already parsed
+	uint64_t received;
+
+	StreamHello hello;
+	std::vector<StreamChannel> channels;
+	StreamBlock block;
+	std::vector<int16_t> decoded;
+	StreamEnvelope envelope;
+	std::vector<int16_t> envelopeColumns;
+};
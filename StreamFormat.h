@@ -0,0 +1,108 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2023  Neuro Software Developers, Inc.
+//
+// Contact Information:
+//
+// Email:
+// info@neurosoftware.com
+//
+// Website:
+// www.neurosoftware.com
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <stdint.h>
+#include "Scaling.h"
+
+/*
+Streaming protocol between the scope (StreamServer) and remote viewers (StreamClient), over TCP, all integers
+little endian. Every message is a StreamMessage header followed by bytes of payload:
+
+	server -> client	STREAM_HELLO		StreamHello + numChannels x StreamChannel, on connect and whenever the
+											layout changes (acquisition restarted with other channels, or stopped)
+	client -> server	STREAM_SUBSCRIBE	StreamSubscribe, nothing but hellos is sent before the first one
+	server -> client	STREAM_BLOCK		StreamBlock + numFrames interleaved frames in the block's encoding
+	server -> client	STREAM_ENVELOPE		StreamEnvelope + numColumns x numChannels x (min, max) int16 codes
+
+Frames are numbered from the hello that announced the layout. The server never lets a slow client hold up the
+others: what a client's connection can't take in time is skipped, the gap shows in firstFrame and droppedFrames.
+Every block decodes on its own, so a gap never corrupts what follows.
+*/
+
+#define STREAM_MAGIC "OSCSTRM"
+#define STREAM_VERSION 1
+#define STREAM_DEFAULT_PORT 7400
+#define STREAM_MAX_MESSAGE (64u << 20)		// readers refuse anything bigger as garbage
+#define STREAM_MAX_BLOCK_BYTES (1u << 20)	// raw bytes of the frames of one block at most
+
+#define STREAM_HELLO 1
+#define STREAM_SUBSCRIBE 2
+#define STREAM_BLOCK 3
+#define STREAM_ENVELOPE 4
+
+#define STREAM_MODE_BLOCKS 0				// every frame
+#define STREAM_MODE_ENVELOPE 1				// per channel min/max of every column of a sweep, for a view of given width
+
+#define STREAM_ENCODING_RAW 0				// interleaved int16 frames
+#define STREAM_ENCODING_PACKED 1			// packFrames(), see SampleCodec.h
+
+struct StreamMessage {
+	uint32_t type;				// STREAM_...
+	uint32_t bytes;				// payload following this header
+};
+
+struct StreamHello {
+	char magic[8];				// STREAM_MAGIC
+	uint32_t version;
+	uint32_t live;				// 0 while the scope isn't acquiring
+	uint32_t numChannels;
+	uint32_t reserved;
+	double sampleRate;			// per channel
+	char device[64];
+};
+
+struct StreamChannel {
+	double coefficients[SCALING_COEFFICIENTS];	// codes -> volts, see ChannelScaling
+	double minVoltage;
+	double maxVoltage;
+};
+
+struct StreamSubscribe {
+	uint32_t mode;				// STREAM_MODE_...
+	uint32_t encoding;			// STREAM_ENCODING_..., for blocks
+	uint32_t columns;			// envelope: the view's width in pixels
+	uint32_t reserved;
+	double sweepSeconds;		// envelope: the time across the view
+};
+
+struct StreamBlock {
+	uint64_t firstFrame;
+	uint64_t droppedFrames;		// skipped for this client so far
+	int64_t acquiredAt;			// when the server got the newest frame, its steady clock in nanoseconds
+	uint32_t numFrames;
+	uint32_t encoding;
+};
+
+struct StreamEnvelope {
+	uint64_t firstFrame;		// of the first column
+	uint64_t droppedFrames;
+	int64_t acquiredAt;
+	uint32_t numColumns;
+	uint32_t framesPerColumn;
+};
+
+// the most frames a block of numChannels carries, never less than one
+inline uint32_t maxStreamBlockFrames(int numChannels) {
+	uint32_t frames = numChannels > 0 ? STREAM_MAX_BLOCK_BYTES / (uint32_t)(numChannels * sizeof(int16_t)) : 0;
+	return frames > 0 ? frames : 1;
+}
+
+static_assert(sizeof(StreamMessage) == 8, "stream message layout changed");
+static_assert(sizeof(StreamHello) == 96, "stream hello layout changed");
+static_assert(sizeof(StreamChannel) == 48, "stream channel layout changed");
+static_assert(sizeof(StreamSubscribe) == 24, "stream subscribe layout changed");
+static_assert(sizeof(StreamBlock) == 32, "stream block layout changed");
+static_assert(sizeof(StreamEnvelope) == 32, "stream envelope layout changed");
@@ -0,0 +1,431 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2023  Neuro Software Developers, Inc.
+//
+// Contact Information:
+//
+// Email:
+// info@neurosoftware.com
+//
+// Website:
+// www.neurosoftware.com
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "StreamServer.h"
+#include "SampleCodec.h"
+#include <string.h>
+#include <math.h>
+
+using namespace std;
+
+#define STREAM_BATCH_MILLISECONDS 5		// how long the network thread lets blocks gather before sending
+#define CLIENT_BUFFER_SECONDS 0.5		// of raw samples a client's connection may fall behind
+#define MIN_CLIENT_BUFFER_BYTES (1 << 20)
+#define STAMPS 1024
+#define MAX_ENVELOPE_COLUMNS 16384		// wider than any screen; a subscription for more is taken for garbage
+#define MAX_SWEEP_SECONDS 3600			// longer sweeps are taken for garbage too
+#define MAX_COLUMN_SECONDS 10			// of samples reduced into one envelope column at most
+
+struct StreamServer::Client {
+	TcpSocket socket;
+	vector<uint8_t> inbox;			// partial messages from the client
+	vector<uint8_t> outbox;			// messages waiting for the kernel to take them
+	size_t outboxSent;
+	bool subscribed;
+	StreamSubscribe subscription;
+	uint64_t dropped;
+
+	// envelope state: the column being reduced and the columns finished in this pass
+	uint32_t framesPerColumn;
+	uint32_t columnFilled;
+	uint64_t nextColumnFrame;		// the first frame of the column being reduced
+	vector<int16_t> runMin, runMax;
+	vector<int16_t> columns;
+
+	Client() : outboxSent(0), subscribed(false), dropped(0), framesPerColumn(1), columnFilled(0), nextColumnFrame(0) {
+		memset(&subscription, 0, sizeof(subscription));
+	}
+};
+
+static int64_t nowNanoseconds() {
+	return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+StreamServer::StreamServer() : listenPort(0), live(false), generation(0), sentGeneration(0), clientBufferBytes(MIN_CLIENT_BUFFER_BYTES),
+	queuedFrames(0), streamFrames(0), newestStamp(0), keepRunning(false), queueDropped(0), bytesSent(0), sendCalls(0), clientDropped(0),
+	numClients(0), rateBytes(0), recentRate(0) {
+	pendingStamp[0] = pendingStamp[1] = -1;
+	stamps.allocate(2, STAMPS);
+}
+
+StreamServer::~StreamServer() {
+	stop();
+}
+
+bool StreamServer::start(int port, bool loopbackOnly) {
+	stop();
+	error.clear();
+	if (!listener.listen(port, loopbackOnly)) {
+		error = listener.errorString();
+		return false;
+	}
+	listenPort = listener.port();
+	bytesSent = 0;
+	sendCalls = 0;
+	clientDropped = 0;
+	queueDropped = 0;
+	rateTime = chrono::steady_clock::now();
+	rateBytes = 0;
+	recentRate = 0;
+	sentGeneration = generation - 1;  // the first pass sends every client a hello
+	keepRunning = true;
+	networkThread = thread(&StreamServer::run, this);
+	return true;
+}
+
+void StreamServer::stop() {
+	keepRunning = false;
+	if (networkThread.joinable()) {
+		networkThread.join();
+	}
+	for (size_t i = 0; i < clients.size(); i++) {
+		delete clients[i];
+	}
+	clients.clear();
+	numClients = 0;
+	listener.close();
+}
+
+void StreamServer::configure(const StreamLayout &newLayout, double queueSeconds) {
+	lock_guard<mutex> hold(layoutLock);
+	layout = newLayout;
+	live = true;
+	int channels = (int)layout.channels.size();
+	size_t frames = (size_t)(layout.sampleRate * queueSeconds);
+	queue.allocate(channels > 0 ? channels : 1, frames > 1024 ? frames : 1024);
+	stamps.reset();
+	queuedFrames = 0;
+	streamFrames = 0;
+	pendingStamp[0] = pendingStamp[1] = -1;
+	newestStamp = 0;
+	double bytes = layout.sampleRate * channels * sizeof(int16_t) * CLIENT_BUFFER_SECONDS;
+	clientBufferBytes = bytes > MIN_CLIENT_BUFFER_BYTES ? (size_t)bytes : MIN_CLIENT_BUFFER_BYTES;
+	generation++;
+}
+
+void StreamServer::idle() {
+	lock_guard<mutex> hold(layoutLock);
+	live = false;
+	generation++;
+}
+
+void StreamServer::consume(const int16_t *frames, size_t numFrames) {
+	size_t pushed = queue.push(frames, numFrames);
+	if (pushed < numFrames) {
+		queueDropped += numFrames - pushed;
+	}
+	if (pushed > 0) {
+		queuedFrames += pushed;
+		int64_t stamp[2] = { (int64_t)queuedFrames, nowNanoseconds() };
+		stamps.push(stamp, 1);
+	}
+}
+
+StreamServerStats StreamServer::stats() const {
+	StreamServerStats s;
+	s.clients = numClients;
+	s.bytesSent = bytesSent;
+	s.sendCalls = sendCalls;
+	s.droppedFrames = clientDropped;
+	s.queueDropped = queueDropped;
+
+	chrono::steady_clock::time_point now = chrono::steady_clock::now();
+	double elapsed = chrono::duration<double>(now - rateTime).count();
+	if (elapsed >= 1.0) {
+		recentRate = (s.bytesSent - rateBytes) / elapsed / 1e6;
+		rateBytes = s.bytesSent;
+		rateTime = now;
+	}
+	s.recentMBps = recentRate;
+	return s;
+}
+
+void StreamServer::run() {
+	TcpSocket *sockets[STREAM_MAX_CLIENTS + 1];
+	bool wantWrite[STREAM_MAX_CLIENTS + 1], readable[STREAM_MAX_CLIENTS + 1], writable[STREAM_MAX_CLIENTS + 1];
+
+	while (keepRunning) {
+		// sleep until a client says something or the kernel takes more, at most a batch interval
+		int count = 0;
+		sockets[count] = &listener;
+		wantWrite[count++] = false;
+		for (size_t i = 0; i < clients.size(); i++) {
+			sockets[count] = &clients[i]->socket;
+			wantWrite[count++] = clients[i]->outbox.size() > clients[i]->outboxSent;
+		}
+		if (TcpSocket::wait(sockets, wantWrite, count, STREAM_BATCH_MILLISECONDS / 1000.0, readable, writable) < 0) {
+			this_thread::sleep_for(chrono::milliseconds(STREAM_BATCH_MILLISECONDS));
+		}
+
+		if (readable[0]) accept();
+		for (size_t i = 0; i + 1 < (size_t)count; i++) {
+			if (readable[i + 1]) receive(*clients[i]);
+		}
+
+		{
+			// everything queued so far goes out as one batch
+			lock_guard<mutex> hold(layoutLock);
+			if (sentGeneration != generation) {
+				sentGeneration = generation;
+				for (size_t i = 0; i < clients.size(); i++) {
+					sendHello(*clients[i]);
+				}
+			}
+			int channels = queue.numChannels();
+			size_t waiting = queue.readable();
+			if (live && channels > 0 && waiting > 0) {
+				batch.resize(waiting * channels);
+				size_t numFrames = queue.pop(batch.data(), waiting);
+				uint64_t drained = streamFrames + numFrames;
+				for (;;) {
+					if (pendingStamp[0] < 0 && stamps.pop(pendingStamp, 1) == 0) break;
+					if ((uint64_t)pendingStamp[0] > drained) break;
+					newestStamp = pendingStamp[1];
+					pendingStamp[0] = -1;
+				}
+				// no bigger than fits an empty outbox, raw or packed, or a client would lose every block for size alone
+				size_t messageFrames = maxStreamBlockFrames(channels);
+				size_t budget = clientBufferBytes - sizeof(StreamMessage) - sizeof(StreamBlock);
+				if (messageFrames > budget / (channels * sizeof(int16_t))) messageFrames = budget / (channels * sizeof(int16_t));
+				while (messageFrames > 1 && packedFramesBound(messageFrames, channels) > budget) messageFrames -= messageFrames / 512 + 1;
+				if (messageFrames < 1) messageFrames = 1;
+				for (size_t start = 0; start < numFrames; start += messageFrames) {
+					size_t blockFrames = numFrames - start < messageFrames ? numFrames - start : messageFrames;
+					publish(batch.data() + start * channels, blockFrames, streamFrames + start, newestStamp);
+				}
+				streamFrames = drained;
+			}
+		}
+
+		// one send per client per pass; a client whose connection broke is let go
+		for (size_t i = 0; i < clients.size(); ) {
+			flush(*clients[i]);
+			if (!clients[i]->socket.isOpen()) {
+				delete clients[i];
+				clients.erase(clients.begin() + i);
+			}
+			else {
+				i++;
+			}
+		}
+		numClients = (int)clients.size();
+	}
+}
+
+void StreamServer::accept() {
+	Client *client = new Client;
+	while (listener.accept(client->socket)) {
+		if (clients.size() >= STREAM_MAX_CLIENTS) {
+			client->socket.close();
+			continue;
+		}
+		{
+			lock_guard<mutex> hold(layoutLock);
+			sendHello(*client);
+		}
+		clients.push_back(client);
+		client = new Client;
+	}
+	delete client;
+	numClients = (int)clients.size();
+}
+
+void StreamServer::receive(Client &client) {
+	uint8_t buffer[4096];
+	int received;
+	while ((received = client.socket.receive(buffer, sizeof(buffer))) > 0) {
+		client.inbox.insert(client.inbox.end(), buffer, buffer + received);
+	}
+
+	// whole messages only; the client has nothing to say but subscriptions
+	size_t used = 0;
+	while (client.inbox.size() - used >= sizeof(StreamMessage)) {
+		StreamMessage message;
+		memcpy(&message, &client.inbox[used], sizeof(message));
+		if (message.bytes > STREAM_MAX_MESSAGE) {
+			client.socket.close();
+			return;
+		}
+		if (client.inbox.size() - used < sizeof(message) + message.bytes) break;
+		if (message.type == STREAM_SUBSCRIBE && message.bytes >= sizeof(StreamSubscribe)) {
+			StreamSubscribe subscription;
+			memcpy(&subscription, &client.inbox[used + sizeof(message)], sizeof(subscription));
+			lock_guard<mutex> hold(layoutLock);
+			subscribe(client, subscription);
+		}
+		used += sizeof(message) + message.bytes;
+	}
+	client.inbox.erase(client.inbox.begin(), client.inbox.begin() + used);
+}
+
+// with layoutLock held
+void StreamServer::subscribe(Client &client, const StreamSubscribe &subscription) {
+	client.subscription = subscription;
+	client.subscribed = true;
+	// the envelope parameters come off the network: a view that can't exist gets every frame instead
+	if (subscription.mode == STREAM_MODE_ENVELOPE && (subscription.columns < 1 || subscription.columns > MAX_ENVELOPE_COLUMNS ||
+		!isfinite(subscription.sweepSeconds) || subscription.sweepSeconds <= 0 || subscription.sweepSeconds > MAX_SWEEP_SECONDS)) {
+		client.subscription.mode = STREAM_MODE_BLOCKS;
+	}
+	int channels = (int)layout.channels.size();
+	double frames = client.subscription.mode == STREAM_MODE_ENVELOPE ? layout.sampleRate * subscription.sweepSeconds / subscription.columns : 1;
+	double most = layout.sampleRate * MAX_COLUMN_SECONDS;
+	if (most > UINT32_MAX) most = UINT32_MAX;
+	if (frames > most) frames = most;
+	client.framesPerColumn = frames > 1 ? (uint32_t)(frames + 0.5 < most ? frames + 0.5 : most) : 1;
+	client.columnFilled = 0;
+	client.nextColumnFrame = streamFrames;
+	client.runMin.assign(channels, 0);
+	client.runMax.assign(channels, 0);
+	client.columns.clear();
+}
+
+// with layoutLock held; a new layout also restarts the client's envelope
+void StreamServer::sendHello(Client &client) {
+	vector<uint8_t> payload(sizeof(StreamHello) + layout.channels.size() * sizeof(StreamChannel));
+	StreamHello hello;
+	memset(&hello, 0, sizeof(hello));
+	memcpy(hello.magic, STREAM_MAGIC, sizeof(hello.magic));
+	hello.version = STREAM_VERSION;
+	hello.live = live ? 1 : 0;
+	hello.numChannels = (uint32_t)layout.channels.size();
+	hello.sampleRate = layout.sampleRate;
+	strncpy(hello.device, layout.device.c_str(), sizeof(hello.device) - 1);
+	memcpy(payload.data(), &hello, sizeof(hello));
+	if (!layout.channels.empty()) {
+		memcpy(payload.data() + sizeof(hello), layout.channels.data(), layout.channels.size() * sizeof(StreamChannel));
+	}
+
+	StreamMessage message = { STREAM_HELLO, (uint32_t)payload.size() };
+	client.outbox.insert(client.outbox.end(), (const uint8_t *)&message, (const uint8_t *)(&message + 1));
+	client.outbox.insert(client.outbox.end(), payload.begin(), payload.end());
+	if (client.subscribed) subscribe(client, client.subscription);
+}
+
+bool StreamServer::queueMessage(Client &client, uint32_t type, const void *header, size_t headerBytes, const void *payload, size_t payloadBytes) {
+	// backpressure: a client that can't keep up loses this message, nobody else waits for it
+	if (client.outbox.size() - client.outboxSent + sizeof(StreamMessage) + headerBytes + payloadBytes > clientBufferBytes)
+		return false;
+
+	StreamMessage message = { type, (uint32_t)(headerBytes + payloadBytes) };
+	client.outbox.insert(client.outbox.end(), (const uint8_t *)&message, (const uint8_t *)(&message + 1));
+	client.outbox.insert(client.outbox.end(), (const uint8_t *)header, (const uint8_t *)header + headerBytes);
+	client.outbox.insert(client.outbox.end(), (const uint8_t *)payload, (const uint8_t *)payload + payloadBytes);
+	return true;
+}
+
+void StreamServer::publish(const int16_t *frames, size_t numFrames, uint64_t firstFrame, int64_t acquiredAt) {
+	int channels = queue.numChannels();
+	size_t packedBytes = 0;		// packed once for all the clients that want it packed
+	for (size_t i = 0; i < clients.size(); i++) {
+		Client &client = *clients[i];
+		if (!client.subscribed) continue;
+		if (client.subscription.mode == STREAM_MODE_ENVELOPE) {
+			publishEnvelope(client, frames, numFrames, firstFrame, acquiredAt);
+			continue;
+		}
+
+		StreamBlock block;
+		block.firstFrame = firstFrame;
+		block.droppedFrames = client.dropped;
+		block.acquiredAt = acquiredAt;
+		block.numFrames = (uint32_t)numFrames;
+		block.encoding = client.subscription.encoding == STREAM_ENCODING_PACKED ? STREAM_ENCODING_PACKED : STREAM_ENCODING_RAW;
+		bool queued;
+		if (block.encoding == STREAM_ENCODING_PACKED) {
+			if (packedBytes == 0) {
+				packed.resize(packedFramesBound(numFrames, channels));
+				packedBytes = packFrames(frames, numFrames, channels, packed.data());
+			}
+			queued = queueMessage(client, STREAM_BLOCK, &block, sizeof(block), packed.data(), packedBytes);
+		}
+		else {
+			queued = queueMessage(client, STREAM_BLOCK, &block, sizeof(block), frames, numFrames * channels * sizeof(int16_t));
+		}
+		if (!queued) {
+			client.dropped += numFrames;
+			clientDropped += numFrames;
+		}
+	}
+}
+
+void StreamServer::publishEnvelope(Client &client, const int16_t *frames, size_t numFrames, uint64_t firstFrame, int64_t acquiredAt) {
+	int channels = queue.numChannels();
+	if ((int)client.runMin.size() != channels) return;
+
+	// frames the client lost to backpressure leave their columns out, the next column starts where we are
+	if (client.nextColumnFrame + client.columnFilled != firstFrame) {
+		client.nextColumnFrame = firstFrame;
+		client.columnFilled = 0;
+	}
+	uint64_t firstColumnFrame = client.nextColumnFrame;
+	client.columns.clear();
+	for (size_t frame = 0; frame < numFrames; frame++) {
+		const int16_t *codes = frames + frame * channels;
+		if (client.columnFilled == 0) {
+			memcpy(client.runMin.data(), codes, channels * sizeof(int16_t));
+			memcpy(client.runMax.data(), codes, channels * sizeof(int16_t));
+		}
+		else {
+			for (int channel = 0; channel < channels; channel++) {
+				if (codes[channel] < client.runMin[channel]) client.runMin[channel] = codes[channel];
+				if (codes[channel] > client.runMax[channel]) client.runMax[channel] = codes[channel];
+			}
+		}
+		if (++client.columnFilled == client.framesPerColumn) {
+			for (int channel = 0; channel < channels; channel++) {
+				client.columns.push_back(client.runMin[channel]);
+				client.columns.push_back(client.runMax[channel]);
+			}
+			client.columnFilled = 0;
+			client.nextColumnFrame += client.framesPerColumn;
+		}
+	}
+	if (client.columns.empty())
+		return;
+
+	StreamEnvelope envelope;
+	envelope.firstFrame = firstColumnFrame;
+	envelope.droppedFrames = client.dropped;
+	envelope.acquiredAt = acquiredAt;
+	envelope.numColumns = (uint32_t)(client.columns.size() / (2 * channels));
+	envelope.framesPerColumn = client.framesPerColumn;
+	if (!queueMessage(client, STREAM_ENVELOPE, &envelope, sizeof(envelope), client.columns.data(), client.columns.size() * sizeof(int16_t))) {
+		uint64_t lost = (uint64_t)envelope.numColumns * envelope.framesPerColumn;
+		client.dropped += lost;
+		clientDropped += lost;
+	}
+}
+
+void StreamServer::flush(Client &client) {
+	size_t waiting = client.outbox.size() - client.outboxSent;
+	if (waiting == 0)
+		return;
+
+	int sent = client.socket.send(client.outbox.data() + client.outboxSent, waiting);
+	sendCalls++;
+	if (sent <= 0)
+		return;
+
+	bytesSent += sent;
+	client.outboxSent += sent;
+	if (client.outboxSent == client.outbox.size()) {
+		client.outbox.clear();
+		client.outboxSent = 0;
+	}
+	else if (client.outboxSent > client.outbox.size() / 2) {
+		client.outbox.erase(client.outbox.begin(), client.outbox.begin() + client.outboxSent);
+		client.outboxSent = 0;
+	}
+}
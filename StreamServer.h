@@ -0,0 +1,120 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2023  Neuro Software Developers, Inc.
+//
+// Contact Information:
+//
+// Email:
+// info@neurosoftware.com
+//
+// Website:
+// www.neurosoftware.com
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <chrono>
+#include "AcquisitionEngine.h"
+#include "SampleRing.h"
+#include "Socket.h"
+#include "StreamFormat.h"
+
+#define STREAM_MAX_CLIENTS 32
+
+// what the clients are told the blocks are
+struct StreamLayout {
+	std::string device;
+	double sampleRate;
+	std::vector<StreamChannel> channels;
+
+	StreamLayout() : sampleRate(0) {}
+};
+
+struct StreamServerStats {
+	int clients;
+	uint64_t bytesSent;
+	uint64_t sendCalls;
+	uint64_t droppedFrames;		// skipped for slow clients, summed over the clients
+	uint64_t queueDropped;		// frames the network thread didn't take from consume() in time
+	double recentMBps;			// over roughly the last second
+};
+
+// Serves the acquired blocks to remote viewers over TCP (see StreamFormat.h): every frame, optionally delta
+// packed, or per channel min/max envelopes at the width of the viewer's window. consume() runs on the acquisition
+// thread and only copies into a lock-free queue. A network thread drains the queue every STREAM_BATCH_MILLISECONDS
+// into one message per client and one send() per client, so the syscalls don't grow with the block rate. Each
+// client has a bounded outgoing buffer; what doesn't fit is skipped for that client alone and the others carry on.
+class StreamServer : public BlockSink {
+public:
+	StreamServer();
+	~StreamServer();
+
+	// listens on port (0 picks a free one, see port()) on every interface, or only 127.0.0.1
+	bool start(int port, bool loopbackOnly);
+	void stop();
+	bool running() const { return networkThread.joinable(); }
+	int port() const { return listenPort; }
+
+	// not while attached: the layout of the blocks consume() will get from now on; the clients get a hello
+	void configure(const StreamLayout &layout, double queueSeconds);
+	void idle();  // acquisition stopped, the clients are told and wait
+
+	void consume(const int16_t *frames, size_t numFrames);
+
+	StreamServerStats stats() const;
+	const std::string &errorString() const { return error; }
+
+private:
+	struct Client;
+
+	void run();
+	void accept();
+	void receive(Client &client);
+	void sendHello(Client &client);
+	void subscribe(Client &client, const StreamSubscribe &subscription);
+	void publish(const int16_t *frames, size_t numFrames, uint64_t firstFrame, int64_t acquiredAt);
+	void publishEnvelope(Client &client, const int16_t *frames, size_t numFrames, uint64_t firstFrame, int64_t acquiredAt);
+	bool queueMessage(Client &client, uint32_t type, const void *header, size_t headerBytes, const void *payload, size_t payloadBytes);
+	void flush(Client &client);
+
+	TcpSocket listener;
+	int listenPort;
+	std::string error;
+	std::vector<Client *> clients;	// network thread only
+
+	// the layout, swapped under layoutLock; the network thread sends hellos when generation moves
+	mutable std::mutex layoutLock;
+	StreamLayout layout;
+	bool live;
+	std::atomic<uint32_t> generation;
+	uint32_t sentGeneration;
+	size_t clientBufferBytes;		// per client limit of what is waiting to be sent
+
+	// consume() -> network thread
+	SampleRing<int16_t> queue;
+	SampleRing<int64_t> stamps;		// per consume(): frames queued in all, when
+	uint64_t queuedFrames;			// acquisition thread
+	uint64_t streamFrames;			// network thread: frames taken from the queue since the layout
+	int64_t pendingStamp[2];
+	int64_t newestStamp;
+	std::vector<int16_t> batch;
+	std::vector<uint8_t> packed;
+
+	std::thread networkThread;
+	std::atomic<bool> keepRunning;
+	std::atomic<uint64_t> queueDropped;
+	std::atomic<uint64_t> bytesSent;
+	std::atomic<uint64_t> sendCalls;
+	std::atomic<uint64_t> clientDropped;
+	std::atomic<int> numClients;
+
+	mutable std::chrono::steady_clock::time_point rateTime;
+	mutable uint64_t rateBytes;
+	mutable double recentRate;
+};
@@ -0,0 +1,159 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2023  Neuro Software Developers, Inc.
+//
+// Contact Information:
+//
+// Email:
+// info@neurosoftware.com
+//
+// Website:
+// www.neurosoftware.com
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Example remote viewer of the scope's stream server: connects to the scope (or Acquire --serve) over TCP, follows
+// every frame or the min/max envelopes of a view of some width, and prints each channel's minimum and maximum in
+// volts once a second with the frames, bytes and drops. Against the scope on the same machine (127.0.0.1) it also
+// prints the sample-to-viewer latency, both ends then read the same steady clock.
+//
+//   StreamViewer [--host 127.0.0.1] [--port 7400] [--raw] [--envelope COLUMNS] [--sweep S] [--seconds S] [--channels N]
+
+#include <string>
+#include <vector>
+#include <chrono>
+#include <thread>
+#include <algorithm>
+#include <stdio.h>
+#include <stdlib.h>
+#include "StreamClient.h"
+#include "Telemetry.h"
+
+using namespace std;
+
+#define CONNECT_SECONDS 5
+
+struct ChannelRange {
+	int minimum;
+	int maximum;
+
+	ChannelRange() : minimum(32767), maximum(-32768) {}
+	void add(int low, int high) {
+		if (low < minimum) minimum = low;
+		if (high > maximum) maximum = high;
+	}
+};
+
+// the server stamps blocks with its steady clock, which is this one only on the same machine
+static double millisecondsSince(int64_t stamp) {
+	return (chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count() - stamp) / 1e6;
+}
+
+int main(int argc, char **argv) {
+	string host = "127.0.0.1";
+	int port = STREAM_DEFAULT_PORT;
+	int encoding = STREAM_ENCODING_PACKED;
+	int columns = 0;
+	double sweep = 1;
+	double seconds = 0;
+	int maxChannels = 8;
+	for (int i = 1; i < argc; i++) {
+		string arg = argv[i];
+		if (arg == "--raw") {
+			encoding = STREAM_ENCODING_RAW;
+			continue;
+		}
+		if (i + 1 >= argc) {
+			fprintf(stderr, "usage: StreamViewer [--host HOST] [--port PORT] [--raw] [--envelope COLUMNS] [--sweep S] [--seconds S] [--channels N]\n");
+			return 2;
+		}
+		if (arg == "--host") host = argv[++i];
+		else if (arg == "--port") port = atoi(argv[++i]);
+		else if (arg == "--envelope") columns = atoi(argv[++i]);
+		else if (arg == "--sweep") sweep = atof(argv[++i]);
+		else if (arg == "--seconds") seconds = atof(argv[++i]);
+		else if (arg == "--channels") maxChannels = atoi(argv[++i]);
+		else {
+			fprintf(stderr, "unknown option %s\n", arg.c_str());
+			return 2;
+		}
+	}
+
+	StreamClient client;
+	chrono::steady_clock::time_point began = chrono::steady_clock::now();
+	chrono::steady_clock::time_point reported = began;
+	vector<ChannelRange> ranges;
+	TimeHistogram latency;
+	uint64_t frames = 0, dropped = 0, reportedBytes = 0;
+	bool waiting = false;
+
+	while (seconds <= 0 || chrono::duration<double>(chrono::steady_clock::now() - began).count() < seconds) {
+		// the scope may not be serving yet, or may have gone away
+		if (!client.isOpen()) {
+			if (!client.connect(host, port, CONNECT_SECONDS) ||
+				!client.subscribe(columns > 0 ? STREAM_MODE_ENVELOPE : STREAM_MODE_BLOCKS, encoding, columns, sweep)) {
+				if (!waiting) printf("waiting for %s:%d: %s\n", host.c_str(), port, client.errorString().c_str());
+				waiting = true;
+				this_thread::sleep_for(chrono::milliseconds(500));
+				continue;
+			}
+			waiting = false;
+			reportedBytes = client.bytesReceived();
+		}
+
+		// connect() already took the first hello
+		int type = ranges.empty() ? STREAM_HELLO : client.receive(0.1);
+		int channels = client.numChannels();
+		int shown = min(channels, maxChannels);
+		if (type == STREAM_HELLO) {
+			printf("%s: %d channels at %g Hz, %s\n", client.device().c_str(), channels, client.sampleRate(), client.live() ? "live" : "idle");
+			ranges.assign(shown, ChannelRange());
+		}
+		else if (type == STREAM_BLOCK) {
+			const int16_t *codes = client.frames();
+			for (size_t frame = 0; frame < client.numFrames(); frame++, codes += channels) {
+				for (int channel = 0; channel < shown; channel++) ranges[channel].add(codes[channel], codes[channel]);
+			}
+			frames += client.numFrames();
+			dropped += client.blockHeader().droppedFrames;
+			latency.add(millisecondsSince(client.blockHeader().acquiredAt));
+		}
+		else if (type == STREAM_ENVELOPE) {
+			const StreamEnvelope &envelope = client.envelopeHeader();
+			const int16_t *pairs = client.columns();
+			for (uint32_t column = 0; column < envelope.numColumns; column++, pairs += channels * 2) {
+				for (int channel = 0; channel < shown; channel++) ranges[channel].add(pairs[channel * 2], pairs[channel * 2 + 1]);
+			}
+			frames += (uint64_t)envelope.numColumns * envelope.framesPerColumn;
+			dropped += envelope.droppedFrames;
+			latency.add(millisecondsSince(envelope.acquiredAt));
+		}
+		else if (type < 0) {
+			printf("disconnected: %s\n", client.errorString().c_str());
+			client.close();
+			ranges.clear();
+			continue;
+		}
+
+		chrono::steady_clock::time_point now = chrono::steady_clock::now();
+		double elapsed = chrono::duration<double>(now - reported).count();
+		if (elapsed >= 1) {
+			printf("%.0f frames/s  %.2f MB/s  dropped %llu", frames / elapsed, (client.bytesReceived() - reportedBytes) / elapsed / 1e6,
+				(unsigned long long)dropped);
+			if (latency.total > 0) printf("  latency p50 %.1f p99 %.1f ms", latency.percentile(0.5), latency.percentile(0.99));
+			printf("\n");
+			for (int channel = 0; channel < shown && frames > 0 && channel < (int)ranges.size(); channel++) {
+				ChannelScaling scaling = client.scaling(channel);
+				printf("    ch %d  min %.4f V  max %.4f V\n", channel, scaling.toVolts((int16_t)ranges[channel].minimum),
+					scaling.toVolts((int16_t)ranges[channel].maximum));
+			}
+			fflush(stdout);
+			ranges.assign(shown, ChannelRange());
+			latency.clear();
+			frames = dropped = 0;
+			reportedBytes = client.bytesReceived();
+			reported = now;
+		}
+	}
+	return 0;
+}
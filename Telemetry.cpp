@@ -0,0 +1,296 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2023  Neuro Software Developers, Inc.
+//
+// Contact Information:
+//
+// Email:
+// info@neurosoftware.com
+//
+// Website:
+// www.neurosoftware.com
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "Telemetry.h"
+#include <ctype.h>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+using namespace std;
+
+#define BUCKETS_PER_OCTAVE 4
+#define LOWEST_BOUND (1.0 / 16)		// milliseconds, upper bound of the first bucket
+
+double TimeHistogram::upperBound(int bucket) {
+	if (bucket >= TELEMETRY_BUCKETS - 1) return HUGE_VAL;
+	return LOWEST_BOUND * pow(2.0, (double)bucket / BUCKETS_PER_OCTAVE);
+}
+
+void TimeHistogram::clear() {
+	memset(counts, 0, sizeof(counts));
+	total = 0;
+	maximum = 0;
+}
+
+void TimeHistogram::add(double milliseconds) {
+	int bucket = 0;
+	if (milliseconds > LOWEST_BOUND) {
+		bucket = (int)ceil(log2(milliseconds / LOWEST_BOUND) * BUCKETS_PER_OCTAVE);
+		if (bucket > TELEMETRY_BUCKETS - 1) bucket = TELEMETRY_BUCKETS - 1;
+	}
+	counts[bucket]++;
+	total++;
+	if (milliseconds > maximum) maximum = milliseconds;
+}
+
+double TimeHistogram::percentile(double fraction) const {
+	if (total == 0) return 0;
+	double wanted = fraction * total;
+	double below = 0;
+	for (int bucket = 0; bucket < TELEMETRY_BUCKETS; bucket++) {
+		if (counts[bucket] == 0) continue;
+		if (below + counts[bucket] >= wanted) {
+			double low = bucket > 0 ? upperBound(bucket - 1) : 0;
+			double high = upperBound(bucket);
+			if (high > maximum) high = maximum;
+			if (low > high) low = high;
+			return low + (high - low) * (wanted - below) / counts[bucket];
+		}
+		below += counts[bucket];
+	}
+	return maximum;
+}
+
+TelemetryReport::TelemetryReport() : time(0), seconds(0), reads(0), framesAcquired(0), framesDropped(0), overruns(0), errors(0),
+	readerSinkShare(0), ringFill(0), peakRingFill(0), framesRendered(0), framesSkipped(0) {
+	for (int stage = 0; stage < TELEMETRY_STAGES; stage++) {
+		stageMilliseconds[stage] = 0;
+		stageMaxMilliseconds[stage] = 0;
+	}
+}
+
+Telemetry::Telemetry() : period(1), ringSum(0), ringFrames(0), periods(0), csv(false), logSize(0) {
+	started = periodStart = frameStart = Clock::now();
+	for (int stage = 0; stage < TELEMETRY_STAGES; stage++) {
+		stageSeconds[stage] = 0;
+	}
+}
+
+Telemetry::~Telemetry() {
+	closeLog();
+}
+
+void Telemetry::start(double periodSeconds) {
+	period = periodSeconds > 0 ? periodSeconds : 1;
+	started = periodStart = frameStart = Clock::now();
+	current = TelemetryReport();
+	last = TelemetryReport();
+	previousEngine = EngineCounters();
+	for (int stage = 0; stage < TELEMETRY_STAGES; stage++) {
+		stageSeconds[stage] = 0;
+	}
+	ringSum = 0;
+	ringFrames = 0;
+	periods = 0;
+}
+
+void Telemetry::beginFrame(double ringFill) {
+	frameStart = Clock::now();
+	ringSum += ringFill;
+	ringFrames++;
+	if (ringFill > current.peakRingFill) current.peakRingFill = ringFill;
+}
+
+void Telemetry::lap(TelemetryStage stage, Clock::time_point &mark) {
+	Clock::time_point now = Clock::now();
+	double seconds = chrono::duration<double>(now - mark).count();
+	mark = now;
+	stageSeconds[stage] += seconds;
+	if (seconds * 1000 > current.stageMaxMilliseconds[stage]) current.stageMaxMilliseconds[stage] = seconds * 1000;
+}
+
+void Telemetry::sampleLatency(double seconds) {
+	current.latency.add(seconds * 1000);
+}
+
+void Telemetry::endFrame(bool rendered) {
+	if (rendered) {
+		current.frameTimes.add(chrono::duration<double, milli>(Clock::now() - frameStart).count());
+		current.framesRendered++;
+	} else {
+		current.framesSkipped++;
+	}
+}
+
+bool Telemetry::update(AcquisitionEngine &engine) {
+	Clock::time_point now = Clock::now();
+	double seconds = chrono::duration<double>(now - periodStart).count();
+	if (seconds < period) return false;
+
+	EngineCounters counters = engine.counters();
+	if (counters.reads < previousEngine.reads || counters.framesAcquired < previousEngine.framesAcquired) {
+		previousEngine = EngineCounters();	// the engine was restarted
+	}
+	current.time = chrono::duration<double>(now - started).count();
+	current.seconds = seconds;
+	current.engine = counters;
+	current.reads = counters.reads - previousEngine.reads;
+	current.framesAcquired = counters.framesAcquired - previousEngine.framesAcquired;
+	current.framesDropped = counters.framesDropped - previousEngine.framesDropped;
+	current.overruns = counters.overruns - previousEngine.overruns;
+	current.errors = counters.errors - previousEngine.errors;
+	current.readerSinkShare = (counters.sinkNanoseconds - previousEngine.sinkNanoseconds) / 1e9 / seconds;
+	current.ringFill = ringFrames > 0 ? ringSum / ringFrames : 0;
+	for (int stage = 0; stage < TELEMETRY_STAGES; stage++) {
+		current.stageMilliseconds[stage] = current.framesRendered > 0 ? stageSeconds[stage] * 1000 / current.framesRendered : 0;
+		stageSeconds[stage] = 0;
+	}
+	last = current;
+	periods++;
+	if (log.isOpen()) writeLog();
+
+	previousEngine = counters;
+	current = TelemetryReport();
+	ringSum = 0;
+	ringFrames = 0;
+	periodStart = now;
+	return true;
+}
+
+static const char *stageNames[TELEMETRY_STAGES] = { "drain", "draw", "xy", "compose", "text", "present" };
+
+// the columns of a log line, in order; the stage columns are appended from stageNames
+static const char *fieldNames[] = {
+	"time", "seconds", "reads", "frames_acquired", "frames_dropped", "overruns", "errors", "status",
+	"mean_block", "largest_block", "backend_backlog", "peak_backend_backlog", "reader_sink_share", "ring_fill", "peak_ring_fill",
+	"frames_rendered", "frames_skipped", "frame_p50_ms", "frame_p90_ms", "frame_p99_ms", "frame_max_ms",
+	"latency_frames", "latency_p50_ms", "latency_p90_ms", "latency_p99_ms", "latency_max_ms"
+};
+#define FIXED_FIELDS (int)(sizeof(fieldNames) / sizeof(fieldNames[0]))
+#define ALL_FIELDS (FIXED_FIELDS + 2 * TELEMETRY_STAGES)
+
+int Telemetry::fields(double *values) const {
+	const TelemetryReport &r = last;
+	double fixed[FIXED_FIELDS] = {
+		r.time, r.seconds, (double)r.reads, (double)r.framesAcquired, (double)r.framesDropped, (double)r.overruns, (double)r.errors,
+		(double)r.engine.status, r.reads > 0 ? (double)r.framesAcquired / r.reads : 0, (double)r.engine.largestBlock,
+		(double)r.engine.backendBacklog, (double)r.engine.peakBackendBacklog, r.readerSinkShare, r.ringFill, r.peakRingFill,
+		(double)r.framesRendered, (double)r.framesSkipped, r.frameTimes.percentile(0.5), r.frameTimes.percentile(0.9),
+		r.frameTimes.percentile(0.99), r.frameTimes.maximum, (double)r.latency.total, r.latency.percentile(0.5),
+		r.latency.percentile(0.9), r.latency.percentile(0.99), r.latency.maximum
+	};
+	int count = 0;
+	for (int i = 0; i < FIXED_FIELDS; i++) {
+		values[count++] = fixed[i];
+	}
+	for (int stage = 0; stage < TELEMETRY_STAGES; stage++) {
+		values[count++] = r.stageMilliseconds[stage];
+		values[count++] = r.stageMaxMilliseconds[stage];
+	}
+	return count;
+}
+
+static void fieldName(int field, char *name, size_t size) {
+	if (field < FIXED_FIELDS) {
+		snprintf(name, size, "%s", fieldNames[field]);
+	} else {
+		int stage = (field - FIXED_FIELDS) / 2;
+		snprintf(name, size, (field - FIXED_FIELDS) % 2 == 0 ? "%s_ms" : "%s_max_ms", stageNames[stage]);
+	}
+}
+
+bool Telemetry::openLog(const string &path) {
+	closeLog();
+	error.clear();
+	if (!log.create(path, false)) {
+		error = log.errorString();
+		return false;
+	}
+	size_t dot = path.find_last_of('.');
+	string extension = dot == string::npos ? "" : path.substr(dot + 1);
+	csv = extension.size() == 3 && tolower(extension[0]) == 'c' && tolower(extension[1]) == 's' && tolower(extension[2]) == 'v';
+	logSize = 0;
+
+	if (csv) {
+		size_t length = 0;
+		for (int field = 0; field < ALL_FIELDS; field++) {
+			char name[64];
+			fieldName(field, name, sizeof(name));
+			length += snprintf(line + length, sizeof(line) - length, "%s%s", field > 0 ? "," : "", name);
+		}
+		length += snprintf(line + length, sizeof(line) - length, "\r\n");
+		if (!log.writeAt(logSize, line, length)) {
+			error = log.errorString();
+			log.close();
+			return false;
+		}
+		logSize += length;
+	}
+	return true;
+}
+
+void Telemetry::closeLog() {
+	log.close();
+	error.clear();
+}
+
+void Telemetry::writeLog() {
+	double values[ALL_FIELDS];
+	int count = fields(values);
+	size_t length = 0;
+	if (!csv) length += snprintf(line, sizeof(line), "{");
+	for (int field = 0; field < count; field++) {
+		if (csv) {
+			length += snprintf(line + length, sizeof(line) - length, "%s%.10g", field > 0 ? "," : "", values[field]);
+		} else {
+			char name[64];
+			fieldName(field, name, sizeof(name));
+			length += snprintf(line + length, sizeof(line) - length, "%s\"%s\":%.10g", field > 0 ? "," : "", name, values[field]);
+		}
+	}
+	length += snprintf(line + length, sizeof(line) - length, csv ? "\r\n" : "}\n");
+	if (!log.writeAt(logSize, line, length)) {
+		error = log.errorString();
+		log.close();	// the UI finds out from logging()
+		return;
+	}
+	logSize += length;
+}
+
+int Telemetry::formatLines(char lines[][160], int maxLines) const {
+	const TelemetryReport &r = last;
+	int count = 0;
+	if (count < maxLines) {
+		char backlog[64] = "n/a";
+		if (r.engine.backendBacklog >= 0) {
+			snprintf(backlog, sizeof(backlog), "%lld (peak %lld)", (long long)r.engine.backendBacklog, (long long)r.engine.peakBackendBacklog);
+		}
+		snprintf(lines[count++], 160, "acquired %.0f frames/s in %.0f reads/s, block mean %.0f max %d, backend backlog %s",
+			r.seconds > 0 ? r.framesAcquired / r.seconds : 0, r.seconds > 0 ? r.reads / r.seconds : 0,
+			r.reads > 0 ? (double)r.framesAcquired / r.reads : 0, r.engine.largestBlock, backlog);
+	}
+	if (count < maxLines) {
+		snprintf(lines[count++], 160, "dropped %llu (total %llu), overruns %llu, errors %llu, ring %.0f%% (peak %.0f%%), sinks %.1f%% of reader",
+			(unsigned long long)r.framesDropped, (unsigned long long)r.engine.framesDropped, (unsigned long long)r.overruns,
+			(unsigned long long)r.errors, r.ringFill * 100, r.peakRingFill * 100, r.readerSinkShare * 100);
+	}
+	if (count < maxLines) {
+		snprintf(lines[count++], 160, "frame p50 %.2f p90 %.2f p99 %.2f max %.2f ms, %u rendered, %u skipped",
+			r.frameTimes.percentile(0.5), r.frameTimes.percentile(0.9), r.frameTimes.percentile(0.99), r.frameTimes.maximum,
+			r.framesRendered, r.framesSkipped);
+	}
+	if (count < maxLines) {
+		snprintf(lines[count++], 160, "sample to screen p50 %.1f p90 %.1f p99 %.1f max %.1f ms",
+			r.latency.percentile(0.5), r.latency.percentile(0.9), r.latency.percentile(0.99), r.latency.maximum);
+	}
+	if (count < maxLines) {
+		size_t length = snprintf(lines[count], 160, "ms/frame");
+		for (int stage = 0; stage < TELEMETRY_STAGES && length < 160; stage++) {
+			length += snprintf(lines[count] + length, 160 - length, " %s %.2f", stageNames[stage], r.stageMilliseconds[stage]);
+		}
+		count++;
+	}
+	return count;
+}
@@ -0,0 +1,117 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2023  Neuro Software Developers, Inc.
+//
+// Contact Information:
+//
+// Email:
+// info@neurosoftware.com
+//
+// Website:
+// www.neurosoftware.com
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <chrono>
+#include <string>
+#include <stdint.h>
+#include <stddef.h>
+#include "AcquisitionEngine.h"
+#include "BinaryFile.h"
+
+// where the UI thread's time goes in a frame
+enum TelemetryStage {
+	STAGE_DRAIN,		// ring to history: filters, history, measurements
+	STAGE_DRAW,			// traces, sweeps or spectrum, and the static layers when they change
+	STAGE_XY,			// cartesian plot and persistence
+	STAGE_COMPOSE,
+	STAGE_TEXT,			// overlays drawn by GDI
+	STAGE_PRESENT,		// BitBlt to the window
+	TELEMETRY_STAGES
+};
+
+#define TELEMETRY_BUCKETS 48	// histogram of milliseconds: 4 buckets per octave from 1/16 ms to 181 ms, then one open bucket
+
+// Log-spaced histogram of milliseconds; percentiles are interpolated inside a bucket, so they are good to a few %.
+struct TimeHistogram {
+	uint32_t counts[TELEMETRY_BUCKETS];
+	uint32_t total;
+	double maximum;
+
+	TimeHistogram() { clear(); }
+	void clear();
+	void add(double milliseconds);
+	double percentile(double fraction) const;
+	static double upperBound(int bucket);	// milliseconds, infinite for the last bucket
+};
+
+// one period's worth of telemetry
+struct TelemetryReport {
+	double time;						// seconds since start() at the end of the period
+	double seconds;						// length of the period
+	EngineCounters engine;				// as of the end of the period
+	uint64_t reads, framesAcquired, framesDropped, overruns, errors;	// during the period
+	double readerSinkShare;				// of the period the reader thread spent in the sinks
+	double ringFill, peakRingFill;		// 0..1, at the start of the frames
+	uint32_t framesRendered, framesSkipped;
+	double stageMilliseconds[TELEMETRY_STAGES];	// mean per rendered frame
+	double stageMaxMilliseconds[TELEMETRY_STAGES];
+	TimeHistogram frameTimes;			// rendered frames
+	TimeHistogram latency;				// sample to presented frame, of the frames that showed new samples
+
+	TelemetryReport();
+};
+
+// Acquisition and render telemetry, kept by the UI thread. The frame loop reports how long each stage took, the
+// ring fill it saw and, for frames that showed new samples, how old the newest of them was when the frame was
+// presented; every period the engine's counters are added and the period becomes report(), for the HUD, and a
+// line of the log when one is open: CSV (a header, then a row per period) or, for any other extension, JSON lines.
+class Telemetry {
+public:
+	typedef std::chrono::steady_clock Clock;
+
+	Telemetry();
+	~Telemetry();
+
+	void start(double periodSeconds);	// starts over
+
+	void beginFrame(double ringFill);
+	// adds the time since mark to stage and moves mark on to now
+	void lap(TelemetryStage stage, Clock::time_point &mark);
+	void sampleLatency(double seconds);
+	void endFrame(bool rendered);
+
+	// closes the period if it is over, taking the engine's counters; true when there is a new report()
+	bool update(AcquisitionEngine &engine);
+	const TelemetryReport &report() const { return last; }
+	uint64_t reports() const { return periods; }
+
+	bool openLog(const std::string &path);
+	void closeLog();
+	bool logging() const { return log.isOpen(); }
+	const std::string &errorString() const { return error; }	// why the log stopped on its own
+
+	// one line of text each for the HUD, returns the number written
+	int formatLines(char lines[][160], int maxLines) const;
+
+private:
+	void writeLog();
+	int fields(double *values) const;
+
+	double period;
+	Clock::time_point started, periodStart, frameStart;
+	TelemetryReport current, last;
+	EngineCounters previousEngine;
+	double stageSeconds[TELEMETRY_STAGES];
+	double ringSum;
+	uint32_t ringFrames;
+	uint64_t periods;
+
+	BinaryFile log;
+	bool csv;
+	uint64_t logSize;
+	std::string error;
+	char line[8192];
+};
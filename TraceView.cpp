@@ -0,0 +1,388 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2023  Neuro Software Developers, Inc.
+//
+// Contact Information:
+//
+// Email:
+// info@neurosoftware.com
+//
+// Website:
+// www.neurosoftware.com
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "TraceView.h"
+#include "Decimator.h"
+#include <math.h>
+
+using namespace std;
+
+#define NO_SPAN 0x3FFFFFFF	// top and bottom of a column with nothing in it, clipped away by Raster::columnSpans
+#define COARSE_RUN 64		// samples scanned in one go between the gaps of a sample stride > 1
+#define TILE_MIN_COLUMNS 32	// narrower bands of columns aren't worth a tile of their own
+#define TILES_PER_THREAD 4	// enough tiles for the pool to even out, few enough that each is worth the overhead
+
+TraceView::TraceView() : minV(-10), maxV(10), layout(TRACES_OVERLAID), incremental(true), redrawAll(true), sampleStride(1), pool(NULL), capacity(0), lastWritten(0), lastColumn(-1),
+	bandTop(0), bandBottom(-1), lastColumnsDrawn(0), passHistory(NULL), passLayer(NULL), passFirst(0), passLast(-1), passX0(0), tileBands(1) {
+}
+
+void TraceView::setArea(const RasterRect &area, float minVolts, float maxVolts) {
+	if (area.left != plot.left || area.top != plot.top || area.right != plot.right || area.bottom != plot.bottom ||
+		minVolts != minV || maxVolts != maxV) {
+		plot = area;
+		minV = minVolts;
+		maxV = maxVolts;
+		redrawAll = true;
+	}
+}
+
+// NaN equals NaN here, it stands for "the area's range"
+static bool sameVolts(float a, float b) {
+	return a == b || (a != a && b != b);
+}
+
+void TraceView::setChannels(const int *list, const Pixel *colorList, const ChannelScaling *scalingList, int count,
+	const float *minVolts, const float *maxVolts) {
+	bool same = (int)channels.size() == count;
+	for (int i = 0; same && i < count; i++) {
+		same = channels[i] == list[i] && colors[i] == colorList[i] &&
+			memcmp(scaling[i].coefficients, scalingList[i].coefficients, sizeof(scaling[i].coefficients)) == 0 &&
+			sameVolts(slotMin[i], minVolts != NULL ? minVolts[i] : NAN) && sameVolts(slotMax[i], maxVolts != NULL ? maxVolts[i] : NAN);
+	}
+	if (same) return;
+	channels.assign(list, list + count);
+	colors.assign(colorList, colorList + count);
+	scaling.assign(scalingList, scalingList + count);
+	// NaN stands for the area's range
+	slotMin.assign(count, NAN);
+	slotMax.assign(count, NAN);
+	if (minVolts != NULL && maxVolts != NULL) {
+		slotMin.assign(minVolts, minVolts + count);
+		slotMax.assign(maxVolts, maxVolts + count);
+	}
+	redrawAll = true;
+}
+
+void TraceView::setLayout(TraceLayout newLayout) {
+	if (newLayout != layout) {
+		layout = newLayout;
+		redrawAll = true;
+	}
+}
+
+// where a channel is drawn: the whole plot, or its strip
+RasterRect TraceView::slotArea(int slot) const {
+	if (layout != TRACES_STACKED || channels.size() < 2) return plot;
+	int n = (int)channels.size();
+	int height = plot.bottom - plot.top;
+	return RasterRect(plot.left, plot.top + slot * height / n, plot.right, plot.top + (slot + 1) * height / n);
+}
+
+int TraceView::toY(int slot, float volts) const {
+	if (layout != TRACES_STACKED) {
+		return plot.top + (int)((maxV - volts) / (maxV - minV) * (plot.bottom - plot.top));
+	}
+	RasterRect area = slotArea(slot);
+	float low = slotMin[slot] == slotMin[slot] ? slotMin[slot] : minV;
+	float high = slotMax[slot] == slotMax[slot] ? slotMax[slot] : maxV;
+	return area.top + (int)((high - volts) / (high - low) * (area.bottom - area.top - 1));
+}
+
+// first sample of an absolute column
+uint64_t TraceView::columnStart(int64_t column) const {
+	int width = plot.right - plot.left;
+	return column <= 0 ? 0 : ((uint64_t)column * capacity + width - 1) / width;
+}
+
+void TraceView::clearLayer(Raster &layer) {
+	layer.resetClip();
+	if (bandTop <= bandBottom) {
+		layer.fillRect(plot.left, bandTop, plot.right, bandBottom + 1, PIXEL_TRANSPARENT);
+	}
+	if (!drawn.empty()) {
+		layer.fillRect(drawn.left, drawn.top, drawn.right, drawn.bottom, PIXEL_TRANSPARENT);
+	}
+	bandTop = plot.bottom;
+	bandBottom = plot.top - 1;
+	drawn = RasterRect();
+}
+
+// min and max of every column in [firstColumn, lastColumn] of one channel, into the ring
+void TraceView::envelope(Lane &lane, const HistoryBuffer<int16_t> &history, int slot, int64_t firstColumn, int64_t lastColumn) {
+	int width = plot.right - plot.left;
+	size_t n = (size_t)(lastColumn - firstColumn + 1);
+	if (lane.codeMin.size() < n) {
+		lane.codeMin.resize(n);
+		lane.codeMax.resize(n);
+		lane.voltMin.resize(n);
+		lane.voltMax.resize(n);
+		lane.filled.resize(n);
+	}
+	int16_t *codeMin = lane.codeMin.data();
+	int16_t *codeMax = lane.codeMax.data();
+	float *voltMin = lane.voltMin.data();
+	float *voltMax = lane.voltMax.data();
+	char *filled = lane.filled.data();
+
+	uint64_t oldest = history.oldest();
+	uint64_t written = history.written();
+	int channel = channels[slot];
+	for (size_t i = 0; i < n; i++) {
+		filled[i] = false;
+		int64_t column = firstColumn + (int64_t)i;
+		uint64_t start = column < 0 ? 0 : columnStart(column);
+		uint64_t end = column < 0 ? 0 : columnStart(column + 1);
+		if (start < oldest) start = oldest;
+		if (end > written) end = written;
+		if (end <= start) continue;
+
+		// with a stride every column still gets at least one run, so nothing goes blank, but a short glitch can
+		// fall into a gap
+		int16_t mn = 32767, mx = -32768;
+		for (uint64_t index = start; index < end;) {
+			uint64_t runEnd = end;
+			if (sampleStride > 1 && end - index > COARSE_RUN) runEnd = index + COARSE_RUN;
+			while (index < runEnd) {
+				const int16_t *samples;
+				size_t count = history.span(channel, index, runEnd - index, &samples);
+				int16_t a, b;
+				minMaxRange(samples, count, &a, &b);
+				if (a < mn) mn = a;
+				if (b > mx) mx = b;
+				index += count;
+			}
+			index += (uint64_t)(sampleStride - 1) * COARSE_RUN;
+		}
+		codeMin[i] = mn;
+		codeMax[i] = mx;
+		filled[i] = true;
+	}
+
+	// only the envelope gets scaled, 2 values per column instead of every sample
+	scaleToVolts(codeMin, n, scaling[slot], voltMin);
+	scaleToVolts(codeMax, n, scaling[slot], voltMax);
+
+	float *ringLo = &ringMin[(size_t)slot * width];
+	float *ringHi = &ringMax[(size_t)slot * width];
+	for (size_t i = 0; i < n; i++) {
+		size_t at = (size_t)((firstColumn + (int64_t)i) % width + width) % width;
+		ringLo[at] = filled[i] ? voltMin[i] : NAN;
+		ringHi[at] = filled[i] ? voltMax[i] : NAN;
+	}
+}
+
+void TraceView::EnvelopePass::run(int slot, int worker) {
+	TraceView &v = *view;
+	int width = v.plot.right - v.plot.left;
+	// the column left of the first one redrawn, before envelope() can reuse its slot in the ring
+	size_t previous = (size_t)((v.passFirst - 1) % width + width) % width;
+	v.edgeMin[slot] = v.ringMin[(size_t)slot * width + previous];
+	v.edgeMax[slot] = v.ringMax[(size_t)slot * width + previous];
+	v.envelope(v.lanes[worker], *v.passHistory, slot, v.passFirst, v.passLast);
+}
+
+void TraceView::TilePass::run(int tile, int worker) {
+	view->drawTile(view->lanes[worker], tile);
+}
+
+// spans of every channel in one tile, through a Raster of our own on the layer's pixels so the tiles can be
+// clipped independently
+void TraceView::drawTile(Lane &lane, int tile) {
+	int width = plot.right - plot.left;
+	int count = (int)(passLast - passFirst + 1);
+	int band = tile % tileBands;
+	int begin = (int)((int64_t)count * band / tileBands);	// columns, relative to passFirst
+	int end = (int)((int64_t)count * (band + 1) / tileBands);
+	int firstSlot = 0, lastSlot = (int)channels.size();
+	if (layout == TRACES_STACKED) {
+		firstSlot = tile / tileBands;
+		lastSlot = firstSlot + 1;
+	}
+
+	Raster tileLayer;
+	tileLayer.attach(passLayer->pixels(), passLayer->width(), passLayer->height(), passLayer->stride());
+	int *top = lane.top.data();
+	int *bottom = lane.bottom.data();
+	for (int slot = firstSlot; slot < lastSlot; slot++) {
+		const float *ringLo = &ringMin[(size_t)slot * width];
+		const float *ringHi = &ringMax[(size_t)slot * width];
+		float previousMin = edgeMin[slot], previousMax = edgeMax[slot];
+		if (begin > 0) {
+			size_t at = (size_t)((passFirst + begin - 1) % width + width) % width;
+			previousMin = ringLo[at];
+			previousMax = ringHi[at];
+		}
+
+		RasterRect area = slotArea(slot);
+		tileLayer.setClip(passX0 + begin, area.top, passX0 + end, area.bottom);
+		for (int i = begin; i < end; i++) {
+			size_t at = (size_t)((passFirst + i) % width + width) % width;
+			float lo = ringLo[at], hi = ringHi[at];
+			int j = i - begin;
+			if (lo != lo) {  // NaN: no samples in this column
+				top[j] = bottom[j] = NO_SPAN;
+			}
+			else {
+				// stretch each span to reach the previous column so the trace stays connected
+				float spanLo = previousMax == previousMax && previousMax < lo ? previousMax : lo;
+				float spanHi = previousMin == previousMin && previousMin > hi ? previousMin : hi;
+				top[j] = toY(slot, spanHi);
+				bottom[j] = toY(slot, spanLo);
+				if (top[j] < lane.bandTop) lane.bandTop = top[j] < plot.top ? plot.top : top[j];
+				if (bottom[j] > lane.bandBottom) lane.bandBottom = bottom[j] >= plot.bottom ? plot.bottom - 1 : bottom[j];
+			}
+			previousMin = lo;
+			previousMax = hi;
+		}
+		tileLayer.columnSpans(passX0 + begin, top, bottom, (size_t)(end - begin), colors[slot]);
+	}
+}
+
+RasterRect TraceView::update(Raster &layer, const HistoryBuffer<int16_t> &history) {
+	int width = plot.right - plot.left;
+	lastColumnsDrawn = 0;
+	if (width <= 0 || plot.bottom <= plot.top) return RasterRect();
+
+	if (history.capacity() != capacity) {
+		capacity = history.capacity();
+		redrawAll = true;
+	}
+	if (capacity <= (uint64_t)width) {
+		return updatePolyline(layer, history);
+	}
+
+	uint64_t written = history.written();
+	int64_t rightColumn = written > 0 ? (int64_t)((written - 1) * (uint64_t)width / capacity) : -1;
+	int64_t firstColumn;
+	RasterRect changed;
+
+	bool scroll = incremental && !redrawAll && lastColumn >= 0 && written >= lastWritten &&
+		rightColumn >= lastColumn && rightColumn - lastColumn < width;
+	if (scroll) {
+		// move what is there and redraw from the column that was still filling up last time
+		int shift = (int)(rightColumn - lastColumn);
+		int redrawFrom = plot.right - 1 - shift;
+		if (bandTop <= bandBottom) {
+			layer.resetClip();
+			layer.scrollLeft(plot.left, bandTop, plot.right, bandBottom + 1, shift);
+			layer.fillRect(redrawFrom, bandTop, plot.right, bandBottom + 1, PIXEL_TRANSPARENT);
+			changed = RasterRect(shift > 0 ? plot.left : redrawFrom, bandTop, plot.right, bandBottom + 1);
+		}
+		firstColumn = lastColumn;
+	}
+	else {
+		changed = RasterRect(plot.left, bandTop, plot.right, bandBottom + 1);
+		clearLayer(layer);
+		if (ringMin.size() != channels.size() * width) {
+			ringMin.assign(channels.size() * width, NAN);
+			ringMax.assign(channels.size() * width, NAN);
+		}
+		firstColumn = rightColumn - width + 1;
+		redrawAll = false;
+	}
+
+	int64_t count = rightColumn - firstColumn + 1;
+	if (count > 0 && !channels.empty()) {
+		int threads = pool != NULL ? pool->threads() : 1;
+		int strips = layout == TRACES_STACKED ? (int)channels.size() : 1;
+		tileBands = threads * TILES_PER_THREAD / strips;
+		if (tileBands > (int)(count / TILE_MIN_COLUMNS)) tileBands = (int)(count / TILE_MIN_COLUMNS);
+		if (tileBands < 1) tileBands = 1;
+		if ((int)lanes.size() < threads) lanes.resize(threads);
+		for (int i = 0; i < threads; i++) {
+			Lane &lane = lanes[i];
+			if ((int64_t)lane.top.size() < count) {
+				lane.top.resize((size_t)count);
+				lane.bottom.resize((size_t)count);
+			}
+			lane.bandTop = bandTop;
+			lane.bandBottom = bandBottom;
+		}
+		edgeMin.resize(channels.size());
+		edgeMax.resize(channels.size());
+
+		passHistory = &history;
+		passLayer = &layer;
+		passFirst = firstColumn;
+		passLast = rightColumn;
+		passX0 = plot.right - 1 - (int)(rightColumn - firstColumn);
+		EnvelopePass envelopes;
+		envelopes.view = this;
+		TilePass tiles;
+		tiles.view = this;
+		if (pool != NULL) {
+			pool->run(envelopes, (int)channels.size());
+		}
+		else {
+			for (int slot = 0; slot < (int)channels.size(); slot++) envelopes.run(slot, 0);
+		}
+		if (!scroll) {
+			// nothing left of the first column is on screen
+			edgeMin.assign(channels.size(), NAN);
+			edgeMax.assign(channels.size(), NAN);
+		}
+		if (pool != NULL) {
+			pool->run(tiles, strips * tileBands);
+		}
+		else {
+			for (int tile = 0; tile < strips * tileBands; tile++) tiles.run(tile, 0);
+		}
+		for (int i = 0; i < threads; i++) {
+			if (lanes[i].bandTop < bandTop) bandTop = lanes[i].bandTop;
+			if (lanes[i].bandBottom > bandBottom) bandBottom = lanes[i].bandBottom;
+		}
+		passHistory = NULL;
+		passLayer = NULL;
+		changed = changed.united(RasterRect(passX0, bandTop, plot.right, bandBottom + 1));
+		lastColumnsDrawn = (int)count;
+	}
+
+	lastColumn = rightColumn;
+	lastWritten = written;
+	return changed.intersected(plot);
+}
+
+// fewer samples than columns: scale them all and connect them, from scratch
+RasterRect TraceView::updatePolyline(Raster &layer, const HistoryBuffer<int16_t> &history) {
+	RasterRect changed = drawn.united(RasterRect(plot.left, bandTop, plot.right, bandBottom + 1));
+	clearLayer(layer);
+	redrawAll = false;
+	lastColumn = -1;
+
+	int width = plot.right - plot.left;
+	uint64_t firstSample = history.oldest();
+	uint64_t available = history.size();
+	if (available < 2) return changed;
+
+	double viewStart = (double)history.written() - (double)capacity;
+	double pixelsPerSample = (double)width / (double)capacity;
+	if (codes.size() < available) {
+		codes.resize((size_t)available);
+		volts.resize((size_t)available);
+		xs.resize((size_t)available);
+		ys.resize((size_t)available);
+	}
+
+	for (int slot = 0; slot < (int)channels.size(); slot++) {
+		RasterRect area = slotArea(slot);
+		layer.setClip(area.left, area.top, area.right, area.bottom);
+		history.read(channels[slot], firstSample, available, codes.data());
+		scaleToVolts(codes.data(), (size_t)available, scaling[slot], volts.data());
+
+		int yTop = plot.bottom, yBottom = plot.top;
+		for (uint64_t i = 0; i < available; i++) {
+			int y = toY(slot, volts[i]);	// get data value and scale into window's space
+			xs[i] = (int)((firstSample + i - viewStart) * pixelsPerSample) + plot.left;
+			ys[i] = y;
+			if (y < yTop) yTop = y;
+			if (y > yBottom) yBottom = y;
+		}
+		layer.polyline(xs.data(), ys.data(), (size_t)available, colors[slot]);
+		drawn = drawn.united(RasterRect(xs[0], yTop, xs[available - 1] + 1, yBottom + 1));
+	}
+	layer.resetClip();
+	drawn = drawn.intersected(plot);
+	lastColumnsDrawn = (int)available;
+	return changed.united(drawn);
+}
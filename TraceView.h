@@ -0,0 +1,128 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2023  Neuro Software Developers, Inc.
+//
+// Contact Information:
+//
+// Email:
+// info@neurosoftware.com
+//
+// Website:
+// www.neurosoftware.com
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <vector>
+#include <stdint.h>
+#include "Compositor.h"
+#include "HistoryBuffer.h"
+#include "Scaling.h"
+#include "WorkerPool.h"
+
+enum TraceLayout {
+	TRACES_OVERLAID,	// every channel across the whole plot, over the area's voltage range
+	TRACES_STACKED		// one strip per channel, top to bottom in drawing order, each over its own range
+};
+
+// Draws the scrolling trace of a few channels of a HistoryBuffer into a layer, newest sample at the right.
+//
+// When the history holds more samples than there are pixel columns each column is the peak-detect envelope
+// of the samples that fall into it. Columns are anchored to absolute sample indices (column k holds samples
+// k * capacity / width up to the next column's first sample), so as samples arrive the picture only moves:
+// update() scrolls the layer left by the number of columns completed since the last call and rasterizes just
+// those, making the cost per frame proportional to the incoming sample rate instead of the history length.
+// Shorter histories are drawn as a polyline through every sample, from scratch each time.
+//
+// With a WorkerPool the envelope columns are worked out in two passes over the pool's threads: first every
+// channel's envelope (the part that reads samples), then the rasterizing, in tiles that are disjoint regions of
+// the layer: one per strip in the stacked layout, split further into bands of columns when there are more
+// threads than strips. Within a tile the channels are drawn in order, so the picture is the same as from one thread.
+class TraceView {
+public:
+	TraceView();
+
+	// the plot's rectangle in the layer and the voltage range it spans top to bottom
+	void setArea(const RasterRect &area, float minVolts, float maxVolts);
+	// channels in drawing order (later ones on top), and for the stacked layout the range of each strip (NULL for
+	// the area's); a change redraws everything
+	void setChannels(const int *channels, const Pixel *colors, const ChannelScaling *scaling, int count,
+		const float *minVolts = NULL, const float *maxVolts = NULL);
+	void setLayout(TraceLayout layout);
+	void setIncremental(bool scroll) { incremental = scroll; invalidate(); }
+	// > 1 trades envelope accuracy for speed: only every stride-th run of samples is scanned. Applies to columns
+	// rasterized from now on, the ones already on screen keep the detail they were drawn with.
+	void setSampleStride(int stride) { sampleStride = stride > 1 ? stride : 1; }
+	void invalidate() { redrawAll = true; }
+	// NULL (the default) draws on the calling thread alone
+	void setPool(WorkerPool *workers) { pool = workers; }
+
+	// brings layer up to date with history and returns the part of the layer that changed
+	RasterRect update(Raster &layer, const HistoryBuffer<int16_t> &history);
+
+	int columnsRasterized() const { return lastColumnsDrawn; }	// in the last update(), per channel
+
+private:
+	// scratch of one pool thread
+	struct Lane {
+		std::vector<int16_t> codeMin, codeMax;
+		std::vector<float> voltMin, voltMax;
+		std::vector<char> filled;
+		std::vector<int> top, bottom;
+		int bandTop, bandBottom;
+	};
+	// the two passes of an update, an item is a channel and a tile respectively
+	struct EnvelopePass : public ParallelTask {
+		TraceView *view;
+		void run(int slot, int worker);
+	};
+	struct TilePass : public ParallelTask {
+		TraceView *view;
+		void run(int tile, int worker);
+	};
+
+	RasterRect updatePolyline(Raster &layer, const HistoryBuffer<int16_t> &history);
+	void envelope(Lane &lane, const HistoryBuffer<int16_t> &history, int slot, int64_t firstColumn, int64_t lastColumn);
+	void drawTile(Lane &lane, int tile);
+	uint64_t columnStart(int64_t column) const;
+	RasterRect slotArea(int slot) const;
+	int toY(int slot, float volts) const;
+	void clearLayer(Raster &layer);
+
+	RasterRect plot;
+	float minV, maxV;
+	std::vector<int> channels;
+	std::vector<Pixel> colors;
+	std::vector<ChannelScaling> scaling;
+	std::vector<float> slotMin, slotMax;
+	TraceLayout layout;
+	bool incremental;
+	bool redrawAll;
+	int sampleStride;
+	WorkerPool *pool;
+
+	// what is on the layer now
+	uint64_t capacity;
+	uint64_t lastWritten;
+	int64_t lastColumn;			// absolute index of the rightmost column drawn (it may have been partial)
+	int bandTop, bandBottom;	// rows that hold trace pixels, the only ones worth scrolling
+	RasterRect drawn;			// polyline mode: everything drawn last time
+	int lastColumnsDrawn;
+
+	// per channel ring of column envelopes in volts, slot * width + column % width; empty columns are NaN
+	std::vector<float> ringMin, ringMax;
+
+	// the update in progress, for the passes
+	const HistoryBuffer<int16_t> *passHistory;
+	Raster *passLayer;
+	int64_t passFirst, passLast;	// absolute columns
+	int passX0;						// where passFirst goes on the layer
+	int tileBands;					// column bands per strip
+	std::vector<float> edgeMin, edgeMax;	// per channel, the column left of passFirst; NaN when not on screen
+
+	std::vector<Lane> lanes;
+	std::vector<int16_t> codes;
+	std::vector<float> volts;
+	std::vector<int> xs, ys;
+};
@@ -0,0 +1,252 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2023  Neuro Software Developers, Inc.
+//
+// Contact Information:
+//
+// Email:
+// info@neurosoftware.com
+//
+// Website:
+// www.neurosoftware.com
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "Trigger.h"
+#include "SimdSupport.h"
+
+#define SCAN_BLOCK 4096			// samples copied out of the history and scanned at a time
+#define MAX_SLOPE_SAMPLES 4096
+
+TriggerSettings::TriggerSettings() : mode(TRIGGER_FREE_RUN), type(TRIGGER_EDGE), rising(true), channel(0), level(0),
+	hysteresis(64), slopeSamples(8), minWidth(0), maxWidth(UINT64_MAX), holdoff(0), preTrigger(256), postTrigger(768),
+	autoTimeout(4096) {
+}
+
+static int16_t saturate(int value) {
+	return (int16_t)(value < -32768 ? -32768 : (value > 32767 ? 32767 : value));
+}
+
+// index of the first sample >= threshold, count if there is none
+static size_t findAtLeast(const int16_t *samples, size_t count, int16_t threshold) {
+	size_t i = 0;
+#ifdef SCOPE_SSE2
+	__m128i t = _mm_set1_epi16(threshold);
+	for (; i + 16 <= count; i += 16) {
+		// lanes below the threshold, the first one that isn't is the match
+		unsigned int below = (unsigned int)_mm_movemask_epi8(_mm_packs_epi16(
+			_mm_cmplt_epi16(_mm_loadu_si128((const __m128i *)(samples + i)), t),
+			_mm_cmplt_epi16(_mm_loadu_si128((const __m128i *)(samples + i + 8)), t)));
+		if (below != 0xFFFF) return i + lowestSetBit(~below & 0xFFFF);
+	}
+#endif
+	for (; i < count; i++) {
+		if (samples[i] >= threshold) return i;
+	}
+	return count;
+}
+
+// index of the first sample <= threshold, count if there is none
+static size_t findAtMost(const int16_t *samples, size_t count, int16_t threshold) {
+	size_t i = 0;
+#ifdef SCOPE_SSE2
+	__m128i t = _mm_set1_epi16(threshold);
+	for (; i + 16 <= count; i += 16) {
+		unsigned int above = (unsigned int)_mm_movemask_epi8(_mm_packs_epi16(
+			_mm_cmpgt_epi16(_mm_loadu_si128((const __m128i *)(samples + i)), t),
+			_mm_cmpgt_epi16(_mm_loadu_si128((const __m128i *)(samples + i + 8)), t)));
+		if (above != 0xFFFF) return i + lowestSetBit(~above & 0xFFFF);
+	}
+#endif
+	for (; i < count; i++) {
+		if (samples[i] <= threshold) return i;
+	}
+	return count;
+}
+
+// first sample past threshold in the given direction
+static size_t findPast(const int16_t *samples, size_t count, int16_t threshold, bool upward) {
+	return upward ? findAtLeast(samples, count, threshold) : findAtMost(samples, count, threshold);
+}
+
+// slope[i] = samples[i + distance] - samples[i], saturated
+static void difference(const int16_t *samples, size_t count, int distance, int16_t *slope) {
+	size_t i = 0;
+#ifdef SCOPE_SSE2
+	for (; i + 8 <= count; i += 8) {
+		__m128i later = _mm_loadu_si128((const __m128i *)(samples + i + distance));
+		__m128i earlier = _mm_loadu_si128((const __m128i *)(samples + i));
+		_mm_storeu_si128((__m128i *)(slope + i), _mm_subs_epi16(later, earlier));
+	}
+#endif
+	for (; i < count; i++) {
+		slope[i] = saturate(samples[i + distance] - samples[i]);
+	}
+}
+
+Trigger::Trigger() : armThreshold(0), fireThreshold(0), scanned(0), primed(false), inPulse(false), pulseStart(0),
+	pending(false), pendingAt(0), lastSweepEnd(0), stopped(false), sweep(0), forced(false), sweeps(0) {
+	configure(TriggerSettings());
+}
+
+void Trigger::configure(const TriggerSettings &settings) {
+	s = settings;
+	if (s.slopeSamples < 1) s.slopeSamples = 1;
+	if (s.slopeSamples > MAX_SLOPE_SAMPLES) s.slopeSamples = MAX_SLOPE_SAMPLES;
+	if (s.hysteresis < 0) s.hysteresis = 0;
+
+	// everything is phrased as "prime past armThreshold, fire past fireThreshold", the direction says which way past is
+	int level = s.level;
+	if (s.type == TRIGGER_SLOPE) {
+		if (level < 0) level = -level;
+		if (!s.rising) level = -level;
+	}
+	fireThreshold = saturate(level);
+	armThreshold = saturate(s.rising ? level - s.hysteresis : level + s.hysteresis);
+
+	block.resize(SCAN_BLOCK + MAX_SLOPE_SAMPLES);
+	slope.resize(SCAN_BLOCK);
+	stopped = false;
+	rearm();
+}
+
+void Trigger::reset(uint64_t position) {
+	scanned = position;
+	lastSweepEnd = position;
+	sweeps = 0;
+	stopped = false;
+	rearm();
+}
+
+void Trigger::arm() {
+	stopped = false;
+	rearm();
+}
+
+void Trigger::rearm() {
+	primed = false;
+	inPulse = false;
+	pending = false;
+}
+
+// looks for the next trigger in [scanned, written), true with its sample index in at
+bool Trigger::scan(const HistoryBuffer<int16_t> &history, uint64_t written, uint64_t *at) {
+	bool up = s.rising;
+	while (scanned < written) {
+		uint64_t from = scanned;
+		size_t count = written - from > SCAN_BLOCK ? SCAN_BLOCK : (size_t)(written - from);
+		const int16_t *x;
+		if (s.type == TRIGGER_SLOPE) {
+			history.read(s.channel, from - s.slopeSamples, count + s.slopeSamples, block.data());
+			difference(block.data(), count, s.slopeSamples, slope.data());
+			x = slope.data();
+		}
+		else {
+			history.read(s.channel, from, count, block.data());
+			x = block.data();
+		}
+
+		size_t i = 0;
+		while (i < count) {
+			if (s.type == TRIGGER_LEVEL) {
+				i += findPast(x + i, count - i, fireThreshold, up);
+				if (i < count) {
+					*at = from + i;
+					return true;
+				}
+			}
+			else if (!primed) {
+				i += findPast(x + i, count - i, armThreshold, !up);
+				if (i < count) primed = true;
+			}
+			else if (s.type != TRIGGER_PULSE_WIDTH) {
+				// edge and slope fire on the first sample past the level after priming
+				i += findPast(x + i, count - i, fireThreshold, up);
+				if (i < count) {
+					*at = from + i;
+					return true;
+				}
+			}
+			else if (!inPulse) {
+				i += findPast(x + i, count - i, fireThreshold, up);
+				if (i < count) {
+					inPulse = true;
+					pulseStart = from + i;
+				}
+			}
+			else {
+				// the pulse ends where the signal is back past the hysteresis, which also primes the next one
+				i += findPast(x + i, count - i, armThreshold, !up);
+				if (i < count) {
+					inPulse = false;
+					uint64_t width = from + i - pulseStart;
+					if (width >= s.minWidth && width <= s.maxWidth) {
+						*at = from + i;
+						return true;
+					}
+				}
+			}
+		}
+		scanned = from + count;
+	}
+	return false;
+}
+
+bool Trigger::update(const HistoryBuffer<int16_t> &history) {
+	if (s.mode == TRIGGER_FREE_RUN || stopped) return false;
+	uint64_t written = history.written();
+	if (written < scanned && !pending) {
+		reset(written);  // the history was cleared under us
+	}
+
+	// a trigger point needs its pre-trigger samples (and the slope its look-back) still in the history
+	uint64_t lookBack = s.type == TRIGGER_SLOPE && (uint64_t)s.slopeSamples > s.preTrigger ? s.slopeSamples : s.preTrigger;
+	uint64_t earliest = history.oldest() + lookBack;
+	if (scanned < earliest) {
+		scanned = earliest;
+		primed = false;
+		inPulse = false;
+	}
+
+	bool completed = false;
+	while (true) {
+		if (pending) {
+			if (written < pendingAt + s.postTrigger) break;
+			sweep = pendingAt - s.preTrigger;
+			forced = false;
+			sweeps++;
+			completed = true;
+			pending = false;
+			lastSweepEnd = pendingAt + s.postTrigger;
+			if (s.mode == TRIGGER_SINGLE) {
+				stopped = true;
+				return true;
+			}
+			// like a hardware scope the next trigger can come once this sweep and the holdoff are over
+			if (scanned < lastSweepEnd + s.holdoff) {
+				scanned = lastSweepEnd + s.holdoff;
+				primed = false;
+				inPulse = false;
+			}
+			continue;
+		}
+		uint64_t at;
+		if (!scan(history, written, &at)) break;
+		pending = true;
+		pendingAt = at;
+		scanned = at + 1;
+		primed = false;
+		inPulse = false;
+	}
+
+	// auto mode keeps the display alive without a trigger: sweep whatever arrived last
+	if (s.mode == TRIGGER_AUTO && !pending && !completed && written >= lastSweepEnd + s.autoTimeout &&
+		written - history.oldest() >= sweepLength()) {
+		sweep = written - sweepLength();
+		forced = true;
+		sweeps++;
+		completed = true;
+		lastSweepEnd = written;
+	}
+	return completed;
+}
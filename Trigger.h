@@ -0,0 +1,107 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2023  Neuro Software Developers, Inc.
+//
+// Contact Information:
+//
+// Email:
+// info@neurosoftware.com
+//
+// Website:
+// www.neurosoftware.com
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <vector>
+#include <stdint.h>
+#include "HistoryBuffer.h"
+
+enum TriggerMode {
+	TRIGGER_FREE_RUN,	// no trigger, the display scrolls
+	TRIGGER_AUTO,		// sweeps on triggers, and on its own when none came for a while
+	TRIGGER_NORMAL,		// sweeps only on triggers, holding the last sweep in between
+	TRIGGER_SINGLE		// one sweep, then stops until arm()
+};
+
+enum TriggerType {
+	TRIGGER_EDGE,			// the signal crosses the level (after having been past it the other way by the hysteresis)
+	TRIGGER_LEVEL,			// the signal is beyond the level
+	TRIGGER_SLOPE,			// the signal changes by more than level within slopeSamples
+	TRIGGER_PULSE_WIDTH		// a pulse beyond the level ends, having lasted minWidth..maxWidth samples
+};
+
+// Thresholds are raw ADC codes of the trigger channel, like the history holds them; see ChannelScaling::toCode().
+struct TriggerSettings {
+	TriggerMode mode;
+	TriggerType type;
+	bool rising;			// edge and slope direction; pulse polarity (rising: pulses above the level)
+	int channel;
+	int16_t level;			// for TRIGGER_SLOPE the change in codes over slopeSamples, always positive
+	int16_t hysteresis;		// how far past the level the signal must go back before the next trigger can fire
+	int slopeSamples;
+	uint64_t minWidth, maxWidth;	// samples
+	uint64_t holdoff;		// samples after a sweep during which no trigger fires
+	uint64_t preTrigger;	// samples of the sweep before the trigger point
+	uint64_t postTrigger;	// from the trigger point on
+	uint64_t autoTimeout;	// TRIGGER_AUTO: samples without a trigger before a sweep is taken anyway
+
+	TriggerSettings();
+};
+
+// Finds trigger events in the samples of one channel of a HistoryBuffer as they arrive and turns them into
+// sweeps: windows of preTrigger + postTrigger samples around the trigger point, complete once the last of
+// their samples has arrived. The history itself holds the sweep's samples, sweepStart() says where.
+//
+// The scan works a vector of samples at a time: it compares 16 samples against the threshold it is waiting for
+// (the arming one or the firing one) and only branches when one of them matched, so the state machine steps
+// once per event rather than once per sample and the scan runs at close to memory speed whatever the signal does.
+class Trigger {
+public:
+	Trigger();
+
+	// changes take effect from the next sample on, and re-arm a single sweep
+	void configure(const TriggerSettings &settings);
+	const TriggerSettings &settings() const { return s; }
+
+	// starts over at sample index position (e.g. after the history was cleared)
+	void reset(uint64_t position);
+	// TRIGGER_SINGLE: take another sweep
+	void arm();
+
+	// scans what arrived since the last call, true when a new sweep completed
+	bool update(const HistoryBuffer<int16_t> &history);
+
+	bool hasSweep() const { return sweeps > 0; }
+	uint64_t sweepStart() const { return sweep; }		// sample index of the first sample of the last sweep
+	uint64_t sweepLength() const { return s.preTrigger + s.postTrigger; }
+	bool sweepForced() const { return forced; }			// taken by TRIGGER_AUTO without a trigger
+	bool waiting() const { return !stopped; }			// false once a single sweep was taken
+	bool triggered() const { return pending; }			// a trigger fired, its post-trigger samples are still coming
+	uint64_t sweepCount() const { return sweeps; }
+
+private:
+	bool scan(const HistoryBuffer<int16_t> &history, uint64_t written, uint64_t *at);
+	void rearm();
+
+	TriggerSettings s;
+	int16_t armThreshold;	// the signal (or its slope) must get past this, away from fireThreshold, to prime
+	int16_t fireThreshold;
+
+	uint64_t scanned;		// next sample index to look at
+	bool primed;
+	bool inPulse;
+	uint64_t pulseStart;
+	bool pending;
+	uint64_t pendingAt;
+	uint64_t lastSweepEnd;	// for the auto timeout
+	bool stopped;
+
+	uint64_t sweep;
+	bool forced;
+	uint64_t sweeps;
+
+	std::vector<int16_t> block;
+	std::vector<int16_t> slope;
+};
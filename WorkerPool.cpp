@@ -0,0 +1,153 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2023  Neuro Software Developers, Inc.
+//
+// Contact Information:
+//
+// Email:
+// info@neurosoftware.com
+//
+// Website:
+// www.neurosoftware.com
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "WorkerPool.h"
+
+using namespace std;
+
+WorkerPool::WorkerPool() : task(NULL), generation(0), running(0), quit(false) {
+	start(1);
+}
+
+WorkerPool::~WorkerPool() {
+	stop();
+}
+
+void WorkerPool::start(int threads) {
+	stop();
+	if (threads < 1) threads = 1;
+	for (int i = 0; i < threads; i++) {
+		Queue *queue = new Queue();
+		queue->begin = queue->end = 0;
+		queues.push_back(queue);
+	}
+	quit = false;
+	for (int i = 1; i < threads; i++) {
+		workers.push_back(thread(&WorkerPool::loop, this, i));
+	}
+}
+
+void WorkerPool::stop() {
+	{
+		lock_guard<mutex> guard(lock);
+		quit = true;
+	}
+	wake.notify_all();
+	for (size_t i = 0; i < workers.size(); i++) {
+		workers[i].join();
+	}
+	workers.clear();
+	for (size_t i = 0; i < queues.size(); i++) {
+		delete queues[i];
+	}
+	queues.clear();
+}
+
+void WorkerPool::run(ParallelTask &work, int items) {
+	int n = (int)queues.size();
+	if (n <= 1 || items <= 1) {
+		for (int i = 0; i < items; i++) work.run(i, 0);
+		return;
+	}
+
+	// the workers are all waiting for the next generation, so the queues are ours until then
+	for (int i = 0; i < n; i++) {
+		queues[i]->begin = (int)((int64_t)items * i / n);
+		queues[i]->end = (int)((int64_t)items * (i + 1) / n);
+	}
+	{
+		lock_guard<mutex> guard(lock);
+		task = &work;
+		running = n - 1;
+		generation++;
+	}
+	wake.notify_all();
+
+	this->work(0);
+
+	unique_lock<mutex> guard(lock);
+	while (running > 0) done.wait(guard);
+	task = NULL;
+}
+
+void WorkerPool::loop(int worker) {
+	uint64_t seen = 0;
+	for (;;) {
+		{
+			unique_lock<mutex> guard(lock);
+			while (!quit && generation == seen) wake.wait(guard);
+			if (quit) return;
+			seen = generation;
+		}
+		work(worker);
+		{
+			lock_guard<mutex> guard(lock);
+			if (--running == 0) done.notify_one();
+		}
+	}
+}
+
+// runs items until there are none left anywhere
+void WorkerPool::work(int worker) {
+	int item;
+	for (;;) {
+		while (take(worker, &item)) {
+			task->run(item, worker);
+		}
+		if (!steal(worker)) return;
+	}
+}
+
+bool WorkerPool::take(int worker, int *item) {
+	Queue &queue = *queues[worker];
+	lock_guard<mutex> guard(queue.lock);
+	if (queue.begin >= queue.end) return false;
+	*item = queue.begin++;
+	return true;
+}
+
+// moves the back half of the fullest other queue into ours; false when every queue is empty
+bool WorkerPool::steal(int worker) {
+	int n = (int)queues.size();
+	int victim = -1, most = 0;
+	for (int i = 1; i < n; i++) {
+		Queue &queue = *queues[(worker + i) % n];
+		int left;
+		{
+			lock_guard<mutex> guard(queue.lock);
+			left = queue.end - queue.begin;
+		}
+		if (left > most) {
+			most = left;
+			victim = (worker + i) % n;
+		}
+	}
+	if (victim < 0) return false;
+
+	int begin, end;
+	{
+		Queue &queue = *queues[victim];
+		lock_guard<mutex> guard(queue.lock);
+		int left = queue.end - queue.begin;
+		if (left <= 0) return true;  // emptied meanwhile, look again
+		end = queue.end;
+		begin = queue.end - (left + 1) / 2;
+		queue.end = begin;
+	}
+	Queue &own = *queues[worker];
+	lock_guard<mutex> guard(own.lock);
+	own.begin = begin;
+	own.end = end;
+	return true;
+}
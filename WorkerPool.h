@@ -0,0 +1,72 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2023  Neuro Software Developers, Inc.
+//
+// Contact Information:
+//
+// Email:
+// info@neurosoftware.com
+//
+// Website:
+// www.neurosoftware.com
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <stdint.h>
+
+// work split into numbered items, run() may be called for several items at once from different threads
+class ParallelTask {
+public:
+	// worker is the index (0 .. WorkerPool::threads() - 1) of the thread running the item, for per thread scratch
+	virtual void run(int item, int worker) = 0;
+
+protected:
+	~ParallelTask() {}
+};
+
+// A fixed set of threads that run the items of a task in parallel, the calling thread being one of them.
+// Every thread gets its own queue: a contiguous run of the items to start with, taken from the front. A thread
+// whose queue runs dry steals the back half of another's, so uneven items (a busy channel next to a flat one)
+// still finish at about the same time on every core. run() neither allocates nor returns before every item is
+// done, so a task can live on the caller's stack and hand its items pointers to the caller's data.
+class WorkerPool {
+public:
+	WorkerPool();
+	~WorkerPool();
+
+	// threads including the caller's, 1 runs everything on the caller; not while run() is running
+	void start(int threads);
+	void stop();
+	int threads() const { return (int)queues.size(); }
+
+	void run(ParallelTask &task, int items);
+
+private:
+	struct Queue {
+		std::mutex lock;
+		int begin, end;				// the items still to be run
+		char pad[64];				// queues are locked by different threads, keep them off each other's cache line
+	};
+
+	void loop(int worker);
+	void work(int worker);
+	bool take(int worker, int *item);
+	bool steal(int worker);
+
+	std::vector<Queue *> queues;		// queues[0] is the caller's
+	std::vector<std::thread> workers;	// threads 1 .. threads() - 1
+	ParallelTask *task;
+
+	std::mutex lock;
+	std::condition_variable wake;		// a new task or stop()
+	std::condition_variable done;		// the last worker finished
+	uint64_t generation;				// tasks started
+	int running;						// workers still on the current task
+	bool quit;
+};